@@ -0,0 +1,155 @@
+// -*- LSST-C++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "boost/date_time/posix_time/posix_time.hpp"
+#include "boost/thread.hpp"
+
+#include "lsst/afw/geom.h"
+#include "lsst/afw/image/Image.h"
+#include "lsst/afw/image/MaskedImage.h"
+#include "lsst/afw/detection/FootprintSet.h"
+
+namespace afwGeom = lsst::afw::geom;
+namespace afwImage = lsst::afw::image;
+namespace afwDetect = lsst::afw::detection;
+namespace posixTime = boost::posix_time;
+
+typedef float ImageType;
+
+const unsigned DefImageSize = 4096;
+const unsigned DefNIter = 3;
+const int StarSpacing = 12;     // separation of stars; 4096/12 gives 1.2e5 of them
+const int StampHalfWidth = 3;   // stars are drawn out to +- this many pixels
+const double Sigma = 1.2;       // Gaussian width of stars (pixels)
+const double ThresholdValue = 5;
+
+/*
+ * Make a crowded field: Gaussian stars of varying brightness on a jittered grid,
+ * with a faint pattern (not Gaussian noise, so as to be reproducible) as background
+ */
+void makeCrowdedField(afwImage::MaskedImage<ImageType> &mImage) {
+    afwImage::Image<ImageType> &image = *mImage.getImage();
+    for (int y = 0; y != image.getHeight(); ++y) {
+        int x = 0;
+        for (afwImage::Image<ImageType>::x_iterator ptr = image.row_begin(y), end = image.row_end(y);
+             ptr != end; ++ptr, ++x) {
+            *ptr = static_cast<ImageType>((x*31 + y*17) % 7) * 0.5;
+        }
+    }
+    *mImage.getVariance() = 1.0;
+
+    int const border = StampHalfWidth + 2; // allow for the jitter of +- 2 pixels
+    int nStar = 0;
+    for (int iy = StarSpacing/2; iy < image.getHeight() - border; iy += StarSpacing) {
+        for (int ix = StarSpacing/2; ix < image.getWidth() - border; ix += StarSpacing, ++nStar) {
+            int const xc = ix + (nStar*7) % 5 - 2;
+            int const yc = iy + (nStar*3) % 5 - 2;
+            double const amp = 20 + (nStar*37) % 500;
+            for (int dy = -StampHalfWidth; dy <= StampHalfWidth; ++dy) {
+                for (int dx = -StampHalfWidth; dx <= StampHalfWidth; ++dx) {
+                    image(xc + dx, yc + dy) += amp*std::exp(-0.5*(dx*dx + dy*dy)/(Sigma*Sigma));
+                }
+            }
+        }
+    }
+    std::cout << "Image " << image.getWidth() << " x " << image.getHeight() << " with " << nStar
+        << " stars" << std::endl;
+}
+
+/*
+ * Time detection for 1, 2, 4, ... maxThreads threads
+ * (wall clock time, since CPU time summed over threads says nothing about scaling)
+ */
+void timeDetection(afwImage::MaskedImage<ImageType> const &mImage, afwDetect::Threshold::ThresholdType type,
+                   std::string const &descr, unsigned int nIter, int maxThreads) {
+    std::cout << std::endl << descr << std::endl;
+    std::cout << "Threads\tNFoot\tDetSec\tSpeedup" << std::endl;
+
+    double serialSecPerIter = 0;
+    for (int nThreads = 1; ; nThreads = std::min(nThreads * 2, maxThreads)) {
+        afwDetect::Threshold threshold(ThresholdValue, type);
+        threshold.setNThreads(nThreads);
+
+        int nFoot = 0;
+        posixTime::ptime const startTime = posixTime::microsec_clock::local_time();
+        for (unsigned int iter = 0; iter < nIter; ++iter) {
+            afwDetect::FootprintSet<ImageType> fs(mImage, threshold);
+            nFoot = fs.getFootprints()->size();
+        }
+        double const secPerIter =
+            (posixTime::microsec_clock::local_time() - startTime).total_microseconds() / (1.0e6 * nIter);
+        if (nThreads == 1) {
+            serialSecPerIter = secPerIter;
+        }
+
+        std::cout << nThreads << "\t" << nFoot << "\t" << secPerIter << "\t"
+            << serialSecPerIter / secPerIter << std::endl;
+
+        if (nThreads >= maxThreads) break;
+    }
+}
+
+int main(int argc, char **argv) {
+    unsigned int imSize = DefImageSize;
+    unsigned int nIter = DefNIter;
+    int maxThreads = std::max(static_cast<int>(boost::thread::hardware_concurrency()), 1);
+    if (argc > 1) {
+        std::istringstream(argv[1]) >> imSize;
+    }
+    if (argc > 2) {
+        std::istringstream(argv[2]) >> nIter;
+    }
+    if (argc > 3) {
+        std::istringstream(argv[3]) >> maxThreads;
+    }
+    if (argc > 4 || imSize < static_cast<unsigned int>(StarSpacing) || maxThreads < 1) {
+        std::cerr << "Time detecting Footprints in a crowded field" << std::endl;
+        std::cerr << "Usage: timeDetection [imSize [nIter [maxThreads]]]" << std::endl;
+        std::cerr << "imSize (default " << DefImageSize << ") is the width and height of the image"
+            << std::endl;
+        std::cerr << "nIter (default " << DefNIter << ") is the number of iterations per test" << std::endl;
+        std::cerr << "maxThreads (default: number of cores) is the maximum number of threads" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    std::cout << "Timing detection (FootprintSet construction, including peaks)" << std::endl;
+    std::cout << "Columns:" << std::endl;
+    std::cout << "* NFoot: number of Footprints detected" << std::endl;
+    std::cout << "* DetSec: wall clock time to detect the Footprints (sec)" << std::endl;
+    std::cout << "* Speedup: DetSec for one thread / DetSec" << std::endl;
+
+    afwImage::MaskedImage<ImageType> mImage(afwGeom::Extent2I(imSize, imSize));
+    makeCrowdedField(mImage);
+
+    timeDetection(mImage, afwDetect::Threshold::VALUE, "Threshold on pixel value", nIter, maxThreads);
+    timeDetection(mImage, afwDetect::Threshold::PIXEL_STDEV, "Threshold on per-pixel s.d.",
+                  nIter, maxThreads);
+}
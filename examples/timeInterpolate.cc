@@ -0,0 +1,133 @@
+// -*- LSST-C++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "boost/date_time/posix_time/posix_time.hpp"
+
+#include "lsst/afw/math/Interpolate.h"
+
+namespace afwMath = lsst::afw::math;
+namespace posixTime = boost::posix_time;
+
+const unsigned DefNIter = 1000;
+const int RowLength = 4096;     // number of pixels in a row
+const int NKnotList[] = {5, 10, 40};
+const char *ModeNameList[] = {"point", "batch", "native"};
+enum Mode {POINT = 0, BATCH, NATIVE};
+
+/*
+ * Interpolate a row of RowLength pixels nIter times and return the time per row (sec);
+ * also return the values of the last row
+ */
+double timeInterpolate(afwMath::Interpolate &interp, Mode mode, unsigned int nIter,
+                       std::vector<double> const &xList, std::vector<double> &yList) {
+    double sum = 0; // prevent the compiler from eliminating the loop
+    posixTime::ptime const startTime = posixTime::microsec_clock::local_time();
+    for (unsigned int iter = 0; iter < nIter; ++iter) {
+        if (mode == POINT) {
+            for (int i = 0; i < RowLength; ++i) {
+                yList[i] = interp.interpolate(xList[i]);
+            }
+        } else {
+            interp.interpolate(xList, yList);
+        }
+        sum += yList[iter % RowLength];
+    }
+    double const secPerIter =
+        (posixTime::microsec_clock::local_time() - startTime).total_microseconds() / (1.0e6 * nIter);
+    if (sum == 0) {
+        std::cerr << "unexpected sum" << std::endl;
+    }
+    return secPerIter;
+}
+
+int main(int argc, char **argv) {
+    unsigned int nIter = DefNIter;
+    if (argc > 1) {
+        std::istringstream(argv[1]) >> nIter;
+    }
+    if (argc > 2 || nIter < 1) {
+        std::cerr << "Time interpolating a row of pixels one point at a time, in one call,"
+            << " and in one call with a native spline" << std::endl;
+        std::cerr << "Usage: timeInterpolate [nIter]" << std::endl;
+        std::cerr << "nIter (default " << DefNIter << ") is the number of rows interpolated per test"
+            << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    std::vector<double> xList(RowLength);
+    for (int i = 0; i < RowLength; ++i) {
+        xList[i] = i;
+    }
+
+    std::cout << "Timing Interpolate.interpolate for rows of " << RowLength << " pixels" << std::endl;
+    std::cout << "Columns:" << std::endl;
+    std::cout << "* Style: interpolation style" << std::endl;
+    std::cout << "* NKnot: number of points being interpolated" << std::endl;
+    std::cout << "* Mode: point = interpolate(x) for each pixel; batch = interpolate(xList, yList);"
+        << " native = batch with a native (non-GSL) spline" << std::endl;
+    std::cout << "* Sec: time to interpolate one row (sec)" << std::endl;
+    std::cout << "* Speedup: Sec for point / Sec" << std::endl;
+    std::cout << "* MaxErr: maximum difference from point" << std::endl;
+    std::cout << std::endl << "Style\tNKnot\tMode\tSec\tSpeedup\tMaxErr" << std::endl;
+
+    afwMath::Interpolate::Style const styleList[] = {afwMath::Interpolate::NATURAL_SPLINE,
+                                                     afwMath::Interpolate::AKIMA_SPLINE};
+    char const *styleNameList[] = {"natural", "akima"};
+    for (unsigned int s = 0; s < sizeof(styleList) / sizeof(styleList[0]); ++s) {
+        for (unsigned int k = 0; k < sizeof(NKnotList) / sizeof(NKnotList[0]); ++k) {
+            int const nKnot = NKnotList[k];
+            std::vector<double> knotX(nKnot), knotY(nKnot);
+            for (int i = 0; i < nKnot; ++i) {
+                knotX[i] = (i + 0.5) * RowLength / nKnot - 0.5;
+                knotY[i] = 1000 + 10 * std::sin(0.7 * i) + 0.01 * knotX[i];
+            }
+
+            std::vector<double> pointYList(RowLength);
+            double pointSecPerIter = 0;
+            for (int mode = POINT; mode <= NATIVE; ++mode) {
+                afwMath::Interpolate interp(knotX, knotY, styleList[s], mode == NATIVE);
+                std::vector<double> yList(RowLength);
+                double const secPerIter = timeInterpolate(interp, static_cast<Mode>(mode), nIter,
+                                                          xList, yList);
+                if (mode == POINT) {
+                    pointSecPerIter = secPerIter;
+                    pointYList = yList;
+                }
+                double maxErr = 0;
+                for (int i = 0; i < RowLength; ++i) {
+                    maxErr = std::max(maxErr, std::fabs(yList[i] - pointYList[i]));
+                }
+                std::cout << styleNameList[s] << "\t" << nKnot << "\t" << ModeNameList[mode] << "\t"
+                    << secPerIter << "\t" << pointSecPerIter / secPerIter << "\t" << maxErr << std::endl;
+            }
+        }
+    }
+}
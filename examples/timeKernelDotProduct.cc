@@ -0,0 +1,133 @@
+// -*- LSST-C++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#include <iostream>
+#include <sstream>
+
+#include "boost/date_time/posix_time/posix_time.hpp"
+
+#include "lsst/afw/geom.h"
+#include "lsst/afw/math/FunctionLibrary.h"
+#include "lsst/afw/image/Image.h"
+#include "lsst/afw/image/MaskedImage.h"
+#include "lsst/afw/math/Kernel.h"
+#include "lsst/afw/math/ConvolveImage.h"
+#include "lsst/afw/math/detail/DotProduct.h"
+
+namespace afwGeom = lsst::afw::geom;
+namespace afwImage = lsst::afw::image;
+namespace afwMath = lsst::afw::math;
+namespace mathDetail = lsst::afw::math::detail;
+namespace posixTime = boost::posix_time;
+
+typedef float ImageType;
+typedef double KernelType;
+
+const double Sigma = 3;
+const unsigned DefImageSize = 1024;
+const unsigned DefNIter = 3;
+const int KernelSizeList[] = {5, 11, 21};
+const char *SimdNameList[] = {"none", "SSE2", "AVX2"};
+
+/*
+ * Time brute force convolution of image with kernel using the generic (template) inner loop
+ * and each instruction set supported by this CPU
+ */
+template <class ImageClass>
+void timeConvolution(ImageClass const &image, afwMath::Kernel const &kernel, unsigned int nIter) {
+    ImageClass resImage(image.getDimensions());
+    afwMath::ConvolutionControl convControl;
+    convControl.setFftMinKernelSize(0);     // always use brute force
+
+    double templateSecPerIter = 0;
+    for (int level = mathDetail::SIMD_NONE; level <= mathDetail::getMaxSimdLevel(); ++level) {
+        mathDetail::setSimdLevel(static_cast<mathDetail::SimdLevel>(level));
+
+        posixTime::ptime const startTime = posixTime::microsec_clock::local_time();
+        for (unsigned int iter = 0; iter < nIter; ++iter) {
+            afwMath::convolve(resImage, image, kernel, convControl);
+        }
+        double const secPerIter =
+            (posixTime::microsec_clock::local_time() - startTime).total_microseconds() / (1.0e6 * nIter);
+        if (level == mathDetail::SIMD_NONE) {
+            templateSecPerIter = secPerIter;
+        }
+
+        std::cout << image.getWidth() << "\t" << image.getHeight() << "\t" << kernel.getWidth() << "\t"
+            << kernel.getHeight() << "\t" << SimdNameList[level] << "\t" << secPerIter << "\t"
+            << templateSecPerIter / secPerIter << std::endl;
+    }
+    mathDetail::setSimdLevel(mathDetail::getMaxSimdLevel());
+}
+
+template <class ImageClass>
+void timeAllKernelSizes(ImageClass const &image, unsigned int nIter) {
+    std::cout << "ImWid\tImHt\tKerWid\tKerHt\tSIMD\tCnvSec\tSpeedup" << std::endl;
+    afwMath::GaussianFunction2<KernelType> gaussFunc(Sigma, Sigma, 0);
+    for (unsigned int i = 0; i < sizeof(KernelSizeList) / sizeof(KernelSizeList[0]); ++i) {
+        afwMath::AnalyticKernel kernel(KernelSizeList[i], KernelSizeList[i], gaussFunc);
+        timeConvolution(image, kernel, nIter);
+    }
+}
+
+int main(int argc, char **argv) {
+    unsigned int imSize = DefImageSize;
+    unsigned int nIter = DefNIter;
+    if (argc > 1) {
+        std::istringstream(argv[1]) >> imSize;
+    }
+    if (argc > 2) {
+        std::istringstream(argv[2]) >> nIter;
+    }
+    if (argc > 3 || imSize < 21) {
+        std::cerr << "Time the vectorized kernel dot product against the generic template code" << std::endl;
+        std::cerr << "Usage: timeKernelDotProduct [imSize [nIter]]" << std::endl;
+        std::cerr << "imSize (default " << DefImageSize << ") is the width and height of the image" << std::endl;
+        std::cerr << "nIter (default " << DefNIter << ") is the number of iterations per test" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    std::cout << "Timing brute force convolution with and without SIMD" << std::endl;
+    std::cout << "Columns:" << std::endl;
+    std::cout << "* SIMD: instruction set used for the kernel dot product (none = generic template code)"
+        << std::endl;
+    std::cout << "* CnvSec: time to perform one convolution (sec)" << std::endl;
+    std::cout << "* Speedup: CnvSec for SIMD=none / CnvSec" << std::endl;
+
+    afwImage::MaskedImage<ImageType> mImage(afwGeom::Extent2I(imSize, imSize));
+    for (int y = 0; y != mImage.getHeight(); ++y) {
+        int x = 0;
+        for (afwImage::MaskedImage<ImageType>::x_iterator ptr = mImage.row_begin(y), end = mImage.row_end(y);
+             ptr != end; ++ptr, ++x) {
+            *ptr = afwImage::MaskedImage<ImageType>::SinglePixel(static_cast<double>((x*31 + y*17) % 1000),
+                (x + y) % 2, 10.0);
+        }
+    }
+
+    std::cout << std::endl << "Image " << imSize << " x " << imSize << std::endl;
+    timeAllKernelSizes(*mImage.getImage(), nIter);
+
+    std::cout << std::endl << "MaskedImage " << imSize << " x " << imSize << std::endl;
+    timeAllKernelSizes(mImage, nIter);
+}
@@ -0,0 +1,148 @@
+// -*- LSST-C++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "boost/date_time/posix_time/posix_time.hpp"
+
+#include "lsst/daf/base.h"
+#include "lsst/afw/image/MaskedImage.h"
+
+namespace afwGeom = lsst::afw::geom;
+namespace afwImage = lsst::afw::image;
+namespace dafBase = lsst::daf::base;
+namespace posixTime = boost::posix_time;
+
+typedef afwImage::MaskedImage<float> MaskedImageF;
+
+const int DefSize = 4096;
+const unsigned DefNIter = 5;
+char const *FileName = "timeMaskedImageIo.fits";
+
+double secondsSince(posixTime::ptime const &startTime) {
+    return (posixTime::microsec_clock::local_time() - startTime).total_microseconds() / 1.0e6;
+}
+
+/*
+ * Write the MaskedImage an HDU at a time, as MaskedImage::writeFits did before it wrote the planes
+ * concurrently
+ */
+void writeSerially(MaskedImageF const &mi, std::string const &fileName) {
+    dafBase::PropertySet::Ptr metadata(new dafBase::PropertyList());
+    mi.getImage()->writeFits(fileName, metadata, "pdu");
+
+    metadata->set("EXTTYPE", "IMAGE");
+    mi.getImage()->writeFits(fileName, metadata, "a");
+
+    metadata.reset(new dafBase::PropertyList());
+    metadata->set("EXTTYPE", "MASK");
+    mi.getMask()->writeFits(fileName, metadata, "a");
+
+    metadata.reset(new dafBase::PropertyList());
+    metadata->set("EXTTYPE", "VARIANCE");
+    mi.getVariance()->writeFits(fileName, metadata, "a");
+}
+
+/*
+ * Read the MaskedImage an HDU at a time, as the MaskedImage constructor did before it read the planes
+ * concurrently
+ */
+MaskedImageF readSerially(std::string const &fileName) {
+    dafBase::PropertySet::Ptr metadata(new dafBase::PropertyList());
+    MaskedImageF::ImagePtr image(new MaskedImageF::Image(fileName, 2, metadata));
+    MaskedImageF::MaskPtr mask(new MaskedImageF::Mask(fileName, 3, metadata));
+    MaskedImageF::VariancePtr variance(new MaskedImageF::Variance(fileName, 4, metadata));
+    return MaskedImageF(image, mask, variance);
+}
+
+int main(int argc, char **argv) {
+    int size = DefSize;
+    unsigned int nIter = DefNIter;
+    if (argc > 1) {
+        std::istringstream(argv[1]) >> size;
+    }
+    if (argc > 2) {
+        std::istringstream(argv[2]) >> nIter;
+    }
+    if (argc > 3 || size < 1 || nIter < 1) {
+        std::cerr << "Time reading and writing a MaskedImageF as a multi-extension FITS file" << std::endl;
+        std::cerr << "Usage: timeMaskedImageIo [size [nIter]]" << std::endl;
+        std::cerr << "size (default " << DefSize << ") is the width and height of the image" << std::endl;
+        std::cerr << "nIter (default " << DefNIter << ") is the number of times to read and write it"
+            << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    MaskedImageF mi(afwGeom::Extent2I(size, size));
+    for (int y = 0; y != size; ++y) {
+        MaskedImageF::x_iterator ptr = mi.row_begin(y);
+        for (int x = 0; x != size; ++x, ++ptr) {
+            ptr.image() = x + y;
+            ptr.mask() = (x ^ y) & 0xff;
+            ptr.variance() = x - y;
+        }
+    }
+
+    std::cout << "Timing reading and writing a " << size << "x" << size << " MaskedImageF ("
+        << nIter << " iterations; wall clock seconds per iteration)" << std::endl;
+    std::cout << "Operation\tSerialSec\tConcurrentSec\tSpeedup" << std::endl;
+
+    double serialSec = 0, concurrentSec = 0;
+    for (unsigned int iter = 0; iter < nIter; ++iter) {
+        posixTime::ptime startTime = posixTime::microsec_clock::local_time();
+        writeSerially(mi, FileName);
+        serialSec += secondsSince(startTime);
+
+        startTime = posixTime::microsec_clock::local_time();
+        mi.writeFits(FileName);
+        concurrentSec += secondsSince(startTime);
+    }
+    std::cout << "write\t" << serialSec/nIter << "\t" << concurrentSec/nIter << "\t"
+        << serialSec/concurrentSec << std::endl;
+
+    serialSec = concurrentSec = 0;
+    for (unsigned int iter = 0; iter < nIter; ++iter) {
+        posixTime::ptime startTime = posixTime::microsec_clock::local_time();
+        MaskedImageF const serial = readSerially(FileName);
+        serialSec += secondsSince(startTime);
+
+        startTime = posixTime::microsec_clock::local_time();
+        MaskedImageF const concurrent(FileName);
+        concurrentSec += secondsSince(startTime);
+
+        if ((*concurrent.getImage())(size - 1, size - 1) != (*serial.getImage())(size - 1, size - 1) ||
+            (*concurrent.getMask())(size - 1, 0) != (*serial.getMask())(size - 1, 0) ||
+            (*concurrent.getVariance())(0, size - 1) != (*serial.getVariance())(0, size - 1)) {
+            std::cerr << "Error: the planes read concurrently differ from those read serially" << std::endl;
+        }
+    }
+    std::cout << "read\t" << serialSec/nIter << "\t" << concurrentSec/nIter << "\t"
+        << serialSec/concurrentSec << std::endl;
+
+    std::remove(FileName);
+}
@@ -0,0 +1,235 @@
+// -*- LSST-C++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "boost/date_time/posix_time/posix_time.hpp"
+#include "boost/thread.hpp"
+
+#include "lsst/afw/geom/Angle.h"
+#include "lsst/afw/math/Random.h"
+#include "lsst/afw/detection/Source.h"
+#include "lsst/afw/detection/SourceCatalog.h"
+#include "lsst/afw/detection/SourceMatch.h"
+#include "lsst/afw/detection/SourceSkyIndex.h"
+
+namespace afwGeom = lsst::afw::geom;
+namespace afwMath = lsst::afw::math;
+namespace afwDetect = lsst::afw::detection;
+namespace posixTime = boost::posix_time;
+
+const unsigned DefNSource = 1000000;
+const double DefRadius = 1.0;           // match radius (arcsec)
+const double CapDec = 80.0;             // lower limit of dec for the polar cap field (degrees)
+
+/*
+ * Make a catalogue of sources distributed uniformly over the sky above minDec; the second catalogue
+ * is the first with its positions jittered by up to the match radius, so most sources match
+ */
+void makeSources(afwDetect::SourceSet &set1, afwDetect::SourceSet &set2, unsigned int nSource,
+                 double minDec, afwGeom::Angle radius) {
+    afwMath::Random rng(afwMath::Random::MT19937);
+    double const minZ = std::sin(minDec*afwGeom::PI/180);
+    set1.clear();
+    set2.clear();
+    set1.reserve(nSource);
+    set2.reserve(nSource);
+    for (unsigned int i = 0; i < nSource; ++i) {
+        afwGeom::Angle const ra = rng.flat(0.0, 360.0) * afwGeom::degrees;
+        afwGeom::Angle const dec = std::asin(rng.flat(minZ, 1.0)) * afwGeom::radians;
+
+        afwDetect::Source::Ptr src1(new afwDetect::Source);
+        src1->setSourceId(i);
+        src1->setRa(ra);
+        src1->setDec(dec);
+        set1.push_back(src1);
+
+        afwDetect::Source::Ptr src2(new afwDetect::Source);
+        src2->setSourceId(i);
+        src2->setRa(ra + rng.flat(-0.5, 0.5)*radius/std::max(std::cos(dec), 1e-3));
+        src2->setDec(dec + rng.flat(-0.5, 0.5)*radius);
+        set2.push_back(src2);
+    }
+}
+
+/*
+ * The declination-band algorithm used by matchRaDec before SourceSkyIndex (closest matches only):
+ * sort both catalogues by dec, and compare each source with every source in a band of dec around it
+ */
+struct BandPos {
+    double dec, x, y, z;
+    bool operator<(BandPos const &rhs) const { return dec < rhs.dec; }
+};
+
+std::vector<BandPos> makeBandPositions(afwDetect::SourceSet const &set) {
+    std::vector<BandPos> pos;
+    pos.reserve(set.size());
+    for (afwDetect::SourceSet::const_iterator i = set.begin(); i != set.end(); ++i) {
+        afwGeom::Angle ra = (*i)->getRa();
+        afwGeom::Angle dec = (*i)->getDec();
+        double cosDec = std::cos(dec);
+        BandPos p = {dec.asRadians(), std::cos(ra)*cosDec, std::sin(ra)*cosDec, std::sin(dec)};
+        pos.push_back(p);
+    }
+    std::sort(pos.begin(), pos.end());
+    return pos;
+}
+
+int bandMatch(afwDetect::SourceSet const &set1, afwDetect::SourceSet const &set2, afwGeom::Angle radius) {
+    double const d2Limit = radius.toUnitSphereDistanceSquared();
+    std::vector<BandPos> const pos1 = makeBandPositions(set1);
+    std::vector<BandPos> const pos2 = makeBandPositions(set2);
+
+    int nMatch = 0;
+    for (std::size_t i = 0, start = 0; i < pos1.size(); ++i) {
+        double const minDec = pos1[i].dec - radius.asRadians();
+        while (start < pos2.size() && pos2[start].dec < minDec) { ++start; }
+        double const maxDec = pos1[i].dec + radius.asRadians();
+        bool found = false;
+        for (std::size_t j = start; j < pos2.size() && pos2[j].dec <= maxDec; ++j) {
+            double const dx = pos1[i].x - pos2[j].x;
+            double const dy = pos1[i].y - pos2[j].y;
+            double const dz = pos1[i].z - pos2[j].z;
+            if (dx*dx + dy*dy + dz*dz < d2Limit) {
+                found = true;
+            }
+        }
+        nMatch += found;
+    }
+    return nMatch;
+}
+
+double secondsSince(posixTime::ptime const &startTime) {
+    return (posixTime::microsec_clock::local_time() - startTime).total_microseconds() / 1.0e6;
+}
+
+/*
+ * Time the declination-band algorithm and matchRaDec, then building a SourceSkyIndex and matching
+ * against it with 1, 2, 4, ... maxThreads threads (wall clock time, since CPU time summed over
+ * threads says nothing about scaling)
+ */
+void timeMatch(afwDetect::SourceSet const &set1, afwDetect::SourceSet const &set2, afwGeom::Angle radius,
+               std::string const &descr, bool doBand, int maxThreads) {
+    std::cout << std::endl << descr << std::endl;
+    std::cout << "Method\tThreads\tNMatch\tBuildSec\tMatchSec\tSpeedup" << std::endl;
+
+    posixTime::ptime startTime = posixTime::microsec_clock::local_time();
+    double bandSec = 0;
+    if (doBand) {
+        int const nMatch = bandMatch(set1, set2, radius);
+        bandSec = secondsSince(startTime);
+        std::cout << "band\t1\t" << nMatch << "\t-\t" << bandSec << "\t1" << std::endl;
+    }
+
+    startTime = posixTime::microsec_clock::local_time();
+    std::vector<afwDetect::SourceMatch> const refMatches = afwDetect::matchRaDec(set1, set2, radius, true);
+    double const matchRaDecSec = secondsSince(startTime);
+    double const refSec = doBand ? bandSec : matchRaDecSec;
+    std::cout << "matchRaDec\t1\t" << refMatches.size() << "\t-\t" << matchRaDecSec << "\t"
+        << refSec / matchRaDecSec << std::endl;
+
+    startTime = posixTime::microsec_clock::local_time();
+    afwDetect::SourceCatalog const cat1(set1), cat2(set2);
+    double const catalogSec = secondsSince(startTime);
+    startTime = posixTime::microsec_clock::local_time();
+    std::size_t const nCatalogMatch = afwDetect::matchRaDec(cat1, cat2, radius, true).size();
+    double const catalogMatchSec = secondsSince(startTime);
+    std::cout << "catalog\t1\t" << nCatalogMatch << "\t" << catalogSec << "\t" << catalogMatchSec << "\t"
+        << refSec / catalogMatchSec << std::endl;
+
+    startTime = posixTime::microsec_clock::local_time();
+    afwDetect::SourceSkyIndex const index(set2);
+    double const buildSec = secondsSince(startTime);
+
+    for (int nThreads = 1; ; nThreads = std::min(nThreads * 2, maxThreads)) {
+        startTime = posixTime::microsec_clock::local_time();
+        std::vector<afwDetect::SourceMatch> const matches = index.match(set1, radius, true, nThreads);
+        double const matchSec = secondsSince(startTime);
+
+        std::cout << "index\t" << nThreads << "\t" << matches.size() << "\t" << buildSec << "\t"
+            << matchSec << "\t" << refSec / matchSec << std::endl;
+        if (matches.size() != refMatches.size()) {
+            std::cerr << "Error: index found " << matches.size() << " matches; matchRaDec found "
+                << refMatches.size() << std::endl;
+        }
+
+        if (nThreads >= maxThreads) break;
+    }
+}
+
+int main(int argc, char **argv) {
+    unsigned int nSource = DefNSource;
+    double radiusArcsec = DefRadius;
+    int maxThreads = std::max(static_cast<int>(boost::thread::hardware_concurrency()), 1);
+    int doBand = 1;
+    if (argc > 1) {
+        std::istringstream(argv[1]) >> nSource;
+    }
+    if (argc > 2) {
+        std::istringstream(argv[2]) >> radiusArcsec;
+    }
+    if (argc > 3) {
+        std::istringstream(argv[3]) >> maxThreads;
+    }
+    if (argc > 4) {
+        std::istringstream(argv[4]) >> doBand;
+    }
+    if (argc > 5 || nSource < 1 || radiusArcsec <= 0 || maxThreads < 1) {
+        std::cerr << "Time matching two catalogues in ra, dec" << std::endl;
+        std::cerr << "Usage: timeMatchRaDec [nSource [radius [maxThreads [doBand]]]]" << std::endl;
+        std::cerr << "nSource (default " << DefNSource << ") is the number of sources in each catalogue"
+            << std::endl;
+        std::cerr << "radius (default " << DefRadius << ") is the match radius (arcsec)" << std::endl;
+        std::cerr << "maxThreads (default: number of cores) is the maximum number of threads" << std::endl;
+        std::cerr << "doBand (default 1): if 0, don't time the (slow near the pole) dec-band algorithm"
+            << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    afwGeom::Angle const radius = radiusArcsec * afwGeom::arcseconds;
+
+    std::cout << "Timing closest matches between two catalogues of " << nSource << " sources" << std::endl;
+    std::cout << "Columns:" << std::endl;
+    std::cout << "* Method: band = the dec-band algorithm matchRaDec used to use;"
+        << " catalog = matchRaDec on SourceCatalogs; index = matching against a prebuilt SourceSkyIndex"
+        << std::endl;
+    std::cout << "* NMatch: number of matches found" << std::endl;
+    std::cout << "* BuildSec: wall clock time to build the catalogs or the index (sec)" << std::endl;
+    std::cout << "* MatchSec: wall clock time to match the catalogues (sec)" << std::endl;
+    std::cout << "* Speedup: MatchSec for band (or matchRaDec, if band isn't timed) / MatchSec" << std::endl;
+
+    afwDetect::SourceSet set1, set2;
+    makeSources(set1, set2, nSource, -90.0, radius);
+    timeMatch(set1, set2, radius, "Whole sky", doBand, maxThreads);
+
+    makeSources(set1, set2, nSource, CapDec, radius);
+    std::ostringstream descr;
+    descr << "Polar cap (dec > " << CapDec << " degrees)";
+    timeMatch(set1, set2, radius, descr.str(), doBand, maxThreads);
+}
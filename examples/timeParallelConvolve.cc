@@ -0,0 +1,137 @@
+/* 
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ * 
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the LSST License Statement and 
+ * the GNU General Public License along with this program.  If not, 
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+ 
+#include <iostream>
+#include <sstream>
+
+#include "boost/date_time/posix_time/posix_time.hpp"
+#include "boost/thread.hpp"
+
+#include "lsst/afw/geom.h"
+#include "lsst/afw/math/FunctionLibrary.h"
+#include "lsst/afw/image/Image.h"
+#include "lsst/afw/image/MaskedImage.h"
+#include "lsst/afw/math/Kernel.h"
+#include "lsst/afw/math/ConvolveImage.h"
+
+namespace afwGeom = lsst::afw::geom;
+namespace afwImage = lsst::afw::image;
+namespace afwMath = lsst::afw::math;
+namespace posixTime = boost::posix_time;
+
+typedef float ImageType;
+typedef double KernelType;
+
+const double Sigma = 3;
+const unsigned DefImageSize = 2048;
+const unsigned DefNIter = 3;
+const unsigned KernelSize = 15;
+
+/*
+ * Time convolution of image with kernel for 1, 2, 4, ... maxThreads threads
+ * (wall clock time, since CPU time summed over threads says nothing about scaling)
+ */
+template <class ImageClass>
+void timeConvolution(ImageClass const &image, afwMath::Kernel const &kernel, std::string const &kernelDescr,
+                     unsigned int nIter, int maxThreads) {
+    ImageClass resImage(image.getDimensions());
+
+    std::cout << std::endl << kernelDescr << std::endl;
+    std::cout << "ImWid\tImHt\tKerWid\tKerHt\tThreads\tCnvSec\tSpeedup" << std::endl;
+
+    double serialSecPerIter = 0;
+    for (int nThreads = 1; ; nThreads = std::min(nThreads * 2, maxThreads)) {
+        afwMath::ConvolutionControl convControl;
+        convControl.setNThreads(nThreads);
+
+        posixTime::ptime const startTime = posixTime::microsec_clock::local_time();
+        for (unsigned int iter = 0; iter < nIter; ++iter) {
+            afwMath::convolve(resImage, image, kernel, convControl);
+        }
+        double const secPerIter =
+            (posixTime::microsec_clock::local_time() - startTime).total_microseconds() / (1.0e6 * nIter);
+        if (nThreads == 1) {
+            serialSecPerIter = secPerIter;
+        }
+
+        std::cout << image.getWidth() << "\t" << image.getHeight() << "\t" << kernel.getWidth() << "\t"
+            << kernel.getHeight() << "\t" << nThreads << "\t" << secPerIter << "\t"
+            << serialSecPerIter / secPerIter << std::endl;
+
+        if (nThreads >= maxThreads) break;
+    }
+}
+
+template <class ImageClass>
+void timeAllKernels(ImageClass const &image, unsigned int nIter, int maxThreads) {
+    afwMath::GaussianFunction2<KernelType> gaussFunc2(Sigma, Sigma, 0);
+    afwMath::AnalyticKernel analyticKernel(KernelSize, KernelSize, gaussFunc2);
+    timeConvolution(image, analyticKernel, "Analytic Kernel", nIter, maxThreads);
+
+    afwMath::GaussianFunction1<KernelType> gaussFunc1(Sigma);
+    afwMath::SeparableKernel separableKernel(KernelSize, KernelSize, gaussFunc1, gaussFunc1);
+    timeConvolution(image, separableKernel, "Separable Kernel", nIter, maxThreads);
+}
+
+int main(int argc, char **argv) {
+    unsigned int imSize = DefImageSize;
+    unsigned int nIter = DefNIter;
+    int maxThreads = std::max(static_cast<int>(boost::thread::hardware_concurrency()), 1);
+    if (argc > 1) {
+        std::istringstream(argv[1]) >> imSize;
+    }
+    if (argc > 2) {
+        std::istringstream(argv[2]) >> nIter;
+    }
+    if (argc > 3) {
+        std::istringstream(argv[3]) >> maxThreads;
+    }
+    if (argc > 4 || imSize < KernelSize || maxThreads < 1) {
+        std::cerr << "Time multithreaded convolution with a spatially invariant kernel" << std::endl;
+        std::cerr << "Usage: timeParallelConvolve [imSize [nIter [maxThreads]]]" << std::endl;
+        std::cerr << "imSize (default " << DefImageSize << ") is the width and height of the image" << std::endl;
+        std::cerr << "nIter (default " << DefNIter << ") is the number of iterations per test" << std::endl;
+        std::cerr << "maxThreads (default: number of cores) is the maximum number of threads" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    std::cout << "Timing multithreaded convolution" << std::endl;
+    std::cout << "Columns:" << std::endl;
+    std::cout << "* CnvSec: wall clock time to perform one convolution (sec)" << std::endl;
+    std::cout << "* Speedup: CnvSec for one thread / CnvSec" << std::endl;
+
+    afwImage::MaskedImage<ImageType> mImage(afwGeom::Extent2I(imSize, imSize));
+    for (int y = 0; y != mImage.getHeight(); ++y) {
+        int x = 0;
+        for (afwImage::MaskedImage<ImageType>::x_iterator ptr = mImage.row_begin(y), end = mImage.row_end(y);
+             ptr != end; ++ptr, ++x) {
+            *ptr = afwImage::MaskedImage<ImageType>::SinglePixel(static_cast<double>((x*31 + y*17) % 1000),
+                (x + y) % 2, 10.0);
+        }
+    }
+
+    std::cout << std::endl << "Image " << imSize << " x " << imSize << std::endl;
+    timeAllKernels(*mImage.getImage(), nIter, maxThreads);
+
+    std::cout << std::endl << "MaskedImage " << imSize << " x " << imSize << std::endl;
+    timeAllKernels(mImage, nIter, maxThreads);
+}
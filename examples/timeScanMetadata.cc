@@ -0,0 +1,118 @@
+// -*- LSST-C++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "boost/date_time/posix_time/posix_time.hpp"
+#include "boost/format.hpp"
+
+#include "lsst/daf/base.h"
+#include "lsst/afw/image/MaskedImage.h"
+#include "lsst/afw/image/Utils.h"
+
+namespace afwGeom = lsst::afw::geom;
+namespace afwImage = lsst::afw::image;
+namespace dafBase = lsst::daf::base;
+namespace posixTime = boost::posix_time;
+
+const int DefNFiles = 1000;
+const int DefNThreads = 0;
+
+double secondsSince(posixTime::ptime const &startTime) {
+    return (posixTime::microsec_clock::local_time() - startTime).total_microseconds() / 1.0e6;
+}
+
+int main(int argc, char **argv) {
+    int nFiles = DefNFiles;
+    int nThreads = DefNThreads;
+    if (argc > 1) {
+        std::istringstream(argv[1]) >> nFiles;
+    }
+    if (argc > 2) {
+        std::istringstream(argv[2]) >> nThreads;
+    }
+    if (argc > 3 || nFiles < 1 || nThreads < 0) {
+        std::cerr << "Time reading a few keywords from the headers of many FITS files" << std::endl;
+        std::cerr << "Usage: timeScanMetadata [nFiles [nThreads]]" << std::endl;
+        std::cerr << "nFiles (default " << DefNFiles << ") is the number of files to read" << std::endl;
+        std::cerr << "nThreads (default " << DefNThreads << ") is the number of threads to scan them with;"
+            " 0 for one per core" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    /*
+     * Write small MaskedImages with a realistically large header; their metadata's in the PDU and
+     * the image HDU, and scanMetadata and readMetadata both read the image HDU
+     */
+    afwImage::MaskedImage<float> mi(afwGeom::Extent2I(64, 64));
+    dafBase::PropertySet::Ptr metadata(new dafBase::PropertyList());
+    for (int i = 0; i != 200; ++i) {
+        metadata->set((boost::format("KEY%03d") % i).str(), i);
+    }
+    std::vector<std::string> fileNames;
+    for (int i = 0; i != nFiles; ++i) {
+        metadata->set("EXPTIME", 15.0 + i);
+        metadata->set("FILTER", std::string(1, "ugrizy"[i%6]));
+        fileNames.push_back((boost::format("timeScanMetadata%d.fits") % i).str());
+        mi.writeFits(fileNames.back(), metadata);
+    }
+
+    std::vector<std::string> keys;
+    keys.push_back("EXPTIME");
+    keys.push_back("FILTER");
+
+    std::cout << "Reading EXPTIME and FILTER from " << nFiles << " files (wall clock seconds)" << std::endl;
+    std::cout << "readMetadataSec\tscanMetadataSec\tSpeedup" << std::endl;
+
+    posixTime::ptime startTime = posixTime::microsec_clock::local_time();
+    double sum = 0;
+    for (int i = 0; i != nFiles; ++i) {
+        dafBase::PropertySet::Ptr md = afwImage::readMetadata(fileNames[i]);
+        sum += md->getAsDouble("EXPTIME");
+        md->getAsString("FILTER");
+    }
+    double const readSec = secondsSince(startTime);
+
+    startTime = posixTime::microsec_clock::local_time();
+    std::vector<afwImage::HeaderValues> const values = afwImage::scanMetadata(fileNames, keys, 0, nThreads);
+    double scanSum = 0;
+    for (int i = 0; i != nFiles; ++i) {
+        scanSum += std::atof(values[i].find("EXPTIME")->second.c_str());
+    }
+    double const scanSec = secondsSince(startTime);
+
+    if (scanSum != sum) {
+        std::cerr << "Error: the values scanned differ from those read by readMetadata" << std::endl;
+    }
+    std::cout << readSec << "\t" << scanSec << "\t" << readSec/scanSec << std::endl;
+
+    for (int i = 0; i != nFiles; ++i) {
+        std::remove(fileNames[i].c_str());
+    }
+}
@@ -0,0 +1,130 @@
+// -*- LSST-C++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "boost/date_time/posix_time/posix_time.hpp"
+
+#include "lsst/afw/math/warpExposure.h"
+
+namespace afwMath = lsst::afw::math;
+namespace posixTime = boost::posix_time;
+
+const unsigned DefNIter = 1000000;
+const int CacheSize = 10000;    // the cache size used by lsst.afw.math.Warper
+const int OrderList[] = {2, 3, 4, 5};
+const char *ModeNameList[] = {"exact", "cache", "table"};
+enum Mode {EXACT = 0, CACHE, TABLE};
+
+/*
+ * Compute the kernel vectors nIter times at a sequence of fractional pixel offsets
+ * and return the time per call (sec); also return the maximum error with respect to exactKernel
+ */
+double timeKernel(afwMath::LanczosWarpingKernel &kernel, afwMath::LanczosWarpingKernel &exactKernel,
+                  unsigned int nIter, double &maxErr) {
+    std::vector<double> colList(kernel.getWidth());
+    std::vector<double> rowList(kernel.getHeight());
+    std::vector<double> exactColList(kernel.getWidth());
+    std::vector<double> exactRowList(kernel.getHeight());
+    std::vector<double> params(2);
+
+    double sum = 0; // prevent the compiler from eliminating the loop
+    posixTime::ptime const startTime = posixTime::microsec_clock::local_time();
+    for (unsigned int iter = 0; iter < nIter; ++iter) {
+        params[0] = std::fmod(iter * 0.6180339887, 1.0);
+        params[1] = std::fmod(iter * 0.4142135624, 1.0);
+        kernel.setKernelParameters(params);
+        sum += kernel.computeVectors(colList, rowList, false);
+    }
+    double const secPerIter =
+        (posixTime::microsec_clock::local_time() - startTime).total_microseconds() / (1.0e6 * nIter);
+
+    maxErr = 0;
+    for (unsigned int iter = 0; iter < std::min(nIter, 10000U); ++iter) {
+        params[0] = std::fmod(iter * 0.6180339887, 1.0);
+        params[1] = std::fmod(iter * 0.4142135624, 1.0);
+        kernel.setKernelParameters(params);
+        exactKernel.setKernelParameters(params);
+        kernel.computeVectors(colList, rowList, false);
+        exactKernel.computeVectors(exactColList, exactRowList, false);
+        for (int i = 0; i < kernel.getWidth(); ++i) {
+            maxErr = std::max(maxErr, std::fabs(colList[i] - exactColList[i]));
+        }
+        for (int i = 0; i < kernel.getHeight(); ++i) {
+            maxErr = std::max(maxErr, std::fabs(rowList[i] - exactRowList[i]));
+        }
+    }
+    if (sum == 0) {
+        std::cerr << "unexpected sum" << std::endl;
+    }
+    return secPerIter;
+}
+
+int main(int argc, char **argv) {
+    unsigned int nIter = DefNIter;
+    if (argc > 1) {
+        std::istringstream(argv[1]) >> nIter;
+    }
+    if (argc > 2 || nIter < 1) {
+        std::cerr << "Time computing Lanczos warping kernels exactly, from a nearest-bin cache"
+            << " and from an interpolated lookup table" << std::endl;
+        std::cerr << "Usage: timeWarpingKernel [nIter]" << std::endl;
+        std::cerr << "nIter (default " << DefNIter << ") is the number of kernels computed per test"
+            << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    std::cout << "Timing LanczosWarpingKernel.computeVectors" << std::endl;
+    std::cout << "Columns:" << std::endl;
+    std::cout << "* Mode: exact = evaluate the Lanczos function; cache = nearest-bin cache of size "
+        << CacheSize << "; table = interpolated lookup table (the default)" << std::endl;
+    std::cout << "* Sec: time to compute one kernel (sec)" << std::endl;
+    std::cout << "* Speedup: Sec for exact / Sec" << std::endl;
+    std::cout << "* MaxErr: maximum error of any kernel element with respect to exact" << std::endl;
+    std::cout << std::endl << "Order\tMode\tSec\tSpeedup\tMaxErr" << std::endl;
+
+    for (unsigned int i = 0; i < sizeof(OrderList) / sizeof(OrderList[0]); ++i) {
+        int const order = OrderList[i];
+        afwMath::LanczosWarpingKernel exactKernel(order, false);
+        double exactSecPerIter = 0;
+        for (int mode = EXACT; mode <= TABLE; ++mode) {
+            afwMath::LanczosWarpingKernel kernel(order, mode == TABLE);
+            if (mode == CACHE) {
+                kernel.computeCache(CacheSize);
+            }
+            double maxErr;
+            double const secPerIter = timeKernel(kernel, exactKernel, nIter, maxErr);
+            if (mode == EXACT) {
+                exactSecPerIter = secPerIter;
+            }
+            std::cout << order << "\t" << ModeNameList[mode] << "\t" << secPerIter << "\t"
+                << exactSecPerIter / secPerIter << "\t" << maxErr << std::endl;
+        }
+    }
+}
@@ -30,13 +30,16 @@
 #include "lsst/afw/detection/Threshold.h"
 #include "lsst/afw/detection/FootprintFunctor.h"
 #include "lsst/afw/detection/FootprintSet.h"
+#include "lsst/afw/detection/FootprintIndex.h"
 #include "lsst/afw/detection/FootprintArray.h"
 #include "lsst/afw/detection/Footprint.h"
 #include "lsst/afw/detection/Peak.h"
 #include "lsst/afw/detection/Source.h"
+#include "lsst/afw/detection/SourceCatalog.h"
 #include "lsst/afw/detection/DiaSource.h"
 #include "lsst/afw/detection/LocalPsf.h"
 #include "lsst/afw/detection/Psf.h"
 #include "lsst/afw/detection/SourceMatch.h"
+#include "lsst/afw/detection/SourceSkyIndex.h"
 
 #endif
@@ -35,6 +35,7 @@
 #include <cmath>
 #include <boost/cstdint.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/serialization/version.hpp>
 #include "lsst/ndarray.h"
 #include "lsst/base.h"
 #include "lsst/pex/policy/Policy.h"
@@ -69,6 +70,7 @@ public:
          int x0,                        //!< Starting column (inclusive)
          int x1)                        //!< Ending column (inclusive)
         : _y(y), _x0(x0), _x1(x1) {}    
+    Span() : _y(0), _x0(0), _x1(-1) {}  ///< An empty Span, for use by containers
     ~Span() {}
 
     int getX0() const { return _x0; }         ///< Return the starting x-value
@@ -82,8 +84,6 @@ public:
 
     friend class Footprint;
 private:
-    Span() {}
-
     friend class boost::serialization::access;
     template <typename Archive>
     void serialize(Archive & ar, const unsigned int version) {
@@ -110,7 +110,9 @@ public:
     typedef boost::shared_ptr<Footprint> Ptr;
     typedef boost::shared_ptr<const Footprint> ConstPtr;
 
-    /// The Footprint's Span list
+    /// The Footprint's Spans, stored contiguously by value
+    typedef std::vector<Span> SpanVector;
+    /// A list of pointers to Spans, as returned by getSpans()
     typedef std::vector<Span::Ptr> SpanList;
     typedef std::vector<PTR(Peak)> PeakList;
 
@@ -119,13 +121,24 @@ public:
     Footprint(geom::Point2I const & center, double const radius, geom::Box2I const & = geom::Box2I());
     explicit Footprint(geom::ellipses::Ellipse const & ellipse, geom::Box2I const & region=geom::Box2I());
 
+    explicit Footprint(SpanVector const & spans, geom::Box2I const & region=geom::Box2I());
     explicit Footprint(SpanList const & spans, geom::Box2I const & region=geom::Box2I());
     Footprint(Footprint const & other);    
     ~Footprint();
 
     int getId() const { return _fid; }   //!< Return the Footprint's unique ID
-    SpanList& getSpans() { return _spans; } //!< return the Span%s contained in this Footprint
-    const SpanList& getSpans() const { return _spans; } //!< return the Span%s contained in this Footprint
+    /// Return the Span%s contained in this Footprint
+    SpanVector const & getSpanVector() const { return _spans; }
+    SpanList const & getSpans() const;
+    /**
+     * Return the Span%s contained in this Footprint as a list of pointers
+     *
+     * @deprecated Use getSpanVector() instead.  The list is the one returned by the const getSpans(), so
+     * modifying it (or the Spans that it points to) doesn't modify the Footprint
+     */
+    SpanList & getSpans() {
+        return const_cast<SpanList &>(static_cast<Footprint const *>(this)->getSpans());
+    }
     PeakList & getPeaks() { return _peaks; } //!< Return the Peak%s contained in this Footprint
     const PeakList & getPeaks() const { return _peaks; } //!< Return the Peak%s contained in this Footprint
     int getNpix() const { return _area; }     //!< Return the number of pixels in this Footprint
@@ -179,7 +192,9 @@ private:
     mutable int _fid;                    //!< unique ID
     int _area;                           //!< number of pixels in this Footprint
      
-    SpanList _spans;                     //!< the Spans contained in this Footprint
+    SpanVector _spans;                   //!< the Spans contained in this Footprint
+    mutable SpanList _spanList;          //!< copies of _spans, made on demand by getSpans()
+    mutable bool _spanListIsValid;       //!< does _spanList reflect the current _spans?
     geom::Box2I _bbox;                   //!< the Footprint's bounding box
     PeakList _peaks;                     //!< the Peaks lying in this footprint
     mutable geom::Box2I _region;         //!< The corners of the MaskedImage the footprints live in
@@ -230,4 +245,9 @@ Footprint::Ptr footprintAndMask(Footprint::Ptr const&  foot,
 
 }}}
 
+#ifndef SWIG
+// version 0 archives stored the Spans as a vector of shared_ptr
+BOOST_CLASS_VERSION(lsst::afw::detection::Footprint, 1)
+#endif
+
 #endif
@@ -89,10 +89,10 @@ void flattenArray(
     }
 
     typename DestT::Iterator destIter(dest.begin());
-    for (Footprint::SpanList::const_iterator s = fp.getSpans().begin(); 
-         s != fp.getSpans().end(); ++s
+    for (Footprint::SpanVector::const_iterator s = fp.getSpanVector().begin(); 
+         s != fp.getSpanVector().end(); ++s
     ) {
-        Span const & span = **s;
+        Span const & span = *s;
         typename SourceT::Reference row(src[span.getY() - origin.getY()]);
         std::copy(
             row.begin() + span.getX0() - origin.getX(),
@@ -176,10 +176,10 @@ void expandArray(
     }
 
     typename SourceT::Iterator srcIter(src.begin());
-    for (Footprint::SpanList::const_iterator s = fp.getSpans().begin(); 
-        s != fp.getSpans().end(); ++s
+    for (Footprint::SpanVector::const_iterator s = fp.getSpanVector().begin(); 
+        s != fp.getSpanVector().end(); ++s
     ) {
-        Span const & span = **s;
+        Span const & span = *s;
         typename DestT::Reference row(dest[span.getY() - origin.getY()]);
         std::copy(srcIter, srcIter + span.getWidth(), row.begin() + span.getX0() - origin.getX());
         srcIter += span.getWidth();
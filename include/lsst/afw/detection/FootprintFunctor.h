@@ -60,7 +60,7 @@ public:
         reset();
         reset(foot);
 
-        if (foot.getSpans().empty()) {
+        if (foot.getSpanVector().empty()) {
             return;
         }
 
@@ -80,7 +80,7 @@ public:
             );
         }
 
-        // Current position of the locator (in the SpanList loop)
+        // Current position of the locator (in the Span loop)
         int ox1 = 0, oy = 0;            
         
         typename ImageT::xy_locator loc = _image.xy_at(
@@ -89,16 +89,16 @@ public:
 
         int const width = _image.getWidth();
         int const height = _image.getHeight();
-        for (Footprint::SpanList::const_iterator siter = foot.getSpans().begin();
-             siter != foot.getSpans().end(); siter++) {
-            Span::Ptr const span = *siter;
+        for (Footprint::SpanVector::const_iterator siter = foot.getSpanVector().begin();
+             siter != foot.getSpanVector().end(); siter++) {
+            Span const& span = *siter;
 
-            int const y = span->getY();
+            int const y = span.getY();
             if (y < margin || y >= height - margin) {
                 continue;
             }
-            int x0 = span->getX0();
-            int x1 = span->getX1();
+            int x0 = span.getX0();
+            int x1 = span.getX1();
             if (x0 < margin) {
                 x0 = margin;
             }
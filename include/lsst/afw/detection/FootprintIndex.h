@@ -0,0 +1,90 @@
+// -*- LSST-C++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#if !defined(LSST_AFW_DETECTION_FOOTPRINTINDEX_H)
+#define LSST_AFW_DETECTION_FOOTPRINTINDEX_H
+/**
+ * \file
+ * \brief A spatial index over a list of Footprint%s
+ */
+#include <vector>
+#include "boost/shared_ptr.hpp"
+#include "lsst/afw/geom.h"
+#include "lsst/afw/detection/Footprint.h"
+
+namespace lsst {
+namespace afw {
+namespace detection {
+
+/**
+ * \brief A spatial index over a list of Footprint%s (e.g. those of a FootprintSet), supporting fast
+ * point, box and nearest-Footprint queries
+ *
+ * The index is a packed R-tree over the Footprints' bounding boxes, so a query costs O(log n) plus
+ * the number of bounding boxes that match; the matching Footprints are then checked pixel by pixel,
+ * using a binary search over the rows of normalized Footprints.
+ *
+ * The index holds pointers to the Footprints, but doesn't notice if they, or the list they came from,
+ * are later modified; make a new index if they are.
+ *
+ * \code
+    detection::FootprintIndex index(*fs.getFootprints());
+    detection::Footprint::Ptr foot = index.findContaining(geom::Point2I(x, y));
+ * \endcode
+ */
+class FootprintIndex {
+public:
+    typedef boost::shared_ptr<FootprintIndex> Ptr;
+    typedef boost::shared_ptr<FootprintIndex const> ConstPtr;
+    /// A list of Footprint%s, as found in a FootprintSet
+    typedef std::vector<Footprint::Ptr> FootprintList;
+
+    explicit FootprintIndex(FootprintList const& footprints, int const nodeCapacity=16);
+
+    /// Return the number of Footprints in the index
+    int getSize() const { return _footprints.size(); }
+
+    Footprint::Ptr findContaining(geom::Point2I const& pix) const;
+    FootprintList findOverlapping(geom::Box2I const& box) const;
+    Footprint::Ptr findNearest(geom::Point2D const& point) const;
+
+private:
+    /// A node of the R-tree; its children are [begin, end) in the level below (or _order, for leaves)
+    struct Node {
+        Node(geom::Box2I const& bbox_, int begin_, int end_) : bbox(bbox_), begin(begin_), end(end_) {}
+
+        geom::Box2I bbox;               ///< the bounding box of all the node's children
+        int begin, end;                 ///< range of the node's children
+    };
+
+    void _findCandidates(geom::Box2I const& box, std::vector<int> *candidates) const;
+
+    FootprintList _footprints;          ///< the indexed Footprints
+    std::vector<int> _order;            ///< indices of the non-empty Footprints, in leaf order
+    std::vector<std::vector<Node> > _levels; ///< the R-tree's nodes, from the root down to the leaves
+};
+
+}}}
+
+#endif
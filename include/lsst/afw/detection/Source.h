@@ -226,6 +226,8 @@ inline bool operator!=(Source const & lhs, Source const & rhs) {
 
 
 typedef std::vector<Source::Ptr> SourceSet;
+
+class SourceCatalog;
  
 class PersistableSourceVector : public lsst::daf::base::Persistable {
 public:
@@ -233,6 +235,7 @@ public:
     PersistableSourceVector() {}
     PersistableSourceVector(SourceSet const & sources)
         : _sources(sources) {}
+    explicit PersistableSourceVector(SourceCatalog const & catalog);
     ~PersistableSourceVector(){_sources.clear();}
         
     SourceSet getSources() const {return _sources; }
@@ -0,0 +1,192 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/** @file
+  * @brief A column-oriented view of a SourceSet
+  * @ingroup afw
+  */
+#ifndef LSST_AFW_DETECTION_SOURCECATALOG_H
+#define LSST_AFW_DETECTION_SOURCECATALOG_H
+
+#include <vector>
+
+#include "boost/cstdint.hpp"
+#include "boost/shared_ptr.hpp"
+
+#include "lsst/afw/detection/Source.h"
+#include "lsst/afw/geom/Angle.h"
+
+namespace lsst { namespace afw { namespace detection {
+
+class SourceCatalog;
+
+/**
+ * @brief One row of a SourceCatalog
+ *
+ * A row is a lightweight view (a catalog and an index) that reads the catalog's columns in place.
+ * Its accessors have the same names and types as those of Source; fields the catalog doesn't hold
+ * as columns are available from the Source the row was made from, via getSource().
+ *
+ * A row is only valid as long as its catalog is neither destroyed nor appended to.
+ */
+class SourceRow {
+public:
+    SourceRow(SourceCatalog const &catalog, int index) : _catalog(&catalog), _index(index) {}
+
+    /// Return the index of this row in its catalog
+    int getIndex() const { return _index; }
+    inline Source::Ptr const &getSource() const;
+
+    inline boost::int64_t getId() const;
+    inline boost::int64_t getSourceId() const;
+    inline lsst::afw::geom::Angle getRa() const;
+    inline lsst::afw::geom::Angle getDec() const;
+    inline double getXAstrom() const;
+    inline double getYAstrom() const;
+    inline double getPsfFlux() const;
+    inline float  getPsfFluxErr() const;
+    inline double getApFlux() const;
+    inline float  getApFluxErr() const;
+    inline double getModelFlux() const;
+    inline float  getModelFluxErr() const;
+    inline double getInstFlux() const;
+    inline float  getInstFluxErr() const;
+    inline float  getIxx() const;
+    inline float  getIyy() const;
+    inline float  getIxy() const;
+    inline boost::int64_t getFlagForDetection() const;
+
+private:
+    SourceCatalog const *_catalog;
+    int _index;
+};
+
+/**
+ * @brief A catalog of sources, holding their most frequently used fields as contiguous columns
+ *
+ * Code that makes a pass over many sources but only needs a few fields (matching, selecting on flux
+ * or flags, extracting columns for Python) reads the columns rather than following a pointer to each
+ * separately allocated Source.  The catalog also keeps the Source::Ptr each row was made from, so
+ * converting back to a SourceSet (getSources()) copies nothing, and every field of a row remains
+ * available through SourceRow::getSource().
+ *
+ * The columns are a snapshot of the sources' fields when they were added to the catalog; if the
+ * sources are later modified, make a new catalog.
+ *
+ * @code
+    detection::SourceCatalog cat(sourceSet);
+    std::vector<double> const &flux = cat.getPsfFluxColumn();
+    std::vector<detection::SourceMatch> matches = detection::matchRaDec(cat, refCat, radius);
+ * @endcode
+ */
+class SourceCatalog {
+public:
+    typedef boost::shared_ptr<SourceCatalog> Ptr;
+    typedef boost::shared_ptr<SourceCatalog const> ConstPtr;
+    typedef SourceRow Row;
+
+    SourceCatalog() {}
+    explicit SourceCatalog(SourceSet const &set);
+
+    void reserve(int n);
+    void append(Source::Ptr const &source);
+
+    /// Return the number of sources in the catalog
+    int size() const { return _sources.size(); }
+    /// Return true if the catalog has no sources
+    bool empty() const { return _sources.empty(); }
+
+    /// Return row i (not range checked)
+    SourceRow operator[](int i) const { return SourceRow(*this, i); }
+    /// Return the Source that row i was made from (not range checked)
+    Source::Ptr const &getSource(int i) const { return _sources[i]; }
+    /// Return the sources, in row order
+    SourceSet const &getSources() const { return _sources; }
+
+    std::vector<boost::int64_t> const &getIdColumn() const { return _id; }                ///< ids
+    std::vector<double> const &getRaColumn() const { return _ra; }                        ///< ra (radians)
+    std::vector<double> const &getDecColumn() const { return _dec; }                      ///< dec (radians)
+    std::vector<double> const &getXAstromColumn() const { return _xAstrom; }              ///< x (pixels)
+    std::vector<double> const &getYAstromColumn() const { return _yAstrom; }              ///< y (pixels)
+    std::vector<double> const &getPsfFluxColumn() const { return _psfFlux; }              ///< PSF fluxes
+    std::vector<float> const &getPsfFluxErrColumn() const { return _psfFluxErr; }         ///< their errors
+    std::vector<double> const &getApFluxColumn() const { return _apFlux; }                ///< aperture fluxes
+    std::vector<float> const &getApFluxErrColumn() const { return _apFluxErr; }           ///< their errors
+    std::vector<double> const &getModelFluxColumn() const { return _modelFlux; }          ///< model fluxes
+    std::vector<float> const &getModelFluxErrColumn() const { return _modelFluxErr; }     ///< their errors
+    std::vector<double> const &getInstFluxColumn() const { return _instFlux; }            ///< inst fluxes
+    std::vector<float> const &getInstFluxErrColumn() const { return _instFluxErr; }       ///< their errors
+    std::vector<float> const &getIxxColumn() const { return _ixx; }                       ///< second moments
+    std::vector<float> const &getIyyColumn() const { return _iyy; }                       ///< second moments
+    std::vector<float> const &getIxyColumn() const { return _ixy; }                       ///< second moments
+    /// detection flags
+    std::vector<boost::int64_t> const &getFlagForDetectionColumn() const { return _flagForDetection; }
+
+private:
+    friend class SourceRow;
+
+    SourceSet _sources;                 ///< the sources the rows were made from
+    std::vector<boost::int64_t> _id;
+    std::vector<double> _ra, _dec;
+    std::vector<double> _xAstrom, _yAstrom;
+    std::vector<double> _psfFlux;
+    std::vector<float> _psfFluxErr;
+    std::vector<double> _apFlux;
+    std::vector<float> _apFluxErr;
+    std::vector<double> _modelFlux;
+    std::vector<float> _modelFluxErr;
+    std::vector<double> _instFlux;
+    std::vector<float> _instFluxErr;
+    std::vector<float> _ixx, _iyy, _ixy;
+    std::vector<boost::int64_t> _flagForDetection;
+};
+
+Source::Ptr const &SourceRow::getSource() const { return _catalog->_sources[_index]; }
+
+boost::int64_t SourceRow::getId() const { return _catalog->_id[_index]; }
+boost::int64_t SourceRow::getSourceId() const { return _catalog->_id[_index]; }
+lsst::afw::geom::Angle SourceRow::getRa() const {
+    return _catalog->_ra[_index] * lsst::afw::geom::radians;
+}
+lsst::afw::geom::Angle SourceRow::getDec() const {
+    return _catalog->_dec[_index] * lsst::afw::geom::radians;
+}
+double SourceRow::getXAstrom() const { return _catalog->_xAstrom[_index]; }
+double SourceRow::getYAstrom() const { return _catalog->_yAstrom[_index]; }
+double SourceRow::getPsfFlux() const { return _catalog->_psfFlux[_index]; }
+float  SourceRow::getPsfFluxErr() const { return _catalog->_psfFluxErr[_index]; }
+double SourceRow::getApFlux() const { return _catalog->_apFlux[_index]; }
+float  SourceRow::getApFluxErr() const { return _catalog->_apFluxErr[_index]; }
+double SourceRow::getModelFlux() const { return _catalog->_modelFlux[_index]; }
+float  SourceRow::getModelFluxErr() const { return _catalog->_modelFluxErr[_index]; }
+double SourceRow::getInstFlux() const { return _catalog->_instFlux[_index]; }
+float  SourceRow::getInstFluxErr() const { return _catalog->_instFluxErr[_index]; }
+float  SourceRow::getIxx() const { return _catalog->_ixx[_index]; }
+float  SourceRow::getIyy() const { return _catalog->_iyy[_index]; }
+float  SourceRow::getIxy() const { return _catalog->_ixy[_index]; }
+boost::int64_t SourceRow::getFlagForDetection() const { return _catalog->_flagForDetection[_index]; }
+
+}}} // namespace lsst::afw::detection
+
+#endif // #ifndef LSST_AFW_DETECTION_SOURCECATALOG_H
@@ -34,6 +34,7 @@
 #include "boost/tuple/tuple.hpp"
 
 #include "lsst/afw/detection/Source.h"
+#include "lsst/afw/detection/SourceCatalog.h"
 #include "lsst/daf/base/Persistable.h"
 #include "lsst/daf/base/PropertySet.h"
 #include "lsst/afw/geom/Angle.h"
@@ -58,11 +59,21 @@ struct SourceMatch {
 };
 
 std::vector<SourceMatch> matchRaDec(SourceSet const &set1, SourceSet const &set2,
-                                    lsst::afw::geom::Angle radius, bool closest=true);
-std::vector<SourceMatch> matchRaDec(SourceSet const &set, lsst::afw::geom::Angle radius, bool symmetric = true);
+                                    lsst::afw::geom::Angle radius, bool closest=true, int nThreads=1);
+std::vector<SourceMatch> matchRaDec(SourceSet const &set, lsst::afw::geom::Angle radius,
+                                    bool symmetric = true, int nThreads=1);
 std::vector<SourceMatch> matchXy(SourceSet const &set1, SourceSet const &set2,
-                                 double radius, bool closest=true);
-std::vector<SourceMatch> matchXy(SourceSet const &set, double radius, bool symmetric = true);
+                                 double radius, bool closest=true, int nThreads=1);
+std::vector<SourceMatch> matchXy(SourceSet const &set, double radius, bool symmetric = true, int nThreads=1);
+
+std::vector<SourceMatch> matchRaDec(SourceCatalog const &cat1, SourceCatalog const &cat2,
+                                    lsst::afw::geom::Angle radius, bool closest=true, int nThreads=1);
+std::vector<SourceMatch> matchRaDec(SourceCatalog const &cat, lsst::afw::geom::Angle radius,
+                                    bool symmetric = true, int nThreads=1);
+std::vector<SourceMatch> matchXy(SourceCatalog const &cat1, SourceCatalog const &cat2,
+                                 double radius, bool closest=true, int nThreads=1);
+std::vector<SourceMatch> matchXy(SourceCatalog const &cat, double radius, bool symmetric = true,
+                                 int nThreads=1);
 
 
 typedef std::vector<SourceMatch> SourceMatchVector;
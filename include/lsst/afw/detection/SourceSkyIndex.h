@@ -0,0 +1,112 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/** @file
+  * @brief A reusable spatial index over the sky positions of a set of sources
+  * @ingroup afw
+  */
+#ifndef LSST_AFW_DETECTION_SOURCESKYINDEX_H
+#define LSST_AFW_DETECTION_SOURCESKYINDEX_H
+
+#include <utility>
+#include <vector>
+
+#include "boost/shared_ptr.hpp"
+
+#include "lsst/afw/detection/Source.h"
+#include "lsst/afw/detection/SourceCatalog.h"
+#include "lsst/afw/detection/SourceMatch.h"
+#include "lsst/afw/geom/Angle.h"
+
+namespace lsst { namespace afw { namespace detection {
+
+/**
+ * @brief An index over the (ra, dec) positions of a SourceSet or SourceCatalog, for matching other
+ * sources against it
+ *
+ * The positions are converted to unit vectors and stored in a k-d tree, so the cost of a query
+ * depends only on the number of sources near the query position: unlike a scan of a band in
+ * declination it doesn't degrade near the poles or for large radii.  An index is built once and
+ * may be queried any number of times, and from several threads at once.
+ *
+ * The matches returned are identical, in content and order, to those of the declination-band
+ * algorithm previously used by matchRaDec (which is now implemented using a SourceSkyIndex).
+ * Sources whose ra or dec is NaN are not indexed, and never match.
+ */
+class SourceSkyIndex {
+public:
+    typedef boost::shared_ptr<SourceSkyIndex> Ptr;
+    typedef boost::shared_ptr<SourceSkyIndex const> ConstPtr;
+
+    explicit SourceSkyIndex(SourceSet const &set, int leafSize=8);
+    explicit SourceSkyIndex(SourceCatalog const &catalog, int leafSize=8);
+
+    /// Return the number of sources in the index
+    int getSize() const { return _sources.size(); }
+
+    Source::Ptr findClosest(lsst::afw::geom::Angle ra, lsst::afw::geom::Angle dec,
+                            lsst::afw::geom::Angle radius) const;
+    SourceSet findWithin(lsst::afw::geom::Angle ra, lsst::afw::geom::Angle dec,
+                         lsst::afw::geom::Angle radius) const;
+
+    std::vector<SourceMatch> match(SourceSet const &set, lsst::afw::geom::Angle radius,
+                                   bool closest=true, int nThreads=1) const;
+    std::vector<SourceMatch> match(SourceCatalog const &catalog, lsst::afw::geom::Angle radius,
+                                   bool closest=true, int nThreads=1) const;
+    std::vector<SourceMatch> matchSelf(lsst::afw::geom::Angle radius,
+                                       bool symmetric=true, int nThreads=1) const;
+
+private:
+    /// The position of a source to be indexed or matched
+    struct Position;
+    /// The position of an indexed source
+    struct Entry {
+        double x, y, z;                 ///< unit vector
+        double dec;                     ///< declination (radians)
+        int index;                      ///< index into _sources
+    };
+    /// A node of the k-d tree; a leaf if left < 0
+    struct Node {
+        double min[3], max[3];          ///< bounding box of the node's unit vectors
+        int begin, end;                 ///< range of _entries in the node
+        int left, right;                ///< indices of children in _nodes
+    };
+    class Query;
+    class MatchBand;
+
+    static void _makePositions(SourceSet const &set, std::vector<Position> &positions);
+    static void _makePositions(SourceCatalog const &catalog, std::vector<Position> &positions);
+    void _initialize(std::vector<Position> const &positions, int leafSize);
+    int _build(int begin, int end, int leafSize);
+    std::vector<SourceMatch> _match(std::vector<Position> const &positions, lsst::afw::geom::Angle radius,
+                                    bool closest, bool self, bool symmetric, int nThreads) const;
+
+    std::vector<Source::Ptr> _sources;  ///< the indexed sources, sorted by declination
+    std::vector<Entry> _entries;        ///< the sources' positions, in the order of the k-d tree
+    std::vector<Node> _nodes;           ///< the k-d tree; _nodes[0] is the root
+};
+
+}}} // namespace lsst::afw::detection
+
+#endif // #ifndef LSST_AFW_DETECTION_SOURCESKYINDEX_H
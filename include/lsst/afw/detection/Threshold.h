@@ -63,7 +63,7 @@ public:
         double const value,
         ThresholdType const type = VALUE,
         bool const polarity = true
-    ) : _value(value), _type(type), _polarity(polarity) {}
+    ) : _value(value), _type(type), _polarity(polarity), _nThreads(1) {}
 
     //! return type of threshold
     ThresholdType getType() const { return _type; }
@@ -88,10 +88,16 @@ public:
 
     /// return Threshold's polarity
     bool getPolarity() const { return _polarity; }
+
+    /// return the number of threads that detection may use; 0 for one per core
+    int getNThreads() const { return _nThreads; }
+    /// set the number of threads that detection may use; 0 for one per core
+    void setNThreads(int nThreads) { _nThreads = nThreads; }
 private:
     double _value;                      //!< value of threshold, to be interpreted via _type
     ThresholdType _type;                //!< type of threshold
     bool _polarity;                     //!< true for positive polarity, false for negative
+    int _nThreads;                      //!< number of threads to use when searching an image
 };
 
 // brief Factory method for creating Threshold objects
@@ -34,6 +34,7 @@
 #include "lsst/afw/image/Exposure.h"    // Exposure.h brings in almost everything
 #include "lsst/afw/image/ImageAlgorithm.h"
 #include "lsst/afw/image/ImagePca.h"
+#include "lsst/afw/image/ImagePrefetcher.h"
 #include "lsst/afw/image/ImageUtils.h"
 #include "lsst/afw/image/ImageSlice.h"
 
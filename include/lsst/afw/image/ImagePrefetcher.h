@@ -0,0 +1,140 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/** @file
+  * @brief Read a list of MaskedImages or Exposures from FITS files ahead of their use
+  * @ingroup afw
+  */
+#ifndef LSST_AFW_IMAGE_IMAGEPREFETCHER_H
+#define LSST_AFW_IMAGE_IMAGEPREFETCHER_H
+
+#include <string>
+#include <vector>
+
+#include "boost/function.hpp"
+#include "boost/noncopyable.hpp"
+#include "boost/thread.hpp"
+
+#include "lsst/daf/base/PropertySet.h"
+#include "lsst/afw/geom.h"
+#include "lsst/afw/image/Image.h"
+
+namespace lsst { namespace afw { namespace image {
+
+/**
+ * @brief Where to read an image from: a file, an HDU, and (optionally) a bounding box
+ *
+ * The arguments are those of the MaskedImage and Exposure FITS constructors.
+ */
+struct PrefetchRequest {
+    explicit PrefetchRequest(std::string const& fileName_="", int hdu_=0,
+                             geom::Box2I const& bbox_=geom::Box2I(), ImageOrigin origin_=LOCAL) :
+        fileName(fileName_), hdu(hdu_), bbox(bbox_), origin(origin_) {}
+
+    static PrefetchRequest fromAdditionalData(std::string const& fileName,
+                                              lsst::daf::base::PropertySet::ConstPtr additionalData);
+
+    std::string fileName;               ///< file to read
+    int hdu;                            ///< HDU to read (0: the first with data)
+    geom::Box2I bbox;                   ///< the pixels to read; empty for the whole image
+    ImageOrigin origin;                 ///< coordinate system of bbox
+};
+
+/**
+ * @brief Read a list of images (MaskedImages or Exposures) from FITS files on background threads,
+ * ahead of their use
+ *
+ * A pipeline driver that processes one image after another usually waits for each to be read before it
+ * can start work on it.  An ImagePrefetcher reads the next few images while the caller processes the
+ * current one, and hands them back, in the order requested, from next():
+ *
+ * @code
+    std::vector<image::PrefetchRequest> requests;
+    ...
+    image::ImagePrefetcher<image::Exposure<float> > prefetcher(requests, 2);
+    while (prefetcher.hasNext()) {
+        image::Exposure<float>::Ptr exposure = prefetcher.next();
+        ...
+    }
+ * @endcode
+ *
+ * At most nAhead images are read but not yet returned by next() (including those being read), so the
+ * memory used is bounded by nAhead images as well as the one the caller is using.
+ *
+ * By default images are read with the MaskedImage or Exposure FITS constructor (so through fits_reader,
+ * exactly as they would be if the caller read them itself); pass a Reader to read them some other way.
+ * PrefetchRequest::fromAdditionalData interprets the additionalData that ExposureFormatter is given, so
+ * a driver can prefetch what it would otherwise read through the persistence framework.
+ *
+ * @note cfitsio is only safe to call from more than one thread at a time if it was built to be reentrant;
+ * if it wasn't, only one image is read at a time (whatever nThreads is), and the caller mustn't read or
+ * write FITS files itself while the prefetcher is reading.  Reading an Exposure also parses its WCS with
+ * wcslib, whose header parser isn't reentrant; Wcs serialises its own calls to it, but the caller mustn't
+ * parse WCS headers with wcslib directly (i.e. other than by making a Wcs) while the prefetcher is running.
+ * Reading a Mask may add planes to the mask plane dictionary (as it would on the caller's thread); the
+ * dictionary is locked while it's changed, but the caller shouldn't assume that it's unchanged between
+ * calls while the prefetcher is running.  Reading an Exposure also looks up its Filter, so the caller
+ * mustn't define Filters or aliases while the prefetcher is running.
+ */
+template <typename ImageT>
+class ImagePrefetcher : private boost::noncopyable {
+public:
+    typedef typename ImageT::Ptr ImagePtr;
+    typedef boost::function<ImagePtr (PrefetchRequest const&)> Reader;
+
+    explicit ImagePrefetcher(std::vector<PrefetchRequest> const& requests, int nAhead=2, int nThreads=1,
+                             Reader const& reader=Reader());
+    explicit ImagePrefetcher(std::vector<std::string> const& fileNames, int nAhead=2, int nThreads=1);
+    ~ImagePrefetcher();
+
+    /// Return the number of images requested
+    int size() const { return _requests.size(); }
+    bool hasNext() const;
+    ImagePtr next();
+
+    static ImagePtr read(PrefetchRequest const& request);
+
+private:
+    void _start(int nAhead, int nThreads);
+    void _readImages();
+
+    std::vector<PrefetchRequest> _requests;
+    Reader _reader;
+    std::size_t _nAhead;                ///< maximum number of images read but not yet returned
+
+    mutable boost::mutex _mutex;        ///< protects everything below
+    boost::condition_variable _readCond;  ///< signalled when an image has been read
+    boost::condition_variable _spaceCond; ///< signalled when an image has been returned, or on exit
+    std::size_t _nextToRead;            ///< index of the next request to start reading
+    std::size_t _nextToReturn;          ///< index of the next image to return from next()
+    bool _stop;                         ///< the threads should exit as soon as they can
+    std::vector<ImagePtr> _images;      ///< images read but not yet returned
+    std::vector<std::string> _errors;   ///< why reading each image failed, if it did
+    std::vector<bool> _isRead;          ///< has each image been read (or failed to be)?
+    boost::thread_group _threads;
+};
+
+}}} // namespace lsst::afw::image
+
+#endif // #ifndef LSST_AFW_IMAGE_IMAGEPREFETCHER_H
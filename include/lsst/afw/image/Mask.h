@@ -58,7 +58,12 @@ namespace detail {
     struct Mask_tag : public detail::basic_tag { };
 }
 
-/// Represent a 2-dimensional array of bitmask pixels
+/**
+ * @brief Represent a 2-dimensional array of bitmask pixels
+ *
+ * The mask plane dictionary is shared by all Masks with the same pixel type; access to it is serialised,
+ * so Masks may be made (e.g. read from files) on more than one thread at once.
+ */
 template<typename MaskPixelT=lsst::afw::image::MaskPixel>
 class Mask : public ImageBase<MaskPixelT> {
 public:
@@ -132,7 +137,7 @@ public:
     explicit Mask(lsst::ndarray::Array<MaskPixelT,2,1> const & array, bool deep = false,
                    geom::Point2I const & xy0 = geom::Point2I()) :
         image::ImageBase<MaskPixelT>(array, deep, xy0),
-        _myMaskDictVersion(_maskDictVersion) {}
+        _myMaskDictVersion(_getMaskDictVersion()) {}
 
 
     void swap(Mask& rhs);
@@ -190,14 +195,15 @@ public:
     static MaskPixelT getPlaneBitMask(const std::string& name);
 
     static int getNumPlanesMax()  { return 8*sizeof(MaskPixelT); }
-    static int getNumPlanesUsed() { return _maskPlaneDict.size(); }
-    static const MaskPlaneDict& getMaskPlaneDict() { return _maskPlaneDict; }
+    static int getNumPlanesUsed();
+    static MaskPlaneDict getMaskPlaneDict();
     static void printMaskPlanes();
 
     static void addMaskPlanesToMetadata(lsst::daf::base::PropertySet::Ptr);
     //
     // This one isn't static, it fixes up a given Mask's planes
     void conformMaskPlanes(const MaskPlaneDict& masterPlaneDict);
+    void conformMaskPlanes(lsst::daf::base::PropertySet::Ptr metadata, bool const conformMasks=false);
     
     // Getters
         
@@ -215,6 +221,7 @@ private:
     static MaskPixelT getBitMask(int plane);
 
     static int _maskDictVersion;    // version number for bitplane dictionary
+    static int _getMaskDictVersion();
 
     void _initializePlanes(MaskPlaneDict const& planeDefs); // called by ctors
     //
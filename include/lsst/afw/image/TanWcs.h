@@ -127,6 +127,11 @@ namespace image {
         virtual void pixelToSkyImpl(double pixel1, double pixel2, lsst::afw::geom::Angle skyTmp[2]) const;
         virtual lsst::afw::geom::Point2D skyToPixelImpl(lsst::afw::geom::Angle sky1, lsst::afw::geom::Angle sky2) const;
 
+    protected:
+        virtual void pixelToSkyArrayImpl(int nPoints, double pixTmp[], double skyTmp[]) const;
+        virtual void skyToPixelArrayImpl(int nPoints, double skyTmp[], double pixTmp[]) const;
+
+    private:
         //Allow the formatter to access private goo
         LSST_PERSIST_FORMATTER(lsst::afw::formatters::TanWcsFormatter)
 
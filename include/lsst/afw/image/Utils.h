@@ -35,6 +35,7 @@
 #include <map>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "boost/format.hpp"
 #include "boost/mpl/bool.hpp"
@@ -53,6 +54,17 @@ namespace lsst { namespace afw { namespace image {
 lsst::daf::base::PropertySet::Ptr readMetadata(std::string const& fileName, const int hdu=0, bool strip=false);
 lsst::daf::base::PropertySet::Ptr readMetadata(char **ramFile, size_t *ramFileLen, const int hdu=0, bool strip=false);
 
+/// The values of some of the keywords in a FITS header, as their (unquoted) strings, indexed by keyword
+typedef std::map<std::string, std::string> HeaderValues;
+
+HeaderValues scanMetadata(std::string const& fileName, std::vector<std::string> const& keys, int hdu=0);
+std::vector<HeaderValues> scanMetadata(std::vector<std::string> const& fileNames,
+                                       std::vector<std::string> const& keys, int hdu=0, int nThreads=0);
+std::map<std::string, HeaderValues> scanMetadataDirectory(std::string const& dirName,
+                                                          std::vector<std::string> const& keys, int hdu=0,
+                                                          std::string const& pattern="\\.fits$",
+                                                          int nThreads=0);
+
 /************************************************************************************************************/
 /**
  * Return a value indicating a bad pixel for the given Image type
@@ -31,6 +31,7 @@
 #include "lsst/base.h"
 #include "lsst/daf/base.h"
 #include "lsst/daf/data/LsstBase.h"
+#include "lsst/ndarray.h"
 #include "lsst/afw/image/Image.h"
 #include "lsst/afw/coord/Coord.h"
 #include "lsst/afw/geom/AffineTransform.h"
@@ -156,6 +157,13 @@ public:
     lsst::afw::geom::Point2D skyToPixel(lsst::afw::geom::Angle sky1, lsst::afw::geom::Angle sky2) const;
 
     lsst::afw::geom::Point2D skyToPixel(lsst::afw::coord::Coord::ConstPtr coord) const;
+
+    // Convert many positions at once; each row of the arrays is one (x, y) or (longitude, latitude)
+    // position, and sky positions are in DEGREES
+    void pixelToSky(lsst::ndarray::Array<double const, 2, 1> const & pixels,
+                    lsst::ndarray::Array<double, 2, 1> const & sky) const;
+    void skyToPixel(lsst::ndarray::Array<double const, 2, 1> const & sky,
+                    lsst::ndarray::Array<double, 2, 1> const & pixels) const;
     // Intermediate World Coords are in DEGREES
     lsst::afw::geom::Point2D skyToIntermediateWorldCoord(lsst::afw::coord::Coord::ConstPtr coord) const;
     
@@ -214,6 +222,12 @@ protected:
     lsst::afw::coord::Coord::Ptr makeCorrectCoord(lsst::afw::geom::Angle sky0, lsst::afw::geom::Angle sky1) const;
 
     lsst::afw::coord::Coord::Ptr convertCoordToSky(lsst::afw::coord::Coord::ConstPtr coord) const;
+
+    // Workers for the array versions of pixelToSky and skyToPixel. Positions are interleaved
+    // (x0, y0, x1, y1, ...); pixel positions use the FITS convention and sky positions are in degrees
+    // in wcslib's axis order. The input array may be overwritten.
+    virtual void pixelToSkyArrayImpl(int nPoints, double pixTmp[], double skyTmp[]) const;
+    virtual void skyToPixelArrayImpl(int nPoints, double skyTmp[], double pixTmp[]) const;
     
     virtual lsst::afw::geom::AffineTransform linearizePixelToSkyInternal(
                                                  lsst::afw::geom::Point2D const & pix,
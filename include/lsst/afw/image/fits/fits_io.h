@@ -111,6 +111,27 @@ inline void fits_read_view(std::string const& filename,const View& view,
     m.read_image(array, xy0);
 }
 
+/// \ingroup FITS_IO
+/// \brief Reads an image from the given fits image file by memory-mapping it, rather than copying its pixels.
+///
+/// The pixels (only those within bbox, if specified) are converted in place in a private copy-on-write
+/// mapping owned by the array, so only the pages that hold them are read.  Returns false,
+/// having read nothing, if the HDU can't be mapped (e.g. it isn't of type PixelT, or is compressed);
+/// read it with fits_read_image instead.  Throws lsst::afw::image::FitsException if the file is not a
+/// valid FITS file.
+template <typename PixelT>
+inline bool fits_map_image(const std::string& filename,
+                           lsst::ndarray::Array<PixelT,2,2> & array,
+                           geom::Point2I & xy0,
+                           lsst::daf::base::PropertySet::Ptr metadata = lsst::daf::base::PropertySet::Ptr(),
+                           int hdu=1,
+                           geom::Box2I const& bbox=geom::Box2I(),
+                           ImageOrigin const origin = LOCAL
+) {
+    detail::fits_reader m(filename, metadata, hdu, bbox, origin);
+    return m.map_image(array, xy0);
+}
+
 /// \ingroup FITS_IO
 /// \brief Allocates a new image whose dimensions are determined by the given fits image RAM-file, and loads the
 /// pixels into it.
@@ -137,6 +158,8 @@ inline void fits_read_view(std::string const& filename,const View& view,
 /// \brief Saves the view to a fits file specified by the given fits image file name.
 /// Triggers a compile assert if the view channel depth is not supported by the FITS library or by the I/O extension.
 /// Throws lsst::afw::image::FitsException if it fails to create the file.
+/// The image is tile compressed if metadata requests it (see detail::fits_set_compression); reading a
+/// bounding box from a compressed image only decompresses the tiles that overlap it.
 template <typename ImageT>
 inline void fits_write_image(const std::string& filename, const ImageT & image,
                             boost::shared_ptr<const lsst::daf::base::PropertySet> metadata = lsst::daf::base::PropertySet::Ptr(),
@@ -153,6 +153,11 @@ bool fits_read_image(
 ) {
     lsst::ndarray::Array<typename ImageT::Pixel,2,2> array;
     geom::Point2I xy0;
+    // map the file if it's of the right type, rather than allocating an array and copying into it
+    if (fits_map_image(file, array, xy0, metadata, hdu, bbox, origin)) {
+        img = ImageT(array, false, xy0);
+        return true;
+    }
     try {
         boost::mpl::for_each<supported_fits_types>(
             try_fits_read_image<ImageT, found_type>(
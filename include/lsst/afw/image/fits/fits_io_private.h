@@ -32,10 +32,14 @@
 #if !defined(LSST_FITS_IO_PRIVATE_H)
 #define LSST_FITS_IO_PRIVATE_H
 
+#include <cstring>
 #include <iostream>
+#include <vector>
 #include <unistd.h>
 #include "boost/static_assert.hpp"
 #include "boost/format.hpp"
+#include "boost/noncopyable.hpp"
+#include "boost/shared_ptr.hpp"
 
 #include "boost/gil/gil_all.hpp"
 #include "boost/gil/extension/io/io_error.hpp"
@@ -194,6 +198,131 @@ struct cfitsio_traits<-64> {
     BOOST_STATIC_CONSTANT(bool,is_supported=true);
     typedef types_traits<double>::view_t view_t;
 };
+/*
+ * A range of bytes of a file, mapped copy-on-write so that it may be modified in place without
+ * changing the file.  The mapping is removed when the last shared_ptr to it (which may be held by
+ * the ndarray::Manager of an image made from it) is destroyed.
+ */
+class fits_mapping : private boost::noncopyable {
+public:
+    typedef boost::shared_ptr<fits_mapping> Ptr;
+
+    ~fits_mapping();
+
+    /// Return the first byte of the range that was mapped
+    char *getData() const { return _data; }
+
+    static Ptr map(std::string const& filename, long long begin, long long end);
+    static bool isNeeded();
+
+private:
+    fits_mapping(void *addr, std::size_t len, char *data) : _addr(addr), _len(len), _data(data) {}
+
+    void *_addr;                        // start of the mapping (page aligned)
+    std::size_t _len;                   // length of the mapping
+    char *_data;                        // first requested byte
+};
+
+void fits_convert_in_place(void *data, long long n, int pixelSize, unsigned long long xorMask);
+
+bool fits_compression_requested(lsst::daf::base::PropertySet const *metadata);
+bool fits_set_compression(cfitsio::fitsfile *fd, lsst::daf::base::PropertySet const *metadata,
+                          int bitpix, long const nAxes[2]);
+void fits_unset_compression(cfitsio::fitsfile *fd);
+
+/*
+ * Tile compress the image HDU that's created next in fd if metadata requests it (see fits_set_compression),
+ * and stop compressing when the guard goes out of scope, even if writing the HDU throws; otherwise the
+ * file's later HDUs would be compressed too
+ */
+class fits_compression_guard : private boost::noncopyable {
+public:
+    fits_compression_guard(cfitsio::fitsfile *fd, lsst::daf::base::PropertySet const *metadata,
+                           int bitpix, long const nAxes[2]) :
+        _fd(fd), _isCompressed(fits_set_compression(fd, metadata, bitpix, nAxes)) {}
+
+    ~fits_compression_guard() {
+        if (_isCompressed) {
+            try {
+                fits_unset_compression(_fd);
+            } catch (lsst::pex::exceptions::Exception &e) { // we mustn't throw from a destructor
+                std::cerr << e.what() << std::endl;
+            }
+        }
+    }
+private:
+    cfitsio::fitsfile *_fd;
+    bool const _isCompressed;           // did we turn compression on?
+};
+bool fits_is_compression_key(std::string const& name);
+void fits_copy_compression_keys(boost::shared_ptr<lsst::daf::base::PropertySet const> from,
+                                lsst::daf::base::PropertySet::Ptr to);
+
+/*
+ * Write the pixels of an image HDU straight into a file at the offset of the HDU's data, converting
+ * them to FITS (big-endian) byte order (and applying the BZERO used for unsigned types) a buffer at a
+ * time.  It's used once cfitsio has written the headers of a new file and closed it; writers for
+ * different HDUs of the same file may be used concurrently, on different threads.
+ */
+class fits_pixel_writer : private boost::noncopyable {
+public:
+    fits_pixel_writer(std::string const& filename, long long offset, int bitpix);
+    ~fits_pixel_writer();
+
+    void write(void const *data, long long n);
+    void flush();
+
+private:
+    int _fd;                            // file descriptor
+    long long _offset;                  // where the next buffer goes in the file
+    int _pixelSize;                     // bytes per pixel
+    unsigned long long _xorMask;        // bits to flip before byte swapping
+    std::vector<char> _buffer;          // converted pixels
+    std::size_t _nBuffered;             // number of bytes of _buffer in use
+};
+
+/*
+ * An image HDU whose pixels have been mapped (by fits_reader::start_read) but not yet converted.
+ * Converting them (finish) needs no cfitsio calls, so it may be done on another thread while the
+ * reader goes on to read other HDUs.
+ */
+template <typename PixelT>
+struct fits_pending_image {
+    fits_pending_image() : width(0), height(0), rowLength(0), x0(0), xorMask(0) {}
+
+    /// Convert the mapped pixels in place, setting array; a no-op if they were read by cfitsio
+    void finish() {
+        if (!mapping) {
+            return;
+        }
+        PixelT *data = reinterpret_cast<PixelT *>(mapping->getData());
+        if (width != rowLength) {
+            // move row y from y*rowLength + x0 to y*width; it never overwrites a row that's yet to move
+            for (int y = 0; y != height; ++y) {
+                std::memmove(data + static_cast<long long>(y)*width,
+                             data + static_cast<long long>(y)*rowLength + x0, width*sizeof(PixelT));
+            }
+        }
+        fits_convert_in_place(data, static_cast<long long>(width)*height, sizeof(PixelT), xorMask);
+
+        array = lsst::ndarray::static_dimension_cast<2>(
+            lsst::ndarray::Array<PixelT,2,0>(
+                lsst::ndarray::external(data, lsst::ndarray::makeVector(height, width),
+                                        lsst::ndarray::makeVector(width, 1), mapping)
+            )
+        );
+        mapping.reset();                // array's Manager now owns it
+    }
+
+    lsst::ndarray::Array<PixelT,2,2> array; ///< the pixels (once finished)
+    geom::Point2I xy0;                  ///< the image's origin
+    fits_mapping::Ptr mapping;          ///< the mapped rows, until finished
+    int width, height;                  ///< dimensions of the image
+    int rowLength;                      ///< length of the mapped rows (NAXIS1)
+    int x0;                             ///< column of each mapped row where the image starts
+    unsigned long long xorMask;         ///< bits to flip after byte swapping
+};
+
 //
 // Like gil's file_mgr class (from whence cometh this code), but knows about
 // cfitsio
@@ -393,6 +522,99 @@ protected:
         // Don't read the rest of the metadata here -- we don't yet know if the view is the right type
         //
     }
+
+    /*
+     * Read the metadata and check the bounding box; set xy0 to the origin of the part of the image to
+     * read, and xyOffset to the image's XY0 as recorded in the metadata
+     */
+    void _prepare_read(geom::Point2I & xy0, geom::Extent2I & xyOffset) {
+        cfitsio::getMetadata(_fd.get(), _metadata);
+
+        xy0 = geom::Point2I(0, 0);
+        xyOffset = geom::Extent2I(getImageXY0FromMetadata(wcsNameForXY0, _metadata.get()));
+        if (!_bbox.isEmpty()) {
+            if(_origin == PARENT) {
+                _bbox.shift(-xyOffset);
+            }
+            
+            xy0 = _bbox.getMin();
+
+            if (_bbox.getMinX() < 0 || _bbox.getMinY() < 0 ||
+                _bbox.getMaxX() >= _naxis1 || _bbox.getMaxY() >= _naxis2
+            ) {
+                throw LSST_EXCEPT(
+                    lsst::pex::exceptions::LengthErrorException,
+                    (boost::format("BBox (%d,%d) %dx%d doesn't fit in image %dx%d") %
+                    _bbox.getMinX() % _bbox.getMinY() % _bbox.getWidth() % _bbox.getHeight() %
+                    _naxis1 % _naxis2).str()
+                ); 
+            } 
+        }
+    }
+
+    /*
+     * Read the part of the image of size getDimensions() starting at xy0 into data, with cfitsio
+     */
+    void _read_subset(void *data, geom::Point2I const& xy0) {
+        geom::Extent2I const dimensions = getDimensions();
+        // 'bottom left corner' of the subsection (1-indexed)
+        long blc[2] = {xy0.getX() + 1, xy0.getY() + 1};
+        // 'top right corner' of the subsection
+        long trc[2] = {xy0.getX() + dimensions.getX(), xy0.getY() + dimensions.getY()}; 
+        // increment to be applied in each dimension (of file)
+        long inc[2] = {1, 1};                       
+
+        int status = 0;                 // cfitsio function return status
+
+        if (fits_read_subset(_fd.get(), _ttype, blc, trc, inc, NULL, data, NULL, &status) != 0) {
+            throw LSST_EXCEPT(FitsException, cfitsio::err_msg(_fd.get(), status));
+        }
+    }
+
+    /*
+     * Can the current HDU be memory-mapped?  If so, return the offset of its data in the file and the
+     * bits to flip in each pixel (after byte swapping) to apply its BZERO
+     */
+    bool _can_map(long long & dataOffset, unsigned long long & xorMask) {
+        if (_filename.empty() || !fits_mapping::isNeeded()) {
+            return false;
+        }
+        int status = 0;
+        if (fits_is_compressed_image(_fd.get(), &status) || status != 0) {
+            return false;
+        }
+        int rawBitpix = 0;              // BITPIX as written, before applying BZERO and BSCALE
+        if (fits_get_img_type(_fd.get(), &rawBitpix, &status) != 0) {
+            return false;
+        }
+        double bzero = 0.0, bscale = 1.0;
+        if (fits_read_key(_fd.get(), TDOUBLE, const_cast<char *>("BZERO"), &bzero, NULL, &status) != 0) {
+            status = 0;                 // no BZERO keyword
+            bzero = 0.0;
+        }
+        if (fits_read_key(_fd.get(), TDOUBLE, const_cast<char *>("BSCALE"), &bscale, NULL, &status) != 0) {
+            status = 0;
+            bscale = 1.0;
+        }
+        if (bscale != 1.0) {
+            return false;
+        }
+        if (rawBitpix == _bitpix && bzero == 0.0) {
+            xorMask = 0;
+        } else if (_bitpix == USHORT_IMG && rawBitpix == SHORT_IMG && bzero == 32768.0) {
+            xorMask = 0x8000;
+        } else if (_bitpix == ULONG_IMG && rawBitpix == LONG_IMG && bzero == 2147483648.0) {
+            xorMask = 0x80000000;
+        } else {
+            return false;
+        }
+        LONGLONG headStart = 0, dataStart = 0, dataEnd = 0;
+        if (fits_get_hduaddrll(_fd.get(), &headStart, &dataStart, &dataEnd, &status) != 0) {
+            return false;
+        }
+        dataOffset = dataStart;
+        return true;
+    }
     
 public:
     fits_reader(cfitsio::fitsfile *file,
@@ -419,6 +641,18 @@ public:
         init(); 
     }
 
+    /*
+     * Read another HDU of the file that reader has open, without opening it again.  The readers share
+     * cfitsio's current HDU, so reader mustn't be used once this one has been made
+     */
+    fits_reader(fits_reader const& reader,
+                lsst::daf::base::PropertySet::Ptr metadata,
+                int hdu, geom::Box2I const& bbox=geom::Box2I(),
+                ImageOrigin const origin = LOCAL
+    ) : fits_file_mgr(reader), _hdu(hdu), _metadata(metadata), _bbox(bbox), _origin(origin) {
+        init();
+    }
+
     fits_reader(const std::string& filename,
                 lsst::daf::base::PropertySet::Ptr metadata,
                 int hdu, bool headerOnly
@@ -440,33 +674,10 @@ public:
             );
         }
 
-        /*
-         * Read metadata
-         */
-        cfitsio::getMetadata(_fd.get(), _metadata);
-
-        // Origin of part of image to read
-        geom::Point2I xy0(0,0);
-
-        geom::Extent2I xyOffset(getImageXY0FromMetadata(wcsNameForXY0, _metadata.get()));
-        if (!_bbox.isEmpty()) {
-            if(_origin == PARENT) {
-                _bbox.shift(-xyOffset);
-            }
-            
-            xy0 = _bbox.getMin();
+        geom::Point2I xy0;              // origin of part of image to read
+        geom::Extent2I xyOffset;        // XY0 of the image in the file
+        _prepare_read(xy0, xyOffset);
 
-            if (_bbox.getMinX() < 0 || _bbox.getMinY() < 0 ||
-                _bbox.getWidth() > _naxis1 || _bbox.getHeight() > _naxis2
-            ) {
-                throw LSST_EXCEPT(
-                    lsst::pex::exceptions::LengthErrorException,
-                    (boost::format("BBox (%d,%d) %dx%d doesn't fit in image %dx%d") %
-                    _bbox.getMinX() % _bbox.getMinY() % _bbox.getWidth() % _bbox.getHeight() %
-                    _naxis1 % _naxis2).str()
-                ); 
-            } 
-        }
         geom::Extent2I dimensions = getDimensions();
         if (array.template getSize<1>() != dimensions.getX() 
             || array.template getSize<0>() != dimensions.getY()) {
@@ -477,20 +688,81 @@ public:
                  dimensions.getX() % dimensions.getY()).str()
             );
         }
-        // 'bottom left corner' of the subsection (1-indexed)
-        long blc[2] = {xy0.getX() + 1, xy0.getY() + 1};
-        // 'top right corner' of the subsection
-        long trc[2] = {xy0.getX() + dimensions.getX(), xy0.getY() + dimensions.getY()}; 
-        // increment to be applied in each dimension (of file)
-        long inc[2] = {1, 1};                       
+        _read_subset(array.getData(), xy0);
 
-        int status = 0;                 // cfitsio function return status
+        return xy0 + xyOffset;
+    }
 
-        if (fits_read_subset(_fd.get(), _ttype, blc, trc, inc, NULL, array.getData(), NULL, &status) != 0) {
-            throw LSST_EXCEPT(FitsException, cfitsio::err_msg(_fd.get(), status));
+    /*
+     * Read the image by memory-mapping its rows rather than copying them with cfitsio.  The rows are
+     * mapped copy-on-write; if a bounding box narrower than the image was requested its part of each
+     * row is moved down to make the pixels contiguous, and then the pixels are converted in place in
+     * one pass.  Only the pages holding the requested pixels are touched, and array's Manager owns
+     * the mapping.
+     *
+     * Returns false, having read nothing (not even the metadata), if the HDU can't be mapped: if it
+     * isn't of type PixelT, is compressed or scaled (other than the BZERO used for unsigned types),
+     * holds single-byte pixels (which need no conversion, so would stay shared with the file), or
+     * isn't in a plain FITS file on disk
+     */
+    template <typename PixelT>
+    bool map_image(lsst::ndarray::Array<PixelT,2,2> & array, geom::Point2I & xy0) {
+        fits_pending_image<PixelT> pending;
+        if (!start_read(pending, true)) {
+            return false;
+        }
+        pending.finish();
+        array = pending.array;
+        xy0 = pending.xy0;
+        return true;
+    }
+
+    /*
+     * Start reading the image: read the metadata and map the pixels as map_image does, leaving
+     * pending.finish() (which may be called on another thread) to convert them.  If the HDU can't be
+     * mapped the pixels are read with cfitsio now, unless mapOnly is true.
+     *
+     * Returns false, having read nothing, if the HDU isn't of type PixelT or is empty, or if mapOnly
+     * is true and the HDU can't be mapped
+     */
+    template <typename PixelT>
+    bool start_read(fits_pending_image<PixelT> & pending, bool mapOnly=false) {
+        const int BITPIX = detail::fits_read_support_private<PixelT>::BITPIX;
+        if (BITPIX != _bitpix || _naxis1 == 0 || _naxis2 == 0) {
+            return false;
+        }
+        long long dataOffset = 0;       // offset of the HDU's data in the file
+        unsigned long long xorMask = 0; // bits to flip after byte swapping
+        bool const canMap = (sizeof(PixelT) != 1 && _can_map(dataOffset, xorMask));
+        if (mapOnly && !canMap) {
+            return false;
         }
 
-        return xy0 + xyOffset;
+        geom::Point2I xy0;              // origin of part of image to read
+        geom::Extent2I xyOffset;        // XY0 of the image in the file
+        _prepare_read(xy0, xyOffset);
+        int const width = getDimensions().getX();
+        int const height = getDimensions().getY();
+
+        if (canMap) {
+            long long const rowBytes = static_cast<long long>(_naxis1)*sizeof(PixelT);
+            pending.mapping = fits_mapping::map(_filename, dataOffset + rowBytes*xy0.getY(),
+                                                dataOffset + rowBytes*(xy0.getY() + height));
+        }
+        if (pending.mapping) {
+            pending.width = width;
+            pending.height = height;
+            pending.rowLength = _naxis1;
+            pending.x0 = xy0.getX();
+            pending.xorMask = xorMask;
+        } else {
+            // the HDU can't be mapped, or the file isn't a plain FITS file (e.g. cfitsio is
+            // decompressing it on the fly); we've already read the metadata, so read the pixels here
+            pending.array = lsst::ndarray::allocate(height, width);
+            _read_subset(pending.array.getData(), xy0);
+        }
+        pending.xy0 = xy0 + xyOffset;
+        return true;
     }
    
     template <typename PixelT>
@@ -512,6 +784,33 @@ class fits_writer : public fits_file_mgr {
     void init() {
         ;
     }
+    /*
+     * Write metadata to header.
+     * Ugliness is required to avoid multiple SIMPLE, etc keywords in Fits file,
+     * since cfitsio will put in its own in any case.
+     */
+    void write_metadata(boost::shared_ptr<const lsst::daf::base::PropertySet> metadata) {
+        if (metadata != NULL) {
+            typedef std::vector<std::string> NameList;
+            NameList paramNames;
+
+            boost::shared_ptr<lsst::daf::base::PropertyList const> pl =
+                boost::dynamic_pointer_cast<lsst::daf::base::PropertyList const,
+                lsst::daf::base::PropertySet const>(metadata);
+            if (pl) {
+                paramNames = pl->getOrderedNames();
+            } else {
+                paramNames = metadata->paramNames(false);
+            }
+            for (NameList::const_iterator i = paramNames.begin(), e = paramNames.end(); i != e; ++i) {
+                if (*i != "SIMPLE" && *i != "BITPIX" &&
+                    *i != "NAXIS" && *i != "NAXIS1" && *i != "NAXIS2" && *i != "EXTEND" &&
+                    !fits_is_compression_key(*i)) {
+                    cfitsio::appendKey(_fd.get(), *i, "", metadata);
+                }
+            }
+        }
+    }
 public:
     fits_writer(cfitsio::fitsfile *file) :     fits_file_mgr(file)           { init(); }
     fits_writer(std::string const& filename, std::string const&mode) : fits_file_mgr(filename, mode) { init(); }
@@ -533,6 +832,8 @@ public:
         const int BITPIX = detail::fits_read_support_private<typename ImageT::Pixel>::BITPIX;
 
         int status = 0;
+        fits_compression_guard const compression(_fd.get(), (_flags == "pdu") ? NULL : metadata.get(),
+                                                 BITPIX, nAxes);
         if (_flags == "pdu") {
             if (fits_create_img(_fd.get(), 8, 0, nAxes, &status) != 0) {
                 throw LSST_EXCEPT(FitsException, cfitsio::err_msg(_fd.get(), status));
@@ -542,32 +843,7 @@ public:
                 throw LSST_EXCEPT(FitsException, cfitsio::err_msg(_fd.get(), status));
             }
         }
-        /*
-         * Write metadata to header.  
-         * Ugliness is required to avoid multiple SIMPLE, etc keywords in Fits file,
-         * since cfitsio will put in its own in any case.
-         */
-#if 1
-        if (metadata != NULL) {
-            typedef std::vector<std::string> NameList;
-            NameList paramNames;
-
-            boost::shared_ptr<lsst::daf::base::PropertyList const> pl =
-                boost::dynamic_pointer_cast<lsst::daf::base::PropertyList const,
-                lsst::daf::base::PropertySet const>(metadata);
-            if (pl) {
-                paramNames = pl->getOrderedNames();
-            } else {
-                paramNames = metadata->paramNames(false);
-            }
-            for (NameList::const_iterator i = paramNames.begin(), e = paramNames.end(); i != e; ++i) {
-                if (*i != "SIMPLE" && *i != "BITPIX" &&
-                    *i != "NAXIS" && *i != "NAXIS1" && *i != "NAXIS2" && *i != "EXTEND") {
-                    cfitsio::appendKey(_fd.get(), *i, "", metadata);
-                }
-            }
-        }
-#endif
+        write_metadata(metadata);
         if (_flags == "pdu") {            // no data to write
             return;
         }
@@ -586,6 +862,71 @@ public:
             throw LSST_EXCEPT(FitsException, cfitsio::err_msg(_fd.get(), status));
         }
     }
+
+    /*
+     * Append an image HDU of the given size without writing its data, which may then be
+     * written a band of rows at a time using write_rows (in any order, even after later HDUs
+     * have been created). Pixels that are never written are 0.
+     *
+     * If dimensions is 0x0 a header-only HDU is created, as for a PDU
+     */
+    template <typename PixelT>
+    void create_image(
+        geom::Extent2I const& dimensions,
+        boost::shared_ptr<const lsst::daf::base::PropertySet> metadata
+    ) {
+        long nAxes[2];
+        nAxes[0] = dimensions.getX();
+        nAxes[1] = dimensions.getY();
+        bool const isHeaderOnly = (nAxes[0] == 0 && nAxes[1] == 0);
+
+        const int BITPIX = isHeaderOnly ? 8 : detail::fits_read_support_private<PixelT>::BITPIX;
+
+        int status = 0;
+        if (fits_create_img(_fd.get(), BITPIX, isHeaderOnly ? 0 : 2, nAxes, &status) != 0) {
+            throw LSST_EXCEPT(FitsException, cfitsio::err_msg(_fd.get(), status));
+        }
+        write_metadata(metadata);
+    }
+
+    /*
+     * Return the offset in the file of the data of HDU hdu (FITS numbering); call it once all the HDUs
+     * have been created, as adding keywords to a header may move its data
+     */
+    long long get_data_offset(int hdu) {
+        move_to_hdu(_fd.get(), hdu);
+
+        LONGLONG headStart = 0, dataStart = 0, dataEnd = 0;
+        int status = 0;
+        if (fits_get_hduaddrll(_fd.get(), &headStart, &dataStart, &dataEnd, &status) != 0) {
+            throw LSST_EXCEPT(FitsException, cfitsio::err_msg(_fd.get(), status));
+        }
+        return dataStart;
+    }
+
+    /*
+     * Write the rows of array to rows [y0, y0 + number of rows) of image HDU hdu (FITS numbering),
+     * which must have been created by create_image with the same width as array
+     */
+    template <typename PixelT>
+    void write_rows(int hdu, int y0, lsst::ndarray::Array<PixelT const, 2, 1> const& rows) {
+        const int BITPIX = detail::fits_read_support_private<PixelT>::BITPIX;
+        int const ttype = cfitsio::ttypeFromBitpix(BITPIX);
+
+        move_to_hdu(_fd.get(), hdu);
+
+        ndarray::Array<PixelT const, 2, 2> array = ndarray::dynamic_dimension_cast<2>(rows);
+        if (array.empty()) {
+            array = ndarray::copy(rows);
+        }
+        long firstPixel[2] = {1, y0 + 1};
+        long const nPixels = static_cast<long>(array.template getSize<0>())*array.template getSize<1>();
+        PixelT *data = const_cast<PixelT *>(array.getData());
+        int status = 0;
+        if (fits_write_pix(_fd.get(), ttype, firstPixel, nPixels, data, &status) != 0) {
+            throw LSST_EXCEPT(FitsException, cfitsio::err_msg(_fd.get(), status));
+        }
+    }
 };
 
 } // namespace detail
@@ -72,7 +72,8 @@ public:
           _nxSample(nxSample), _nySample(nySample),
           _undersampleStyle(undersampleStyle),
           _sctrl(new StatisticsControl(sctrl)),
-          _prop(prop) {
+          _prop(prop),
+          _nThreads(1) {
         assert(nxSample > 0);
         assert(nySample > 0);
     }
@@ -90,7 +91,8 @@ public:
           _nxSample(nxSample), _nySample(nySample),
           _undersampleStyle(math::stringToUndersampleStyle(undersampleStyle)),
           _sctrl(new StatisticsControl(sctrl)),
-          _prop(stringToStatisticsProperty(prop)) {
+          _prop(stringToStatisticsProperty(prop)),
+          _nThreads(1) {
         assert(nxSample > 0);
         assert(nySample > 0);
     }
@@ -121,6 +123,9 @@ public:
     Property getStatisticsProperty() { return _prop; }
     void setStatisticsProperty(Property prop) { _prop = prop; }
     void setStatisticsProperty(std::string prop) { _prop = stringToStatisticsProperty(prop); }
+
+    int getNThreads() const { return _nThreads; }
+    void setNThreads(int nThreads) { _nThreads = nThreads; }
     
 private:
     Interpolate::Style _style;                       // style of interpolation to use
@@ -129,6 +134,7 @@ private:
     UndersampleStyle _undersampleStyle; // what to do when nx,ny are too small for the requested interp style
     StatisticsControl::Ptr _sctrl;           // statistics control object
     Property _prop;                          // statistics Property
+    int _nThreads;                           // number of threads to use; 0 for one per core
 };
     
 /**
@@ -150,8 +156,16 @@ private:
        math::Background backobj = math::makeBackground(img, bctrl);
        double somepoint = backobj.getPixel(i_x,i_y); // get the background at a pixel at i_x,i_y
        ImageT back = backobj.getImage();             // get a whole background image
+       backobj.getImage(img, true);                  // subtract the background from img in place
  * @endcode
  *
+ * The grid statistics, the interpolation and getImage are split over BackgroundControl::getNThreads()
+ * threads; the results do not depend on the number of threads.
+ *
+ * The constructor computes the cubic (or linear) coefficients of every row's interpolant
+ * between the grid points, so getPixel and getImage evaluate a polynomial rather than
+ * building a new spline. Pixels beyond the outermost grid points are extrapolated
+ * using the outermost interval.
  */
 class Background {
 public:
@@ -166,6 +180,9 @@ public:
 
     template<typename PixelT>
     typename lsst::afw::image::Image<PixelT>::Ptr getImage() const;
+
+    template<typename PixelT>
+    void getImage(lsst::afw::image::Image<PixelT> &img, bool const subtract=false) const;
     
     BackgroundControl getBackgroundControl() const { return _bctrl; }
     
@@ -185,9 +202,22 @@ private:
     std::vector<std::vector<double> > _grid; // 3-sig clipped means for the grid of sub images.
 
     std::vector<std::vector<double> > _gridcolumns; // interpolated columns for the bicubic spline
+    int _nInterval;                     // number of intervals in each row's interpolant
+    std::vector<double> _rowCoeffs;     // 4 polynomial coefficients per interval per row
+    std::vector<int> _xInterval;        // interval used to evaluate each column
+    std::vector<double> _xOffset;       // offset of each column from the start of its interval
     BackgroundControl _bctrl;           // control info set by user.
 
     void _checkSampling();
+    int _findInterval(int const x, double *offset) const;
+    template<typename ImageT>
+    void _computeGridStatistics(std::vector<typename ImageT::Ptr> const& subimgs,
+                                int const cellBegin, int const cellEnd);
+    void _computeGridColumns(int const iXBegin, int const iXEnd);
+    void _computeRowCoefficients(int const yBegin, int const yEnd);
+    template<typename PixelT>
+    void _fillRows(lsst::afw::image::Image<PixelT> &img, bool const subtract,
+                   int const yBegin, int const yEnd) const;
 };
 
 /**
@@ -44,6 +44,7 @@
 #include "lsst/afw/image/Image.h"
 #include "lsst/afw/image/MaskedImage.h"
 #include "lsst/afw/math/Kernel.h"
+#include "lsst/afw/math/detail/DotProduct.h"
 
 namespace lsst {
 namespace afw {
@@ -60,22 +61,31 @@ namespace math {
                 bool doNormalize = true,    ///< normalize the kernel to sum=1?
                 bool doCopyEdge = false,    ///< copy edge pixels from source image
                     ///< instead of setting them to the standard edge pixel?
-                int maxInterpolationDistance = 10)  ///< maximum width or height of a region
+                int maxInterpolationDistance = 10,  ///< maximum width or height of a region
                     ///< over which to use linear interpolation interpolate
+                int nThreads = 1,   ///< number of threads to use; 0 for one per available core
+                int fftMinKernelSize = 15)  ///< minimum width and height of a spatially invariant kernel
+                    ///< for which to convolve using FFTs; 0 to never use FFTs
         :
             _doNormalize(doNormalize),
             _doCopyEdge(doCopyEdge),
-            _maxInterpolationDistance(maxInterpolationDistance)
+            _maxInterpolationDistance(maxInterpolationDistance),
+            _nThreads(nThreads),
+            _fftMinKernelSize(fftMinKernelSize)
         { }
     
         bool getDoNormalize() const { return _doNormalize; }
         bool getDoCopyEdge() const { return _doCopyEdge; }
         int getMaxInterpolationDistance() const { return _maxInterpolationDistance; };
+        int getNThreads() const { return _nThreads; }
+        int getFftMinKernelSize() const { return _fftMinKernelSize; }
         
         void setDoNormalize(bool doNormalize) {_doNormalize = doNormalize; }
         void setDoCopyEdge(bool doCopyEdge) { _doCopyEdge = doCopyEdge; }
         void setMaxInterpolationDistance(int maxInterpolationDistance) {
             _maxInterpolationDistance = maxInterpolationDistance; }
+        void setNThreads(int nThreads) { _nThreads = nThreads; }
+        void setFftMinKernelSize(int fftMinKernelSize) { _fftMinKernelSize = fftMinKernelSize; }
     
     private:
         bool _doNormalize;  ///< normalize the kernel to sum=1?
@@ -83,6 +93,10 @@ namespace math {
                     ///< instead of setting them to the standard edge pixel?
         int _maxInterpolationDistance;  ///< maximum width or height of a region
                     ///< over which to attempt interpolation
+        int _nThreads;      ///< number of threads over which to split the output rows;
+                    ///< 0 for one per available core. Results do not depend on this value.
+        int _fftMinKernelSize;  ///< spatially invariant kernels at least this wide and high
+                    ///< are convolved using FFTs (floating point output only); 0 to never use FFTs
     };
 
     template <typename OutImageT, typename InImageT>
@@ -172,6 +186,9 @@ namespace math {
  * the kernel center and adjust the supplied pixel accessors accordingly.
  * For an example of how to do this see convolve().
  *
+ * @note Each kernel row of a float or double Image or MaskedImage is computed by vectorized code
+ * (see lsst/afw/math/detail/DotProduct.h) unless SIMD has been disabled.
+ *
  * @ingroup afw
  */
 template <typename OutImageT, typename InImageT>
@@ -185,17 +202,22 @@ inline typename OutImageT::SinglePixel lsst::afw::math::convolveAtAPoint(
 {
     typename OutImageT::SinglePixel outValue = 0;
     for (int kRow = 0; kRow != kHeight; ++kRow) {
-        for (lsst::afw::image::Image<lsst::afw::math::Kernel::Pixel>::const_xy_locator kEnd = 
-            kernelLocator + lsst::afw::image::detail::difference_type(kWidth, 0);
-            kernelLocator != kEnd; ++inImageLocator.x(), ++kernelLocator.x()) {
-            typename lsst::afw::math::Kernel::Pixel const kVal = kernelLocator[0];
-            if (kVal != 0) {
-                outValue += *inImageLocator*kVal;
+        if (!lsst::afw::math::detail::addDotProduct(
+                outValue, inImageLocator, &(*kernelLocator)[0], kWidth)) {
+            for (lsst::afw::image::Image<lsst::afw::math::Kernel::Pixel>::const_xy_locator kEnd = 
+                kernelLocator + lsst::afw::image::detail::difference_type(kWidth, 0);
+                kernelLocator != kEnd; ++inImageLocator.x(), ++kernelLocator.x()) {
+                typename lsst::afw::math::Kernel::Pixel const kVal = kernelLocator[0];
+                if (kVal != 0) {
+                    outValue += *inImageLocator*kVal;
+                }
             }
+            inImageLocator += lsst::afw::image::detail::difference_type(-kWidth, 0);
+            kernelLocator += lsst::afw::image::detail::difference_type(-kWidth, 0);
         }
 
-        inImageLocator  += lsst::afw::image::detail::difference_type(-kWidth, 1);
-        kernelLocator += lsst::afw::image::detail::difference_type(-kWidth, 1);
+        inImageLocator  += lsst::afw::image::detail::difference_type(0, 1);
+        kernelLocator += lsst::afw::image::detail::difference_type(0, 1);
     }
 
     return outValue;
@@ -225,12 +247,16 @@ inline typename OutImageT::SinglePixel lsst::afw::math::convolveAtAPoint(
          kernelYIter != yEnd; ++kernelYIter) {
 
         OutT outValueY = 0;
-        for (k_iter kernelXIter = kernelXList.begin(), xEnd = kernelXList.end();
-             kernelXIter != xEnd; ++kernelXIter, ++inImageLocator.x()) {
-            typename lsst::afw::math::Kernel::Pixel const kValX = *kernelXIter;
-            if (kValX != 0) {
-                outValueY += *inImageLocator*kValX;
+        if (!lsst::afw::math::detail::addDotProduct(outValueY, inImageLocator, &kernelXList[0],
+                                                    static_cast<int>(kernelXList.size()))) {
+            for (k_iter kernelXIter = kernelXList.begin(), xEnd = kernelXList.end();
+                 kernelXIter != xEnd; ++kernelXIter, ++inImageLocator.x()) {
+                typename lsst::afw::math::Kernel::Pixel const kValX = *kernelXIter;
+                if (kValX != 0) {
+                    outValueY += *inImageLocator*kValX;
+                }
             }
+            inImageLocator += lsst::afw::image::detail::difference_type(-kernelXList.size(), 0);
         }
         
         double const kValY = *kernelYIter;
@@ -238,7 +264,7 @@ inline typename OutImageT::SinglePixel lsst::afw::math::convolveAtAPoint(
             outValue += outValueY*kValY;
         }
         
-        inImageLocator += lsst::afw::image::detail::difference_type(-kernelXList.size(), 1);
+        inImageLocator += lsst::afw::image::detail::difference_type(0, 1);
     }
 
     return outValue;
@@ -32,6 +32,7 @@
  */
 #include <limits>
 #include <map>
+#include <vector>
 #include "gsl/gsl_interp.h"
 #include "gsl/gsl_spline.h"
 #include "boost/shared_ptr.hpp"
@@ -42,6 +43,19 @@ namespace lsst {
 namespace afw {
 namespace math {
 
+namespace detail {
+    class Spline;
+}
+
+/**
+ * @brief Interpolate values for a set of x,y vector<>s
+ *
+ * By default the interpolation is done by GSL. The natural (NATURAL_SPLINE or CUBIC_SPLINE) and Akima
+ * (AKIMA_SPLINE) splines may instead be computed natively (see the Style constructor's isNative),
+ * which gives the same interpolant but evaluates arrays of points considerably faster.
+ *
+ * @note The x and y vectors are held by reference, and must outlive the Interpolate.
+ */
 class Interpolate {
 public:
 
@@ -59,7 +73,7 @@ public:
     Interpolate(std::vector<double> const &x, std::vector<double> const &y,
                 ::gsl_interp_type const *gslInterpType = ::gsl_interp_akima);
     Interpolate(std::vector<double> const &x, std::vector<double> const &y,
-                Interpolate::Style const style);
+                Interpolate::Style const style, bool const isNative=false);
     Interpolate(std::vector<double> const &x, std::vector<double> const &y,
                 std::string style);
     
@@ -68,12 +82,14 @@ public:
 
     virtual ~Interpolate();
     double interpolate(double const x);
+    void interpolate(std::vector<double> const &x, std::vector<double> &y);
     
 private:
     std::vector<double> const &_x;
     std::vector<double> const &_y;
     ::gsl_interp_accel *_acc;
     ::gsl_interp *_interp;
+    boost::shared_ptr<detail::Spline> _spline; // native spline, if requested; else NULL
 };
 
 
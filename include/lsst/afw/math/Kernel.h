@@ -68,6 +68,10 @@ namespace math {
 using boost::serialization::make_nvp;
 #endif
 
+namespace detail {
+    class KernelFunctionTable;
+}
+
 //forward declaration of LocalKernel Classes
 class ImageLocalKernel;
 class FourierLocalKernel;
@@ -719,9 +723,17 @@ class FourierLocalKernel;
 
         virtual void computeCache(int const cacheSize);
 
+        int getCacheSize() const;
+
     protected:
         virtual void setKernelParameter(unsigned int ind, double value) const;
 
+        void setKernelFunctionTable(boost::shared_ptr<detail::KernelFunctionTable const> tablePtr);
+
+        boost::shared_ptr<detail::KernelFunctionTable const> getKernelFunctionTable() const {
+            return _kernelFunctionTablePtr;
+        }
+
     private:
         double basicComputeVectors(
             std::vector<Pixel> &colList,
@@ -740,6 +752,10 @@ class FourierLocalKernel;
         //
         mutable std::vector<std::vector<double> > _kernelRowCache;
         mutable std::vector<std::vector<double> > _kernelColCache;
+        //
+        // Interpolated table of the row and column kernel functions (if not null)
+        //
+        boost::shared_ptr<detail::KernelFunctionTable const> _kernelFunctionTablePtr;
 
         friend class boost::serialization::access;
         template <class Archive>
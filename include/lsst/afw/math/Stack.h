@@ -29,6 +29,7 @@
  * @brief Functions to stack images
  * @ingroup stack
  */ 
+#include <string>
 #include <vector>
 #include "lsst/afw/image/Image.h"
 #include "lsst/afw/math/Statistics.h"
@@ -66,6 +67,20 @@ typename lsst::afw::image::MaskedImage<PixelT>::Ptr statisticsStack(
                                                                    );
 
 
+/**
+ * @brief A function to compute some statistics of a stack of MaskedImages stored in FITS files,
+ * a band of rows at a time
+ */
+template<typename PixelT>
+void statisticsStackFits(
+        std::string const& outFileName,             ///< MEF file to write the stacked MaskedImage to
+        std::vector<std::string> const& fileNames,  ///< MEF files of the MaskedImages to process
+        Property flags, ///< statistics requested
+        StatisticsControl const& sctrl=StatisticsControl(), ///< control structure
+        std::vector<PixelT> const& wvector=std::vector<PixelT>(0), ///< vector containing weights
+        int bandHeight=256                          ///< number of rows to read from each file at a time
+                        );
+
 /**
  * @brief A function to compute some statistics of a stack of std::vectors
  */
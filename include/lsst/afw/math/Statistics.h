@@ -101,7 +101,9 @@ public:
         _noGoodPixelsMask(lsst::afw::image::Mask<>::getPlaneBitMask("EDGE")),
         _isNanSafe(isNanSafe),
         _isWeighted(isWeighted),
-        _isMultiplyingWeights(false) {
+        _isMultiplyingWeights(false),
+        _isHistogramQuantiles(false),
+        _nThreads(1) {
         
         assert(_numSigmaClip > 0);
         assert(_numIter > 0);
@@ -114,6 +116,8 @@ public:
     bool getNanSafe() const { return _isNanSafe; }
     bool getWeighted() const { return _isWeighted; }
     bool getMultiplyWeights() const { return _isMultiplyingWeights; }
+    bool getHistogramQuantiles() const { return _isHistogramQuantiles; }
+    int getNThreads() const { return _nThreads; }
     
     
     void setNumSigmaClip(double numSigmaClip) { assert(numSigmaClip > 0); _numSigmaClip = numSigmaClip; }
@@ -123,6 +127,8 @@ public:
     void setNanSafe(bool isNanSafe) { _isNanSafe = isNanSafe; }
     void setWeighted(bool isWeighted) { _isWeighted = isWeighted; }
     void setMultiplyWeights(bool isMultiplyingWeights) { _isMultiplyingWeights = isMultiplyingWeights; }
+    void setHistogramQuantiles(bool isHistogramQuantiles) { _isHistogramQuantiles = isHistogramQuantiles; }
+    void setNThreads(int nThreads) { _nThreads = nThreads; }
     
 
 private:
@@ -133,6 +139,8 @@ private:
     bool _isNanSafe;                      // Check for NaNs before running (slower)
     bool _isWeighted;                     // Use inverse variance to weight statistics.
     bool _isMultiplyingWeights;           // Treat variance plane as weights and multiply instead of dividing
+    bool _isHistogramQuantiles;           // Find median and quartiles by radix selection, not by reordering
+    int _nThreads;                        // Number of threads used by statisticsStack; 0 for one per core
 };
 
             
@@ -155,6 +163,7 @@ private:
         sctrl.setNumIter(5);                   // reset number of iterations for N-sigma clipping
         sctrl.setAndMask(0x1);                 // ignore pixels with these mask bits set
         sctrl.setNanSafe(true);                // check for NaNs, a bit slower (default=true)
+        sctrl.setHistogramQuantiles(true);     // don't copy the image to find the median and quartiles
         
         lsst::afw::math::Statistics statobj =
             lsst::afw::math::makeStatistics(*img, afwMath::NPOINT | 
@@ -177,6 +186,11 @@ private:
  *       median +/- numSigmaClip*IQ_TO_STDEV*IQR, where IQ_TO_STDEV=~0.74 is the conversion factor
  *       between the IQR and sigma for a Gaussian distribution.  All subsequent iterations perform
  *       clips at mean +/- numSigmaClip*stdev.
+ * @note Quantiles: By default the median and quartiles are found by partially sorting a copy of the good
+ *       pixels.  If StatisticsControl::setHistogramQuantiles(true) has been called (and NaNs are being
+ *       ignored), they are instead found by radix selection using histograms of successive 16-bit digits
+ *       of the pixel values (one pass through the image for 16-bit images, two for int and float,
+ *       and four for double) with no copy of the pixels; the results are identical.
  *
  */
 class Statistics {
@@ -222,12 +236,6 @@ private:
 
     StatisticsControl _sctrl;           // the control structure
 
-    template<typename IsFinite, typename ImageT, typename MaskT, typename VarianceT>
-    boost::shared_ptr<std::vector<typename ImageT::Pixel> >  _makeVectorCopy(ImageT const &img,
-                                                                             MaskT const &msk,
-                                                                             VarianceT const &var,
-                                                                             int const flags);
-        
     template<typename IsFinite,
              typename HasValueLtMin,
              typename HasValueGtMax,
@@ -238,11 +246,41 @@ private:
                         int const nCrude, int const stride = 1, double const meanCrude = 0,
                         double const cliplimit = std::numeric_limits<double>::quiet_NaN());
     
+    template<typename IsFinite,
+             typename IsFiniteSum,
+             typename HasValueLtMin,
+             typename HasValueGtMax,
+             bool IsWeighted,
+             typename ImageT, typename MaskT, typename VarianceT>
+    SumReturn _sumImageAndCopy(ImageT const &img, MaskT const &msk, VarianceT const &var,
+                               int const nCrude, double const meanCrude,
+                               std::vector<typename ImageT::Pixel> &values,
+                               std::vector<lsst::afw::image::VariancePixel> &weights);
+
+    template<typename IsFinite, bool IsWeighted, typename Pixel>
+    SumReturn _sumValues(std::vector<Pixel> const &values,
+                         std::vector<lsst::afw::image::VariancePixel> const &weights,
+                         double const center, double const cliplimit);
+
+    template<typename ImageT, typename MaskT, typename VarianceT>
+    double _getMeanCrude(ImageT const &img, MaskT const &msk, VarianceT const &var, int const flags,
+                         int &nCrude);
+
+    StandardReturn _makeStandardReturn(SumReturn const &loopValues, double const center);
+
     template<typename ImageT, typename MaskT, typename VarianceT>
     StandardReturn _getStandard(ImageT const &img, MaskT const &msk, VarianceT const &var, int const flags);
     template<typename ImageT, typename MaskT, typename VarianceT>
     StandardReturn _getStandard(ImageT const &img, MaskT const &msk, VarianceT const &var,
                                 int const flags, std::pair<double, double> clipinfo);
+    template<typename ImageT, typename MaskT, typename VarianceT>
+    StandardReturn _getStandard(ImageT const &img, MaskT const &msk, VarianceT const &var, int const flags,
+                                std::vector<typename ImageT::Pixel> &values,
+                                std::vector<lsst::afw::image::VariancePixel> &weights);
+    template<typename Pixel>
+    StandardReturn _getStandard(std::vector<Pixel> const &values,
+                                std::vector<lsst::afw::image::VariancePixel> const &weights,
+                                int const flags, std::pair<double, double> clipinfo);
 
     template<typename Pixel>
     double _percentile(std::vector<Pixel> &img, double const percentile);   
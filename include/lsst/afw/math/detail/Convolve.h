@@ -78,6 +78,13 @@ namespace detail {
             lsst::afw::math::SeparableKernel const& kernel,
             lsst::afw::math::ConvolutionControl const& convolutionControl);
 
+    template <typename OutImageT, typename InImageT>
+    void convolveWithBruteForce(
+            OutImageT &convolvedImage,
+            InImageT const& inImage,
+            lsst::afw::math::Kernel const& kernel,
+            lsst::afw::math::ConvolutionControl const& convolutionControl);
+
     template <typename OutImageT, typename InImageT>
     void convolveWithBruteForce(
             OutImageT &convolvedImage,
@@ -85,6 +92,13 @@ namespace detail {
             lsst::afw::math::Kernel const& kernel,
             bool doNormalize);
 
+    template <typename OutImageT, typename InImageT>
+    void convolveWithFft(
+            OutImageT &convolvedImage,
+            InImageT const& inImage,
+            lsst::afw::math::Kernel const& kernel,
+            lsst::afw::math::ConvolutionControl const& convolutionControl);
+
     // I would prefer this to be nested in KernelImagesForRegion but SWIG doesn't support that
     class RowOfKernelImagesForRegion;
 
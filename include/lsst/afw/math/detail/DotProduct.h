@@ -0,0 +1,202 @@
+// -*- LSST-C++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_AFW_MATH_DETAIL_DOTPRODUCT_H
+#define LSST_AFW_MATH_DETAIL_DOTPRODUCT_H
+/**
+ * @file
+ *
+ * @brief Vectorized dot products of contiguous rows of %image and kernel pixels
+ *
+ * These are the innermost loops of convolution. The instruction set (SSE2 or AVX2) is chosen at runtime
+ * from the features of the CPU; if neither is available (or SIMD_NONE is selected) callers use
+ * their generic (template) code instead. The addDotProduct overloads encapsulate this choice for
+ * rows of float and double Image and MaskedImage pixels.
+ *
+ * As with the generic code, kernel pixels that are exactly 0 are ignored (so a NaN %image pixel
+ * under a zero kernel pixel does not contaminate the result). Sums are accumulated in double precision,
+ * so results may differ from the generic code by roundoff.
+ *
+ * @ingroup afw
+ */
+#include "lsst/afw/image/LsstImageTypes.h"
+#include "lsst/afw/image/Image.h"
+#include "lsst/afw/image/MaskedImage.h"
+
+namespace lsst {
+namespace afw {
+namespace math {
+namespace detail {
+
+    /**
+     * @brief Instruction sets that may be used to vectorize dot products
+     */
+    enum SimdLevel {
+        SIMD_NONE = 0,  ///< do not vectorize; use generic template code
+        SIMD_SSE2,      ///< use SSE2 instructions
+        SIMD_AVX2       ///< use AVX2 instructions
+    };
+
+    SimdLevel getSimdLevel();
+    SimdLevel getMaxSimdLevel();
+    void setSimdLevel(SimdLevel simdLevel);
+
+    double dotProduct(float const *image, double const *kernel, int n);
+    double dotProduct(double const *image, double const *kernel, int n);
+
+    void maskedDotProduct(
+        float const *image,
+        lsst::afw::image::MaskPixel const *mask,
+        lsst::afw::image::VariancePixel const *variance,
+        double const *kernel,
+        int n,
+        double &imageSum,
+        lsst::afw::image::MaskPixel &maskSum,
+        double &varianceSum);
+    void maskedDotProduct(
+        double const *image,
+        lsst::afw::image::MaskPixel const *mask,
+        lsst::afw::image::VariancePixel const *variance,
+        double const *kernel,
+        int n,
+        double &imageSum,
+        lsst::afw::image::MaskPixel &maskSum,
+        double &varianceSum);
+
+    /**
+     * @brief Add the dot product of a kernel row and a row of %image pixels to outPixel, if it can be vectorized
+     *
+     * This generic version handles %image pixel types and iterators that cannot be vectorized.
+     *
+     * @return false (outPixel is not modified); the caller must compute the dot product itself
+     */
+    template <typename OutPixelT, typename ImageIterT>
+    inline bool addDotProduct(
+            OutPixelT &,            ///< accumulated output pixel
+            ImageIterT,             ///< iterator or locator for first %image pixel of row
+            double const *,         ///< first kernel pixel of row
+            int)                    ///< number of pixels in row
+    {
+        return false;
+    }
+
+    /**
+     * @brief Add the dot product of a kernel row and a contiguous row of %image pixels to outPixel
+     *
+     * @return true if the dot product was computed and added, false if SIMD is disabled
+     */
+    template <typename OutPixelT, typename ImagePixelT>
+    inline bool addRowDotProduct(
+            OutPixelT &outPixel,        ///< accumulated output pixel
+            ImagePixelT const *image,   ///< first %image pixel of row
+            double const *kernel,       ///< first kernel pixel of row
+            int n)                      ///< number of pixels in row
+    {
+        if (getSimdLevel() == SIMD_NONE) {
+            return false;
+        }
+        outPixel += static_cast<OutPixelT>(dotProduct(image, kernel, n));
+        return true;
+    }
+
+    /**
+     * @brief Add the dot product of a kernel row and a contiguous row of MaskedImage pixels to outPixel
+     *
+     * @return true if the dot product was computed and added, false if SIMD is disabled
+     */
+    template <typename OutPixelT, typename ImagePixelT>
+    inline bool addRowDotProduct(
+            OutPixelT &outPixel,        ///< accumulated output pixel
+            ImagePixelT const *image,   ///< first %image pixel of row
+            lsst::afw::image::MaskPixel const *mask,            ///< first mask pixel of row
+            lsst::afw::image::VariancePixel const *variance,    ///< first variance pixel of row
+            double const *kernel,       ///< first kernel pixel of row
+            int n)                      ///< number of pixels in row
+    {
+        if (getSimdLevel() == SIMD_NONE) {
+            return false;
+        }
+        double imageSum;
+        lsst::afw::image::MaskPixel maskSum;
+        double varianceSum;
+        maskedDotProduct(image, mask, variance, kernel, n, imageSum, maskSum, varianceSum);
+        outPixel += OutPixelT(imageSum, maskSum, varianceSum);
+        return true;
+    }
+
+    template <typename OutPixelT>
+    inline bool addDotProduct(OutPixelT &outPixel,
+            lsst::afw::image::Image<float>::const_x_iterator imageIter, double const *kernel, int n) {
+        return addRowDotProduct(outPixel, &(*imageIter)[0], kernel, n);
+    }
+
+    template <typename OutPixelT>
+    inline bool addDotProduct(OutPixelT &outPixel,
+            lsst::afw::image::Image<double>::const_x_iterator imageIter, double const *kernel, int n) {
+        return addRowDotProduct(outPixel, &(*imageIter)[0], kernel, n);
+    }
+
+    template <typename OutPixelT>
+    inline bool addDotProduct(OutPixelT &outPixel,
+            lsst::afw::image::Image<float>::const_xy_locator imageLoc, double const *kernel, int n) {
+        return addRowDotProduct(outPixel, &(*imageLoc)[0], kernel, n);
+    }
+
+    template <typename OutPixelT>
+    inline bool addDotProduct(OutPixelT &outPixel,
+            lsst::afw::image::Image<double>::const_xy_locator imageLoc, double const *kernel, int n) {
+        return addRowDotProduct(outPixel, &(*imageLoc)[0], kernel, n);
+    }
+
+    template <typename OutPixelT>
+    inline bool addDotProduct(OutPixelT &outPixel,
+            lsst::afw::image::MaskedImage<float>::const_x_iterator imageIter, double const *kernel, int n) {
+        return addRowDotProduct(outPixel, &imageIter.image(), &imageIter.mask(), &imageIter.variance(),
+                                kernel, n);
+    }
+
+    template <typename OutPixelT>
+    inline bool addDotProduct(OutPixelT &outPixel,
+            lsst::afw::image::MaskedImage<double>::const_x_iterator imageIter, double const *kernel, int n) {
+        return addRowDotProduct(outPixel, &imageIter.image(), &imageIter.mask(), &imageIter.variance(),
+                                kernel, n);
+    }
+
+    template <typename OutPixelT>
+    inline bool addDotProduct(OutPixelT &outPixel,
+            lsst::afw::image::MaskedImage<float>::const_xy_locator imageLoc, double const *kernel, int n) {
+        return addRowDotProduct(outPixel, &imageLoc.image(), &imageLoc.mask(), &imageLoc.variance(),
+                                kernel, n);
+    }
+
+    template <typename OutPixelT>
+    inline bool addDotProduct(OutPixelT &outPixel,
+            lsst::afw::image::MaskedImage<double>::const_xy_locator imageLoc, double const *kernel, int n) {
+        return addRowDotProduct(outPixel, &imageLoc.image(), &imageLoc.mask(), &imageLoc.variance(),
+                                kernel, n);
+    }
+
+}}}}   // lsst::afw::math::detail
+
+#endif // !defined(LSST_AFW_MATH_DETAIL_DOTPRODUCT_H)
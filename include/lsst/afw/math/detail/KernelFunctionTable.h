@@ -0,0 +1,106 @@
+// -*- LSST-C++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_AFW_MATH_DETAIL_KERNELFUNCTIONTABLE_H
+#define LSST_AFW_MATH_DETAIL_KERNELFUNCTIONTABLE_H
+/**
+ * @file
+ *
+ * @brief An interpolated lookup table for a 1-dimensional kernel function
+ *
+ * @ingroup afw
+ */
+#include <vector>
+
+#include "boost/noncopyable.hpp"
+#include "boost/shared_ptr.hpp"
+
+#include "lsst/afw/math/Function.h"
+
+namespace lsst {
+namespace afw {
+namespace math {
+namespace detail {
+
+    /**
+     * @brief An immutable lookup table for a 1-dimensional kernel function f(x - offset)
+     *
+     * The function is sampled (with offset = 0) at samplesPerUnit points per unit of x
+     * over [-halfWidth, halfWidth] and linearly interpolated. Outside that range the function itself
+     * is evaluated. The interpolation error is at most h^2 max|f''| / 8, where h = 1/samplesPerUnit;
+     * getMaxError returns the largest error measured when the table was built.
+     *
+     * Tables are never modified once built, so a table may be shared by any number of kernels
+     * and used by any number of threads. getLanczosTable returns process-wide shared tables.
+     *
+     * The function must be shift-parameterized, i.e. its only parameter must be an offset
+     * such that f(x; offset) = f(x - offset; 0), as is the case for LanczosFunction1.
+     */
+    class KernelFunctionTable : private boost::noncopyable {
+    public:
+        typedef boost::shared_ptr<KernelFunctionTable const> ConstPtr;
+
+        enum { DEFAULT_SAMPLES_PER_UNIT = 4096 };   ///< default number of samples per unit of x
+
+        explicit KernelFunctionTable(
+            Function1<double> const &function,
+            double halfWidth,
+            int samplesPerUnit = DEFAULT_SAMPLES_PER_UNIT);
+
+        /**
+         * @brief Return the interpolated value of the function at x (with offset = 0)
+         */
+        double operator()(double x) const {
+            double const pos = (x + _halfWidth) * _samplesPerUnit;
+            if (!(pos >= 0) || (pos >= _maxPos)) {
+                return (*_functionPtr)(x);
+            }
+            int const ind = static_cast<int>(pos);
+            double const frac = pos - ind;
+            return _table[ind] + frac * (_table[ind + 1] - _table[ind]);
+        }
+
+        double computeValues(
+            std::vector<double> &valueList,
+            std::vector<double> const &xList,
+            double offset) const;
+
+        double getHalfWidth() const { return _halfWidth; }
+        int getSamplesPerUnit() const { return _samplesPerUnit; }
+        double getMaxError() const { return _maxError; }
+
+        static ConstPtr getLanczosTable(int order);
+
+    private:
+        Function1<double>::Ptr _functionPtr;    ///< function with offset 0; used outside the table
+        double _halfWidth;
+        int _samplesPerUnit;
+        double _maxPos;                         ///< largest table position that can be interpolated
+        std::vector<double> _table;
+        double _maxError;
+    };
+
+}}}}   // lsst::afw::math::detail
+
+#endif // !defined(LSST_AFW_MATH_DETAIL_KERNELFUNCTIONTABLE_H)
@@ -0,0 +1,152 @@
+// -*- LSST-C++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_AFW_MATH_DETAIL_PARALLEL_H
+#define LSST_AFW_MATH_DETAIL_PARALLEL_H
+/**
+ * @file
+ *
+ * @brief Simple support for splitting a computation into bands that are processed on separate threads
+ *
+ * The model is deliberately minimal: the caller splits its work into a list of independent functors
+ * (typically one per band of image rows), each owning whatever mutable state it needs (e.g. its own
+ * clone of a Kernel), and runInParallel runs them concurrently and waits for all of them to finish.
+ *
+ * @ingroup afw
+ */
+#include <algorithm>
+#include <exception>
+#include <string>
+#include <vector>
+
+#include "boost/thread.hpp"
+
+#include "lsst/pex/exceptions.h"
+
+namespace lsst {
+namespace afw {
+namespace math {
+namespace detail {
+
+    /**
+     * @brief Return the number of threads to use given a requested number
+     *
+     * @return nThreads if > 0, else the number of hardware threads (at least 1)
+     */
+    inline int computeNThreads(
+            int nThreads)   ///< requested number of threads; 0 for one per available core
+    {
+        if (nThreads > 0) {
+            return nThreads;
+        }
+        return std::max(static_cast<int>(boost::thread::hardware_concurrency()), 1);
+    }
+
+    /**
+     * @brief Split the range [begin, end) into bands of nearly equal length
+     *
+     * @return a list of nBands + 1 band edges: band i is [edges[i], edges[i+1]).
+     * If the range is shorter than nBands then fewer bands are returned, each of length 1.
+     */
+    inline std::vector<int> computeBandEdges(
+            int begin,      ///< start of range
+            int end,        ///< end of range (one past the last element)
+            int nBands)     ///< desired number of bands
+    {
+        int const length = std::max(end - begin, 0);
+        nBands = std::max(std::min(nBands, length), 1);
+        std::vector<int> edges;
+        edges.reserve(nBands + 1);
+        for (int i = 0; i <= nBands; ++i) {
+            edges.push_back(begin + static_cast<int>((static_cast<long>(length) * i) / nBands));
+        }
+        return edges;
+    }
+
+    /**
+     * @brief Call a functor, recording the message of any exception it throws
+     *
+     * Exceptions cannot propagate out of a boost::thread, so they are trapped here and rethrown
+     * (as a RuntimeErrorException) by runInParallel once all threads have finished.
+     */
+    template <typename FunctorT>
+    class TrapExceptions {
+    public:
+        TrapExceptions(FunctorT &functor, std::string &errorMessage) :
+            _functor(&functor), _errorMessage(&errorMessage) {}
+
+        void operator()() {
+            try {
+                (*_functor)();
+            } catch (lsst::pex::exceptions::Exception &e) {
+                *_errorMessage = e.what();
+            } catch (std::exception &e) {
+                *_errorMessage = e.what();
+            } catch (...) {
+                *_errorMessage = "unknown exception";
+            }
+        }
+    private:
+        FunctorT *_functor;
+        std::string *_errorMessage;
+    };
+
+    /**
+     * @brief Run each functor in a list on its own thread and wait for them all to finish
+     *
+     * The first functor is run on the calling thread. If there is only one functor then it is
+     * simply called, so exceptions propagate unchanged and no threads are created.
+     *
+     * @throw lsst::pex::exceptions::RuntimeErrorException if any functor run in parallel throws;
+     *  the message is that of the first failing functor (in list order).
+     */
+    template <typename FunctorT>
+    void runInParallel(
+            std::vector<FunctorT> &functorList) ///< functors to run; each must be callable as f()
+    {
+        if (functorList.size() == 1) {
+            functorList[0]();
+            return;
+        }
+        std::vector<std::string> errorList(functorList.size());
+        boost::thread_group threadGroup;
+        for (std::size_t i = 1; i < functorList.size(); ++i) {
+            threadGroup.create_thread(TrapExceptions<FunctorT>(functorList[i], errorList[i]));
+        }
+        if (!functorList.empty()) {
+            TrapExceptions<FunctorT>(functorList[0], errorList[0])();
+        }
+        threadGroup.join_all();
+
+        for (std::vector<std::string>::const_iterator errIter = errorList.begin();
+            errIter != errorList.end(); ++errIter) {
+            if (!errIter->empty()) {
+                throw LSST_EXCEPT(lsst::pex::exceptions::RuntimeErrorException, *errIter);
+            }
+        }
+    }
+
+}}}}   // lsst::afw::math::detail
+
+#endif // !defined(LSST_AFW_MATH_DETAIL_PARALLEL_H)
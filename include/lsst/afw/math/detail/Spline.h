@@ -16,6 +16,8 @@ public:
     void interpolate(std::vector<double> const& x, ///< points to interpolate at
                      std::vector<double> &y        ///< interpolated values at x
                     ) const;
+    double interpolate(double const x           ///< point to interpolate at
+                      ) const;
     void derivative(std::vector<double> const& x, ///< points to evaluate derivative at
                     std::vector<double> &dydx     ///< derivatives at x
                    ) const;
@@ -54,6 +56,26 @@ private:
                                 );
 };
 
+/*
+ * The natural cubic spline through a set of points; the same interpolant as gsl_interp_cspline
+ */
+class NaturalSpline : public Spline {
+public:
+    NaturalSpline(std::vector<double> const& x, ///< points where function's specified; monotonic increasing
+                  std::vector<double> const& y  ///< values of function at x
+                 );
+};
+
+/*
+ * Akima's spline through a set of points; the same interpolant as gsl_interp_akima
+ */
+class AkimaSpline : public Spline {
+public:
+    AkimaSpline(std::vector<double> const& x, ///< points where function's specified; monotonic increasing
+                std::vector<double> const& y  ///< values of function at x
+               );
+};
+
 class SmoothedSpline : public Spline {
 public:
     SmoothedSpline(std::vector<double> const& x,  ///< points where function's specified; monotonic increasing
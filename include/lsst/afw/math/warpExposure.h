@@ -59,22 +59,34 @@ namespace math {
     * The number of minima and maxima in the 1-dimensional Lanczos function is 2*order + 1.
     * The kernel has one pixel per function minimum or maximum; but as applied to warping,
     * the first or last pixel is always zero and can be omitted. Thus the kernel size is 2*order x 2*order.
+    *
+    * By default the kernel is computed from a lookup table of the Lanczos function that is shared by all
+    * kernels of the same order (see detail::KernelFunctionTable), with a maximum error of 3.1e-8
+    * (relative to the peak value of 1). Call setUseLookupTable(false) to evaluate the function exactly.
+    * A nearest-bin cache computed with computeCache takes precedence over the lookup table.
     */
     class LanczosWarpingKernel : public SeparableKernel {
     public:
         explicit LanczosWarpingKernel(
-            int order ///< order of Lanczos function
+            int order, ///< order of Lanczos function
+            bool useLookupTable = true ///< compute the kernel from a shared lookup table?
         )
         :
             SeparableKernel(2 * order, 2 * order,
                 LanczosFunction1<Kernel::Pixel>(order), LanczosFunction1<Kernel::Pixel>(order))
-        {}
+        {
+            setUseLookupTable(useLookupTable);
+        }
         
         virtual ~LanczosWarpingKernel() {}
         
         virtual Kernel::Ptr clone() const;
         
         int getOrder() const;
+
+        void setUseLookupTable(bool useLookupTable);
+
+        bool getUseLookupTable() const;
     };
 
     /**
@@ -187,7 +199,7 @@ namespace math {
     int warpExposure(
         DestExposureT &destExposure,
         SrcExposureT const &srcExposure,
-        SeparableKernel &warpingKernel, int const interpLength=0);
+        SeparableKernel &warpingKernel, int const interpLength=0, int const nThreads=1);
 
     template<typename DestImageT, typename SrcImageT>
     int warpImage(
@@ -195,7 +207,7 @@ namespace math {
         lsst::afw::image::Wcs const &destWcs,
         SrcImageT const &srcImage,
         lsst::afw::image::Wcs const &srcWcs,
-        SeparableKernel &warpingKernel, int const interpLength=0);
+        SeparableKernel &warpingKernel, int const interpLength=0, int const nThreads=1);
 
     namespace details {
         template <typename A, typename B>
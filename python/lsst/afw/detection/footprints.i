@@ -29,6 +29,7 @@
 #include "lsst/afw/detection/Peak.h"
 #include "lsst/afw/detection/Footprint.h"
 #include "lsst/afw/detection/FootprintSet.h"
+#include "lsst/afw/detection/FootprintIndex.h"
 #include "lsst/afw/detection/FootprintFunctor.h"
 #include "lsst/afw/detection/FootprintArray.h"
 #include "lsst/afw/detection/FootprintArray.cc"
@@ -44,6 +45,7 @@ SWIG_SHARED_PTR(FootprintSetU, lsst::afw::detection::FootprintSet<boost::uint16_
 SWIG_SHARED_PTR(FootprintSetI, lsst::afw::detection::FootprintSet<int, lsst::afw::image::MaskPixel>);
 SWIG_SHARED_PTR(FootprintSetF, lsst::afw::detection::FootprintSet<float, lsst::afw::image::MaskPixel>);
 SWIG_SHARED_PTR(FootprintSetD, lsst::afw::detection::FootprintSet<double, lsst::afw::image::MaskPixel>);
+SWIG_SHARED_PTR(FootprintIndex, lsst::afw::detection::FootprintIndex);
 SWIG_SHARED_PTR(FootprintList, std::vector<lsst::afw::detection::Footprint::Ptr >);
 
 %rename(assign) lsst::afw::detection::Footprint::operator=;
@@ -52,6 +54,7 @@ SWIG_SHARED_PTR(FootprintList, std::vector<lsst::afw::detection::Footprint::Ptr
 %include "lsst/afw/detection/Peak.h"
 %include "lsst/afw/detection/Footprint.h"
 %include "lsst/afw/detection/FootprintSet.h"
+%include "lsst/afw/detection/FootprintIndex.h"
 %include "lsst/afw/detection/FootprintFunctor.h"
 
 %define %thresholdOperations(TYPE)
@@ -69,6 +72,7 @@ SWIG_SHARED_PTR(FootprintList, std::vector<lsst::afw::detection::Footprint::Ptr
 
 %template(PeakContainerT)      std::vector<lsst::afw::detection::Peak::Ptr>;
 %template(SpanContainerT)      std::vector<lsst::afw::detection::Span::Ptr>;
+%template(SpanVectorT)         std::vector<lsst::afw::detection::Span>;
 %template(FootprintContainerT) std::vector<lsst::afw::detection::Footprint::Ptr>;
 
 %define %imageOperations(NAME, PIXEL_TYPE)
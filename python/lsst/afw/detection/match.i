@@ -24,13 +24,21 @@
 
 %{
 #include "lsst/afw/detection/Source.h"
+#include "lsst/afw/detection/SourceCatalog.h"
 #include "lsst/afw/detection/SourceMatch.h"
+#include "lsst/afw/detection/SourceSkyIndex.h"
 %}
 
 SWIG_SHARED_PTR(PersistableSourceMatchVector,
                 lsst::afw::detection::PersistableSourceMatchVector);
+SWIG_SHARED_PTR(SourceCatalog, lsst::afw::detection::SourceCatalog);
+SWIG_SHARED_PTR(SourceSkyIndex, lsst::afw::detection::SourceSkyIndex);
 
+%ignore lsst::afw::detection::SourceCatalog::operator[];
+
+%include "lsst/afw/detection/SourceCatalog.h"
 %include "lsst/afw/detection/SourceMatch.h"
+%include "lsst/afw/detection/SourceSkyIndex.h"
 
 %template(SourceMatchVector) std::vector<lsst::afw::detection::SourceMatch>;
 
@@ -38,6 +46,29 @@ SWIG_SHARED_PTR_DERIVED(PersistableSourceMatchVector,
                         lsst::daf::base::Persistable,
                         lsst::afw::detection::PersistableSourceMatchVector);
 
+%extend lsst::afw::detection::SourceCatalog {
+    lsst::afw::detection::SourceRow getRow(int i) const {
+        return (*$self)[i];
+    }
+
+    %pythoncode {
+    def __len__(self):
+        return self.size()
+
+    def __getitem__(self, i):
+        """Return row i of the catalog (a SourceRow)"""
+        if i >= self.size() or i < -self.size():
+            raise IndexError(i)
+        if i < 0:
+            i += self.size()
+        return self.getRow(i)
+
+    def __iter__(self):
+        for i in range(self.size()):
+            yield self.getRow(i)
+    }
+}
+
 %extend lsst::afw::detection::SourceMatch {
     %pythoncode {
     def __repr__(self):
@@ -263,7 +263,7 @@ All Footprint coordinates are divided by bin, as is right and proper for overlay
 
     with ds9.Buffering():
         borderWidth /= bin
-        for s in foot.getSpans():
+        for s in foot.getSpanVector():
             y, x0, x1 = s.getY(), s.getX0(), s.getX1()
 
             if origin:
@@ -152,6 +152,9 @@ def version(HeadURL = r"$HeadURL$"):
 %template(pairDoubleInt)    std::pair<double, int>;
 %template(pairDoubleDouble) std::pair<double, double>;
 %template(mapStringInt)     std::map<std::string, int>;
+%template(HeaderValues)     std::map<std::string, std::string>;
+%template(VectorHeaderValues) std::vector<std::map<std::string, std::string> >;
+%template(MapStringHeaderValues) std::map<std::string, std::map<std::string, std::string> >;
 
 /************************************************************************************************************/
 // Images, Masks, and MaskedImages
@@ -289,6 +292,24 @@ SWIG_SHARED_PTR(PsfPtr, lsst::afw::detection::Psf);
 
 /************************************************************************************************************/
 
+%include "lsst/afw/image/ImagePrefetcher.h"
+
+%template(VectorPrefetchRequest) std::vector<lsst::afw::image::PrefetchRequest>;
+
+%define %imagePrefetcher(TYPE, PIXEL_TYPE)
+%template(MaskedImagePrefetcher##TYPE) lsst::afw::image::ImagePrefetcher<
+    lsst::afw::image::MaskedImage<PIXEL_TYPE, lsst::afw::image::MaskPixel, lsst::afw::image::VariancePixel> >;
+%template(ExposurePrefetcher##TYPE) lsst::afw::image::ImagePrefetcher<
+    lsst::afw::image::Exposure<PIXEL_TYPE, lsst::afw::image::MaskPixel, lsst::afw::image::VariancePixel> >;
+%enddef
+
+%imagePrefetcher(U, boost::uint16_t);
+%imagePrefetcher(I, int);
+%imagePrefetcher(F, float);
+%imagePrefetcher(D, double);
+
+/************************************************************************************************************/
+
 %include "lsst/afw/image/Color.h"
 
 /************************************************************************************************************/
@@ -31,6 +31,7 @@
 
 %define %declareStacks(PIXTYPE)
 %template(statisticsStack) lsst::afw::math::statisticsStack<PIXTYPE>;
+%template(statisticsStackFits) lsst::afw::math::statisticsStackFits<PIXTYPE>;
 %enddef
 
 %declareStacks(float)
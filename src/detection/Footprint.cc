@@ -26,16 +26,16 @@
  * \brief Footprint and associated classes
  */
 #include <cassert>
+#include <cmath>
 #include <string>
 #include <typeinfo>
 #include <algorithm>
 #include "boost/format.hpp"
+#include "boost/thread.hpp"
 #include "lsst/pex/logging/Trace.h"
 #include "lsst/pex/exceptions.h"
 #include "lsst/afw/detection/Peak.h"
 #include "lsst/afw/image/Mask.h"
-#include "lsst/afw/math/Kernel.h"
-#include "lsst/afw/math/KernelFunctions.h"
 #include "lsst/afw/detection/Footprint.h"
 #include "lsst/afw/detection/FootprintFunctor.h"
 #include "lsst/afw/detection/FootprintSet.h"
@@ -64,15 +64,15 @@ namespace {
  * A utility functor passed to sort
  */
     struct compareSpanByYX : 
-        public std::binary_function<Span::ConstPtr, Span::ConstPtr, bool> {
-        int operator()(Span::ConstPtr a, Span::ConstPtr b) {
-            if (a->getY() < b->getY()) {
+        public std::binary_function<Span, Span, bool> {
+        bool operator()(Span const& a, Span const& b) const {
+            if (a.getY() < b.getY()) {
                 return true;
-            } else if (a->getY() == b->getY()) {
-                if (a->getX0() < b->getX0()) {
+            } else if (a.getY() == b.getY()) {
+                if (a.getX0() < b.getX0()) {
                     return true;
-                } else if (a->getX0() == b->getX0()) {
-                    if (a->getX1() < b->getX1()) {
+                } else if (a.getX0() == b.getX0()) {
+                    if (a.getX1() < b.getX1()) {
                         return true;
                     }
                 }
@@ -80,6 +80,15 @@ namespace {
             return false;
         }
     };
+/*
+ * Compare two Span%s by y alone; used to find a row in a normalized Footprint
+ */
+    struct compareSpanByY : 
+        public std::binary_function<Span, Span, bool> {
+        bool operator()(Span const& a, Span const& b) const {
+            return a.getY() < b.getY();
+        }
+    };
 } //end namespace
 
 /******************************************************************************/
@@ -107,6 +116,7 @@ Footprint::Footprint(
 ) : lsst::daf::data::LsstBase(typeid(this)),
     _fid(++id),
     _area(0),
+    _spanListIsValid(false),
     _bbox(geom::Box2I()),
     _region(region),
     _normalized(true) 
@@ -116,6 +126,7 @@ Footprint::Footprint(
             lsst::pex::exceptions::InvalidParameterException,
             (boost::format("Number of spans requested is -ve: %d") % nspan).str());
     }
+    _spans.reserve(nspan);
 }
 /**
  * Create a rectangular Footprint
@@ -126,8 +137,10 @@ Footprint::Footprint(
 ) : lsst::daf::data::LsstBase(typeid(this)),
     _fid(++id),
     _area(0),
+    _spanListIsValid(false),
     _bbox(bbox),
-    _region(region)
+    _region(region),
+    _normalized(true)
 {
     int const x0 = bbox.getMinX();
     int const y0 = bbox.getMinY();
@@ -137,7 +150,6 @@ Footprint::Footprint(
     for (int i = y0; i <= y1; i++) {
         addSpan(i, x0, x1);
     }
-    _normalized=true;
 }
 Footprint::Footprint(
     geom::Point2I const & center, 
@@ -146,8 +158,10 @@ Footprint::Footprint(
 ) : lsst::daf::data::LsstBase(typeid(this)),
     _fid(++id),
     _area(0),
+    _spanListIsValid(false),
     _bbox(geom::BoxI()),
-    _region(region)    
+    _region(region),
+    _normalized(true)
 {
     int const r2 = static_cast<int>(radius*radius + 0.5); // rounded radius^2
     int const r = static_cast<int>(std::sqrt(static_cast<double>(r2))); // truncated radius; r*r <= r2
@@ -156,7 +170,6 @@ Footprint::Footprint(
         int hlen = static_cast<int>(std::sqrt(static_cast<double>(r2 - i*i)));
         addSpan(center.getY() + i, center.getX() - hlen, center.getX() + hlen);
     }
-    _normalized = true;
 }
 Footprint::Footprint(
     geom::ellipses::Ellipse const & ellipse, 
@@ -164,6 +177,7 @@ Footprint::Footprint(
 ) :  lsst::daf::data::LsstBase(typeid(this)),
     _fid(++id),
     _area(0),
+    _spanListIsValid(false),
     _bbox(geom::Box2I()),
     _region(region),
     _normalized(true)
@@ -203,7 +217,28 @@ Footprint::Footprint(
 }
 
 /**
- * Construct a footprint from a list of spans. Resulting Footprint is not
+ * Construct a footprint from a vector of spans. Resulting Footprint is not
+ * normalized
+ */
+Footprint::Footprint(
+    Footprint::SpanVector const & spans,
+    geom::Box2I const & region
+) : lsst::daf::data::LsstBase(typeid(this)),
+    _fid(++id),
+    _area(0),
+    _spanListIsValid(false),
+    _bbox(geom::Box2I()),
+    _region(region),
+    _normalized(false)
+{
+    _spans.reserve(spans.size());
+    for(SpanVector::const_iterator i(spans.begin()); i != spans.end(); ++i) {
+        addSpan(*i);
+    }
+}
+
+/**
+ * Construct a footprint from a list of pointers to spans. Resulting Footprint is not
  * normalized
  */
 Footprint::Footprint(
@@ -212,6 +247,7 @@ Footprint::Footprint(
 ) : lsst::daf::data::LsstBase(typeid(this)),
     _fid(++id),
     _area(0),
+    _spanListIsValid(false),
     _bbox(geom::Box2I()),
     _region(region),
     _normalized(false)
@@ -225,19 +261,13 @@ Footprint::Footprint(
 Footprint::Footprint(Footprint const & other) 
   : lsst::daf::data::LsstBase(typeid(this)),
     _fid(++id),
+    _area(other._area),
+    _spans(other._spans),
+    _spanListIsValid(false),
     _bbox(other._bbox),
-    _region(other._region)
+    _region(other._region),
+    _normalized(other._normalized)
 {
-    //deep copy spans
-    _spans.reserve(other._spans.size());
-    for(SpanList::const_iterator i(other._spans.begin()); 
-        i != other._spans.end(); ++i
-    ) {
-        addSpan(**i);
-    }
-    _area = other._area;
-    _normalized = other._normalized;
-
     //deep copy peaks
     _peaks.reserve(other._peaks.size());
     for(PeakList::const_iterator i(other._peaks.begin()); i != other._peaks.end(); ++i) {
@@ -251,6 +281,34 @@ Footprint::Footprint(Footprint const & other)
 Footprint::~Footprint() {
 }
 
+namespace {
+    boost::mutex spanListMutex;         // serialises getSpans()'s updates of Footprints' _spanList caches
+}
+
+/**
+ * Return the Span%s contained in this Footprint as a list of pointers
+ *
+ * The list holds copies of the Spans returned by getSpanVector(), made the first time that it's requested
+ * after the Footprint changes; modifying them doesn't modify the Footprint.  Prefer getSpanVector(),
+ * which doesn't copy anything.
+ *
+ * getSpans() may be called from several threads at once, but (as with the Footprint's other accessors)
+ * not while the Footprint's being modified, which also invalidates the returned list
+ */
+Footprint::SpanList const & Footprint::getSpans() const {
+    boost::lock_guard<boost::mutex> lock(spanListMutex);
+
+    if (!_spanListIsValid) {
+        _spanList.clear();
+        _spanList.reserve(_spans.size());
+        for (SpanVector::const_iterator i = _spans.begin(); i != _spans.end(); ++i) {
+            _spanList.push_back(Span::Ptr(new Span(*i)));
+        }
+        _spanListIsValid = true;
+    }
+    return _spanList;
+}
+
 /**
  * Does this Footprint contain this pixel?
  */
@@ -259,9 +317,13 @@ bool Footprint::contains(
 ) const
 {
     if (_bbox.contains(pix)) {
-        for (Footprint::SpanList::const_iterator siter = _spans.begin(); siter != _spans.end(); ++siter){
-            Span::ConstPtr span = *siter;
-            
+        SpanVector::const_iterator begin = _spans.begin(), end = _spans.end();
+        if (_normalized) {              // the Spans are sorted, so we can go straight to pix's row
+            Span const row(pix.getY(), pix.getX(), pix.getX());
+            begin = std::lower_bound(begin, end, row, compareSpanByY());
+            end = std::upper_bound(begin, end, row, compareSpanByY());
+        }
+        for (SpanVector::const_iterator span = begin; span != end; ++span) {
             if (span->_y == pix.getY() && pix.getX() >= span->_x0 && pix.getX() <= span->_x1) {
                 return true;
             }
@@ -283,55 +345,32 @@ void Footprint::normalize() {
         // in only one span
         //
         sort(_spans.begin(), _spans.end(), compareSpanByYX());
-
-        Footprint::SpanList::iterator ptr = _spans.begin(), end = _spans.end();
-        
-        Span *lspan = ptr->get();  // Left span
-        int y = lspan->_y;
-        int x1 = lspan->_x1;
-        _area = lspan->getWidth();
-        int minX = lspan->_x0, minY=y, maxX=x1;
-
-        ++ptr;
-
-        for (; ptr != end; ++ptr) {
-            Span *rspan = ptr->get(); // Right span
-            if (rspan->_y == y) {
-                if (rspan->_x0 <= x1 + 1) { // Spans overlap or touch
-                    if (rspan->_x1 > x1) {  // right span extends left span
-                        //update area
-                        _area += rspan->_x1 - x1;
-                        //update end of current span
-                        x1 = lspan->_x1 = rspan->_x1;
-                        //update bounds
-                        if(x1 > maxX) maxX = x1;
-                    }                    
-                    
-                    ptr = _spans.erase(ptr);
-                    end = _spans.end();   // delete the right span
-                    if (ptr == end) {
-                        break;
-                    }
-                    
-                    --ptr;
-                    continue;
-                } 
-                else{
-                    _area += rspan->getWidth();
-                    if(rspan->_x1 > maxX) maxX = rspan->_x1;
+        //
+        // Merge Spans that overlap or touch into the Span to their left, packing the survivors
+        // at the start of _spans
+        //
+        SpanVector::iterator lspan = _spans.begin(); // Left span
+        int minX = lspan->_x0, maxX = lspan->_x1;
+        _area = 0;
+
+        for (SpanVector::const_iterator rspan = lspan + 1, end = _spans.end(); rspan != end; ++rspan) {
+            if (rspan->_y == lspan->_y && rspan->_x0 <= lspan->_x1 + 1) { // Spans overlap or touch
+                if (rspan->_x1 > lspan->_x1) {  // right span extends left span
+                    lspan->_x1 = rspan->_x1;
                 }
             } else {
-                _area += rspan->getWidth();
+                _area += lspan->getWidth();
+                *++lspan = *rspan;
             }
 
-            y = rspan->_y;            
-            x1 = rspan->_x1;
-            
-            lspan = rspan;
-            if(lspan->_x0 < minX) minX = lspan->_x0;
-            if(x1 > maxX) maxX = x1;
+            if (rspan->_x0 < minX) minX = rspan->_x0;
+            if (rspan->_x1 > maxX) maxX = rspan->_x1;
         }
-        _bbox = geom::Box2I(geom::Point2I(minX, minY), geom::Point2I(maxX, y));
+        _area += lspan->getWidth();
+        _spans.erase(lspan + 1, _spans.end());
+        _spanListIsValid = false;
+
+        _bbox = geom::Box2I(geom::Point2I(minX, _spans.front()._y), geom::Point2I(maxX, lspan->_y));
 
         _normalized = true;
     }
@@ -339,6 +378,8 @@ void Footprint::normalize() {
 
 /**
  * Add a Span to a footprint, returning a reference to the new Span.
+ *
+ * \note The reference is only valid until the Footprint's Spans are next modified
  */
 Span const& Footprint::addSpan(
     int const y, //!< row value
@@ -349,16 +390,20 @@ Span const& Footprint::addSpan(
         return this->addSpan(y, x1, x0);
     }
 
-    Span::Ptr sp(new Span(y, x0, x1));
-    _spans.push_back(sp);
+    if (_normalized && !_spans.empty()) { // we stay normalized if the new Span follows the last one
+        Span const& last = _spans.back();
+        _normalized = (y > last._y || (y == last._y && x0 > last._x1 + 1));
+    }
+
+    _spans.push_back(Span(y, x0, x1));
+    _spanListIsValid = false;
 
-    _area += sp->getWidth();
-    _normalized = false;
+    _area += x1 - x0 + 1;
 
     _bbox.include(geom::Point2I(x0, y));
     _bbox.include(geom::Point2I(x1, y));
 
-    return *sp.get();
+    return _spans.back();
 }
 /**
  * Add a Span to a Footprint returning a reference to the new Span
@@ -386,13 +431,10 @@ void Footprint::shift(
     int dx, //!< How much to move footprint in column direction
     int dy  //!< How much to move in row direction
 ) {
-    for (SpanList::iterator i = _spans.begin(); i != _spans.end(); ++i){
-        Span::Ptr span = *i;
-
-        span->_y += dy;
-        span->_x0 += dx;
-        span->_x1 += dx;
+    for (SpanVector::iterator i = _spans.begin(); i != _spans.end(); ++i){
+        i->shift(dx, dy);
     }
+    _spanListIsValid = false;
 
     _bbox.shift(geom::Extent2I(dx, dy));
 }
@@ -406,7 +448,7 @@ namespace {
     template<bool overwriteId>
     void
     doInsertIntoImage(geom::Box2I const& _region, // unpacked from Footprint
-                      Footprint::SpanList const& _spans,      // unpacked from Footprint
+                      Footprint::SpanVector const& _spans,    // unpacked from Footprint
                       image::Image<boost::uint16_t>& idImage, // Image to contain the footprint
                       int const id,                           // Add/replace id to idImage for pixels in Footprint
                       geom::Box2I const& region,              // Footprint's region (default: getRegion())
@@ -438,19 +480,19 @@ namespace {
         if (oldIds) {
             pos = oldIds->begin();
         }
-        for (Footprint::SpanList::const_iterator spi = _spans.begin(); spi != _spans.end(); ++spi) {
-            Span::Ptr const span = *spi;
+        for (Footprint::SpanVector::const_iterator spi = _spans.begin(); spi != _spans.end(); ++spi) {
+            Span const& span = *spi;
 
-            int const sy0 = span->getY() - y0;
+            int const sy0 = span.getY() - y0;
             if (sy0 < 0 || sy0 >= height) {
                 continue;
             }
 
-            int sx0 = span->getX0() - x0;
+            int sx0 = span.getX0() - x0;
             if (sx0 < 0) {
                 sx0 = 0;
             }
-            int sx1 = span->getX1() - x0;
+            int sx1 = span.getX1() - x0;
             int const swidth = (sx1 >= width) ? width - sx0 : sx1 - sx0 + 1;
 
             for (image::Image<boost::uint16_t>::x_iterator ptr = idImage.x_at(sx0, sy0),
@@ -508,7 +550,18 @@ Footprint::insertIntoImage(
 
 template <typename Archive>
 void Footprint::serialize(Archive & ar, const unsigned int version) {
-    ar & make_nvp("spans", _spans);
+    if (version > 0) {
+        ar & make_nvp("spans", _spans);
+    } else {                            // Spans were stored by pointer; only read, as we always write v1
+        SpanList spans;
+        ar & make_nvp("spans", spans);
+        _spans.clear();
+        _spans.reserve(spans.size());
+        for (SpanList::const_iterator i = spans.begin(); i != spans.end(); ++i) {
+            _spans.push_back(**i);
+        }
+    }
+    _spanListIsValid = false;
     ar & make_nvp("peaks", _peaks);
     ar & make_nvp("area", _area);
     ar & make_nvp("normalized", _normalized);
@@ -551,14 +604,8 @@ template void Footprint::serialize(boost::archive::binary_iarchive &, unsigned i
 Footprint & Footprint::operator=(Footprint::Footprint & other) {
     _region = other._region;
 
-    //deep copy spans
-    _spans = SpanList();
-    _spans.reserve(other._spans.size());
-    for(SpanList::const_iterator i(other._spans.begin()); 
-        i != other._spans.end(); ++i
-    ) {
-        addSpan(**i);
-    }
+    _spans = other._spans;
+    _spanListIsValid = false;
     _area = other._area;
     _normalized = other._normalized;
     _bbox = other._bbox;
@@ -591,23 +638,23 @@ void Footprint::intersectMask(
     //make sure this is normalized
     normalize();
 
-    SpanList::iterator s(_spans.begin()); 
-    while((*s)->getY() < maskBBox.getMinY() && s != _spans.end()){
+    SpanVector::const_iterator s(_spans.begin()); 
+    while(s != _spans.end() && s->getY() < maskBBox.getMinY()){
         ++s;
     }
 
 
     int x0, x1, y;
-    SpanList maskedSpans;
+    SpanVector maskedSpans;
     int maskedArea=0;
     for( ; s != _spans.end(); ++s) {
-        y = (*s)->getY();
+        y = s->getY();
 
         if (y > maskBBox.getMaxY())
             break;
 
-        x0 = (*s)->getX0();
-        x1 = (*s)->getX1();
+        x0 = s->getX0();
+        x1 = s->getX1();
 
         if(x1 < maskBBox.getMinX() || x0 > maskBBox.getMaxX()) {
             //span is entirely outside the image mask. cannot be used
@@ -632,9 +679,8 @@ void Footprint::intersectMask(
                     //add beginning of span to the output
                     //the fixed span contains all the unmasked pixels up to,
                     //but not including this masked pixel
-                    Span::Ptr maskedSpan(new Span(y, x0, x- 1));
-                    maskedSpans.push_back(maskedSpan);                
-                    maskedArea += maskedSpan->getWidth();
+                    maskedSpans.push_back(Span(y, x0, x- 1));
+                    maskedArea += maskedSpans.back().getWidth();
                 }
                 //set the next Span to start after this pixel
                 x0 = x + 1;
@@ -643,13 +689,13 @@ void Footprint::intersectMask(
         
         //add last section of span
         if(x0 <= x1) {
-            Span::Ptr maskedSpan(new Span(y, x0, x1));
-            maskedSpans.push_back(maskedSpan);
-            maskedArea += maskedSpan->getWidth();
+            maskedSpans.push_back(Span(y, x0, x1));
+            maskedArea += maskedSpans.back().getWidth();
         }
     }
     _area = maskedArea;
-    _spans = maskedSpans;
+    _spans.swap(maskedSpans);
+    _spanListIsValid = false;
     _bbox.clip(maskBBox);
 }
 
@@ -693,16 +739,16 @@ MaskT setMaskFromFootprint(
     int const width = static_cast<int>(mask->getWidth());
     int const height = static_cast<int>(mask->getHeight());
 
-    for (Footprint::SpanList::const_iterator siter = foot.getSpans().begin();
-         siter != foot.getSpans().end(); siter++) {
-        Span::Ptr const span = *siter;
-        int const y = span->getY() - mask->getY0();
+    for (Footprint::SpanVector::const_iterator siter = foot.getSpanVector().begin();
+         siter != foot.getSpanVector().end(); siter++) {
+        Span const& span = *siter;
+        int const y = span.getY() - mask->getY0();
         if (y < 0 || y >= height) {
             continue;
         }
 
-        int x0 = span->getX0() - mask->getX0();
-        int x1 = span->getX1() - mask->getX0();
+        int x0 = span.getX0() - mask->getX0();
+        int x1 = span.getX1() - mask->getX0();
         x0 = (x0 < 0) ? 0 : (x0 >= width ? width - 1 : x0);
         x1 = (x1 < 0) ? 0 : (x1 >= width ? width - 1 : x1);
 
@@ -830,12 +876,12 @@ static void set_footprint_id(
     int const id,                     // the desired ID
     int dx=0, int dy=0                // Add these to all x/y in the Footprint
 ) {
-    for (Footprint::SpanList::const_iterator i = foot.getSpans().begin();
-         i != foot.getSpans().end(); i++) {
-        Span::Ptr const span = *i;
+    for (Footprint::SpanVector::const_iterator i = foot.getSpanVector().begin();
+         i != foot.getSpanVector().end(); i++) {
+        Span const& span = *i;
         for (typename image::Image<IDPixelT>::x_iterator ptr =
-                 idImage->x_at(span->getX0() + dx, span->getY() + dy),
-                 end = ptr + span->getWidth(); ptr != end; ++ptr) {
+                 idImage->x_at(span.getX0() + dx, span.getY() + dy),
+                 end = ptr + span.getWidth(); ptr != end; ++ptr) {
             *ptr = id;
         }
     }
@@ -929,13 +975,16 @@ template image::Image<int>::Ptr setFootprintID(Footprint::Ptr const& foot, int c
 /*
  * Grow a Footprint isotropically by r pixels, returning a new Footprint
  *
- * N.b. this is slow, as it uses a convolution with a disk
+ * The result is the dilation of foot by a disk, i.e. all pixels within a distance ngrow of a pixel
+ * in foot.  We build it directly from the Spans: each row dy of the disk has a half-width hw[dy],
+ * so each Span contributes a Span widened by hw[dy] to each of the 2*ngrow + 1 rows around it;
+ * normalize() then merges the overlapping pieces.
  */
 namespace {
-Footprint::Ptr growFootprintSlow(
-        Footprint const& foot, //!< The Footprint to grow
-        int ngrow                              //!< how much to grow foot
-                                                 ) {
+Footprint::Ptr growFootprintIsotropic(
+        Footprint const& foot,          //!< The Footprint to grow
+        int ngrow                       //!< how much to grow foot
+                                     ) {
     if (ngrow < 0) {
         ngrow = 0;                      // ngrow == 0 => no grow
     }
@@ -943,48 +992,31 @@ Footprint::Ptr growFootprintSlow(
     if (foot.getNpix() == 0) {          // an empty Footprint
         return Footprint::Ptr(new Footprint);
     }
-
     /*
-     * We'll insert the footprints into an image, then convolve with a disk,
-     * then extract a footprint from the result --- this is magically what we want.
+     * The disk's half-widths; (dx, dy) is in the disk if dx*dx + dy*dy <= ngrow*ngrow
      */
-    geom::Box2I bbox = foot.getBBox();
-    bbox.grow(2*ngrow);
-    image::Image<int>::Ptr idImage(new image::Image<int>(bbox));
-    *idImage = 0;
-    idImage->setXY0(0, 0);
-
-    set_footprint_id<int>(idImage, foot, 1, -bbox.getMinX(), -bbox.getMinY());
-
-
-    image::Image<double>::Ptr circle_im(
-        new image::Image<double>(geom::Extent2I(2*ngrow + 1, 2*ngrow + 1))
-    );
-    *circle_im = 0;
-    for (int r = -ngrow; r <= ngrow; ++r) {
-        image::Image<double>::x_iterator row = circle_im->x_at(0, r + ngrow);
-        for (int c = -ngrow; c <= ngrow; ++c, ++row) {
-            if (r*r + c*c <= ngrow*ngrow) {
-                *row = 8;
-            }
+    std::vector<int> hw(ngrow + 1);
+    for (int dy = 0; dy <= ngrow; ++dy) {
+        int const r2 = ngrow*ngrow - dy*dy;
+        int dx = static_cast<int>(std::sqrt(static_cast<double>(r2)));
+        while (dx*dx > r2) {            // guard against rounding in sqrt
+            --dx;
         }
+        while ((dx + 1)*(dx + 1) <= r2) {
+            ++dx;
+        }
+        hw[dy] = dx;
     }
 
-    math::FixedKernel::Ptr circle(new math::FixedKernel(*circle_im));
-    // Here's the actual grow step
-    image::MaskedImage<int>::Ptr convolvedImage(new image::MaskedImage<int>(idImage->getDimensions()));
-    math::convolve(*convolvedImage->getImage(), *idImage, *circle, false);
-
-    FootprintSet<int>::Ptr
-        grownList(new FootprintSet<int>(*convolvedImage, 0.5, 1.0, "", 1));
-
-    assert (grownList->getFootprints()->size() > 0);
-    Footprint::Ptr grown = *grownList->getFootprints()->begin();
-    //
-    // Fix the coordinate system to be that of foot
-    //
-    grown->shift(bbox.getMinX(), bbox.getMinY());
-    grown->setRegion(foot.getRegion());
+    Footprint::SpanVector const& spans = foot.getSpanVector();
+    Footprint::Ptr grown(new Footprint(static_cast<int>(spans.size())*(2*ngrow + 1), foot.getRegion()));
+    for (Footprint::SpanVector::const_iterator sp = spans.begin(); sp != spans.end(); ++sp) {
+        for (int dy = -ngrow; dy <= ngrow; ++dy) {
+            int const dx = hw[dy < 0 ? -dy : dy];
+            grown->addSpan(sp->getY() + dy, sp->getX0() - dx, sp->getX1() + dx);
+        }
+    }
+    grown->normalize();
 
     return grown;
 }
@@ -998,11 +1030,10 @@ Footprint::Ptr growFootprint(
         Footprint const& foot,      //!< The Footprint to grow
         int ngrow,                             //!< how much to grow foot
         bool isotropic                         //!< Grow isotropically (as opposed to a Manhattan metric)
-                                               //!< @note Isotropic grows are significantly slower
                                                  ) {
 
     if (isotropic) {
-        return growFootprintSlow(foot, ngrow);
+        return growFootprintIsotropic(foot, ngrow);
     }
 
     if (ngrow < 0) {
@@ -0,0 +1,383 @@
+// -*- LSST-C++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * \file
+ * \brief A spatial index over a list of Footprint%s
+ */
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <utility>
+#include "boost/format.hpp"
+#include "lsst/pex/exceptions.h"
+#include "lsst/afw/detection/FootprintIndex.h"
+
+namespace pexExcept = lsst::pex::exceptions;
+
+namespace lsst {
+namespace afw {
+namespace detection {
+
+namespace {
+    /*
+     * Compare the centres of two boxes in x (or y); used to sort boxes into tiles
+     */
+    class CompareCentres {
+    public:
+        CompareCentres(std::vector<geom::Box2I> const& boxes, bool const inY) : _boxes(&boxes), _inY(inY) {}
+
+        bool operator()(int a, int b) const {
+            geom::Box2I const& ba = (*_boxes)[a];
+            geom::Box2I const& bb = (*_boxes)[b];
+            if (_inY) {
+                return ba.getMinY() + ba.getMaxY() < bb.getMinY() + bb.getMaxY();
+            } else {
+                return ba.getMinX() + ba.getMaxX() < bb.getMinX() + bb.getMaxX();
+            }
+        }
+    private:
+        std::vector<geom::Box2I> const* _boxes;
+        bool _inY;
+    };
+    /*
+     * Sort items (indices into boxes) so that consecutive runs of nodeCapacity items are compact tiles:
+     * sort by x, cut into sqrt(nTile) vertical slices, and sort each slice by y (Sort-Tile-Recursive)
+     */
+    void sortIntoTiles(std::vector<int> &items, std::vector<geom::Box2I> const& boxes,
+                       int const nodeCapacity) {
+        std::size_t const n = items.size();
+        std::stable_sort(items.begin(), items.end(), CompareCentres(boxes, false));
+
+        std::size_t const nTile = (n + nodeCapacity - 1)/nodeCapacity;
+        std::size_t const nSlice = std::ceil(std::sqrt(static_cast<double>(nTile)));
+        std::size_t const sliceSize = nodeCapacity*((nTile + nSlice - 1)/nSlice);
+        for (std::size_t start = 0; start < n; start += sliceSize) {
+            std::stable_sort(items.begin() + start, items.begin() + std::min(start + sliceSize, n),
+                             CompareCentres(boxes, true));
+        }
+    }
+    /*
+     * Is a Span's row before y?  Used to binary search a normalized Footprint's Spans
+     */
+    struct SpanRowBefore {
+        template<typename T>
+        bool operator()(Span const& span, T const y) const { return span.getY() < y; }
+    };
+    /*
+     * Does a Footprint have any pixels in a box?
+     */
+    bool overlaps(Footprint const& foot, geom::Box2I const& box) {
+        Footprint::SpanVector const& spans = foot.getSpanVector();
+        Footprint::SpanVector::const_iterator ptr = spans.begin(), end = spans.end();
+        bool const normalized = foot.isNormalized();
+        if (normalized) {               // skip straight to box's first row
+            ptr = std::lower_bound(ptr, end, box.getMinY(), SpanRowBefore());
+        }
+        for (; ptr != end; ++ptr) {
+            if (normalized && ptr->getY() > box.getMaxY()) {
+                break;
+            }
+            if (ptr->getY() >= box.getMinY() && ptr->getY() <= box.getMaxY() &&
+                ptr->getX0() <= box.getMaxX() && ptr->getX1() >= box.getMinX()) {
+                return true;
+            }
+        }
+        return false;
+    }
+    /*
+     * Return the distance from v to the nearest of the (integer) values lo, lo + 1, ... hi
+     */
+    inline double distanceOutside(double const v, int const lo, int const hi) {
+        return (v < lo) ? lo - v : ((v > hi) ? v - hi : 0.0);
+    }
+    /*
+     * Return the squared distance from (x, y) to the nearest pixel centre in the Span [x0, x1] in row y0
+     */
+    inline double distanceSquared(int const x0, int const x1, int const y0, double const x, double const y) {
+        double const dx = distanceOutside(x, x0, x1);
+        double const dy = y - y0;
+        return dx*dx + dy*dy;
+    }
+    /*
+     * Return the squared distance from (x, y) to the nearest pixel centre in a box
+     */
+    double distanceSquared(geom::Box2I const& box, double const x, double const y) {
+        double const dx = distanceOutside(x, box.getMinX(), box.getMaxX());
+        double const dy = distanceOutside(y, box.getMinY(), box.getMaxY());
+        return dx*dx + dy*dy;
+    }
+    /*
+     * Return the squared distance from (x, y) to the nearest pixel centre in a Footprint
+     *
+     * If the Footprint is normalized we search outwards from y's row, stopping when no further row
+     * can be closer
+     */
+    double distanceSquared(Footprint const& foot, double const x, double const y) {
+        Footprint::SpanVector const& spans = foot.getSpanVector();
+        double best = std::numeric_limits<double>::max();
+
+        if (!foot.isNormalized()) {
+            for (Footprint::SpanVector::const_iterator ptr = spans.begin(); ptr != spans.end(); ++ptr) {
+                best = std::min(best, distanceSquared(ptr->getX0(), ptr->getX1(), ptr->getY(), x, y));
+            }
+            return best;
+        }
+
+        Footprint::SpanVector::const_iterator const mid =
+            std::lower_bound(spans.begin(), spans.end(), y, SpanRowBefore());
+        for (Footprint::SpanVector::const_iterator ptr = mid; ptr != spans.end(); ++ptr) {
+            double const dy = ptr->getY() - y;
+            if (dy*dy >= best) {
+                break;
+            }
+            best = std::min(best, distanceSquared(ptr->getX0(), ptr->getX1(), ptr->getY(), x, y));
+        }
+        for (Footprint::SpanVector::const_iterator ptr = mid; ptr != spans.begin(); ) {
+            --ptr;
+            double const dy = ptr->getY() - y;
+            if (dy*dy >= best) {
+                break;
+            }
+            best = std::min(best, distanceSquared(ptr->getX0(), ptr->getX1(), ptr->getY(), x, y));
+        }
+        return best;
+    }
+    /*
+     * A candidate for the Footprint nearest a point, ordered for a priority_queue
+     */
+    struct NearestCandidate {
+        NearestCandidate(double distance2_, bool exact_, int level_, int index_) :
+            distance2(distance2_), exact(exact_), level(level_), index(index_) {}
+        /*
+         * "less than" means "popped later": further away; or an exact distance rather than a bound
+         * (so that every Footprint at the same distance is considered); or a later Footprint
+         */
+        bool operator<(NearestCandidate const& rhs) const {
+            if (distance2 != rhs.distance2) {
+                return distance2 > rhs.distance2;
+            } else if (exact != rhs.exact) {
+                return exact;
+            } else {
+                return index > rhs.index;
+            }
+        }
+
+        double distance2;               // squared distance to the point, or a lower bound on it
+        bool exact;                     // is distance2 exact?
+        int level;                      // level in the R-tree; the number of levels for a Footprint
+        int index;                      // index of the node in its level, or of the Footprint
+    };
+}
+
+/**
+ * Build an index over a list of Footprints
+ *
+ * \throws lsst::pex::exceptions::InvalidParameterException if nodeCapacity < 2
+ */
+FootprintIndex::FootprintIndex(
+        FootprintList const& footprints, ///< the Footprints to index
+        int const nodeCapacity           ///< maximum number of children of each node of the R-tree
+                              ) : _footprints(footprints), _order(), _levels() {
+    if (nodeCapacity < 2) {
+        throw LSST_EXCEPT(pexExcept::InvalidParameterException,
+                          (boost::format("nodeCapacity must be at least 2, not %d") % nodeCapacity).str());
+    }
+    /*
+     * Pack the (non-empty) Footprints into leaves
+     */
+    std::vector<geom::Box2I> boxes;
+    boxes.reserve(_footprints.size());
+    for (std::size_t i = 0; i != _footprints.size(); ++i) {
+        boxes.push_back(_footprints[i] ? _footprints[i]->getBBox() : geom::Box2I());
+        if (!boxes.back().isEmpty()) {
+            _order.push_back(i);
+        }
+    }
+    if (_order.empty()) {
+        return;
+    }
+    sortIntoTiles(_order, boxes, nodeCapacity);
+
+    std::vector<Node> level;
+    for (std::size_t i = 0; i < _order.size(); i += nodeCapacity) {
+        std::size_t const end = std::min(i + nodeCapacity, _order.size());
+        geom::Box2I bbox;
+        for (std::size_t j = i; j != end; ++j) {
+            bbox.include(boxes[_order[j]]);
+        }
+        level.push_back(Node(bbox, i, end));
+    }
+    /*
+     * Pack each level's nodes into the level above, until we reach the root
+     */
+    while (level.size() > 1) {
+        boxes.clear();
+        std::vector<int> order;
+        for (std::size_t i = 0; i != level.size(); ++i) {
+            boxes.push_back(level[i].bbox);
+            order.push_back(i);
+        }
+        sortIntoTiles(order, boxes, nodeCapacity);
+
+        _levels.push_back(std::vector<Node>());
+        std::vector<Node> &sortedLevel = _levels.back();
+        sortedLevel.reserve(level.size());
+        for (std::size_t i = 0; i != order.size(); ++i) {
+            sortedLevel.push_back(level[order[i]]);
+        }
+
+        level.clear();
+        for (std::size_t i = 0; i < sortedLevel.size(); i += nodeCapacity) {
+            std::size_t const end = std::min(i + nodeCapacity, sortedLevel.size());
+            geom::Box2I bbox;
+            for (std::size_t j = i; j != end; ++j) {
+                bbox.include(sortedLevel[j].bbox);
+            }
+            level.push_back(Node(bbox, i, end));
+        }
+    }
+    _levels.push_back(level);
+    std::reverse(_levels.begin(), _levels.end());
+}
+
+/*
+ * Find the indices of all Footprints whose bounding boxes overlap box
+ */
+void FootprintIndex::_findCandidates(geom::Box2I const& box, std::vector<int> *candidates) const {
+    if (_levels.empty()) {
+        return;
+    }
+    int const nLevel = _levels.size();
+
+    std::vector<std::pair<int, int> > stack(1, std::make_pair(0, 0)); // (level, node) still to search
+    while (!stack.empty()) {
+        int const level = stack.back().first;
+        Node const& node = _levels[level][stack.back().second];
+        stack.pop_back();
+
+        if (!node.bbox.overlaps(box)) {
+            continue;
+        }
+        if (level + 1 == nLevel) {      // a leaf
+            for (int i = node.begin; i != node.end; ++i) {
+                if (_footprints[_order[i]]->getBBox().overlaps(box)) {
+                    candidates->push_back(_order[i]);
+                }
+            }
+        } else {
+            for (int i = node.begin; i != node.end; ++i) {
+                stack.push_back(std::make_pair(level + 1, i));
+            }
+        }
+    }
+}
+
+/**
+ * Return the Footprint containing a pixel, or an empty pointer if there is none
+ *
+ * If several Footprints contain the pixel, the first in the list that was indexed is returned
+ */
+Footprint::Ptr FootprintIndex::findContaining(
+        geom::Point2I const& pix        ///< the desired pixel
+                                             ) const {
+    std::vector<int> candidates;
+    _findCandidates(geom::Box2I(pix, pix), &candidates);
+
+    int best = -1;
+    for (std::vector<int>::const_iterator ptr = candidates.begin(); ptr != candidates.end(); ++ptr) {
+        if ((best < 0 || *ptr < best) && _footprints[*ptr]->contains(pix)) {
+            best = *ptr;
+        }
+    }
+    return (best < 0) ? Footprint::Ptr() : _footprints[best];
+}
+
+/**
+ * Return all the Footprints with at least one pixel in a box, in the order of the list that was indexed
+ */
+FootprintIndex::FootprintList FootprintIndex::findOverlapping(
+        geom::Box2I const& box          ///< the box in question
+                                                             ) const {
+    std::vector<int> candidates;
+    _findCandidates(box, &candidates);
+    std::sort(candidates.begin(), candidates.end());
+
+    FootprintList found;
+    for (std::vector<int>::const_iterator ptr = candidates.begin(); ptr != candidates.end(); ++ptr) {
+        if (overlaps(*_footprints[*ptr], box)) {
+            found.push_back(_footprints[*ptr]);
+        }
+    }
+    return found;
+}
+
+/**
+ * Return the Footprint with a pixel centre nearest to a point, or an empty pointer if the index is empty
+ *
+ * A Footprint containing the point is at distance zero.  If several Footprints are equally near, the
+ * first in the list that was indexed is returned
+ */
+Footprint::Ptr FootprintIndex::findNearest(
+        geom::Point2D const& point      ///< the point in question
+                                          ) const {
+    if (_levels.empty()) {
+        return Footprint::Ptr();
+    }
+    int const nLevel = _levels.size();
+    double const x = point.getX();
+    double const y = point.getY();
+    /*
+     * A best-first search: the queue holds nodes and Footprints ordered by a lower bound on their
+     * distance; a Footprint's exact distance is calculated when it reaches the head of the queue,
+     * and it is the answer when that exact distance in turn reaches the head
+     */
+    std::priority_queue<NearestCandidate> queue;
+    queue.push(NearestCandidate(0.0, false, 0, 0));
+    while (!queue.empty()) {
+        NearestCandidate const next = queue.top();
+        queue.pop();
+
+        if (next.exact) {
+            return _footprints[next.index];
+        } else if (next.level == nLevel) {
+            queue.push(NearestCandidate(distanceSquared(*_footprints[next.index], x, y),
+                                        true, nLevel, next.index));
+        } else {
+            Node const& node = _levels[next.level][next.index];
+            bool const isLeaf = (next.level + 1 == nLevel);
+            for (int i = node.begin; i != node.end; ++i) {
+                int const index = isLeaf ? _order[i] : i;
+                geom::Box2I const bbox =
+                    isLeaf ? _footprints[index]->getBBox() : _levels[next.level + 1][i].bbox;
+                queue.push(NearestCandidate(distanceSquared(bbox, x, y), false, next.level + 1, index));
+            }
+        }
+    }
+
+    return Footprint::Ptr();            // not reached
+}
+
+}}}
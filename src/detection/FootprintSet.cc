@@ -44,6 +44,7 @@
  */
 #include <algorithm>
 #include <cassert>
+#include <queue>
 #include <set>
 #include <string>
 #include <typeinfo>
@@ -52,6 +53,7 @@
 #include "lsst/pex/logging/Trace.h"
 #include "lsst/afw/image/MaskedImage.h"
 #include "lsst/afw/math/Statistics.h"
+#include "lsst/afw/math/detail/Parallel.h"
 #include "lsst/afw/detection/Peak.h"
 #include "lsst/afw/detection/FootprintFunctor.h"
 #include "lsst/afw/detection/FootprintSet.h"
@@ -59,13 +61,12 @@
 namespace detection = lsst::afw::detection;
 namespace image = lsst::afw::image;
 namespace math = lsst::afw::math;
+namespace mathDetail = lsst::afw::math::detail;
 namespace pexLogging = lsst::pex::logging;
 namespace geom = lsst::afw::geom;
 
 /************************************************************************************************************/
 namespace {
-    typedef unsigned short IdPixelT;    // Type of temporary Images used in merging Footprints
-
     struct Threshold_traits {
     };
     struct ThresholdLevel_traits : public Threshold_traits { // Threshold is a single number
@@ -90,52 +91,6 @@ namespace {
     }
 }
 
-namespace {
-    /// Don't let doxygen see this block  \cond
-/*
- * run-length code for part of object
- */
-    class IdSpan {
-    public:
-        typedef boost::shared_ptr<IdSpan> Ptr;
-        
-        explicit IdSpan(int id, int y, int x0, int x1, double good) : 
-            id(id), y(y), x0(x0), x1(x1), good(good) {}
-        int id;                         /* ID for object */
-        int y;                          /* Row wherein IdSpan dwells */
-        int x0, x1;                     /* inclusive range of columns */
-        bool good;                      /* includes a value over the desired threshold? */
-    };
-/*
- * comparison functor; sort by ID then row
- */
-    struct IdSpanCompar : public std::binary_function<const IdSpan::Ptr, const IdSpan::Ptr, bool> {
-        bool operator()(IdSpan::Ptr const a, IdSpan::Ptr const b) {
-            if (a->id < b->id) {
-                return true;
-            } else if (a->id > b->id) {
-                return false;
-            } else {
-                return (a->y < b->y) ? true : false;
-            }
-        }
-    };
-/*
- * Follow a chain of aliases, returning the final resolved value.
- */
-    int resolve_alias(std::vector<int> const &aliases, /* list of aliases */
-                      int id) {         /* alias to look up */
-        int resolved = id;              /* resolved alias */
-        
-        while (id != aliases[id]) {
-            resolved = id = aliases[id];
-        }
-        
-        return(resolved);
-    }
-    /// \endcond
-}
-
 /************************************************************************************************************/
 /**
  * Dtor for FootprintSet
@@ -306,164 +261,316 @@ advancePtr(IterT varPtr, ThresholdPixelLevel_traits) {
     return varPtr + 1;
 }
 
+namespace {
+    /// Don't let doxygen see this block  \cond
 /*
- * Here's the working routine for the FootprintSet constructors; see documentation
- * of the constructors themselves
+ * run-length code for a row of pixels above threshold
  */
-template<typename ImagePixelT, typename MaskPixelT, typename VariancePixelT, typename ThresholdTraitT>
-static void findFootprints(
-        typename detection::FootprintSet<ImagePixelT, MaskPixelT>::FootprintList *_footprints, // Footprints
-        geom::Box2I const& _region,               // BBox of pixels that are being searched
-        image::ImageBase<ImagePixelT> const &img, // Image to search for objects
-        image::Image<VariancePixelT> const *var,  // img's variance
-        double const thresholdVal,                // threshold value defining Footprints
-        double const includeThresholdMultiplier, // threshold multiplier for inclusion in FootprintSet
-        bool const polarity,                      // if false, search _below_ thresholdVal
-        int const npixMin,                        // minimum number of pixels in an object
-        bool const setPeaks                      // should I set the Peaks list?
-) {
-    int id;                             /* object ID */
-    int in_span;                        /* object ID of current IdSpan */
-    int nobj = 0;                       /* number of objects found */
-    int x0 = 0;                         /* unpacked from a IdSpan */
-    double const includeThresholdVal = thresholdVal * includeThresholdMultiplier; // threshold for inclusion
+    struct Run {
+        Run(int y, int x0, int x1, bool good) : y(y), x0(x0), x1(x1), good(good), id(0) {}
 
-    typedef typename image::Image<ImagePixelT> ImageT;
-    
-    int const row0 = img.getY0();
-    int const col0 = img.getX0();
-    int const height = img.getHeight();
-    int const width = img.getWidth();
+        int y;                          /* Row wherein Run dwells */
+        int x0, x1;                     /* inclusive range of columns */
+        bool good;                      /* includes a value over the desired threshold? */
+        int id;                         /* ID for object */
+    };
 /*
- * Storage for arrays that identify objects by ID. We want to be able to
- * refer to idp[-1] and idp[width], hence the (width + 2)
+ * A range of columns in a row whose pixels all carry the same (provisional) object ID
  */
-    std::vector<int> id1(width + 2);
-    std::fill(id1.begin(), id1.end(), 0);
-    std::vector<int> id2(width + 2);
-    std::fill(id2.begin(), id2.end(), 0);
-    std::vector<int>::iterator idc = id1.begin() + 1; // object IDs in current/
-    std::vector<int>::iterator idp = id2.begin() + 1; //                       previous row
+    struct IdSegment {
+        IdSegment(int x0, int x1, int id) : x0(x0), x1(x1), id(id) {}
 
-    std::vector<int> aliases;           // aliases for initially disjoint parts of Footprints
-    aliases.reserve(1 + height/20);     // initial size of aliases
+        int x0, x1;                     /* inclusive range of columns */
+        int id;                         /* ID for object */
+    };
+/*
+ * A Span of one of the Footprints being merged, tagged with the index of that Footprint
+ */
+    struct SourceSpan {
+        SourceSpan(int y, int x0, int x1, int source) : y(y), x0(x0), x1(x1), source(source) {}
 
-    std::vector<IdSpan::Ptr> spans;     // y:x0,x1 for objects
-    spans.reserve(aliases.capacity());  // initial size of spans
+        bool operator<(SourceSpan const& rhs) const {
+            return (y < rhs.y) || (y == rhs.y && x0 < rhs.x0);
+        }
 
-    aliases.push_back(0);               // 0 --> 0
+        int y;                          /* Row wherein Span dwells */
+        int x0, x1;                     /* inclusive range of columns */
+        int source;                     /* index of the Footprint that the Span came from */
+    };
 /*
- * Go through image identifying objects
+ * Find the root of an ID in a union-find forest, halving the path as we go
  */
-    typedef typename image::Image<ImagePixelT>::x_iterator x_iterator;
-    typedef typename image::Image<VariancePixelT>::x_iterator x_var_iterator;
-
-    in_span = 0;                        // not in a span
-    for (int y = 0; y != height; ++y) {
-        if (idc == id1.begin() + 1) {
-            idc = id2.begin() + 1;
-            idp = id1.begin() + 1;
-        } else {
-            idc = id1.begin() + 1;
-            idp = id2.begin() + 1;
+    inline int resolve_alias(std::vector<int> &aliases, /* list of aliases */
+                             int id) {  /* alias to look up */
+        while (id != aliases[id]) {
+            id = aliases[id] = aliases[aliases[id]];
         }
-        std::fill_n(idc - 1, width + 2, 0);
-        
-        in_span = 0;                    /* not in a span */
-        bool good = (includeThresholdMultiplier == 1.0); /* Span exceeds the threshold? */
-
-        x_iterator pixPtr = img.row_begin(y);
-        x_var_iterator varPtr = (var == NULL) ? NULL : var->row_begin(y);
-        for (int x = 0; x < width; ++x, ++pixPtr, varPtr = advancePtr(varPtr, ThresholdTraitT())) {
-            ImagePixelT const pixVal = *pixPtr;
+        return id;
+    }
+/*
+ * Find the runs of pixels above threshold in rows [y0, y1) of an image
+ */
+    template<typename ImagePixelT, typename VariancePixelT, typename ThresholdTraitT>
+    class FindRuns {
+    public:
+        FindRuns(image::ImageBase<ImagePixelT> const &img, image::Image<VariancePixelT> const *var,
+                 double thresholdVal, double includeThresholdMultiplier, bool polarity,
+                 int y0, int y1, std::vector<Run> *runs) :
+            _img(&img), _var(var), _thresholdVal(thresholdVal),
+            _includeThresholdMultiplier(includeThresholdMultiplier), _polarity(polarity),
+            _y0(y0), _y1(y1), _runs(runs) {}
+
+        void operator()() {
+            typedef typename image::Image<ImagePixelT>::x_iterator x_iterator;
+            typedef typename image::Image<VariancePixelT>::x_iterator x_var_iterator;
+
+            // threshold for inclusion
+            double const includeThresholdVal = _thresholdVal * _includeThresholdMultiplier;
+            int const width = _img->getWidth();
+
+            for (int y = _y0; y != _y1; ++y) {
+                bool in_span = false;   /* in a run? */
+                int x0 = 0;             /* start of current run */
+                bool good = (_includeThresholdMultiplier == 1.0); /* Run exceeds the threshold? */
+
+                x_iterator pixPtr = _img->row_begin(y);
+                x_var_iterator varPtr = (_var == NULL) ? NULL : _var->row_begin(y);
+                for (int x = 0; x < width;
+                     ++x, ++pixPtr, varPtr = advancePtr(varPtr, ThresholdTraitT())) {
+                    ImagePixelT const pixVal = *pixPtr;
+
+                    if (isBadPixel(pixVal) || !inFootprint(pixVal, varPtr,
+                                                           _polarity, _thresholdVal, ThresholdTraitT())) {
+                        if (in_span) {
+                            _runs->push_back(Run(y, x0, x - 1, good));
+
+                            in_span = false;
+                            good = false;
+                        }
+                    } else {
+                        if (!in_span) {
+                            x0 = x;
+                            in_span = true;
+                        }
+                        if (!good && inFootprint(pixVal, varPtr, _polarity, includeThresholdVal,
+                                                 ThresholdTraitT())) {
+                            good = true;
+                        }
+                    }
+                }
 
-            if (isBadPixel(pixVal) || !inFootprint(pixVal, varPtr,
-                                                   polarity, thresholdVal, ThresholdTraitT())) {
                 if (in_span) {
-                    IdSpan::Ptr sp(new IdSpan(in_span, y, x0, x - 1, good));
-                    spans.push_back(sp);
-
-                    in_span = 0;
-                    good = false;
-                }
-            } else {                    /* a pixel to fix */
-                if (idc[x - 1] != 0) {
-                    id = idc[x - 1];
-                } else if (idp[x - 1] != 0) {
-                    id = idp[x - 1];
-                } else if (idp[x] != 0) {
-                    id = idp[x];
-                } else if (idp[x + 1] != 0) {
-                    id = idp[x + 1];
-                } else {
-                    id = ++nobj;
-                    aliases.push_back(id);
+                    _runs->push_back(Run(y, x0, width - 1, good));
                 }
+            }
+        }
+    private:
+        image::ImageBase<ImagePixelT> const *_img;
+        image::Image<VariancePixelT> const *_var;
+        double _thresholdVal;
+        double _includeThresholdMultiplier;
+        bool _polarity;
+        int _y0, _y1;
+        std::vector<Run> *_runs;
+    };
+    /// \endcond
+}
 
-                idc[x] = id;
-                if (!in_span) {
-                    x0 = x;
-                    in_span = id;
-                }
 /*
- * Do we need to merge ID numbers? If so, make suitable entries in aliases[]
+ * Assign object IDs to a list of runs sorted by row and then column, returning the number of IDs used
+ *
+ * The IDs are exactly those of the classic pixel-by-pixel algorithm: a pixel takes the ID of the pixel
+ * to its left or, failing that, of the first of the three pixels below it that is set (left to right);
+ * if the pixel below and to the right carries a different ID the two IDs are merged, and the pixel takes
+ * that ID. We do the same thing a run at a time by keeping the previous row as segments of constant
+ * ID, and use a union-find array to resolve the merges; the final IDs (and thus the order of the
+ * Footprints) are the roots of the union-find forest.
  */
-                if (idp[x + 1] != 0 && idp[x + 1] != id) {
-                    aliases[resolve_alias(aliases, idp[x + 1])] = resolve_alias(aliases, id);
-               
-                    idc[x] = id = idp[x + 1];
-                }
+static int labelRuns(std::vector<Run> &runs) {
+    int nobj = 0;                       // number of IDs issued
+    std::vector<int> aliases;           // aliases for initially disjoint parts of Footprints
+    aliases.reserve(1 + runs.size()/4);
+    aliases.push_back(0);               // 0 --> 0
 
-                if (!good && inFootprint(pixVal, varPtr, polarity, includeThresholdVal, 
-                                         ThresholdTraitT())) {
-                    good = true;
+    std::vector<IdSegment> prevSegs, curSegs; // segments of constant ID in the previous/current row
+    int prevY = 0;
+    std::size_t ip = 0;                 // first segment in prevSegs that might touch the current run
+
+    for (std::size_t i = 0; i != runs.size(); ++i) {
+        Run &run = runs[i];
+        if (i == 0 || run.y != prevY) {
+            if (i == 0 || run.y != prevY + 1) {
+                curSegs.clear();        // the row above is empty
+            }
+            prevSegs.swap(curSegs);
+            curSegs.clear();
+            prevY = run.y;
+            ip = 0;
+        }
+        int const xs = run.x0;
+        int const xe = run.x1;
+        /*
+         * Skip segments entirely to the left of the current run's neighbourhood
+         */
+        while (ip < prevSegs.size() && prevSegs[ip].x1 < xs - 1) {
+            ++ip;
+        }
+        /*
+         * The first pixel takes the ID of the first of the three pixels below it that is set
+         */
+        int id = 0;
+        for (int x = xs - 1; x <= xs + 1 && id == 0; ++x) {
+            for (std::size_t j = ip; j < prevSegs.size() && prevSegs[j].x0 <= x; ++j) {
+                if (prevSegs[j].x1 >= x) {
+                    id = prevSegs[j].id;
+                    break;
                 }
             }
         }
+        if (id == 0) {
+            id = ++nobj;
+            aliases.push_back(id);
+        }
+        run.id = id;
+        /*
+         * Walk along the run, merging with (and switching to) the ID of each segment of the
+         * previous row that the pixel below and to the right enters
+         */
+        int segStart = xs;
+        for (std::size_t j = ip; j < prevSegs.size() && prevSegs[j].x0 <= xe + 1; ++j) {
+            if (prevSegs[j].x1 < xs + 1) {
+                continue;
+            }
+            int const q = prevSegs[j].id;
+            if (q != id) {
+                aliases[resolve_alias(aliases, q)] = resolve_alias(aliases, id);
 
-        if (in_span) {
-            IdSpan::Ptr sp(new IdSpan(in_span, y, x0, width - 1, good));
-            spans.push_back(sp);
+                int const x = std::max(prevSegs[j].x0, xs + 1) - 1; // first pixel to take ID q
+                if (x > segStart) {
+                    curSegs.push_back(IdSegment(segStart, x - 1, id));
+                }
+                segStart = x;
+                id = q;
+            }
         }
+        curSegs.push_back(IdSegment(segStart, xe, id));
+    }
+
+    for (std::vector<Run>::iterator ptr = runs.begin(), end = runs.end(); ptr != end; ++ptr) {
+        ptr->id = resolve_alias(aliases, ptr->id);
     }
+
+    return nobj;
+}
+
 /*
- * Resolve aliases; first alias chains, then the IDs in the spans
+ * Sort labelled runs by ID, keeping them in row order within an ID
+ *
+ * The runs with ID id are (*sorted)[(*idStart)[id]] ... (*sorted)[(*idStart)[id + 1] - 1]
  */
-    for (unsigned int i = 0; i < spans.size(); i++) {
-        spans[i]->id = resolve_alias(aliases, spans[i]->id);
+static void sortRunsById(std::vector<Run> const &runs, // the runs, as labelled by labelRuns
+                         int const nobj,                // the number of IDs returned by labelRuns
+                         std::vector<int> *idStart,     // where each ID's runs start in sorted
+                         std::vector<Run const *> *sorted // the sorted runs
+                        ) {
+    idStart->assign(nobj + 2, 0);
+    for (std::vector<Run>::const_iterator ptr = runs.begin(), end = runs.end(); ptr != end; ++ptr) {
+        ++(*idStart)[ptr->id + 1];
+    }
+    for (int id = 1; id <= nobj + 1; ++id) {
+        (*idStart)[id] += (*idStart)[id - 1];
     }
+    sorted->resize(runs.size());
+    std::vector<int> next(idStart->begin(), idStart->end() - 1);
+    for (std::vector<Run>::const_iterator ptr = runs.begin(), end = runs.end(); ptr != end; ++ptr) {
+        (*sorted)[next[ptr->id]++] = &*ptr;
+    }
+}
+
 /*
- * Sort spans by ID, so we can sweep through them once
+ * Here's the working routine for the FootprintSet constructors; see documentation
+ * of the constructors themselves
+ *
+ * The rows are divided into nThreads bands which are run-length encoded in parallel; the runs are
+ * then labelled in a single pass, and the Footprints built from the runs grouped by ID.
  */
-    if (spans.size() > 0) {
-        std::sort(spans.begin(), spans.end(), IdSpanCompar());
+template<typename ImagePixelT, typename MaskPixelT, typename VariancePixelT, typename ThresholdTraitT>
+static void findFootprints(
+        typename detection::FootprintSet<ImagePixelT, MaskPixelT>::FootprintList *_footprints, // Footprints
+        geom::Box2I const& _region,               // BBox of pixels that are being searched
+        image::ImageBase<ImagePixelT> const &img, // Image to search for objects
+        image::Image<VariancePixelT> const *var,  // img's variance
+        double const thresholdVal,                // threshold value defining Footprints
+        double const includeThresholdMultiplier, // threshold multiplier for inclusion in FootprintSet
+        bool const polarity,                      // if false, search _below_ thresholdVal
+        int const npixMin,                        // minimum number of pixels in an object
+        bool const setPeaks,                      // should I set the Peaks list?
+        int const nThreads                        // number of threads to use; 0 for one per core
+) {
+    int const row0 = img.getY0();
+    int const col0 = img.getX0();
+/*
+ * Find the runs of pixels above threshold, a band of rows per thread
+ */
+    typedef FindRuns<ImagePixelT, VariancePixelT, ThresholdTraitT> FindRunsT;
+    std::vector<int> const bandEdges =
+        mathDetail::computeBandEdges(0, img.getHeight(), mathDetail::computeNThreads(nThreads));
+    int const nBand = bandEdges.size() - 1;
+    std::vector<std::vector<Run> > bandRuns(nBand);
+    std::vector<FindRunsT> functorList;
+    for (int i = 0; i != nBand; ++i) {
+        functorList.push_back(FindRunsT(img, var, thresholdVal, includeThresholdMultiplier, polarity,
+                                        bandEdges[i], bandEdges[i + 1], &bandRuns[i]));
+    }
+    mathDetail::runInParallel(functorList);
+
+    std::vector<Run> runs;
+    if (nBand == 1) {
+        runs.swap(bandRuns[0]);
+    } else {
+        std::size_t nrun = 0;
+        for (int i = 0; i != nBand; ++i) {
+            nrun += bandRuns[i].size();
+        }
+        runs.reserve(nrun);
+        for (int i = 0; i != nBand; ++i) {
+            runs.insert(runs.end(), bandRuns[i].begin(), bandRuns[i].end());
+            std::vector<Run>().swap(bandRuns[i]);
+        }
     }
 /*
- * Build Footprints from spans
+ * Label the runs, then sort them by ID (keeping them in row order within an ID) into a single array
  */
-    unsigned int i0;                    // initial value of i
-    if (spans.size() > 0) {
-        id = spans[0]->id;
-        i0 = 0;
-        for (unsigned int i = 0; i <= spans.size(); i++) { // <= size to catch the last object
-            if (i == spans.size() || spans[i]->id != id) {
-                PTR(detection::Footprint) fp(new detection::Footprint(i - i0, _region));
-            
-                bool good = false;      // Span includes pixel sufficient to include footprint in set?
-                for (; i0 < i; i0++) {
-                    good |= spans[i0]->good;
-                    fp->addSpan(spans[i0]->y + row0, spans[i0]->x0 + col0, spans[i0]->x1 + col0);
-                }
+    int const nobj = labelRuns(runs);
 
-                if (good && !(fp->getNpix() < npixMin)) {
-                    _footprints->push_back(fp);
-                }
-            }
+    std::vector<int> idStart;
+    std::vector<Run const *> sorted;
+    sortRunsById(runs, nobj, &idStart, &sorted);
+/*
+ * Build Footprints from runs
+ */
+    for (int id = 1; id <= nobj; ++id) {
+        int const i0 = idStart[id];
+        int const i1 = idStart[id + 1];
+        if (i0 == i1) {
+            continue;
+        }
 
-            if (i < spans.size()) {
-                id = spans[i]->id;
-            }
+        bool good = false;              // Span includes pixel sufficient to include footprint in set?
+        int npix = 0;
+        for (int i = i0; i != i1; ++i) {
+            good |= sorted[i]->good;
+            npix += sorted[i]->x1 - sorted[i]->x0 + 1;
+        }
+        if (!good || npix < npixMin) {
+            continue;
+        }
+
+        PTR(detection::Footprint) fp(new detection::Footprint(i1 - i0, _region));
+        for (int i = i0; i != i1; ++i) {
+            fp->addSpan(sorted[i]->y + row0, sorted[i]->x0 + col0, sorted[i]->x1 + col0);
         }
+        _footprints->push_back(fp);
     }
 /*
  * Find all peaks within those Footprints
@@ -500,7 +607,8 @@ detection::FootprintSet<ImagePixelT, MaskPixelT>::FootprintSet(
         NULL,
         threshold.getValue(img), includeThresholdMultiplier, threshold.getPolarity(),
         npixMin,
-        setPeaks
+        setPeaks,
+        threshold.getNThreads()
     );
 }
 
@@ -530,7 +638,8 @@ void detection::FootprintSet<ImagePixelT, MaskPixelT>::findFootprintsAndMask(
             includeThresholdMultiplier,
             threshold.getPolarity(),
             npixMin,
-            setPeaks
+            setPeaks,
+            threshold.getNThreads()
                                                                                   );
         break;
       default:
@@ -543,7 +652,8 @@ void detection::FootprintSet<ImagePixelT, MaskPixelT>::findFootprintsAndMask(
             includeThresholdMultiplier,
             threshold.getPolarity(),
             npixMin,
-            setPeaks
+            setPeaks,
+            threshold.getNThreads()
                                                                                   );
         break;
     }
@@ -602,13 +712,13 @@ detection::FootprintSet<ImagePixelT, MaskPixelT>::FootprintSet(
       case Threshold::BITMASK:
         findFootprints<MaskPixelT, MaskPixelT, float, ThresholdBitmask_traits>(
             _footprints.get(), _region, msk, NULL, threshold.getValue(), includeThresholdMultiplier,
-            threshold.getPolarity(), npixMin, false);
+            threshold.getPolarity(), npixMin, false, threshold.getNThreads());
         break;
 
       case Threshold::VALUE:
         findFootprints<MaskPixelT, MaskPixelT, float, ThresholdLevel_traits>(
             _footprints.get(), _region, msk, NULL, threshold.getValue(), includeThresholdMultiplier,
-            threshold.getPolarity(), npixMin, false);
+            threshold.getPolarity(), npixMin, false, threshold.getNThreads());
         break;
 
       default:
@@ -1131,11 +1241,7 @@ void detection::FootprintSet<ImagePixelT, MaskPixelT>::merge(
         bool isotropic                                              ///< Use (expensive) isotropic grow
                                                             )
 {
-    detection::FootprintSet<IdPixelT, MaskPixelT> fs = mergeFootprintSets(*this, tGrow, rhs, rGrow, isotropic);
-    /*
-     * Swap the new FootprintSet into place
-     */
-    this->swap(fs);
+    _footprints = mergeFootprintSets(*this, tGrow, rhs, rGrow, isotropic);
 }
 
 /// Set the corners of the FootprintSet's MaskedImage to region
@@ -1158,73 +1264,95 @@ void detection::FootprintSet<ImagePixelT, MaskPixelT>::setRegion(
 /************************************************************************************************************/
 namespace {
     /*
-     * Find the list of pixel values that lie in a Footprint
-     *
-     * Used when the Footprints are constructed from an Image containing Footprint indices
+     * The next Peak to be merged from one of a set of Peak lists; see mergePeakLists
      */
-    template <typename ImageT>
-    class FindIdsInFootprint: public detection::FootprintFunctor<ImageT> {
-    public:
-        explicit FindIdsInFootprint(ImageT const& image ///< The image the source lives in
-                                   ) : detection::FootprintFunctor<ImageT>(image), _ids(), _old(0) {}
-        /// \brief Reset everything for a new Footprint
-        void reset() {
-            _ids.clear();
-            _old = 0;
+    struct PeakCursor {
+        PeakCursor(float value, int list, std::size_t i) : value(value), list(list), i(i) {}
+        /*
+         * Used by a priority_queue, so "less than" means "merged later": smaller values, then later lists
+         */
+        bool operator<(PeakCursor const& rhs) const {
+            return (value < rhs.value) || (value == rhs.value && list > rhs.list);
         }
-        
-        /// \brief method called for each pixel by apply()
-        void operator()(typename ImageT::xy_locator loc, ///< locator pointing at the pixel
-                        int x,                           ///< column-position of pixel
-                        int y                            ///< row-position of pixel
-                       ) {
-            typename ImageT::Pixel val = loc(0, 0);
 
-            if (val != _old) {
-                _ids.insert(val);
-                _old = val;
+        float value;                    // the Peak's value
+        int list;                       // which list it's in
+        std::size_t i;                  // its index in that list
+    };
+    /*
+     * Is a Peak list sorted by decreasing peak value, as SortPeaks would leave it?
+     */
+    bool isSortedByPeakValue(detection::Footprint::PeakList const& list) {
+        for (std::size_t i = 1; i < list.size(); ++i) {
+            if (SortPeaks()(list[i], list[i - 1])) {
+                return false;
             }
         }
-
-        std::set<typename ImageT::Pixel> const& getIds() const {
-            return _ids;
+        return true;
+    }
+    /*
+     * Merge the Peak lists of a set of Footprints into peaks, sorted by decreasing peak value;
+     * Peaks with equal values are kept in the order of the input lists, just as a stable sort of the
+     * concatenated lists would leave them.
+     *
+     * The merge relies on each list being sorted; they usually are (detection sorts them), but a user may
+     * have added Peaks to a Footprint, so any that aren't are stable-sorted (a copy) first
+     */
+    void mergePeakLists(std::vector<detection::Footprint::PeakList const *> lists,
+                        detection::Footprint::PeakList &peaks) {
+        std::vector<detection::Footprint::PeakList> sortedCopies;
+        sortedCopies.reserve(lists.size());          // so pointers into sortedCopies stay valid
+        for (std::size_t i = 0; i != lists.size(); ++i) {
+            if (!isSortedByPeakValue(*lists[i])) {
+                sortedCopies.push_back(*lists[i]);
+                std::stable_sort(sortedCopies.back().begin(), sortedCopies.back().end(), SortPeaks());
+                lists[i] = &sortedCopies.back();
+            }
         }
 
-    private:
-        std::set<typename ImageT::Pixel> _ids;
-        typename ImageT::Pixel _old;
-    };
-}
+        if (lists.size() == 1) {
+            peaks.insert(peaks.end(), lists[0]->begin(), lists[0]->end());
+            return;
+        }
 
-/************************************************************************************************************/
-namespace {
-    /*
-     * Return the number of bits required to represent a unsigned long
-     */
-    int nbit(unsigned long const n) {
-        if (n == 0) {
-            return 0;
+        std::priority_queue<PeakCursor> queue;
+        std::size_t npeak = 0;
+        for (std::size_t i = 0; i != lists.size(); ++i) {
+            if (!lists[i]->empty()) {
+                queue.push(PeakCursor((*lists[i])[0]->getPeakValue(), i, 0));
+                npeak += lists[i]->size();
+            }
         }
+        peaks.reserve(peaks.size() + npeak);
 
-        unsigned int const log2 = ::log(n)/::log(2);   // rounds down
-        if ((1U << log2) > n) {
-            return log2;
-        } else {
-            return log2 + 1;
+        while (!queue.empty()) {
+            PeakCursor const next = queue.top();
+            queue.pop();
+
+            detection::Footprint::PeakList const& list = *lists[next.list];
+            peaks.push_back(list[next.i]);
+            if (next.i + 1 < list.size()) {
+                queue.push(PeakCursor(list[next.i + 1]->getPeakValue(), next.list, next.i + 1));
+            }
         }
     }
     /*
      * Worker routine for merging two FootprintSets, possibly growing them as we proceed
+     *
+     * We work directly with the (grown) Footprints' Spans, clipped to the FootprintSets' region.
+     * They are sorted and swept into runs of touching pixels, which are then labelled just as
+     * if we'd detected the pixels in an image, so the merged Footprints are those (and in the order)
+     * that detection would give.  Each merged Footprint takes the Peaks of all the input Footprints
+     * that contributed to it.  The cost depends on the number of Spans, not the area of the region.
      */
     template<typename ImagePixelT, typename MaskPixelT>
-    detection::FootprintSet<IdPixelT, MaskPixelT>
+    PTR(typename detection::FootprintSet<ImagePixelT, MaskPixelT>::FootprintList)
     mergeFootprintSets(
         detection::FootprintSet<ImagePixelT, MaskPixelT> const &lhs, // the FootprintSet to be merged to
         int rLhs,                                         // Grow lhs Footprints by this many pixels
         detection::FootprintSet<ImagePixelT, MaskPixelT> const &rhs, // the FootprintSet to be merged into lhs
         int rRhs,                                         // Grow rhs Footprints by this many pixels
         bool isotropic                  // Grow isotropically (as opposed to a Manhattan metric)
-                                        // n.b. Isotropic grows are significantly slower
                       )
     {
         typedef detection::Footprint Footprint;
@@ -1236,117 +1364,93 @@ namespace {
             throw LSST_EXCEPT(lsst::pex::exceptions::InvalidParameterException,
                               boost::format("The two FootprintSets must have the same region").str());
         }
-        
-        image::Image<IdPixelT>::Ptr idImage(new image::Image<IdPixelT>(region));
-        idImage->setXY0(region.getMinX(), region.getMinY());
-        *idImage = 0;
-
-        FootprintList const& lhsFootprints = *lhs.getFootprints();
-        FootprintList const& rhsFootprints = *rhs.getFootprints();
-        int const nLhs = lhsFootprints.size();
-        int const nRhs = rhsFootprints.size();
         /*
-         * In general the lists of Footprints overlap, so we need to make sure that the IDs can be
-         * uniquely recovered from the idImage.  We do this by allocating a range of bits to the lhs IDs
+         * Gather the Spans of all the input Footprints, lhs then rhs, clipped to the region
          */
-        int const lhsIdNbit = nbit(nLhs);
-        int const lhsIdMask = (1 << lhsIdNbit) - 1;
+        FootprintList const* inputs[2] = { lhs.getFootprints().get(), rhs.getFootprints().get() };
+        int const rGrow[2] = { rLhs, rRhs };
+
+        std::vector<CONST_PTR(Footprint)> sources; // the input Footprints, indexed by SourceSpan::source
+        std::vector<SourceSpan> spans;
+        for (int i = 0; i != 2; ++i) {
+            for (typename FootprintList::const_iterator ptr = inputs[i]->begin(), end = inputs[i]->end();
+                 ptr != end; ++ptr) {
+                CONST_PTR(Footprint) foot = *ptr;
+                if (rGrow[i] > 0) {
+                    foot = growFootprint(*foot, rGrow[i], isotropic);
+                }
 
-        if ((nRhs << lhsIdNbit) > std::numeric_limits<IdPixelT>::max() - 1) {
-            throw LSST_EXCEPT(lsst::pex::exceptions::OverflowErrorException,
-                              (boost::format("%d + %d footprints need too many bits; change IdPixelT typedef")
-                               % nLhs % nRhs).str());
+                int const source = sources.size();
+                sources.push_back(*ptr);
+                for (Footprint::SpanVector::const_iterator sp = foot->getSpanVector().begin(),
+                         spEnd = foot->getSpanVector().end(); sp != spEnd; ++sp) {
+                    int const x0 = std::max(sp->getX0(), region.getMinX());
+                    int const x1 = std::min(sp->getX1(), region.getMaxX());
+                    if (sp->getY() >= region.getMinY() && sp->getY() <= region.getMaxY() && x0 <= x1) {
+                        spans.push_back(SourceSpan(sp->getY(), x0, x1, source));
+                    }
+                }
+            }
         }
+        std::sort(spans.begin(), spans.end());
         /*
-         * When we insert grown Footprints into the idImage we can potentially overwrite an entire Footprint,
-         * losing any peaks that it might contain.  We'll preserve the overwritten Ids in case we need to
-         * get them back (n.b. Footprints that overlap, but both if which survive, will appear in this list)
+         * Sweep the Spans into runs of touching pixels, remembering which run each Span went into,
+         * and label the runs
          */
-        typedef std::map<int, std::set<int> > OldIdMap;
-        OldIdMap overwrittenIds;        // here's a map from id -> overwritten IDs
-
-        int id = 0;                         // the ID inserted into the image
-        for (typename FootprintList::const_iterator ptr = lhsFootprints.begin(), end = lhsFootprints.end();
-             ptr != end; ++ptr) {
-            CONST_PTR(Footprint) foot = *ptr;
-
-            if (rLhs > 0) {
-                foot = growFootprint(*foot, rLhs, isotropic);
-            }
-
-            std::set<int> overwritten;
-            foot->insertIntoImage(*idImage, ++id, true, ~0x0, &overwritten);
-            if (!overwritten.empty()) {
-                overwrittenIds.insert(overwrittenIds.end(), std::make_pair(id, overwritten));
-            }
-        }
-
-        id = lhsIdMask;
-        for (typename FootprintList::const_iterator ptr = rhsFootprints.begin(), end = rhsFootprints.end();
-             ptr != end; ++ptr) {
-            CONST_PTR(Footprint) foot = *ptr;
-
-            if (rRhs > 0) {
-                foot = growFootprint(*foot, rRhs, isotropic);
-            }
-
-            std::set<int> overwritten;
-            foot->insertIntoImage(*idImage, ++id, true, ~lhsIdMask, &overwritten);
-
-            if (!overwritten.empty()) {
-                overwrittenIds.insert(overwrittenIds.end(), std::make_pair(id, overwritten));
+        std::vector<Run> runs;
+        std::vector<int> spanRun(spans.size());
+        for (std::size_t i = 0; i != spans.size(); ++i) {
+            SourceSpan const& sp = spans[i];
+            if (runs.empty() || runs.back().y != sp.y || sp.x0 > runs.back().x1 + 1) {
+                runs.push_back(Run(sp.y, sp.x0, sp.x1, true));
+            } else if (sp.x1 > runs.back().x1) {
+                runs.back().x1 = sp.x1;
             }
+            spanRun[i] = runs.size() - 1;
         }
 
-        /*********************************************************************************************************/
-                
-        for (OldIdMap::iterator mapPtr = overwrittenIds.begin(), end = overwrittenIds.end();
-             mapPtr != end; ++mapPtr) {
-            int id = mapPtr->first;
-            std::set<int> &overwritten = mapPtr->second;
+        int const nobj = labelRuns(runs);
 
-            for (std::set<int>::iterator ptr = overwritten.begin(), end = overwritten.end(); ptr != end; ++ptr){
-                std::cout << "RHL overwrote a pixel of Footprint " << *ptr << " -> " << id << std::endl;
-            }
+        std::vector<int> idStart;
+        std::vector<Run const *> sorted;
+        sortRunsById(runs, nobj, &idStart, &sorted);
+        /*
+         * Find which input Footprints contributed to each ID, in the order lhs then rhs
+         */
+        std::vector<std::pair<int, int> > idSources(spans.size()); // (ID, source) pairs
+        for (std::size_t i = 0; i != spans.size(); ++i) {
+            idSources[i] = std::make_pair(runs[spanRun[i]].id, spans[i].source);
         }
-
-        /*********************************************************************************************************/
-
-        detection::FootprintSet<IdPixelT> fs(*idImage, detection::Threshold(1),
-                                             1, false); // detect all pixels in rhs + lhs
+        std::sort(idSources.begin(), idSources.end());
+        idSources.erase(std::unique(idSources.begin(), idSources.end()), idSources.end());
         /*
-         * Now go through the new Footprints looking up their progenitor's IDs and merging the peak lists
+         * Build the merged Footprints, and merge their progenitors' (sorted) Peak lists
          */
-        FindIdsInFootprint<image::Image<IdPixelT> > idFinder(*idImage);
-
-        for (typename FootprintList::iterator ptr = fs.getFootprints()->begin(), end = fs.getFootprints()->end();
-             ptr != end; ++ptr) {
-            PTR(Footprint) foot = *ptr;
-
-            idFinder.apply(*foot);
-
-            Footprint::PeakList &peaks = foot->getPeaks();
+        PTR(FootprintList) merged(new FootprintList());
+        std::vector<std::pair<int, int> >::const_iterator idSource = idSources.begin();
+        std::vector<Footprint::PeakList const *> peakLists;
+        for (int id = 1; id <= nobj; ++id) {
+            int const i0 = idStart[id];
+            int const i1 = idStart[id + 1];
+            if (i0 == i1) {
+                continue;
+            }
 
-            for (std::set<IdPixelT>::iterator idptr = idFinder.getIds().begin(),
-                     idend = idFinder.getIds().end(); idptr != idend; ++idptr) {
-                unsigned int indx = *idptr;
-                if ((indx & lhsIdMask) > 0) {
-                    Footprint::PeakList const& oldPeaks = lhsFootprints[(indx & lhsIdMask) - 1]->getPeaks();
-                    peaks.insert(peaks.end(), oldPeaks.begin(), oldPeaks.end());
-                }
-                indx >>= lhsIdNbit;
+            PTR(Footprint) foot(new Footprint(i1 - i0, region));
+            for (int i = i0; i != i1; ++i) {
+                foot->addSpan(sorted[i]->y, sorted[i]->x0, sorted[i]->x1);
+            }
 
-                if (indx > 0) {
-                    Footprint::PeakList const& oldPeaks = rhsFootprints[indx - 1]->getPeaks();
-                    peaks.insert(peaks.end(), oldPeaks.begin(), oldPeaks.end());
-                }
+            peakLists.clear();
+            for (; idSource != idSources.end() && idSource->first == id; ++idSource) {
+                peakLists.push_back(&sources[idSource->second]->getPeaks());
             }
-            // we could be cleverer here as both lists are already sorted, but std::vector has no
-            // merge method and it probably isn't worth the trouble of hand-coding the merge
-            std::stable_sort(foot->getPeaks().begin(), foot->getPeaks().end(), SortPeaks());
+            mergePeakLists(peakLists, foot->getPeaks());
+
+            merged->push_back(foot);
         }
 
-        return fs;
+        return merged;
     }
 }
 
@@ -1360,7 +1464,6 @@ detection::FootprintSet<ImagePixelT, MaskPixelT>::FootprintSet(
         FootprintSet const &rhs,        //!< the input FootprintSet
         int r,                          //!< Grow Footprints by r pixels
         bool isotropic                  //!< Grow isotropically (as opposed to a Manhattan metric)
-                                        //!< @note Isotropic grows are significantly slower
                                                               )
     : lsst::daf::data::LsstBase(typeid(this)),
       _footprints(rhs._footprints), _region(rhs._region) {
@@ -1371,59 +1474,7 @@ detection::FootprintSet<ImagePixelT, MaskPixelT>::FootprintSet(
         throw LSST_EXCEPT(lsst::pex::exceptions::InvalidParameterException,
                           (boost::format("I cannot grow by negative numbers: %d") % r).str());
     }
-#if 1
-    detection::FootprintSet<IdPixelT, MaskPixelT> fs = mergeFootprintSets(FootprintSet(rhs.getRegion()), 0,
-                                                                          rhs, r, isotropic);
-#else
-    geom::Box2I region = rhs.getRegion();
-    image::Image<IdPixelT>::Ptr idImage(
-        new image::Image<IdPixelT>(region)
-    );
-    idImage->setXY0(region.getMinX(), region.getMinY());
-    *idImage = 0;
-
-    FootprintList const& rhsFootprints = *rhs.getFootprints();
-    if (static_cast<int>(rhsFootprints.size()) > std::numeric_limits<IdPixelT>::max() - 1) {
-        throw LSST_EXCEPT(lsst::pex::exceptions::OverflowErrorException,
-                          (boost::format("%d footprints > %d; change IdPixelT's typedef")
-                           % rhsFootprints.size() % (std::numeric_limits<IdPixelT>::max() - 1)).str());
-    }
-
-    int id = 0;                         // the ID inserted into the image
-    for (FootprintList::const_iterator ptr = rhsFootprints.begin(), end = rhsFootprints.end();
-         ptr != end; ++ptr) {
-        Footprint::Ptr gfoot = growFootprint(**ptr, r, isotropic);
-        gfoot->insertIntoImage(*idImage, ++id); // 1 more than the index into rhsFootprints
-    }
-
-    FootprintSet<IdPixelT> fs(*idImage, Threshold(1), 1, false);
-    /*
-     * Now go through the new Footprints looking up their progenitor's IDs and merging the peak lists
-     */
-    FindIdsInFootprint<image::Image<IdPixelT> > idFinder(*idImage);
-
-    for (FootprintList::iterator ptr = fs.getFootprints()->begin(), end = fs.getFootprints()->end();
-         ptr != end; ++ptr) {
-        PTR(Footprint) foot = *ptr;
-
-        idFinder.apply(*foot);
-
-        detection::Footprint::PeakList &peaks = foot->getPeaks();
-
-        for (std::set<IdPixelT>::iterator idptr = idFinder.getIds().begin(),
-                                        idend = idFinder.getIds().end(); idptr != idend; ++idptr) {
-            detection::Footprint::PeakList const& rhsPeaks = rhsFootprints[*idptr - 1]->getPeaks();
-            peaks.insert(peaks.end(), rhsPeaks.begin(), rhsPeaks.end());
-        }
-        // we could be cleverer here as both lists are already sorted, but std::vector has no
-        // merge method and it probably isn't worth the trouble of hand-coding the merge
-        std::stable_sort(foot->getPeaks().begin(), foot->getPeaks().end(), SortPeaks());
-    }
-#endif
-    /*
-     * Finally swap the new FootprintSet into place
-     */
-    swap(fs);
+    _footprints = mergeFootprintSets(FootprintSet(rhs.getRegion()), 0, rhs, r, isotropic);
 }
 
 /************************************************************************************************************/
@@ -42,11 +42,11 @@ void afwDet::ShapeletLocalPsf::evaluatePointSource(
     MultiShapelet::Evaluator evaluator = _shapelet.evaluate();
     ndarray::Array<Pixel,1,0>::Iterator pixIter = array.begin();
     for (
-        Footprint::SpanList::const_iterator spanIter = fp.getSpans().begin();
-        spanIter != fp.getSpans().end();
+        Footprint::SpanVector::const_iterator spanIter = fp.getSpanVector().begin();
+        spanIter != fp.getSpanVector().end();
         ++spanIter
     ) {
-        Span const & span = **spanIter;
+        Span const & span = *spanIter;
         for (int x = span.getX0(); x <= span.getX1(); ++x, ++pixIter) {
             *pixIter = evaluator(x - offset.getX(), span.getY() - offset.getY());
         }
@@ -0,0 +1,105 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/** @file
+  * @ingroup afw
+  */
+#include "lsst/pex/exceptions.h"
+#include "lsst/afw/detection/SourceCatalog.h"
+
+namespace ex = lsst::pex::exceptions;
+
+namespace lsst { namespace afw { namespace detection {
+
+/**
+  * Make a catalog of the sources in a set, in the same order
+  */
+SourceCatalog::SourceCatalog(SourceSet const &set) {
+    reserve(set.size());
+    for (SourceSet::const_iterator i = set.begin(); i != set.end(); ++i) {
+        append(*i);
+    }
+}
+
+/**
+  * Reserve space for n sources, so that appending them doesn't reallocate the columns
+  */
+void SourceCatalog::reserve(int n) {
+    _sources.reserve(n);
+    _id.reserve(n);
+    _ra.reserve(n);
+    _dec.reserve(n);
+    _xAstrom.reserve(n);
+    _yAstrom.reserve(n);
+    _psfFlux.reserve(n);
+    _psfFluxErr.reserve(n);
+    _apFlux.reserve(n);
+    _apFluxErr.reserve(n);
+    _modelFlux.reserve(n);
+    _modelFluxErr.reserve(n);
+    _instFlux.reserve(n);
+    _instFluxErr.reserve(n);
+    _ixx.reserve(n);
+    _iyy.reserve(n);
+    _ixy.reserve(n);
+    _flagForDetection.reserve(n);
+}
+
+/**
+  * Append a row holding the current values of a source's fields
+  *
+  * @throw lsst::pex::exceptions::InvalidParameterException if source is empty
+  */
+void SourceCatalog::append(Source::Ptr const &source) {
+    if (!source) {
+        throw LSST_EXCEPT(ex::InvalidParameterException, "Cannot append an empty Source::Ptr");
+    }
+    Source const &s = *source;
+    _sources.push_back(source);
+    _id.push_back(s.getId());
+    _ra.push_back(s.getRa().asRadians());
+    _dec.push_back(s.getDec().asRadians());
+    _xAstrom.push_back(s.getXAstrom());
+    _yAstrom.push_back(s.getYAstrom());
+    _psfFlux.push_back(s.getPsfFlux());
+    _psfFluxErr.push_back(s.getPsfFluxErr());
+    _apFlux.push_back(s.getApFlux());
+    _apFluxErr.push_back(s.getApFluxErr());
+    _modelFlux.push_back(s.getModelFlux());
+    _modelFluxErr.push_back(s.getModelFluxErr());
+    _instFlux.push_back(s.getInstFlux());
+    _instFluxErr.push_back(s.getInstFluxErr());
+    _ixx.push_back(s.getIxx());
+    _iyy.push_back(s.getIyy());
+    _ixy.push_back(s.getIxy());
+    _flagForDetection.push_back(s.getFlagForDetection());
+}
+
+/**
+  * Persist the sources of a catalog; only the Source::Ptrs are copied
+  */
+PersistableSourceVector::PersistableSourceVector(SourceCatalog const &catalog) :
+    _sources(catalog.getSources()) {}
+
+}}} // namespace lsst::afw::detection
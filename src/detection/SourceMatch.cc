@@ -28,71 +28,188 @@
 #include <algorithm>
 #include <cmath>
 
-#include "boost/scoped_array.hpp"
-
-#include "lsst/utils/ieee.h"
 #include "lsst/pex/exceptions.h"
-#include "lsst/pex/logging/Trace.h"
 #include "lsst/afw/detection/SourceMatch.h"
+#include "lsst/afw/detection/SourceSkyIndex.h"
 #include "lsst/afw/geom/Angle.h"
+#include "lsst/afw/math/detail/Parallel.h"
 
 
-namespace ex = lsst::pex::exceptions;
 namespace det = lsst::afw::detection;
 namespace afwGeom = lsst::afw::geom;
 
 namespace lsst { namespace afw { namespace detection { namespace {
 
-    struct SourcePos {
-        double dec;
+    /// The pixel position of a source, copied out of the Source so that matching doesn't chase pointers
+    struct XyPos {
         double x;
         double y;
-        double z;
         Source::Ptr const *src;
+
+        bool operator<(XyPos const &rhs) const { return y < rhs.y; }
     };
 
-    bool operator<(SourcePos const &s1, SourcePos const &s2) {
-        return (s1.dec < s2.dec);
+    /**
+      * Extract the pixel positions of the sources in @a set, sorted by y
+      */
+    void makeXyPositions(SourceSet const &set, std::vector<XyPos> &positions) {
+        positions.resize(set.size());
+        size_t n = 0;
+        for (SourceSet::const_iterator i(set.begin()), e(set.end()); i != e; ++i, ++n) {
+            XyPos const p = {(*i)->getXAstrom(), (*i)->getYAstrom(), &(*i)};
+            positions[n] = p;
+        }
+        std::sort(positions.begin(), positions.end());
     }
 
-    struct CmpSourcePtr {
-        bool operator()(Source::Ptr const *s1, Source::Ptr const *s2) {
-            return (*s1)->getYAstrom() < (*s2)->getYAstrom();
+    /**
+      * Extract the pixel positions of the sources in @a catalog from its columns, sorted by y
+      */
+    void makeXyPositions(SourceCatalog const &catalog, std::vector<XyPos> &positions) {
+        std::vector<double> const &x = catalog.getXAstromColumn();
+        std::vector<double> const &y = catalog.getYAstromColumn();
+        SourceSet const &sources = catalog.getSources();
+        positions.resize(sources.size());
+        for (size_t i = 0; i != sources.size(); ++i) {
+            XyPos const p = {x[i], y[i], &sources[i]};
+            positions[i] = p;
         }
-    };
+        std::sort(positions.begin(), positions.end());
+    }
 
     /**
-      * Extract source positions from @a set, convert them to cartesian coordinates
-      * (for faster distance checks) and sort the resulting array of @c SourcePos
-      * instances by declination. Sources with positions containing a NaN are skipped.
-      *
-      * @param[in] set          set of sources to process
-      * @param[out] positions   pointer to an array of at least @c set.size()
-      *                         SourcePos instances
-      * @return                 The number of sources with positions not containing a NaN.
+      * Match the sources pos1[begin, end) against pos2 in pixel space, appending to @a matches.
+      * Both arrays are sorted by y; if they are the same array, each source is only compared with
+      * the sources after it (a self-match).
       */
-    size_t makeSourcePositions(SourceSet const &set, SourcePos *positions) {
-        size_t n = 0;
-        for (SourceSet::const_iterator i(set.begin()), e(set.end()); i != e; ++i) {
-            afwGeom::Angle ra = (*i)->getRa();
-            afwGeom::Angle dec = (*i)->getDec();
-            if (lsst::utils::isnan(ra.asRadians()) || lsst::utils::isnan(dec.asRadians())) {
-                continue;
+    class MatchXyBand {
+    public:
+        MatchXyBand(std::vector<XyPos> const &pos1, std::vector<XyPos> const &pos2,
+                    size_t begin, size_t end, double radius, bool closest, bool symmetric,
+                    std::vector<SourceMatch> &matches) :
+            _pos1(&pos1), _pos2(&pos2), _begin(begin), _end(end),
+            _radius(radius), _closest(closest), _symmetric(symmetric), _matches(&matches) {}
+
+        void operator()() {
+            if (_pos1 == _pos2) {
+                _matchSelf();
+            } else {
+                _match();
+            }
+        }
+
+    private:
+        std::vector<XyPos> const *_pos1;
+        std::vector<XyPos> const *_pos2;
+        size_t _begin, _end;
+        double _radius;
+        bool _closest, _symmetric;
+        std::vector<SourceMatch> *_matches;
+
+        void _match() {
+            std::vector<XyPos> const &pos1 = *_pos1;
+            std::vector<XyPos> const &pos2 = *_pos2;
+            size_t const len2 = pos2.size();
+            double const r2 = _radius*_radius;
+            if (_begin == _end) {
+                return;
+            }
+            // start where a serial sweep over all of pos1 would have reached at _begin
+            double const minY0 = pos1[_begin].y - _radius;
+            size_t start = 0;
+            for (size_t lo = 0, hi = len2; lo < hi; ) {
+                size_t const mid = lo + (hi - lo)/2;
+                if (pos2[mid].y < minY0) {
+                    start = lo = mid + 1;
+                } else {
+                    hi = mid;
+                }
+            }
+            for (size_t i = _begin; i < _end; ++i) {
+                double y = pos1[i].y;
+                double minY = y - _radius;
+                while (start < len2 && pos2[start].y < minY) { ++start; }
+                if (start == len2) {
+                    break;
+                }
+                double x = pos1[i].x;
+                double maxY = y + _radius;
+                double y2;
+                size_t closestIndex = -1;          // Index of closest match (if any)
+                double r2Include = r2;          // Squared radius for inclusion of match
+                bool found = false;             // Found anything?
+                for (size_t j = start; j < len2 && (y2 = pos2[j].y) <= maxY; ++j) {
+                    double dx = x - pos2[j].x;
+                    double dy = y - y2;
+                    double d2 = dx*dx + dy*dy;
+                    if (d2 < r2Include) {
+                        if (_closest) {
+                            r2Include = d2;
+                            closestIndex = j;
+                            found = true;
+                        } else {
+                            _matches->push_back(SourceMatch(*pos1[i].src, *pos2[j].src, std::sqrt(d2)));
+                        }
+                    }
+                }
+                if (_closest && found) {
+                    _matches->push_back(SourceMatch(*pos1[i].src, *pos2[closestIndex].src,
+                                                    std::sqrt(r2Include)));
+                }
+            }
+        }
+
+        void _matchSelf() {
+            std::vector<XyPos> const &pos = *_pos1;
+            size_t const len = pos.size();
+            double const r2 = _radius*_radius;
+            for (size_t i = _begin; i < _end; ++i) {
+                double x = pos[i].x;
+                double y = pos[i].y;
+                double maxY = y + _radius;
+                double y2;
+                for (size_t j = i + 1; j < len && (y2 = pos[j].y) <= maxY; ++j) {
+                    double dx = x - pos[j].x;
+                    double dy = y - y2;
+                    double d2 = dx*dx + dy*dy;
+                    if (d2 < r2) {
+                        double d = std::sqrt(d2);
+                        _matches->push_back(SourceMatch(*pos[i].src, *pos[j].src, d));
+                        if (_symmetric) {
+                            _matches->push_back(SourceMatch(*pos[j].src, *pos[i].src, d));
+                        }
+                    }
+                }
             }
-            double cosDec    = std::cos(dec);
-            positions[n].dec = dec.asRadians();
-            positions[n].x   = std::cos(ra)*cosDec;
-            positions[n].y   = std::sin(ra)*cosDec;
-            positions[n].z   = std::sin(dec);
-            positions[n].src = &(*i);
-            ++n;
         }
-        std::sort(positions, positions + n);
-        if (n < set.size()) {
-            lsst::pex::logging::TTrace<1>("afw.detection.matchRaDec",
-                                          "At least one source had ra or dec equal to NaN");
+    };
+
+    /**
+      * Match pos1 against pos2 in contiguous bands of pos1, one per thread, concatenating the
+      * bands' matches in order so that the result doesn't depend on the number of threads
+      */
+    std::vector<SourceMatch> matchXyInBands(std::vector<XyPos> const &pos1, std::vector<XyPos> const &pos2,
+                                            double radius, bool closest, bool symmetric, int nThreads) {
+        std::vector<int> const edges = lsst::afw::math::detail::computeBandEdges(
+            0, pos1.size(), lsst::afw::math::detail::computeNThreads(nThreads));
+        std::vector<std::vector<SourceMatch> > bandMatches(edges.size() - 1);
+        std::vector<MatchXyBand> bands;
+        for (size_t i = 0; i + 1 < edges.size(); ++i) {
+            bands.push_back(MatchXyBand(pos1, pos2, edges[i], edges[i + 1],
+                                        radius, closest, symmetric, bandMatches[i]));
+        }
+        lsst::afw::math::detail::runInParallel(bands);
+
+        size_t nMatch = 0;
+        for (size_t i = 0; i != bandMatches.size(); ++i) {
+            nMatch += bandMatches[i].size();
+        }
+        std::vector<SourceMatch> matches;
+        matches.reserve(nMatch);
+        for (size_t i = 0; i != bandMatches.size(); ++i) {
+            matches.insert(matches.end(), bandMatches[i].begin(), bandMatches[i].end());
         }
-        return n;
+        return matches;
     }
 
 }}}} // namespace lsst::afw::detection::<anonymous>
@@ -101,69 +218,24 @@ namespace lsst { namespace afw { namespace detection { namespace {
 /** Compute all tuples (s1,s2,d) where s1 belings to @a set1, s2 belongs to @a set2 and
   * d, the distance between s1 and s2, is at most @a radius. If set1 and
   * set2 are identical, then this call is equivalent to @c matchRaDec(set1,radius,true).
-  * The match is performed in ra, dec space.
+  * The match is performed in ra, dec space, using a SourceSkyIndex built from set2;
+  * to match several sets against the same sources, build the index once and use it directly.
+  *
+  * The sources of set1 are matched in bands, one per thread; the result doesn't depend on nThreads.
   *
   * @param[in] set1     first set of sources
   * @param[in] set2     second set of sources
   * @param[in] radius   match radius
   * @param[in] closest  if true then just return the closest match
+  * @param[in] nThreads number of threads to use; 0 for one per available core
   */
 std::vector<det::SourceMatch> det::matchRaDec(lsst::afw::detection::SourceSet const &set1,
                                               lsst::afw::detection::SourceSet const &set2,
-                                              afwGeom::Angle radius, bool closest) {
+                                              afwGeom::Angle radius, bool closest, int nThreads) {
     if (&set1 == &set2) {
-        return matchRaDec(set1, radius, true);
-    }
-    if (radius < 0.0 || (radius > (45. * afwGeom::degrees))) {
-        throw LSST_EXCEPT(ex::RangeErrorException, "match radius out of range (0 to 45 degrees)");
+        return matchRaDec(set1, radius, true, nThreads);
     }
-    if (set1.size() == 0 || set2.size() == 0) {
-        return std::vector<SourceMatch>();
-    }
-    // setup match parameters
-    double const d2Limit = radius.toUnitSphereDistanceSquared();
-
-    // Build position lists
-    size_t len1 = set1.size();
-    size_t len2 = set2.size();
-    boost::scoped_array<SourcePos> pos1(new SourcePos[len1]);
-    boost::scoped_array<SourcePos> pos2(new SourcePos[len2]);
-    len1 = makeSourcePositions(set1, pos1.get());
-    len2 = makeSourcePositions(set2, pos2.get());
-
-    std::vector<SourceMatch> matches;
-    for (size_t i = 0, start = 0; i < len1; ++i) {
-        double minDec = pos1[i].dec - radius.asRadians();
-        while (start < len2 && pos2[start].dec < minDec) { ++start; }
-        if (start == len2) {
-            break;
-        }
-        double maxDec = pos1[i].dec + radius.asRadians();
-        size_t closestIndex = -1;          // Index of closest match (if any)
-        double d2Include = d2Limit;     // Squared distance for inclusion of match
-        bool found = false;             // Found anything?
-        for (size_t j = start; j < len2 && pos2[j].dec <= maxDec; ++j) {
-            double dx = pos1[i].x - pos2[j].x;
-            double dy = pos1[i].y - pos2[j].y;
-            double dz = pos1[i].z - pos2[j].z;
-            double d2 = dx*dx + dy*dy + dz*dz;
-            if (d2 < d2Include) {
-                if (closest) {
-                    d2Include = d2;
-                    closestIndex = j;
-                    found = true;
-                } else {
-                    matches.push_back(SourceMatch(*pos1[i].src, *pos2[j].src,
-                                                  afwGeom::Angle::fromUnitSphereDistanceSquared(d2).asRadians()));
-                }
-            }
-        }
-        if (closest && found) {
-            matches.push_back(SourceMatch(*pos1[i].src, *pos2[closestIndex].src,
-                                          afwGeom::Angle::fromUnitSphereDistanceSquared(d2Include).asRadians()));
-        }
-    }
-    return matches;
+    return SourceSkyIndex(set2).match(set1, radius, closest, nThreads);
 }
 
 
@@ -171,46 +243,18 @@ std::vector<det::SourceMatch> det::matchRaDec(lsst::afw::detection::SourceSet co
   * and d, the distance between s1 and s2, is at most @a radius. The
   * match is performed in ra, dec space.
   *
+  * The sources are matched in bands, one per thread; the result doesn't depend on nThreads.
+  *
   * @param[in] set          the set of sources to self-match
   * @param[in] radius       match radius
   * @param[in] symmetric    if set to @c true symmetric matches are produced: i.e.
   *                         if (s1, s2, d) is reported, then so is (s2, s1, d).
+  * @param[in] nThreads     number of threads to use; 0 for one per available core
   */
 std::vector<det::SourceMatch> det::matchRaDec(lsst::afw::detection::SourceSet const &set,
                                               afwGeom::Angle radius,
-                                              bool symmetric) {
-    if (radius < 0.0 || radius > (45.0 * afwGeom::degrees)) {
-        throw LSST_EXCEPT(ex::RangeErrorException, "match radius out of range (0 to 45 degrees)");
-    }
-    if (set.size() == 0) {
-        return std::vector<SourceMatch>();
-    }
-    // setup match parameters
-    double const d2Limit = radius.toUnitSphereDistanceSquared();
-
-    // Build position list
-    size_t len = set.size();
-    boost::scoped_array<SourcePos> pos(new SourcePos[len]);
-    len = makeSourcePositions(set, pos.get());
-
-    std::vector<SourceMatch> matches;
-    for (size_t i = 0; i < len; ++i) {
-        double maxDec = pos[i].dec + radius.asRadians();
-        for (size_t j = i + 1; j < len && pos[j].dec <= maxDec; ++j) {
-            double dx = pos[i].x - pos[j].x;
-            double dy = pos[i].y - pos[j].y;
-            double dz = pos[i].z - pos[j].z;
-            double d2 = dx*dx + dy*dy + dz*dz;
-            if (d2 < d2Limit) {
-                afwGeom::Angle d = afwGeom::Angle::fromUnitSphereDistanceSquared(d2);
-                matches.push_back(SourceMatch(*pos[i].src, *pos[j].src, d.asRadians()));
-                if (symmetric) {
-                    matches.push_back(SourceMatch(*pos[j].src, *pos[i].src, d.asRadians()));
-                }
-            }
-        }
-    }
-    return matches;
+                                              bool symmetric, int nThreads) {
+    return SourceSkyIndex(set).matchSelf(radius, symmetric, nThreads);
 }
 
 
@@ -219,69 +263,25 @@ std::vector<det::SourceMatch> det::matchRaDec(lsst::afw::detection::SourceSet co
   * set2 are identical, then this call is equivalent to @c matchXy(set1,radius,true).
   * The match is performed in pixel space (2d cartesian).
   *
+  * The sources of set1 are matched in bands, one per thread; the result doesn't depend on nThreads.
+  *
   * @param[in] set1     first set of sources
   * @param[in] set2     second set of sources
   * @param[in] radius   match radius (pixels)
   * @param[in] closest  if true then just return the closest match
+  * @param[in] nThreads number of threads to use; 0 for one per available core
   */
 std::vector<det::SourceMatch> det::matchXy(lsst::afw::detection::SourceSet const &set1,
                                            lsst::afw::detection::SourceSet const &set2,
-                                           double radius, bool closest) {
+                                           double radius, bool closest, int nThreads) {
     if (&set1 == &set2) {
-       return matchXy(set1, radius);
-    }
-    // setup match parameters
-    double const r2 = radius*radius;
-
-    // copy and sort array of pointers on y
-    size_t const len1 = set1.size();
-    size_t const len2 = set2.size();
-    boost::scoped_array<Source::Ptr const *> pos1(new Source::Ptr const *[len1]);
-    boost::scoped_array<Source::Ptr const *> pos2(new Source::Ptr const *[len2]);
-    size_t n = 0;
-    for (SourceSet::const_iterator i(set1.begin()), e(set1.end()); i != e; ++i, ++n) {
-        pos1[n] = &(*i);
-    }
-    n = 0;
-    for (SourceSet::const_iterator i(set2.begin()), e(set2.end()); i != e; ++i, ++n) {
-        pos2[n] = &(*i);
-    }
-    std::sort(pos1.get(), pos1.get() + len1, CmpSourcePtr());
-    std::sort(pos2.get(), pos2.get() + len2, CmpSourcePtr());
-
-    std::vector<SourceMatch> matches;
-    for (size_t i = 0, start = 0; i < len1; ++i) {
-        double y = (*pos1[i])->getYAstrom();
-        double minY = y - radius;
-        while (start < len2 && (*pos2[start])->getYAstrom() < minY) { ++start; }
-        if (start == len2) {
-            break;
-        }
-        double x = (*pos1[i])->getXAstrom();
-        double maxY = y + radius;
-        double y2;
-        size_t closestIndex = -1;          // Index of closest match (if any)
-        double r2Include = r2;          // Squared radius for inclusion of match
-        bool found = false;             // Found anything?
-        for (size_t j = start; j < len2 && (y2 = (*pos2[j])->getYAstrom()) <= maxY; ++j) {
-            double dx = x - (*pos2[j])->getXAstrom();
-            double dy = y - y2;
-            double d2 = dx*dx + dy*dy;
-            if (d2 < r2Include) {
-                if (closest) {
-                    r2Include = d2;
-                    closestIndex = j;
-                    found = true;
-                } else {
-                    matches.push_back(SourceMatch(*pos1[i], *pos2[j], std::sqrt(d2)));
-                }
-            }
-        }
-        if (closest && found) {
-            matches.push_back(SourceMatch(*pos1[i], *pos2[closestIndex], std::sqrt(r2Include)));
-        }
+       return matchXy(set1, radius, true, nThreads);
     }
-    return matches;
+    // copy positions and sort on y
+    std::vector<XyPos> pos1, pos2;
+    makeXyPositions(set1, pos1);
+    makeXyPositions(set2, pos2);
+    return matchXyInBands(pos1, pos2, radius, closest, false, nThreads);
 }
 
 
@@ -289,45 +289,102 @@ std::vector<det::SourceMatch> det::matchXy(lsst::afw::detection::SourceSet const
   * and d, the distance between s1 and s2, in pixels, is at most @a radius. The
   * match is performed in pixel space (2d cartesian).
   *
+  * The sources are matched in bands, one per thread; the result doesn't depend on nThreads.
+  *
   * @param[in] set          the set of sources to self-match
   * @param[in] radius       match radius (pixels)
   * @param[in] symmetric    if set to @c true symmetric matches are produced: i.e.
   *                         if (s1, s2, d) is reported, then so is (s2, s1, d).
+  * @param[in] nThreads     number of threads to use; 0 for one per available core
   */
 std::vector<det::SourceMatch> det::matchXy(lsst::afw::detection::SourceSet const &set,
                                            double radius,
-                                           bool symmetric) {
-    // setup match parameters
-    double const r2 = radius*radius;
-
-    // copy and sort array of pointers on y
-    size_t const len = set.size();
-    boost::scoped_array<Source::Ptr const *> pos(new Source::Ptr const *[len]);
-    size_t n = 0;
-    for (SourceSet::const_iterator i(set.begin()), e(set.end()); i != e; ++i, ++n) {
-        pos[n] = &(*i);
+                                           bool symmetric, int nThreads) {
+    // copy positions and sort on y
+    std::vector<XyPos> pos;
+    makeXyPositions(set, pos);
+    return matchXyInBands(pos, pos, radius, false, symmetric, nThreads);
+}
+
+
+/** Compute all tuples (s1,s2,d) where s1 belongs to @a cat1, s2 belongs to @a cat2 and
+  * d, the distance between s1 and s2, is at most @a radius.  The positions are read from the
+  * catalogs' ra and dec columns; the result is identical to that of
+  * @c matchRaDec(cat1.getSources(), cat2.getSources(), radius, closest).
+  *
+  * @param[in] cat1     first catalog of sources
+  * @param[in] cat2     second catalog of sources
+  * @param[in] radius   match radius
+  * @param[in] closest  if true then just return the closest match
+  * @param[in] nThreads number of threads to use; 0 for one per available core
+  */
+std::vector<det::SourceMatch> det::matchRaDec(lsst::afw::detection::SourceCatalog const &cat1,
+                                              lsst::afw::detection::SourceCatalog const &cat2,
+                                              afwGeom::Angle radius, bool closest, int nThreads) {
+    if (&cat1 == &cat2) {
+        return matchRaDec(cat1, radius, true, nThreads);
     }
-    std::sort(pos.get(), pos.get() + len, CmpSourcePtr());
-
-    std::vector<SourceMatch> matches;
-    for (size_t i = 0; i < len; ++i) {
-        double x = (*pos[i])->getXAstrom();
-        double y = (*pos[i])->getYAstrom();
-        double maxY = y + radius;
-        double y2;
-        for (size_t j = i + 1; j < len && (y2 = (*pos[j])->getYAstrom()) <= maxY; ++j) {
-            double dx = x - (*pos[j])->getXAstrom();
-            double dy = y - y2;
-            double d2 = dx*dx + dy*dy;
-            if (d2 < r2) {
-                double d = std::sqrt(d2);
-                matches.push_back(SourceMatch(*pos[i], *pos[j], d));
-                if (symmetric) {
-                    matches.push_back(SourceMatch(*pos[j], *pos[i], d));
-                }
-            }
-        }
+    return SourceSkyIndex(cat2).match(cat1, radius, closest, nThreads);
+}
+
+
+/** Compute all tuples (s1,s2,d) where s1 != s2, s1 and s2 both belong to @a cat,
+  * and d, the distance between s1 and s2, is at most @a radius.  The positions are read from
+  * the catalog's ra and dec columns; the result is identical to that of
+  * @c matchRaDec(cat.getSources(), radius, symmetric).
+  *
+  * @param[in] cat          the catalog of sources to self-match
+  * @param[in] radius       match radius
+  * @param[in] symmetric    if set to @c true symmetric matches are produced: i.e.
+  *                         if (s1, s2, d) is reported, then so is (s2, s1, d).
+  * @param[in] nThreads     number of threads to use; 0 for one per available core
+  */
+std::vector<det::SourceMatch> det::matchRaDec(lsst::afw::detection::SourceCatalog const &cat,
+                                              afwGeom::Angle radius,
+                                              bool symmetric, int nThreads) {
+    return SourceSkyIndex(cat).matchSelf(radius, symmetric, nThreads);
+}
+
+
+/** Compute all tuples (s1,s2,d) where s1 belongs to @a cat1, s2 belongs to @a cat2 and
+  * d, the distance between s1 and s2, in pixels, is at most @a radius.  The positions are read
+  * from the catalogs' xAstrom and yAstrom columns; the result is identical to that of
+  * @c matchXy(cat1.getSources(), cat2.getSources(), radius, closest).
+  *
+  * @param[in] cat1     first catalog of sources
+  * @param[in] cat2     second catalog of sources
+  * @param[in] radius   match radius (pixels)
+  * @param[in] closest  if true then just return the closest match
+  * @param[in] nThreads number of threads to use; 0 for one per available core
+  */
+std::vector<det::SourceMatch> det::matchXy(lsst::afw::detection::SourceCatalog const &cat1,
+                                           lsst::afw::detection::SourceCatalog const &cat2,
+                                           double radius, bool closest, int nThreads) {
+    if (&cat1 == &cat2) {
+       return matchXy(cat1, radius, true, nThreads);
     }
-    return matches;
+    std::vector<XyPos> pos1, pos2;
+    makeXyPositions(cat1, pos1);
+    makeXyPositions(cat2, pos2);
+    return matchXyInBands(pos1, pos2, radius, closest, false, nThreads);
 }
 
+
+/** Compute all tuples (s1,s2,d) where s1 != s2, s1 and s2 both belong to @a cat,
+  * and d, the distance between s1 and s2, in pixels, is at most @a radius.  The positions are
+  * read from the catalog's xAstrom and yAstrom columns; the result is identical to that of
+  * @c matchXy(cat.getSources(), radius, symmetric).
+  *
+  * @param[in] cat          the catalog of sources to self-match
+  * @param[in] radius       match radius (pixels)
+  * @param[in] symmetric    if set to @c true symmetric matches are produced: i.e.
+  *                         if (s1, s2, d) is reported, then so is (s2, s1, d).
+  * @param[in] nThreads     number of threads to use; 0 for one per available core
+  */
+std::vector<det::SourceMatch> det::matchXy(lsst::afw::detection::SourceCatalog const &cat,
+                                           double radius,
+                                           bool symmetric, int nThreads) {
+    std::vector<XyPos> pos;
+    makeXyPositions(cat, pos);
+    return matchXyInBands(pos, pos, radius, false, symmetric, nThreads);
+}
@@ -0,0 +1,540 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/** @file
+  * @ingroup afw
+  */
+#include <algorithm>
+#include <cmath>
+
+#include "boost/format.hpp"
+
+#include "lsst/utils/ieee.h"
+#include "lsst/pex/exceptions.h"
+#include "lsst/pex/logging/Trace.h"
+#include "lsst/afw/detection/SourceSkyIndex.h"
+#include "lsst/afw/math/detail/Parallel.h"
+
+namespace ex = lsst::pex::exceptions;
+namespace afwGeom = lsst::afw::geom;
+
+namespace lsst { namespace afw { namespace detection { namespace {
+
+    void checkRadius(afwGeom::Angle radius) {
+        if (radius < 0.0 || radius > (45.0 * afwGeom::degrees)) {
+            throw LSST_EXCEPT(ex::RangeErrorException, "match radius out of range (0 to 45 degrees)");
+        }
+    }
+
+    /**
+      * Compare the positions of two k-d tree entries along one axis
+      */
+    struct CmpAxis {
+        explicit CmpAxis(int axis_) : axis(axis_) {}
+
+        template <typename EntryT>
+        bool operator()(EntryT const &e1, EntryT const &e2) const {
+            switch (axis) {
+              case 0:  return e1.x < e2.x;
+              case 1:  return e1.y < e2.y;
+              default: return e1.z < e2.z;
+            }
+        }
+
+        int axis;
+    };
+
+}}}} // namespace lsst::afw::detection::<anonymous>
+
+namespace lsst { namespace afw { namespace detection {
+
+struct SourceSkyIndex::Position {
+    double dec;
+    double x;
+    double y;
+    double z;
+    Source::Ptr const *src;
+
+    bool operator<(Position const &rhs) const { return dec < rhs.dec; }
+};
+
+/**
+  * Extract source positions from @a set, convert them to cartesian coordinates
+  * (for faster distance checks) and sort the resulting array of @c Position
+  * instances by declination. Sources with positions containing a NaN are skipped.
+  *
+  * @param[in] set          set of sources to process
+  * @param[out] positions   the positions; resized to the number of sources
+  *                         with positions not containing a NaN
+  */
+void SourceSkyIndex::_makePositions(SourceSet const &set, std::vector<Position> &positions) {
+    positions.resize(set.size());
+    size_t n = 0;
+    for (SourceSet::const_iterator i(set.begin()), e(set.end()); i != e; ++i) {
+        afwGeom::Angle ra = (*i)->getRa();
+        afwGeom::Angle dec = (*i)->getDec();
+        if (lsst::utils::isnan(ra.asRadians()) || lsst::utils::isnan(dec.asRadians())) {
+            continue;
+        }
+        double cosDec    = std::cos(dec);
+        positions[n].dec = dec.asRadians();
+        positions[n].x   = std::cos(ra)*cosDec;
+        positions[n].y   = std::sin(ra)*cosDec;
+        positions[n].z   = std::sin(dec);
+        positions[n].src = &(*i);
+        ++n;
+    }
+    positions.resize(n);
+    std::sort(positions.begin(), positions.end());
+    if (n < set.size()) {
+        lsst::pex::logging::TTrace<1>("afw.detection.matchRaDec",
+                                      "At least one source had ra or dec equal to NaN");
+    }
+}
+
+/**
+  * As above, but reading the positions from the ra and dec columns of @a catalog
+  */
+void SourceSkyIndex::_makePositions(SourceCatalog const &catalog, std::vector<Position> &positions) {
+    std::vector<double> const &ra = catalog.getRaColumn();
+    std::vector<double> const &dec = catalog.getDecColumn();
+    SourceSet const &sources = catalog.getSources();
+    positions.resize(sources.size());
+    size_t n = 0;
+    for (size_t i = 0; i != sources.size(); ++i) {
+        if (lsst::utils::isnan(ra[i]) || lsst::utils::isnan(dec[i])) {
+            continue;
+        }
+        double cosDec    = std::cos(dec[i]);
+        positions[n].dec = dec[i];
+        positions[n].x   = std::cos(ra[i])*cosDec;
+        positions[n].y   = std::sin(ra[i])*cosDec;
+        positions[n].z   = std::sin(dec[i]);
+        positions[n].src = &sources[i];
+        ++n;
+    }
+    positions.resize(n);
+    std::sort(positions.begin(), positions.end());
+    if (n < sources.size()) {
+        lsst::pex::logging::TTrace<1>("afw.detection.matchRaDec",
+                                      "At least one source had ra or dec equal to NaN");
+    }
+}
+
+/**
+  * A search of the k-d tree around one position
+  *
+  * A source matches if its squared unit-sphere distance from the position is less than d2Limit,
+  * its declination is within radius of the position's, and its index is at least minIndex.  The
+  * distances are computed exactly as they were by the declination-band algorithm, so the
+  * same sources match.
+  */
+class SourceSkyIndex::Query {
+public:
+    Query(SourceSkyIndex const &index, Position const &pos,
+          double radius, double d2Limit, int minIndex=0) :
+        _index(&index), _x(pos.x), _y(pos.y), _z(pos.z),
+        _minDec(pos.dec - radius), _maxDec(pos.dec + radius), _d2Limit(d2Limit), _minIndex(minIndex) {}
+
+    /**
+      * Find all matching sources, returning (index, squared distance) pairs sorted by index
+      */
+    void findWithin(std::vector<std::pair<int, double> > &found) const {
+        found.clear();
+        if (!_index->_nodes.empty()) {
+            _findWithin(0, found);
+            std::sort(found.begin(), found.end());
+        }
+    }
+
+    /**
+      * Find the closest matching source (the one with the smallest index, if several are equally
+      * close), returning false if there is none
+      */
+    bool findClosest(int &index, double &d2) const {
+        index = -1;
+        if (!_index->_nodes.empty()) {
+            _findClosest(0, index, d2);
+        }
+        return index >= 0;
+    }
+
+private:
+    SourceSkyIndex const *_index;
+    double _x, _y, _z;
+    double _minDec, _maxDec;
+    double _d2Limit;
+    int _minIndex;
+
+    bool _isCandidate(Entry const &e) const {
+        return e.index >= _minIndex && e.dec >= _minDec && e.dec <= _maxDec;
+    }
+
+    double _distanceSquared(Entry const &e) const {
+        double dx = _x - e.x;
+        double dy = _y - e.y;
+        double dz = _z - e.z;
+        return dx*dx + dy*dy + dz*dz;
+    }
+
+    // A lower bound on the squared distance to any source in a node; rounding is monotonic,
+    // so this is never larger than the value _distanceSquared returns for any of them
+    double _distanceSquared(Node const &node) const {
+        double dx = (_x < node.min[0]) ? _x - node.min[0] : ((_x > node.max[0]) ? _x - node.max[0] : 0.0);
+        double dy = (_y < node.min[1]) ? _y - node.min[1] : ((_y > node.max[1]) ? _y - node.max[1] : 0.0);
+        double dz = (_z < node.min[2]) ? _z - node.min[2] : ((_z > node.max[2]) ? _z - node.max[2] : 0.0);
+        return dx*dx + dy*dy + dz*dz;
+    }
+
+    void _findWithin(int n, std::vector<std::pair<int, double> > &found) const {
+        Node const &node = _index->_nodes[n];
+        if (_distanceSquared(node) >= _d2Limit) {
+            return;
+        }
+        if (node.left >= 0) {
+            _findWithin(node.left, found);
+            _findWithin(node.right, found);
+            return;
+        }
+        for (int i = node.begin; i != node.end; ++i) {
+            Entry const &e = _index->_entries[i];
+            if (_isCandidate(e)) {
+                double d2 = _distanceSquared(e);
+                if (d2 < _d2Limit) {
+                    found.push_back(std::make_pair(e.index, d2));
+                }
+            }
+        }
+    }
+
+    void _findClosest(int n, int &index, double &d2) const {
+        Node const &node = _index->_nodes[n];
+        double const nodeD2 = _distanceSquared(node);
+        if ((index < 0) ? nodeD2 >= _d2Limit : nodeD2 > d2) {
+            return;
+        }
+        if (node.left >= 0) {           // search the nearer child first, to tighten the bound sooner
+            if (_distanceSquared(_index->_nodes[node.left]) <= _distanceSquared(_index->_nodes[node.right])) {
+                _findClosest(node.left, index, d2);
+                _findClosest(node.right, index, d2);
+            } else {
+                _findClosest(node.right, index, d2);
+                _findClosest(node.left, index, d2);
+            }
+            return;
+        }
+        for (int i = node.begin; i != node.end; ++i) {
+            Entry const &e = _index->_entries[i];
+            if (_isCandidate(e)) {
+                double const eD2 = _distanceSquared(e);
+                if ((index < 0) ? eD2 < _d2Limit : (eD2 < d2 || (eD2 == d2 && e.index < index))) {
+                    index = e.index;
+                    d2 = eD2;
+                }
+            }
+        }
+    }
+};
+
+/**
+  * Match a contiguous range of positions (sorted by declination) against the index
+  */
+class SourceSkyIndex::MatchBand {
+public:
+    MatchBand(SourceSkyIndex const &index, std::vector<Position> const &positions, int begin, int end,
+              afwGeom::Angle radius, bool closest, bool self, bool symmetric,
+              std::vector<SourceMatch> &matches) :
+        _index(&index), _positions(&positions), _begin(begin), _end(end),
+        _radius(radius.asRadians()), _d2Limit(radius.toUnitSphereDistanceSquared()),
+        _closest(closest), _self(self), _symmetric(symmetric), _matches(&matches) {}
+
+    void operator()() {
+        std::vector<std::pair<int, double> > found;
+        for (int i = _begin; i < _end; ++i) {
+            Position const &pos = (*_positions)[i];
+            Query query(*_index, pos, _radius, _d2Limit, _self ? i + 1 : 0);
+            if (_closest) {
+                int j;
+                double d2;
+                if (query.findClosest(j, d2)) {
+                    _matches->push_back(SourceMatch(*pos.src, _index->_sources[j],
+                        afwGeom::Angle::fromUnitSphereDistanceSquared(d2).asRadians()));
+                }
+                continue;
+            }
+            query.findWithin(found);
+            for (std::vector<std::pair<int, double> >::const_iterator j = found.begin();
+                 j != found.end(); ++j) {
+                double d = afwGeom::Angle::fromUnitSphereDistanceSquared(j->second).asRadians();
+                _matches->push_back(SourceMatch(*pos.src, _index->_sources[j->first], d));
+                if (_self && _symmetric) {
+                    _matches->push_back(SourceMatch(_index->_sources[j->first], *pos.src, d));
+                }
+            }
+        }
+    }
+
+private:
+    SourceSkyIndex const *_index;
+    std::vector<Position> const *_positions;
+    int _begin, _end;
+    double _radius;
+    double _d2Limit;
+    bool _closest, _self, _symmetric;
+    std::vector<SourceMatch> *_matches;
+};
+
+namespace {
+    /**
+      * Match positions against an index, splitting them into bands processed by nThreads threads;
+      * the bands' matches are concatenated in order, so the result doesn't depend on nThreads
+      */
+    template <typename MatchBandT>
+    std::vector<SourceMatch> matchInBands(std::vector<MatchBandT> &bands,
+                                          std::vector<std::vector<SourceMatch> > &bandMatches) {
+        lsst::afw::math::detail::runInParallel(bands);
+
+        std::size_t nMatch = 0;
+        for (std::size_t i = 0; i != bandMatches.size(); ++i) {
+            nMatch += bandMatches[i].size();
+        }
+        std::vector<SourceMatch> matches;
+        matches.reserve(nMatch);
+        for (std::size_t i = 0; i != bandMatches.size(); ++i) {
+            matches.insert(matches.end(), bandMatches[i].begin(), bandMatches[i].end());
+        }
+        return matches;
+    }
+}
+
+/**
+  * Build an index over the positions of a set of sources
+  *
+  * @param[in] set          the sources to index; sources whose ra or dec is NaN are skipped
+  * @param[in] leafSize     maximum number of sources in a leaf of the k-d tree
+  *
+  * @throw lsst::pex::exceptions::InvalidParameterException if leafSize < 1
+  */
+SourceSkyIndex::SourceSkyIndex(SourceSet const &set, int leafSize) : _sources(), _entries(), _nodes() {
+    std::vector<Position> pos;
+    _makePositions(set, pos);
+    _initialize(pos, leafSize);
+}
+
+/**
+  * Build an index over the positions of the sources in a catalog, read from its ra and dec columns
+  *
+  * @param[in] catalog      the sources to index; sources whose ra or dec is NaN are skipped
+  * @param[in] leafSize     maximum number of sources in a leaf of the k-d tree
+  *
+  * @throw lsst::pex::exceptions::InvalidParameterException if leafSize < 1
+  */
+SourceSkyIndex::SourceSkyIndex(SourceCatalog const &catalog, int leafSize) :
+    _sources(), _entries(), _nodes()
+{
+    std::vector<Position> pos;
+    _makePositions(catalog, pos);
+    _initialize(pos, leafSize);
+}
+
+/*
+ * Copy positions sorted by declination into _sources and _entries, and build the k-d tree over them
+ */
+void SourceSkyIndex::_initialize(std::vector<Position> const &pos, int leafSize) {
+    if (leafSize < 1) {
+        throw LSST_EXCEPT(ex::InvalidParameterException,
+                          (boost::format("leafSize must be at least 1, not %d") % leafSize).str());
+    }
+    int const len = pos.size();
+    _sources.reserve(len);
+    _entries.reserve(len);
+    for (int i = 0; i < len; ++i) {
+        _sources.push_back(*pos[i].src);
+        Entry e = {pos[i].x, pos[i].y, pos[i].z, pos[i].dec, i};
+        _entries.push_back(e);
+    }
+    if (len > 0) {
+        _nodes.reserve(4*(len/leafSize) + 1);
+        _build(0, len, leafSize);
+    }
+}
+
+/*
+ * Build the k-d tree over _entries[begin, end), splitting each node at the median of the axis
+ * along which its sources are most extended; return the index of the node
+ */
+int SourceSkyIndex::_build(int begin, int end, int leafSize) {
+    int const n = _nodes.size();
+    _nodes.push_back(Node());
+
+    Node node;
+    for (int k = 0; k < 3; ++k) {
+        node.min[k] = 2.0;
+        node.max[k] = -2.0;
+    }
+    for (int i = begin; i != end; ++i) {
+        double const v[3] = {_entries[i].x, _entries[i].y, _entries[i].z};
+        for (int k = 0; k < 3; ++k) {
+            node.min[k] = std::min(node.min[k], v[k]);
+            node.max[k] = std::max(node.max[k], v[k]);
+        }
+    }
+    node.begin = begin;
+    node.end = end;
+    node.left = node.right = -1;
+
+    if (end - begin > leafSize) {
+        int axis = 0;
+        for (int k = 1; k < 3; ++k) {
+            if (node.max[k] - node.min[k] > node.max[axis] - node.min[axis]) {
+                axis = k;
+            }
+        }
+        int const mid = begin + (end - begin)/2;
+        std::nth_element(_entries.begin() + begin, _entries.begin() + mid, _entries.begin() + end,
+                         CmpAxis(axis));
+        node.left = _build(begin, mid, leafSize);
+        node.right = _build(mid, end, leafSize);
+    }
+    _nodes[n] = node;                   // not a reference: _build may have reallocated _nodes
+    return n;
+}
+
+/**
+  * Return the indexed source closest to (ra, dec) and within radius of it, or an empty pointer
+  * if there is none.  If several are equally close, the one with the smallest declination is returned.
+  */
+Source::Ptr SourceSkyIndex::findClosest(afwGeom::Angle ra, afwGeom::Angle dec,
+                                        afwGeom::Angle radius) const {
+    checkRadius(radius);
+    if (lsst::utils::isnan(ra.asRadians()) || lsst::utils::isnan(dec.asRadians())) {
+        return Source::Ptr();
+    }
+    double const cosDec = std::cos(dec);
+    Position const pos = {dec.asRadians(), std::cos(ra)*cosDec, std::sin(ra)*cosDec, std::sin(dec), 0};
+
+    int j;
+    double d2;
+    Query query(*this, pos, radius.asRadians(), radius.toUnitSphereDistanceSquared());
+    return query.findClosest(j, d2) ? _sources[j] : Source::Ptr();
+}
+
+/**
+  * Return all the indexed sources within radius of (ra, dec), sorted by declination
+  */
+SourceSet SourceSkyIndex::findWithin(afwGeom::Angle ra, afwGeom::Angle dec,
+                                     afwGeom::Angle radius) const {
+    checkRadius(radius);
+    SourceSet within;
+    if (lsst::utils::isnan(ra.asRadians()) || lsst::utils::isnan(dec.asRadians())) {
+        return within;
+    }
+    double const cosDec = std::cos(dec);
+    Position const pos = {dec.asRadians(), std::cos(ra)*cosDec, std::sin(ra)*cosDec, std::sin(dec), 0};
+
+    std::vector<std::pair<int, double> > found;
+    Query query(*this, pos, radius.asRadians(), radius.toUnitSphereDistanceSquared());
+    query.findWithin(found);
+    within.reserve(found.size());
+    for (std::vector<std::pair<int, double> >::const_iterator i = found.begin(); i != found.end(); ++i) {
+        within.push_back(_sources[i->first]);
+    }
+    return within;
+}
+
+/** Compute all tuples (s1,s2,d) where s1 belongs to @a set, s2 is an indexed source and
+  * d, the distance between s1 and s2, is at most @a radius.  The result is identical to that of
+  * @c matchRaDec(set, indexedSet, radius, closest), whatever the number of threads.
+  *
+  * @param[in] set          the sources to match against the index
+  * @param[in] radius       match radius
+  * @param[in] closest      if true then just return the closest match
+  * @param[in] nThreads     number of threads to use; 0 for one per available core
+  */
+std::vector<SourceMatch> SourceSkyIndex::match(SourceSet const &set, afwGeom::Angle radius,
+                                               bool closest, int nThreads) const {
+    checkRadius(radius);
+    if (set.empty() || _sources.empty()) {
+        return std::vector<SourceMatch>();
+    }
+    std::vector<Position> pos;
+    _makePositions(set, pos);
+    return _match(pos, radius, closest, false, false, nThreads);
+}
+
+/** As above, but matching the sources of a catalog, whose positions are read from its ra and dec
+  * columns.  The result is identical to that of @c match(catalog.getSources(), radius, closest).
+  */
+std::vector<SourceMatch> SourceSkyIndex::match(SourceCatalog const &catalog, afwGeom::Angle radius,
+                                               bool closest, int nThreads) const {
+    checkRadius(radius);
+    if (catalog.empty() || _sources.empty()) {
+        return std::vector<SourceMatch>();
+    }
+    std::vector<Position> pos;
+    _makePositions(catalog, pos);
+    return _match(pos, radius, closest, false, false, nThreads);
+}
+
+/** Compute all tuples (s1,s2,d) where s1 != s2, s1 and s2 are both indexed sources,
+  * and d, the distance between s1 and s2, is at most @a radius.  The result is identical to that
+  * of @c matchRaDec(indexedSet, radius, symmetric), whatever the number of threads.
+  *
+  * @param[in] radius       match radius
+  * @param[in] symmetric    if set to @c true symmetric matches are produced: i.e.
+  *                         if (s1, s2, d) is reported, then so is (s2, s1, d).
+  * @param[in] nThreads     number of threads to use; 0 for one per available core
+  */
+std::vector<SourceMatch> SourceSkyIndex::matchSelf(afwGeom::Angle radius,
+                                                   bool symmetric, int nThreads) const {
+    checkRadius(radius);
+    if (_sources.empty()) {
+        return std::vector<SourceMatch>();
+    }
+    std::vector<Position> pos(_entries.size());
+    for (std::vector<Entry>::const_iterator e = _entries.begin(); e != _entries.end(); ++e) {
+        Position const p = {e->dec, e->x, e->y, e->z, &_sources[e->index]};
+        pos[e->index] = p;
+    }
+    return _match(pos, radius, false, true, symmetric, nThreads);
+}
+
+/*
+ * Match positions sorted by declination against the index in bands, one per thread
+ */
+std::vector<SourceMatch> SourceSkyIndex::_match(std::vector<Position> const &pos, afwGeom::Angle radius,
+                                                bool closest, bool self, bool symmetric,
+                                                int nThreads) const {
+    std::vector<int> const edges = lsst::afw::math::detail::computeBandEdges(
+        0, pos.size(), lsst::afw::math::detail::computeNThreads(nThreads));
+    std::vector<std::vector<SourceMatch> > bandMatches(edges.size() - 1);
+    std::vector<MatchBand> bands;
+    for (std::size_t i = 0; i + 1 < edges.size(); ++i) {
+        bands.push_back(MatchBand(*this, pos, edges[i], edges[i + 1], radius, closest, self, symmetric,
+                                  bandMatches[i]));
+    }
+    return matchInBands(bands, bandMatches);
+}
+
+}}} // namespace lsst::afw::detection
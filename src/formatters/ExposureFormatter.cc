@@ -57,6 +57,7 @@ static char const* SVNid __attribute__((unused)) =
 #include "lsst/afw/formatters/Utils.h"
 #include "lsst/afw/formatters/WcsFormatter.h"
 #include "lsst/afw/image/Exposure.h"
+#include "lsst/afw/image/ImagePrefetcher.h"
 
 #include <iostream>
 
@@ -308,35 +309,11 @@ dafBase::Persistable* afwForm::ExposureFormatter<ImagePixelT, MaskPixelT, Varian
     } else if (typeid(*storage) == typeid(dafPersist::FitsStorage)) {
         execTrace("ExposureFormatter read FitsStorage");
         dafPersist::FitsStorage* fits = dynamic_cast<dafPersist::FitsStorage*>(storage.get());
-        int hdu = additionalData->get<int>("hdu", 0);
-        afwGeom::Box2I box;
-        if (additionalData->exists("llcX")) {
-            int llcX = additionalData->get<int>("llcX");
-            int llcY = additionalData->get<int>("llcY");
-            int width = additionalData->get<int>("width");
-            int height = additionalData->get<int>("height");
-            box = afwGeom::Box2I(afwGeom::Point2I(llcX, llcY), afwGeom::Extent2I(width, height));
-        }
-        afwImg::ImageOrigin origin = afwImg::LOCAL;
-        if(additionalData->exists("imageOrigin")){
-            std::string originStr = additionalData->get<std::string>("imageOrigin");
-            if(originStr == "LOCAL") {
-                origin = afwImg::LOCAL;
-            } else if (originStr == "PARENT") {
-                origin = afwImg::PARENT;
-            } else {
-                throw LSST_EXCEPT(
-                    lsst::pex::exceptions::RuntimeErrorException, 
-                    (boost::format("Unknown ImageOrigin type  %s specified in additional"
-                                   "data for retrieving Exposure from fits")%originStr
-                        
-                    ).str()
-                );
-            }
-        }
+        afwImg::PrefetchRequest const request =
+            afwImg::PrefetchRequest::fromAdditionalData(fits->getPath(), additionalData);
         afwImg::Exposure<ImagePixelT, MaskPixelT, VariancePixelT>* ip =
             new afwImg::Exposure<ImagePixelT, MaskPixelT, VariancePixelT>(
-                fits->getPath(), hdu, box, origin);
+                request.fileName, request.hdu, request.bbox, request.origin);
         execTrace("ExposureFormatter read end");
         return ip;
     } else if (typeid(*storage) == typeid(dafPersist::DbStorage)) {
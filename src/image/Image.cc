@@ -566,6 +566,9 @@ image::Image<PixelT>::Image(char **ramFile, size_t *ramFileLen,
 
 /**
  * Write an Image to the specified file
+ *
+ * The image is tile compressed if metadata sets ZCMPTYPE; see detail::fits_set_compression for
+ * the keys that control compression (which aren't written to the header)
  */
 template<typename PixelT>
 void image::Image<PixelT>::writeFits(
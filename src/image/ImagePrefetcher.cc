@@ -0,0 +1,290 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file
+ * @brief Implementation of ImagePrefetcher
+ */
+#include <algorithm>
+#include <exception>
+
+#include "boost/bind.hpp"
+#include "boost/cstdint.hpp"
+#include "boost/format.hpp"
+
+#include "lsst/pex/exceptions.h"
+#include "lsst/afw/image/ImagePrefetcher.h"
+#include "lsst/afw/image/Exposure.h"
+#include "lsst/afw/image/Filter.h"
+#include "lsst/afw/image/fits/fits_io_private.h"
+
+namespace pexExcept = lsst::pex::exceptions;
+namespace afwGeom = lsst::afw::geom;
+namespace afwImage = lsst::afw::image;
+
+namespace {
+    /*
+     * Read an image with its FITS constructor; the unused pointer argument selects the overload
+     */
+    template <typename ImagePixelT, typename MaskPixelT, typename VariancePixelT>
+    typename afwImage::MaskedImage<ImagePixelT, MaskPixelT, VariancePixelT>::Ptr
+    readImage(afwImage::PrefetchRequest const& request,
+              afwImage::MaskedImage<ImagePixelT, MaskPixelT, VariancePixelT> *) {
+        typedef afwImage::MaskedImage<ImagePixelT, MaskPixelT, VariancePixelT> MaskedImageT;
+        return typename MaskedImageT::Ptr(new MaskedImageT(request.fileName, request.hdu,
+                                                           lsst::daf::base::PropertySet::Ptr(),
+                                                           request.bbox, request.origin));
+    }
+
+    template <typename ImagePixelT, typename MaskPixelT, typename VariancePixelT>
+    typename afwImage::Exposure<ImagePixelT, MaskPixelT, VariancePixelT>::Ptr
+    readImage(afwImage::PrefetchRequest const& request,
+              afwImage::Exposure<ImagePixelT, MaskPixelT, VariancePixelT> *) {
+        typedef afwImage::Exposure<ImagePixelT, MaskPixelT, VariancePixelT> ExposureT;
+        return typename ExposureT::Ptr(new ExposureT(request.fileName, request.hdu,
+                                                     request.bbox, request.origin));
+    }
+}
+
+/**
+ * @brief Make a request from the additionalData used to retrieve an Exposure from a FitsStorage
+ *
+ * The keys are those ExposureFormatter::read understands: hdu (default 0); llcX, llcY, width, and height
+ * (the bounding box; default: the whole image); and imageOrigin ("LOCAL", the default, or "PARENT").
+ *
+ * @throw lsst::pex::exceptions::RuntimeErrorException if imageOrigin isn't LOCAL or PARENT
+ */
+afwImage::PrefetchRequest afwImage::PrefetchRequest::fromAdditionalData(
+    std::string const& fileName,                                ///< the file to read
+    lsst::daf::base::PropertySet::ConstPtr additionalData       ///< the description of what to read
+) {
+    int const hdu = additionalData->get<int>("hdu", 0);
+    afwGeom::Box2I box;
+    if (additionalData->exists("llcX")) {
+        int llcX = additionalData->get<int>("llcX");
+        int llcY = additionalData->get<int>("llcY");
+        int width = additionalData->get<int>("width");
+        int height = additionalData->get<int>("height");
+        box = afwGeom::Box2I(afwGeom::Point2I(llcX, llcY), afwGeom::Extent2I(width, height));
+    }
+    ImageOrigin origin = LOCAL;
+    if (additionalData->exists("imageOrigin")) {
+        std::string originStr = additionalData->get<std::string>("imageOrigin");
+        if (originStr == "LOCAL") {
+            origin = LOCAL;
+        } else if (originStr == "PARENT") {
+            origin = PARENT;
+        } else {
+            throw LSST_EXCEPT(pexExcept::RuntimeErrorException,
+                              (boost::format("Unknown ImageOrigin type  %s specified in additional"
+                                             "data for retrieving Exposure from fits") % originStr).str());
+        }
+    }
+    return PrefetchRequest(fileName, hdu, box, origin);
+}
+
+/************************************************************************************************************/
+/**
+ * @brief Start reading the requested images
+ */
+template <typename ImageT>
+afwImage::ImagePrefetcher<ImageT>::ImagePrefetcher(
+    std::vector<PrefetchRequest> const& requests, ///< the images to read, in the order they're wanted
+    int nAhead,                 ///< maximum number of images to have read but not yet returned (>= 1)
+    int nThreads,               ///< number of threads to read images with (>= 1)
+    Reader const& reader        ///< function to read an image; if empty, use ImagePrefetcher::read
+) : _requests(requests), _reader(reader) {
+    _start(nAhead, nThreads);
+}
+
+/**
+ * @brief Start reading the whole of each of a list of files
+ */
+template <typename ImageT>
+afwImage::ImagePrefetcher<ImageT>::ImagePrefetcher(
+    std::vector<std::string> const& fileNames, ///< the files to read, in the order they're wanted
+    int nAhead,                 ///< maximum number of images to have read but not yet returned (>= 1)
+    int nThreads                ///< number of threads to read images with (>= 1)
+) : _requests(), _reader() {
+    _requests.reserve(fileNames.size());
+    for (std::vector<std::string>::const_iterator ptr = fileNames.begin(); ptr != fileNames.end(); ++ptr) {
+        _requests.push_back(PrefetchRequest(*ptr));
+    }
+    _start(nAhead, nThreads);
+}
+
+/**
+ * @brief Stop reading images, waiting for any being read to be finished
+ */
+template <typename ImageT>
+afwImage::ImagePrefetcher<ImageT>::~ImagePrefetcher() {
+    {
+        boost::lock_guard<boost::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _spaceCond.notify_all();
+    _threads.join_all();
+}
+
+template <typename ImageT>
+void afwImage::ImagePrefetcher<ImageT>::_start(int nAhead, int nThreads) {
+    if (nAhead < 1 || nThreads < 1) {
+        throw LSST_EXCEPT(pexExcept::InvalidParameterException,
+                          (boost::format("nAhead (%d) and nThreads (%d) must both be at least 1") %
+                           nAhead % nThreads).str());
+    }
+    _nAhead = nAhead;
+    if (!cfitsio::fits_is_reentrant()) {
+        nThreads = 1;
+    }
+    nThreads = std::min(nThreads, static_cast<int>(std::min(_nAhead, _requests.size())));
+    if (!_reader) {
+        _reader = &ImagePrefetcher::read;
+    }
+
+    // Reading an Exposure looks up its Filter, and the filter registry is made (unsafely) on first use
+    Filter::getNames();
+
+    _nextToRead = _nextToReturn = 0;
+    _stop = false;
+    _images.resize(_requests.size());
+    _errors.resize(_requests.size());
+    _isRead.resize(_requests.size(), false);
+    for (int i = 0; i < nThreads; ++i) {
+        _threads.create_thread(boost::bind(&ImagePrefetcher::_readImages, this));
+    }
+}
+
+/*
+ * The body of each reading thread: read the next image that there's room for, until they've all been
+ * read or we're told to stop
+ */
+template <typename ImageT>
+void afwImage::ImagePrefetcher<ImageT>::_readImages() {
+    for (;;) {
+        std::size_t i = 0;              // the request we'll read
+        {
+            boost::unique_lock<boost::mutex> lock(_mutex);
+            while (!_stop && _nextToRead < _requests.size() && _nextToRead >= _nextToReturn + _nAhead) {
+                _spaceCond.wait(lock);
+            }
+            if (_stop || _nextToRead == _requests.size()) {
+                return;
+            }
+            i = _nextToRead++;
+        }
+
+        ImagePtr image;
+        std::string error;
+        try {
+            image = _reader(_requests[i]);
+        } catch (pexExcept::Exception &e) {
+            error = e.what();
+        } catch (std::exception &e) {
+            error = e.what();
+        } catch (...) {
+            error = "unknown exception";
+        }
+
+        {
+            boost::lock_guard<boost::mutex> lock(_mutex);
+            _images[i] = image;
+            _errors[i] = error;
+            _isRead[i] = true;
+        }
+        _readCond.notify_all();
+    }
+}
+
+/**
+ * @brief Are there images that haven't yet been returned by next()?
+ */
+template <typename ImageT>
+bool afwImage::ImagePrefetcher<ImageT>::hasNext() const {
+    boost::lock_guard<boost::mutex> lock(_mutex);
+    return _nextToReturn < _requests.size();
+}
+
+/**
+ * @brief Return the next image, waiting for it to be read if need be
+ *
+ * The prefetcher keeps no reference to the image, and starts reading another in its place.
+ *
+ * @throw lsst::pex::exceptions::OutOfRangeException if all the images have been returned
+ * @throw lsst::pex::exceptions::RuntimeErrorException if the image couldn't be read (the message is
+ * that of the exception thrown while reading it); the next call returns the following image
+ */
+template <typename ImageT>
+typename afwImage::ImagePrefetcher<ImageT>::ImagePtr afwImage::ImagePrefetcher<ImageT>::next() {
+    ImagePtr image;
+    std::string error;
+    std::size_t i = 0;                  // the image we're returning
+    {
+        boost::unique_lock<boost::mutex> lock(_mutex);
+        if (_nextToReturn == _requests.size()) {
+            throw LSST_EXCEPT(pexExcept::OutOfRangeException,
+                              (boost::format("All %d images have been returned") % _requests.size()).str());
+        }
+        i = _nextToReturn;
+        while (!_isRead[i]) {
+            _readCond.wait(lock);
+        }
+        image.swap(_images[i]);
+        error.swap(_errors[i]);
+        ++_nextToReturn;
+    }
+    _spaceCond.notify_all();
+
+    if (!error.empty()) {
+        throw LSST_EXCEPT(pexExcept::RuntimeErrorException,
+                          (boost::format("Reading %s: %s") % _requests[i].fileName % error).str());
+    }
+    return image;
+}
+
+/**
+ * @brief Read an image as the prefetcher does by default, using the MaskedImage or Exposure FITS
+ * constructor
+ */
+template <typename ImageT>
+typename afwImage::ImagePrefetcher<ImageT>::ImagePtr afwImage::ImagePrefetcher<ImageT>::read(
+    PrefetchRequest const& request      ///< what to read
+) {
+    return readImage(request, static_cast<ImageT *>(0));
+}
+
+/************************************************************************************************************/
+//
+// Explicit instantiations
+//
+/// \cond
+#define INSTANTIATE(PIXEL_TYPE) \
+    template class afwImage::ImagePrefetcher<afwImage::MaskedImage<PIXEL_TYPE> >; \
+    template class afwImage::ImagePrefetcher<afwImage::Exposure<PIXEL_TYPE> >;
+
+INSTANTIATE(boost::uint16_t)
+INSTANTIATE(int)
+INSTANTIATE(float)
+INSTANTIATE(double)
+/// \endcond
@@ -31,6 +31,7 @@
 #include "boost/lambda/lambda.hpp"
 #include "boost/format.hpp"
 #include "boost/filesystem/path.hpp"
+#include "boost/thread.hpp"
 
 #include "lsst/daf/base.h"
 #include "lsst/daf/data/LsstBase.h"
@@ -56,11 +57,21 @@ namespace dafBase = lsst::daf::base;
 namespace pexExcept = lsst::pex::exceptions;
 namespace pexLog = lsst::pex::logging;
 
+namespace {
+    /*
+     * Protects every Mask's plane dictionary (and its version number), which may be changed by reading
+     * a file; recursive, as the dictionary operations call one another
+     */
+    boost::recursive_mutex maskDictMutex;
+    typedef boost::lock_guard<boost::recursive_mutex> MaskDictLock;
+}
+
 /**
  * \brief Initialise mask planes; called by constructors
  */
 template<typename MaskPixelT>
 void afwImage::Mask<MaskPixelT>::_initializePlanes(MaskPlaneDict const& planeDefs) {
+    MaskDictLock lock(maskDictMutex);
     pexLog::Trace("afw.Mask", 5,
                    boost::format("Number of mask planes: %d") % getNumPlanesMax());
     if (planeDefs.size() > 0 && planeDefs != _maskPlaneDict) {
@@ -79,7 +90,7 @@ afwImage::Mask<MaskPixelT>::Mask(
     MaskPlaneDict const& planeDefs ///< desired mask planes
 ) :
     afwImage::ImageBase<MaskPixelT>(afwGeom::ExtentI(width, height)),
-    _myMaskDictVersion(_maskDictVersion) {
+    _myMaskDictVersion(_getMaskDictVersion()) {
     _initializePlanes(planeDefs);
     *this = 0x0;
 }
@@ -95,7 +106,7 @@ afwImage::Mask<MaskPixelT>::Mask(
     MaskPlaneDict const& planeDefs ///< desired mask planes
 ) :
     afwImage::ImageBase<MaskPixelT>(afwGeom::ExtentI(width, height)),
-    _myMaskDictVersion(_maskDictVersion) {
+    _myMaskDictVersion(_getMaskDictVersion()) {
     _initializePlanes(planeDefs);
     *this = initialValue;
 }
@@ -109,7 +120,7 @@ afwImage::Mask<MaskPixelT>::Mask(
     MaskPlaneDict const& planeDefs ///< desired mask planes
 ) :
     afwImage::ImageBase<MaskPixelT>(dimensions),
-    _myMaskDictVersion(_maskDictVersion) {
+    _myMaskDictVersion(_getMaskDictVersion()) {
     _initializePlanes(planeDefs);
     *this = 0x0;
 }
@@ -124,7 +135,7 @@ afwImage::Mask<MaskPixelT>::Mask(
     MaskPlaneDict const& planeDefs ///< desired mask planes
 ) :
     afwImage::ImageBase<MaskPixelT>(dimensions),
-    _myMaskDictVersion(_maskDictVersion) {
+    _myMaskDictVersion(_getMaskDictVersion()) {
     _initializePlanes(planeDefs);
     *this = initialValue;
 }
@@ -138,7 +149,7 @@ afwImage::Mask<MaskPixelT>::Mask(
     MaskPlaneDict const& planeDefs ///< desired mask planes
 ) :
     afwImage::ImageBase<MaskPixelT>(bbox),
-    _myMaskDictVersion(_maskDictVersion) {
+    _myMaskDictVersion(_getMaskDictVersion()) {
     _initializePlanes(planeDefs);
     *this = 0x0;
 }
@@ -153,7 +164,7 @@ afwImage::Mask<MaskPixelT>::Mask(
     MaskPlaneDict const& planeDefs ///< desired mask planes
 ) :
     afwImage::ImageBase<MaskPixelT>(bbox),
-    _myMaskDictVersion(_maskDictVersion) {
+    _myMaskDictVersion(_getMaskDictVersion()) {
     _initializePlanes(planeDefs);
     *this = initialValue;
 }
@@ -231,7 +242,7 @@ afwImage::Mask<MaskPixelT>::Mask(std::string const& fileName, ///< Name of file
         bool const conformMasks                            ///< Make Mask conform to mask layout in file?
 ) :
     afwImage::ImageBase<MaskPixelT>(),
-    _myMaskDictVersion(_maskDictVersion) 
+    _myMaskDictVersion(_getMaskDictVersion()) 
 {
     //
     // These are the permitted input file types
@@ -255,22 +266,7 @@ afwImage::Mask<MaskPixelT>::Mask(std::string const& fileName, ///< Name of file
         throw LSST_EXCEPT(afwImage::FitsException,
             (boost::format("Failed to read %s HDU %d") % fileName % hdu).str());
     }
-    // look for mask planes in the file
-    MaskPlaneDict fileMaskDict = parseMaskPlaneMetadata(metadata); 
-
-    if (fileMaskDict == _maskPlaneDict) { // file is consistent with Mask
-        return;
-    }
-    
-    if (conformMasks) {                 // adopt the definitions in the file
-        if (_maskPlaneDict != fileMaskDict) {
-            _maskPlaneDict = fileMaskDict;
-            _maskDictVersion++;
-        }
-    }
-
-    conformMaskPlanes(fileMaskDict);    // convert planes defined by fileMaskDict to the order
-                                        // defined by Mask::_maskPlaneDict
+    conformMaskPlanes(metadata, conformMasks);
 }
 
 /**
@@ -292,7 +288,7 @@ afwImage::Mask<MaskPixelT>::Mask(
         bool const conformMasks                            ///< Make Mask conform to mask layout in file?
 ) :
     afwImage::ImageBase<MaskPixelT>(),
-    _myMaskDictVersion(_maskDictVersion) 
+    _myMaskDictVersion(_getMaskDictVersion()) 
 {
     //
     // These are the permitted input file types
@@ -311,22 +307,7 @@ afwImage::Mask<MaskPixelT>::Mask(
         throw LSST_EXCEPT(afwImage::FitsException,
             (boost::format("Failed to read RAM FITS HDU %d") % hdu).str());
     }
-    // look for mask planes in the file
-    MaskPlaneDict fileMaskDict = parseMaskPlaneMetadata(metadata); 
-
-    if (fileMaskDict == _maskPlaneDict) { // file is consistent with Mask
-        return;
-    }
-    
-    if (conformMasks) {                 // adopt the definitions in the file
-        if (_maskPlaneDict != fileMaskDict) {
-            _maskPlaneDict = fileMaskDict;
-            _maskDictVersion++;
-        }
-    }
-
-    conformMaskPlanes(fileMaskDict);    // convert planes defined by fileMaskDict to the order
-                                        // defined by Mask::_maskPlaneDict
+    conformMaskPlanes(metadata, conformMasks);
 }
 
 /**
@@ -391,6 +372,7 @@ void afwImage::Mask<MaskPixelT>::writeFits(
 template<typename MaskPixelT>
 int afwImage::Mask<MaskPixelT>::addMaskPlane(const std::string& name)
 {
+    MaskDictLock lock(maskDictMutex);
     int const id = getMaskPlaneNoThrow(name);
 
     if (id >= 0) {
@@ -419,6 +401,7 @@ int afwImage::Mask<MaskPixelT>::addMaskPlane(
     std::string name,   ///< new name of mask plane
     int planeId         ///< ID of mask plane to be (re)named
 ) {
+    MaskDictLock lock(maskDictMutex);
     if (planeId < 0 || planeId >= getNumPlanesMax()) {
         throw LSST_EXCEPT(pexExcept::RangeErrorException,
             (boost::format("mask plane ID must be between 0 and %1%") % (getNumPlanesMax() - 1)).str());
@@ -437,6 +420,7 @@ int afwImage::Mask<MaskPixelT>::addMaskPlane(
 template<typename MaskPixelT>
 void afwImage::Mask<MaskPixelT>::removeMaskPlane(const std::string& name)
 {
+    MaskDictLock lock(maskDictMutex);
     int id;
     try {
         id = getMaskPlane(name);
@@ -467,6 +451,7 @@ MaskPixelT afwImage::Mask<MaskPixelT>::getBitMaskNoThrow(int planeId) {
  */
 template<typename MaskPixelT>
 MaskPixelT afwImage::Mask<MaskPixelT>::getBitMask(int planeId) {
+    MaskDictLock lock(maskDictMutex);
     for (MaskPlaneDict::const_iterator i = _maskPlaneDict.begin(); i != _maskPlaneDict.end(); ++i) {
         if (planeId == i->second) {
             MaskPixelT const bitmask = getBitMaskNoThrow(planeId);
@@ -502,6 +487,7 @@ int afwImage::Mask<MaskPixelT>::getMaskPlane(const std::string& name) {
  */
 template<typename MaskPixelT>
 int afwImage::Mask<MaskPixelT>::getMaskPlaneNoThrow(const std::string& name) {
+    MaskDictLock lock(maskDictMutex);
     MaskPlaneDict::const_iterator plane = _maskPlaneDict.find(name);
     
     if (plane == _maskPlaneDict.end()) {
@@ -518,6 +504,7 @@ int afwImage::Mask<MaskPixelT>::getMaskPlaneNoThrow(const std::string& name) {
  */
 template<typename MaskPixelT>
 MaskPixelT afwImage::Mask<MaskPixelT>::getPlaneBitMask(const std::string& name) {
+    MaskDictLock lock(maskDictMutex);
     return getBitMask(getMaskPlane(name));
 }
 
@@ -528,6 +515,7 @@ MaskPixelT afwImage::Mask<MaskPixelT>::getPlaneBitMask(const std::string& name)
  */
 template<typename MaskPixelT>
 MaskPixelT afwImage::Mask<MaskPixelT>::getPlaneBitMask(const std::vector<std::string> &name) {
+    MaskDictLock lock(maskDictMutex);
     MaskPixelT mpix = 0x0;
     for (std::vector<std::string>::const_iterator it = name.begin(); it != name.end(); ++it) {
         mpix |= getBitMask(getMaskPlane(*it));
@@ -541,6 +529,7 @@ MaskPixelT afwImage::Mask<MaskPixelT>::getPlaneBitMask(const std::vector<std::st
  */
 template<typename MaskPixelT>
 void afwImage::Mask<MaskPixelT>::clearMaskPlaneDict() {
+    MaskDictLock lock(maskDictMutex);
     _maskPlaneDict.clear();
     _myMaskDictVersion = ++_maskDictVersion;
 }
@@ -561,6 +550,34 @@ void afwImage::Mask<MaskPixelT>::clearMaskPlane(int planeId) {
     *this &= ~getBitMask(planeId);
 }
 
+/**
+ * \brief Adjust a mask just read from a file to conform to the mask planes described by the file's
+ * metadata; used by the ctors that read files
+ */
+template<typename MaskPixelT>
+void afwImage::Mask<MaskPixelT>::conformMaskPlanes(
+    lsst::daf::base::PropertySet::Ptr metadata, ///< the file's metadata
+    bool const conformMasks                     ///< Make Mask conform to mask layout in file?
+) {
+    MaskDictLock lock(maskDictMutex);
+    // look for mask planes in the file
+    MaskPlaneDict fileMaskDict = parseMaskPlaneMetadata(metadata); 
+
+    if (fileMaskDict == _maskPlaneDict) { // file is consistent with Mask
+        return;
+    }
+    
+    if (conformMasks) {                 // adopt the definitions in the file
+        if (_maskPlaneDict != fileMaskDict) {
+            _maskPlaneDict = fileMaskDict;
+            _maskDictVersion++;
+        }
+    }
+
+    conformMaskPlanes(fileMaskDict);    // convert planes defined by fileMaskDict to the order
+                                        // defined by Mask::_maskPlaneDict
+}
+
 /**
  * \brief Adjust this mask to conform to the standard Mask class's mask plane dictionary,
  * adding any new mask planes to the standard.
@@ -575,6 +592,7 @@ template<typename MaskPixelT>
 void afwImage::Mask<MaskPixelT>::conformMaskPlanes(
     MaskPlaneDict const &currentPlaneDict   ///< mask plane dictionary for this mask
 ) {
+    MaskDictLock lock(maskDictMutex);
     if (_maskPlaneDict == currentPlaneDict) {
         _myMaskDictVersion = _maskDictVersion;
         return;   // nothing to do
@@ -797,6 +815,7 @@ void afwImage::Mask<MaskPixelT>::setMaskPlaneValues(int const planeId,
  */
 template<typename MaskPixelT>
 void afwImage::Mask<MaskPixelT>::addMaskPlanesToMetadata(lsst::daf::base::PropertySet::Ptr metadata) {
+    MaskDictLock lock(maskDictMutex);
     if (!metadata) {
         throw LSST_EXCEPT(pexExcept::InvalidParameterException, "Null PropertySet::Ptr");
     }
@@ -869,11 +888,39 @@ typename afwImage::Mask<MaskPixelT>::MaskPlaneDict afwImage::Mask<MaskPixelT>::p
     return newDict;
 }
 
+/**
+ * \brief Return the number of mask planes in the dictionary
+ */
+template<typename MaskPixelT>
+int afwImage::Mask<MaskPixelT>::getNumPlanesUsed() {
+    MaskDictLock lock(maskDictMutex);
+    return _maskPlaneDict.size();
+}
+
+/**
+ * \brief Return a copy of the mask plane dictionary
+ */
+template<typename MaskPixelT>
+typename afwImage::Mask<MaskPixelT>::MaskPlaneDict afwImage::Mask<MaskPixelT>::getMaskPlaneDict() {
+    MaskDictLock lock(maskDictMutex);
+    return _maskPlaneDict;
+}
+
+/*
+ * Return the current version of the mask plane dictionary; used by the constructors
+ */
+template<typename MaskPixelT>
+int afwImage::Mask<MaskPixelT>::_getMaskDictVersion() {
+    MaskDictLock lock(maskDictMutex);
+    return _maskDictVersion;
+}
+
 /**
  * \brief print the mask plane dictionary to std::cout
  */
 template<typename MaskPixelT>
 void afwImage::Mask<MaskPixelT>::printMaskPlanes() {
+    MaskDictLock lock(maskDictMutex);
     for (MaskPlaneDict::const_iterator i = _maskPlaneDict.begin(); i != _maskPlaneDict.end() ; i++) {
         std::string const planeName = i->first;
         int const planeNumber = i->second;
@@ -30,16 +30,247 @@
 #include <sys/stat.h>
 #include "boost/lambda/lambda.hpp"
 #include "boost/regex.hpp"
+#include "boost/bind.hpp"
+#include "boost/function.hpp"
+#include "boost/filesystem/operations.hpp"
 #include "boost/filesystem/path.hpp"
+#include "boost/thread.hpp"
 #include "lsst/pex/logging/Trace.h"
 #include "lsst/pex/exceptions.h"
 #include "boost/algorithm/string/trim.hpp"
 
 #include "lsst/afw/image/MaskedImage.h"
+#include "lsst/afw/image/Wcs.h"
 #include "lsst/afw/image/fits/fits_io.h"
+#include "lsst/afw/math/detail/Parallel.h"
 
 namespace bl = boost::lambda;
 namespace image = lsst::afw::image;
+namespace mathDetail = lsst::afw::math::detail;
+
+namespace {
+    /*
+     * Check that a plane's EXTTYPE (if it has one) is what we expected
+     */
+    void checkExtType(lsst::daf::base::PropertySet::ConstPtr metadata, std::string const& expected,
+                      std::string const& fileName, int hdu) {
+        if (!metadata->exists("EXTTYPE")) {
+            return;
+        }
+        std::string const exttype = boost::algorithm::trim_right_copy(metadata->getAsString("EXTTYPE"));
+        if (exttype != "" && exttype != expected) {
+            throw LSST_EXCEPT(lsst::pex::exceptions::InvalidParameterException,
+                              (boost::format("Reading %s (hdu %d) Expected EXTTYPE==\"%s\", saw \"%s\"") %
+                               fileName % hdu % expected % exttype).str());
+        }
+    }
+
+    /*
+     * A boost::thread_group that waits for its threads however we leave the scope that owns it
+     */
+    class JoinOnExit : public boost::thread_group {
+    public:
+        ~JoinOnExit() { join_all(); }
+    };
+
+    typedef boost::function<void ()> Job;
+
+    /*
+     * Read one plane of a MaskedImage at a time, sharing cfitsio's handle between planes in the same file
+     */
+    class PlaneReader {
+    public:
+        PlaneReader(lsst::afw::geom::Box2I const& bbox, image::ImageOrigin origin) :
+            _bbox(bbox), _origin(origin) {}
+
+        /*
+         * Read HDU hdu's metadata, and map (or read, if it can't be mapped) its pixels into pending;
+         * returns false if the HDU isn't of type PixelT
+         */
+        template <typename PixelT>
+        bool start(std::string const& fileName, int hdu, lsst::daf::base::PropertySet::Ptr metadata,
+                   image::detail::fits_pending_image<PixelT> & pending) {
+            if (_reader && fileName == _fileName) {
+                _reader.reset(new image::detail::fits_reader(*_reader, metadata, hdu, _bbox, _origin));
+            } else {
+                _reader.reset();
+                _reader.reset(new image::detail::fits_reader(fileName, metadata, hdu, _bbox, _origin));
+                _fileName = fileName;
+            }
+            return _reader->start_read(pending);
+        }
+    private:
+        lsst::afw::geom::Box2I _bbox;
+        image::ImageOrigin _origin;
+        boost::shared_ptr<image::detail::fits_reader> _reader;
+        std::string _fileName;
+    };
+
+    /*
+     * Read the image, mask, and variance of a MaskedImage from HDUs hdu[0], hdu[1], hdu[2] of files
+     * fileName[0], fileName[1], fileName[2] (usually all the same file).
+     *
+     * cfitsio is only called from this thread, but as soon as a plane's header has been read and its
+     * pixels mapped they're converted on a thread of their own, while we go on to the next plane; so
+     * reading the headers overlaps with converting the pixels, and the planes are converted in parallel.
+     *
+     * Returns false, having set nothing, if the planes can't all be read this way (e.g. one is missing,
+     * or isn't of the MaskedImage's pixel type); the caller should then read them one by one.
+     */
+    template <typename MaskedImageT>
+    bool readPlanes(
+        std::string const fileName[3], int const hdu[3],
+        lsst::daf::base::PropertySet::Ptr metadata, lsst::afw::geom::Box2I const& bbox,
+        image::ImageOrigin const origin, bool const conformMasks,
+        typename MaskedImageT::ImagePtr & imagePtr, typename MaskedImageT::MaskPtr & maskPtr,
+        typename MaskedImageT::VariancePtr & variancePtr
+    ) {
+        typedef typename MaskedImageT::Image Image;
+        typedef typename MaskedImageT::Mask Mask;
+        typedef typename MaskedImageT::Variance Variance;
+
+        lsst::daf::base::PropertySet::Ptr planeMetadata[3];
+        for (int i = 0; i != 3; ++i) {
+            planeMetadata[i].reset(new lsst::daf::base::PropertyList);
+        }
+        image::detail::fits_pending_image<typename Image::Pixel> imagePending;
+        image::detail::fits_pending_image<typename Mask::Pixel> maskPending;
+        image::detail::fits_pending_image<typename Variance::Pixel> variancePending;
+        Job jobs[3] = {
+            boost::bind(&image::detail::fits_pending_image<typename Image::Pixel>::finish, &imagePending),
+            boost::bind(&image::detail::fits_pending_image<typename Mask::Pixel>::finish, &maskPending),
+            boost::bind(&image::detail::fits_pending_image<typename Variance::Pixel>::finish,
+                        &variancePending)
+        };
+        std::string errors[3];
+        {
+            // The threads use only jobs, the pending images, and errors (the mapped pixels don't depend
+            // on reader), which are declared outside this block so they outlive the join; keep them there
+            JoinOnExit threads;
+            PlaneReader reader(bbox, origin);
+            try {
+                if (!reader.start(fileName[0], hdu[0], planeMetadata[0], imagePending)) {
+                    return false;
+                }
+                threads.create_thread(mathDetail::TrapExceptions<Job>(jobs[0], errors[0]));
+
+                if (!reader.start(fileName[1], hdu[1], planeMetadata[1], maskPending)) {
+                    return false;
+                }
+                threads.create_thread(mathDetail::TrapExceptions<Job>(jobs[1], errors[1]));
+
+                if (!reader.start(fileName[2], hdu[2], planeMetadata[2], variancePending)) {
+                    return false;
+                }
+            } catch (image::FitsException &) {
+                return false;
+            }
+            mathDetail::TrapExceptions<Job>(jobs[2], errors[2])();
+        }
+        for (int i = 0; i != 3; ++i) {
+            if (!errors[i].empty()) {
+                throw LSST_EXCEPT(lsst::pex::exceptions::RuntimeErrorException, errors[i]);
+            }
+        }
+
+        checkExtType(planeMetadata[0], "IMAGE", fileName[0], hdu[0]);
+        checkExtType(planeMetadata[1], "MASK", fileName[1], hdu[1]);
+        checkExtType(planeMetadata[2], "VARIANCE", fileName[2], hdu[2]);
+
+        imagePtr.reset(new Image(imagePending.array, false, imagePending.xy0));
+        maskPtr.reset(new Mask(maskPending.array, false, maskPending.xy0));
+        maskPtr->conformMaskPlanes(planeMetadata[1], conformMasks);
+        variancePtr.reset(new Variance(variancePending.array, false, variancePending.xy0));
+
+        for (int i = 0; i != 3; ++i) {  // as if each plane's metadata had been read into metadata
+            metadata->combine(planeMetadata[i]);
+        }
+        return true;
+    }
+
+    /*
+     * Write an image's pixels, which cfitsio has made room for at offset in fileName
+     */
+    template <typename ImageT>
+    void writePixels(ImageT const& img, std::string const& fileName, long long offset) {
+        typedef typename ImageT::Pixel PixelT;
+        image::detail::fits_pixel_writer writer(fileName, offset,
+                                                image::detail::fits_read_support_private<PixelT>::BITPIX);
+        typename ImageT::ConstArray const array = img.getArray();
+        for (int y = 0; y != img.getHeight(); ++y) {
+            writer.write(array.getData() + static_cast<long long>(y)*array.template getStride<0>(),
+                         img.getWidth());
+        }
+        writer.flush();
+    }
+
+    /*
+     * Write a new MEF file holding a PDU and the image, mask, and variance of a MaskedImage.  cfitsio
+     * writes the headers and makes room for the pixels; it then closes the file, and the planes'
+     * pixels are written concurrently, each on its own thread.
+     *
+     * Returns false, having written nothing we don't overwrite, if the file can't be written this
+     * way: if it's to be compressed, if the image's metadata sets BZERO or BSCALE (which the pixels
+     * would then need scaling for), or if cfitsio interpreted fileName as something other than a plain
+     * file (e.g. "!foo.fits")
+     */
+    template <typename MaskedImageT>
+    bool writePlanes(MaskedImageT const& mi, std::string const& fileName,
+                     lsst::daf::base::PropertySet::ConstPtr metadata_i) {
+        typedef typename MaskedImageT::Image::Pixel ImagePixelT;
+        typedef typename MaskedImageT::Mask::Pixel MaskPixelT;
+        typedef typename MaskedImageT::Variance::Pixel VariancePixelT;
+        using lsst::daf::base::PropertySet;
+
+        if (image::detail::fits_compression_requested(metadata_i.get()) ||
+            (metadata_i && (metadata_i->exists("BZERO") || metadata_i->exists("BSCALE")))) {
+            return false;
+        }
+
+        PropertySet::Ptr const xy0Metadata = image::detail::createTrivialWcsAsPropertySet(
+            image::detail::wcsNameForXY0, mi.getX0(), mi.getY0());
+        PropertySet::Ptr imageMetadata = metadata_i ? metadata_i->deepCopy() :
+            PropertySet::Ptr(new lsst::daf::base::PropertyList());
+        PropertySet::Ptr maskMetadata(new lsst::daf::base::PropertyList());
+        PropertySet::Ptr varianceMetadata(new lsst::daf::base::PropertyList());
+
+        long long offsets[3];           // offsets of the planes' data
+        {
+            image::detail::fits_writer writer(fileName, "w");
+            writer.create_image<ImagePixelT>(lsst::afw::geom::Extent2I(0, 0), imageMetadata); // the PDU
+
+            imageMetadata->set("EXTTYPE", "IMAGE");
+            imageMetadata->combine(xy0Metadata);
+            writer.create_image<ImagePixelT>(mi.getDimensions(), imageMetadata);
+
+            maskMetadata->set("EXTTYPE", "MASK");
+            MaskedImageT::Mask::addMaskPlanesToMetadata(maskMetadata);
+            maskMetadata->combine(xy0Metadata);
+            writer.create_image<MaskPixelT>(mi.getDimensions(), maskMetadata);
+
+            varianceMetadata->set("EXTTYPE", "VARIANCE");
+            varianceMetadata->combine(xy0Metadata);
+            writer.create_image<VariancePixelT>(mi.getDimensions(), varianceMetadata);
+
+            for (int i = 0; i != 3; ++i) {
+                offsets[i] = writer.get_data_offset(i + 2);
+            }
+        }
+        if (!boost::filesystem::exists(fileName)) {
+            return false;
+        }
+
+        std::vector<Job> jobs;
+        jobs.push_back(boost::bind(&writePixels<typename MaskedImageT::Image>,
+                                   boost::cref(*mi.getImage()), boost::cref(fileName), offsets[0]));
+        jobs.push_back(boost::bind(&writePixels<typename MaskedImageT::Mask>,
+                                   boost::cref(*mi.getMask()), boost::cref(fileName), offsets[1]));
+        jobs.push_back(boost::bind(&writePixels<typename MaskedImageT::Variance>,
+                                   boost::cref(*mi.getVariance()), boost::cref(fileName), offsets[2]));
+        mathDetail::runInParallel(jobs);
+        return true;
+    }
+}
 
 /** Constructors
  *
@@ -157,15 +388,15 @@ image::MaskedImage<ImagePixelT, MaskPixelT, VariancePixelT>::MaskedImage(
             }
         }
 
+        std::string const fileNames[3] = {baseName, baseName, baseName};
+        int const hdus[3] = {real_hdu, real_hdu + 1, real_hdu + 2};
+        if (readPlanes<MaskedImage>(fileNames, hdus, metadata, bbox, origin, conformMasks,
+                                    _image, _mask, _variance)) {
+            return;
+        }
+
         _image = typename Image::Ptr(new Image(baseName, real_hdu, metadata, bbox, origin));
-        try {
-            std::string exttype = boost::algorithm::trim_right_copy(metadata->getAsString("EXTTYPE"));
-            if (exttype != "" && exttype != "IMAGE") {
-                throw LSST_EXCEPT(lsst::pex::exceptions::InvalidParameterException,
-                                  (boost::format("Reading %s (hdu %d) Expected EXTTYPE==\"IMAGE\", saw \"%s\"") %
-                                   baseName % real_hdu % exttype).str());
-            }
-        } catch(lsst::pex::exceptions::NotFoundException) {}
+        checkExtType(metadata, "IMAGE", baseName, real_hdu);
 
         try {
             _mask = typename Mask::Ptr(new Mask(baseName, real_hdu + 1, metadata, bbox, origin, conformMasks));
@@ -178,17 +409,7 @@ image::MaskedImage<ImagePixelT, MaskPixelT, VariancePixelT>::MaskedImage(
             _mask = typename Mask::Ptr(new Mask(_image->getBBox(PARENT)));
         }
 
-        try {
-            std::string exttype = boost::algorithm::trim_right_copy(metadata->getAsString("EXTTYPE"));
-
-            if (exttype != "" && exttype != "MASK") {
-                throw LSST_EXCEPT(lsst::pex::exceptions::InvalidParameterException,
-                                  (boost::format("Reading %s (hdu %d) Expected EXTTYPE==\"MASK\", saw \"%s\"") %
-                                   baseName % (real_hdu + 1) % exttype).str());
-            }
-        } catch(lsst::pex::exceptions::NotFoundException) {
-            ;
-        }
+        checkExtType(metadata, "MASK", baseName, real_hdu + 1);
 
         try {
             _variance = typename Variance::Ptr(new Variance(baseName, real_hdu + 2, metadata, bbox, origin));
@@ -199,50 +420,27 @@ image::MaskedImage<ImagePixelT, MaskPixelT, VariancePixelT>::MaskedImage(
             }
             _variance = typename Variance::Ptr(new Variance(_image->getBBox(PARENT)));
         }
-        try {
-            std::string exttype = boost::algorithm::trim_right_copy(metadata->getAsString("EXTTYPE"));
-
-            if (exttype != "" && exttype != "VARIANCE") {
-                throw LSST_EXCEPT(lsst::pex::exceptions::InvalidParameterException,
-                           (boost::format("Reading %s (hdu %d) Expected EXTTYPE==\"VARIANCE\", saw \"%s\"") %
-                            baseName % (real_hdu + 2) % exttype).str());
-            }
-        } catch(lsst::pex::exceptions::NotFoundException) {}
+        checkExtType(metadata, "VARIANCE", baseName, real_hdu + 2);
     } else {
         int real_hdu = (hdu == 0) ? 1 : hdu;
 
-        _image = typename Image::Ptr(new Image(MaskedImage::imageFileName(baseName),
-                                               real_hdu, metadata, bbox, origin));
-        try {
-            std::string exttype = boost::algorithm::trim_right_copy(metadata->getAsString("EXTTYPE"));
-            if (exttype != "" && exttype != "IMAGE") {
-                throw LSST_EXCEPT(lsst::pex::exceptions::InvalidParameterException,
-                           (boost::format("Reading %s (hdu %d) Expected EXTTYPE==\"IMAGE\", saw \"%s\"") %
-                            MaskedImage::imageFileName(baseName) % real_hdu % exttype).str());
-            }
-        } catch(lsst::pex::exceptions::NotFoundException) {}
+        std::string const fileNames[3] = {MaskedImage::imageFileName(baseName),
+                                          MaskedImage::maskFileName(baseName),
+                                          MaskedImage::varianceFileName(baseName)};
+        int const hdus[3] = {real_hdu, real_hdu, real_hdu};
+        if (readPlanes<MaskedImage>(fileNames, hdus, metadata, bbox, origin, conformMasks,
+                                    _image, _mask, _variance)) {
+            return;
+        }
 
-        _mask = typename Mask::Ptr(new Mask(MaskedImage::maskFileName(baseName),
-                                            real_hdu, metadata, bbox, origin, conformMasks));
-        try {
-            std::string exttype = boost::algorithm::trim_right_copy(metadata->getAsString("EXTTYPE"));
-            if (exttype != "" && exttype != "MASK") {
-                throw LSST_EXCEPT(lsst::pex::exceptions::InvalidParameterException,
-                           (boost::format("Reading %s (hdu %d) Expected EXTTYPE==\"MASK\", saw \"%s\"") %
-                            MaskedImage::maskFileName(baseName) % real_hdu % exttype).str());
-            }
-        } catch(lsst::pex::exceptions::NotFoundException) {}
+        _image = typename Image::Ptr(new Image(fileNames[0], real_hdu, metadata, bbox, origin));
+        checkExtType(metadata, "IMAGE", fileNames[0], real_hdu);
 
-        _variance = typename Variance::Ptr(new Variance(MaskedImage::varianceFileName(baseName),
-                                                        real_hdu, metadata, bbox, origin));
-        try {
-            std::string exttype = boost::algorithm::trim_right_copy(metadata->getAsString("EXTTYPE"));
-            if (exttype != "" && exttype != "VARIANCE") {
-                throw LSST_EXCEPT(lsst::pex::exceptions::InvalidParameterException,
-                           (boost::format("Reading %s (hdu %d) Expected EXTTYPE==\"VARIANCE\", saw \"%s\"") %
-                            MaskedImage::varianceFileName(baseName) % real_hdu % exttype).str());
-            }
-        } catch(lsst::pex::exceptions::NotFoundException) {}
+        _mask = typename Mask::Ptr(new Mask(fileNames[1], real_hdu, metadata, bbox, origin, conformMasks));
+        checkExtType(metadata, "MASK", fileNames[1], real_hdu);
+
+        _variance = typename Variance::Ptr(new Variance(fileNames[2], real_hdu, metadata, bbox, origin));
+        checkExtType(metadata, "VARIANCE", fileNames[2], real_hdu);
     }
 }
 
@@ -634,6 +832,10 @@ void image::MaskedImage<ImagePixelT, MaskPixelT, VariancePixelT>::operator/=(Ima
 /**
  * Write \c this to a FITS file
  *
+ * If metadata sets the keys that request tile compression (ZCMPTYPE etc.; see
+ * detail::fits_set_compression) they apply to the image, mask and variance alike; the quantization
+ * keys only affect the floating point planes.
+ *
  * \deprecated Please avoid using the interface that writes three separate files;  it may be
  * removed in some future release.
  */
@@ -672,6 +874,9 @@ void image::MaskedImage<ImagePixelT, MaskPixelT, VariancePixelT>::writeFits(
             throw LSST_EXCEPT(lsst::pex::exceptions::IoErrorException,
                               "I don't know how to write a compressed MEF: " + baseName);
         }
+        if ((mode == "w" || mode == "wb") && writePlanes(*this, baseName, metadata_i)) {
+            return;
+        }
         //
         // Write the PDU
         //
@@ -686,19 +891,23 @@ void image::MaskedImage<ImagePixelT, MaskPixelT, VariancePixelT>::writeFits(
         _image->writeFits(baseName, metadata, "a");
 
         metadata = lsst::daf::base::PropertySet::Ptr(new lsst::daf::base::PropertyList());
+        image::detail::fits_copy_compression_keys(metadata_i, metadata);
         metadata->set("EXTTYPE", "MASK");
         _mask->writeFits(baseName, metadata, "a");
 
         metadata = lsst::daf::base::PropertySet::Ptr(new lsst::daf::base::PropertyList());
+        image::detail::fits_copy_compression_keys(metadata_i, metadata);
         metadata->set("EXTTYPE", "VARIANCE");
         _variance->writeFits(baseName, metadata, "a");
     } else {
         _image->writeFits(MaskedImage::imageFileName(baseName), metadata, mode);
 
         metadata = lsst::daf::base::PropertySet::Ptr(new lsst::daf::base::PropertyList());
+        image::detail::fits_copy_compression_keys(metadata_i, metadata);
         _mask->writeFits(MaskedImage::maskFileName(baseName), metadata, mode);
 
         metadata = lsst::daf::base::PropertySet::Ptr(new lsst::daf::base::PropertyList());
+        image::detail::fits_copy_compression_keys(metadata_i, metadata);
         _variance->writeFits(MaskedImage::varianceFileName(baseName), metadata, mode);
     }
 }
@@ -751,10 +960,12 @@ void image::MaskedImage<ImagePixelT, MaskPixelT, VariancePixelT>::writeFits(
         _image->writeFits(ramFile, ramFileLen, metadata, "w");    //First one can't be 'a', must be 'w'
 
         metadata = lsst::daf::base::PropertySet::Ptr(new lsst::daf::base::PropertyList());
+        image::detail::fits_copy_compression_keys(metadata_i, metadata);
         metadata->set("EXTTYPE", "MASK");
         _mask->writeFits(ramFile, ramFileLen, metadata, "a");
 
         metadata = lsst::daf::base::PropertySet::Ptr(new lsst::daf::base::PropertyList());
+        image::detail::fits_copy_compression_keys(metadata_i, metadata);
         metadata->set("EXTTYPE", "VARIANCE");
         _variance->writeFits(ramFile, ramFileLen, metadata, "a");
     } else {
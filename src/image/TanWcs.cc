@@ -23,7 +23,9 @@
 #include <iostream>
 #include <sstream>
 #include <cmath>
+#include <algorithm>
 #include <cstring>
+#include <vector>
 
 #include "boost/format.hpp"
 
@@ -453,6 +455,80 @@ TanWcs::pixelToSkyImpl(double pixel1, double pixel2, afwGeom::Angle sky[2]) cons
 
 /************************************************************************************************************/
 
+namespace {
+    /*
+     * Add SIP polynomial corrections to many interleaved (x, y) pixel positions (FITS convention)
+     *
+     * If onlyHigherOrder is true, only the terms with 1 < i+j < order are used (as in undistortPixel),
+     * otherwise all terms are used (as in distortPixel). Powers of u and v are computed by repeated
+     * multiplication, once per position, rather than by calling pow for each term.
+     */
+    void addSipCorrections(Eigen::MatrixXd const & sipX, ///< SIP coefficients for the x correction
+                           Eigen::MatrixXd const & sipY, ///< SIP coefficients for the y correction
+                           bool onlyHigherOrder,         ///< use only terms with 1 < i+j < order?
+                           double const crpix[2],        ///< reference pixel (FITS convention)
+                           int nPoints,                  ///< number of positions
+                           double pixTmp[]               ///< interleaved positions; modified in place
+                          ) {
+        int const nPow = std::max(std::max(std::max(sipX.rows(), sipX.cols()),
+                                           std::max(sipY.rows(), sipY.cols())), 1);
+        std::vector<double> uPow(nPow);
+        std::vector<double> vPow(nPow);
+        for (int k = 0; k < nPoints; ++k) {
+            double const u = pixTmp[2*k] - crpix[0];  //Relative pixel coords
+            double const v = pixTmp[2*k + 1] - crpix[1];
+            uPow[0] = vPow[0] = 1.0;
+            for (int i = 1; i < nPow; ++i) {
+                uPow[i] = uPow[i-1]*u;
+                vPow[i] = vPow[i-1]*v;
+            }
+
+            double f = 0;
+            for (int i = 0; i < sipX.rows(); ++i) {
+                for (int j = 0; j < sipX.cols(); ++j) {
+                    if (!onlyHigherOrder || (i+j > 1 && i+j < sipX.rows())) {
+                        f += sipX(i,j)*uPow[i]*vPow[j];
+                    }
+                }
+            }
+
+            double g = 0;
+            for (int i = 0; i < sipY.rows(); ++i) {
+                for (int j = 0; j < sipY.cols(); ++j) {
+                    if (!onlyHigherOrder || (i+j > 1 && i+j < sipY.rows())) {
+                        g += sipY(i,j)*uPow[i]*vPow[j];
+                    }
+                }
+            }
+
+            pixTmp[2*k] += f;
+            pixTmp[2*k + 1] += g;
+        }
+    }
+}
+
+/*
+ * Worker routine for the array version of pixelToSky: undistort all the positions, then
+ * pass them to wcslib together
+ */
+void TanWcs::pixelToSkyArrayImpl(int nPoints, double pixTmp[], double skyTmp[]) const {
+    if (_hasDistortion) {
+        addSipCorrections(_sipA, _sipB, true, _wcsInfo->crpix, nPoints, pixTmp);
+    }
+    Wcs::pixelToSkyArrayImpl(nPoints, pixTmp, skyTmp);
+}
+
+/*
+ * Worker routine for the array version of skyToPixel: pass all the positions to wcslib together,
+ * then distort them
+ */
+void TanWcs::skyToPixelArrayImpl(int nPoints, double skyTmp[], double pixTmp[]) const {
+    Wcs::skyToPixelArrayImpl(nPoints, skyTmp, pixTmp);
+    if (_hasDistortion) {
+        addSipCorrections(_sipAp, _sipBp, false, _wcsInfo->crpix, nPoints, pixTmp);
+    }
+}
+
 lsst::daf::base::PropertyList::Ptr TanWcs::getFitsMetadata() const {
     return lsst::afw::formatters::TanWcsFormatter::generatePropertySet(*this);       
 }
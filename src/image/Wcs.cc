@@ -26,8 +26,11 @@
 #include <sstream>
 #include <cmath>
 #include <cstring>
+#include <limits>
+#include <vector>
 
 #include "boost/format.hpp"
+#include "boost/thread/mutex.hpp"
 
 #include "wcslib/wcs.h"
 #include "wcslib/wcsfix.h"
@@ -60,6 +63,11 @@ typedef lsst::afw::coord::Coord::Ptr CoordPtr;
 //The amount of space allocated to strings in wcslib
 const int STRLEN = 72;
 
+namespace {
+    // wcspih's Flex-generated parser isn't reentrant, so only one thread may be in it at a time
+    boost::mutex wcspihMutex;
+}
+
 //Set internal params for wcslib
 void lsst::afw::image::Wcs::_setWcslibParams()
 {
@@ -233,7 +241,11 @@ void Wcs::initWcsLibFromFits(lsst::daf::base::PropertySet::Ptr const fitsMetadat
 
     //printf("wcspih string:\n%s\n", hdrString);
 
-    int pihStatus = wcspih(hdrString, nCards, _relax, _wcshdrCtrl, &_nReject, &_nWcsInfo, &_wcsInfo);
+    int pihStatus = 0;
+    {
+        boost::lock_guard<boost::mutex> lock(wcspihMutex);
+        pihStatus = wcspih(hdrString, nCards, _relax, _wcshdrCtrl, &_nReject, &_nWcsInfo, &_wcsInfo);
+    }
     delete[] hdrString;
 
     if (pihStatus != 0) {
@@ -803,6 +815,143 @@ void Wcs::pixelToSky(double pixel1, double pixel2, afwGeom::Angle& sky1, afwGeom
     sky2 = skyTmp[1];
 }
 
+namespace {
+    /*
+     * Check that the input and output arrays of the array versions of pixelToSky and skyToPixel
+     * are compatible
+     */
+    void checkPositionArrays(lsst::ndarray::Array<double const, 2, 1> const & inArray,
+                             lsst::ndarray::Array<double, 2, 1> const & outArray) {
+        if (inArray.getSize<1>() != 2 || outArray.getSize<1>() != 2) {
+            throw LSST_EXCEPT(except::LengthErrorException,
+                              (boost::format("Position arrays must have 2 columns, not %d and %d") %
+                               inArray.getSize<1>() % outArray.getSize<1>()).str());
+        }
+        if (inArray.getSize<0>() != outArray.getSize<0>()) {
+            throw LSST_EXCEPT(except::LengthErrorException,
+                              (boost::format("Position arrays have different numbers of rows: %d != %d") %
+                               inArray.getSize<0>() % outArray.getSize<0>()).str());
+        }
+    }
+}
+
+///\brief Convert many pixel positions to sky coordinates (e.g ra/dec) at once
+///
+///Each row of \c pixels is one (x, y) position; the corresponding row of \c sky is set to
+///(longitude, latitude) in degrees (e.g. ra, dec), even if the WCS axes are swapped. All positions are
+///passed to wcslib in a single call (and, for a TanWcs, corrected for distortion together), so this is
+///much faster than transforming one position at a time. Positions wcslib rejects as invalid are set
+///to NaN rather than raising an exception.
+///
+///\throw lsst::pex::exceptions::LengthErrorException if the arrays do not both have shape (N, 2)
+void Wcs::pixelToSky(lsst::ndarray::Array<double const, 2, 1> const & pixels, ///< pixel positions
+                     lsst::ndarray::Array<double, 2, 1> const & sky ///< sky positions (deg) (output)
+                    ) const {
+    if(! isInitialized()) {
+        throw(LSST_EXCEPT(lsst::pex::exceptions::RuntimeErrorException, "Wcs structure not initialised"));
+    }
+    checkPositionArrays(pixels, sky);
+    int const nPoints = pixels.getSize<0>();
+    if (nPoints == 0) {
+        return;
+    }
+
+    // wcslib assumes 1-indexed coordinates
+    std::vector<double> pixTmp(2*nPoints);
+    std::vector<double> skyTmp(2*nPoints);
+    for (int i = 0; i < nPoints; ++i) {
+        pixTmp[2*i]     = pixels[i][0] - lsst::afw::image::PixelZeroPos + lsstToFitsPixels;
+        pixTmp[2*i + 1] = pixels[i][1] - lsst::afw::image::PixelZeroPos + lsstToFitsPixels;
+    }
+    pixelToSkyArrayImpl(nPoints, &pixTmp[0], &skyTmp[0]);
+    for (int i = 0; i < nPoints; ++i) {
+        sky[i][0] = skyTmp[2*i + _wcsInfo->lng];
+        sky[i][1] = skyTmp[2*i + _wcsInfo->lat];
+    }
+}
+
+///\brief Convert many sky positions (e.g ra/dec) to pixel positions at once
+///
+///Each row of \c sky is one (longitude, latitude) position in degrees, as for skyToPixel(Angle, Angle);
+///the corresponding row of \c pixels is set to (x, y). All positions are passed to wcslib in a single
+///call (and, for a TanWcs, distorted together), so this is much faster than transforming one position
+///at a time. Positions wcslib rejects as invalid are set to NaN rather than raising an exception.
+///
+///\throw lsst::pex::exceptions::LengthErrorException if the arrays do not both have shape (N, 2)
+void Wcs::skyToPixel(lsst::ndarray::Array<double const, 2, 1> const & sky, ///< sky positions (deg)
+                     lsst::ndarray::Array<double, 2, 1> const & pixels ///< pixel positions (output)
+                    ) const {
+    if (!isInitialized()) {
+        throw(LSST_EXCEPT(lsst::pex::exceptions::RuntimeErrorException, "Wcs structure not initialised"));
+    }
+    checkPositionArrays(sky, pixels);
+    int const nPoints = sky.getSize<0>();
+    if (nPoints == 0) {
+        return;
+    }
+
+    std::vector<double> skyTmp(2*nPoints);
+    std::vector<double> pixTmp(2*nPoints);
+    for (int i = 0; i < nPoints; ++i) {
+        skyTmp[2*i + _wcsInfo->lng] = sky[i][0];
+        skyTmp[2*i + _wcsInfo->lat] = sky[i][1];
+    }
+    skyToPixelArrayImpl(nPoints, &skyTmp[0], &pixTmp[0]);
+    // wcslib assumes 1-indexed coords
+    for (int i = 0; i < nPoints; ++i) {
+        pixels[i][0] = pixTmp[2*i]     + lsst::afw::image::PixelZeroPos + fitsToLsstPixels;
+        pixels[i][1] = pixTmp[2*i + 1] + lsst::afw::image::PixelZeroPos + fitsToLsstPixels;
+    }
+}
+
+/*
+ * Worker routine for the array version of pixelToSky
+ */
+void Wcs::pixelToSkyArrayImpl(int nPoints, double pixTmp[], double skyTmp[]) const {
+    std::vector<double> imgcrd(2*nPoints);
+    std::vector<double> phi(nPoints);
+    std::vector<double> theta(nPoints);
+    std::vector<int> stat(nPoints);
+
+    int const status = wcsp2s(_wcsInfo, nPoints, 2, pixTmp, &imgcrd[0], &phi[0], &theta[0], skyTmp,
+                              &stat[0]);
+    if (status == 8) {                  // one or more of the pixel coordinates were invalid
+        for (int i = 0; i < nPoints; ++i) {
+            if (stat[i]) {
+                skyTmp[2*i] = skyTmp[2*i + 1] = std::numeric_limits<double>::quiet_NaN();
+            }
+        }
+    } else if (status > 0) {
+        throw LSST_EXCEPT(except::RuntimeErrorException,
+                          (boost::format("Error: wcslib returned a status code of %d. %s") %
+                           status % wcs_errmsg[status]).str());
+    }
+}
+
+/*
+ * Worker routine for the array version of skyToPixel
+ */
+void Wcs::skyToPixelArrayImpl(int nPoints, double skyTmp[], double pixTmp[]) const {
+    std::vector<double> imgcrd(2*nPoints);
+    std::vector<double> phi(nPoints);
+    std::vector<double> theta(nPoints);
+    std::vector<int> stat(nPoints);
+
+    int const status = wcss2p(_wcsInfo, nPoints, 2, skyTmp, &phi[0], &theta[0], &imgcrd[0], pixTmp,
+                              &stat[0]);
+    if (status == 9) {                  // one or more of the world coordinates were invalid
+        for (int i = 0; i < nPoints; ++i) {
+            if (stat[i]) {
+                pixTmp[2*i] = pixTmp[2*i + 1] = std::numeric_limits<double>::quiet_NaN();
+            }
+        }
+    } else if (status > 0) {
+        throw LSST_EXCEPT(except::RuntimeErrorException,
+                          (boost::format("Error: wcslib returned a status code of %d. %s") %
+                           status % wcs_errmsg[status]).str());
+    }
+}
+
 ///\brief Given a sky position, use the values stored in ctype and radesys to return the correct
 ///sub-class of Coord
 CoordPtr Wcs::makeCorrectCoord(lsst::afw::geom::Angle sky0, lsst::afw::geom::Angle sky1) const {
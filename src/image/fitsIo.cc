@@ -27,15 +27,33 @@
 /// \author Robert Lupton (rhl@astro.princeton.edu)\n
 ///         Princeton University
 /// \date   September 2008
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
 #include <cstring>
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "boost/cstdint.hpp"
+#include "boost/filesystem/operations.hpp"
+#include "boost/filesystem/path.hpp"
 #include "boost/format.hpp"
+#include "boost/noncopyable.hpp"
 #include "boost/regex.hpp"
 
 #include "lsst/base.h"
 #include "lsst/utils/ieee.h"
 #include "lsst/pex/exceptions.h"
 
+#include "lsst/afw/image/Utils.h"
 #include "lsst/afw/image/fits/fits_io_private.h"
+#include "lsst/afw/math/detail/Parallel.h"
 
 
 namespace lsst {
@@ -411,6 +429,16 @@ void addKV(lsst::daf::base::PropertySet::Ptr metadata, std::string const& key, s
     if (metadata.get() == NULL) {
         return;
     }
+    //
+    // The header of a tile-compressed image is that of the binary table holding the compressed tiles;
+    // strip the keys describing the table and the compression too
+    //
+    static boost::regex const compressionKey_RE(
+        "^(Z(IMAGE|SIMPLE|TENSION|EXTEND|BLOCKED|PCOUNT|GCOUNT|HECKSUM|DATASUM|BITPIX|NAXIS[0-9]*|"
+        "TILE[0-9]+|CMPTYPE|NAME[0-9]+|VAL[0-9]+|QUANTIZ|DITHER0|BLANK|SCALE|ZERO|BSCALE|BZERO)|"
+        "TFIELDS|THEAP|T(TYPE|FORM|UNIT|ZERO|SCAL|NULL|DIM)[0-9]+)$");
+    int status = 0;
+    bool const isCompressed = strip && fits_is_compressed_image(fd, &status);
 
     for (int i=1; i<=getNumKeys(fd); i++) {
         std::string keyName;
@@ -423,6 +451,10 @@ void addKV(lsst::daf::base::PropertySet::Ptr metadata, std::string const& key, s
                       keyName == "GCOUNT" || keyName == "PCOUNT" || keyName == "XTENSION" ||
                       keyName == "BSCALE" || keyName == "BZERO")) {
             ;
+        } else if (isCompressed &&
+                   (boost::regex_match(keyName, compressionKey_RE) ||
+                    (keyName == "EXTNAME" && val.find("COMPRESSED_IMAGE") != std::string::npos))) {
+            ;
         } else {
             addKV(metadata, keyName, val, comment);
         }
@@ -433,6 +465,419 @@ void addKV(lsst::daf::base::PropertySet::Ptr metadata, std::string const& key, s
 
 /************************************************************************************************************/
 
+namespace detail {
+
+namespace {
+    /*
+     * Byte-swap n values of type T in place, then flip the bits in xorMask.  The shifts are
+     * recognised by the compiler as byte swaps, and the loop has no dependencies so it vectorises.
+     */
+    inline boost::uint8_t swapBytes(boost::uint8_t v) {
+        return v;
+    }
+    inline boost::uint16_t swapBytes(boost::uint16_t v) {
+        return static_cast<boost::uint16_t>((v >> 8) | (v << 8));
+    }
+    inline boost::uint32_t swapBytes(boost::uint32_t v) {
+        return (v >> 24) | ((v >> 8) & 0x0000ff00u) | ((v << 8) & 0x00ff0000u) | (v << 24);
+    }
+    inline boost::uint64_t swapBytes(boost::uint64_t v) {
+        return (static_cast<boost::uint64_t>(swapBytes(static_cast<boost::uint32_t>(v))) << 32) |
+            swapBytes(static_cast<boost::uint32_t>(v >> 32));
+    }
+
+    template <typename T>
+    void swapInPlace(void *data, long long n, unsigned long long xorMask) {
+        T *ptr = reinterpret_cast<T *>(data);
+        T const mask = static_cast<T>(xorMask);
+        for (long long i = 0; i < n; ++i) {
+            ptr[i] = swapBytes(ptr[i]) ^ mask;
+        }
+    }
+}
+
+/**
+ * Convert n pixels of pixelSize bytes from FITS (big-endian) to native byte order in place, then flip the
+ * bits in xorMask (which applies a BZERO of 2^15 or 2^31 to unsigned data stored as signed)
+ */
+void fits_convert_in_place(void *data, long long n, int pixelSize, unsigned long long xorMask) {
+    switch (pixelSize) {
+      case 2:
+        swapInPlace<boost::uint16_t>(data, n, xorMask);
+        break;
+      case 4:
+        swapInPlace<boost::uint32_t>(data, n, xorMask);
+        break;
+      case 8:
+        swapInPlace<boost::uint64_t>(data, n, xorMask);
+        break;
+      default:
+        throw LSST_EXCEPT(lsst::pex::exceptions::InvalidParameterException,
+                          (boost::format("Unsupported pixel size %d") % pixelSize).str());
+    }
+}
+
+/**
+ * Is there any point in mapping FITS files?  Only if the pixels need byte swapping, as otherwise they'd
+ * never be copied out of the file's pages, and would vanish if the file were truncated
+ */
+bool fits_mapping::isNeeded() {
+    boost::uint16_t const one = 1;
+    return *reinterpret_cast<unsigned char const *>(&one) == 1;
+}
+
+/**
+ * Map bytes [begin, end) of a FITS file copy-on-write, returning an empty pointer if it can't be mapped
+ * (e.g. it doesn't exist, is too short, or isn't a FITS file but something cfitsio reads via a filter)
+ */
+fits_mapping::Ptr fits_mapping::map(std::string const& filename, long long begin, long long end) {
+    int const fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return Ptr();
+    }
+    struct stat st;
+    char simple[6];
+    if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size < end ||
+        ::pread(fd, simple, sizeof(simple), 0) != static_cast<ssize_t>(sizeof(simple)) ||
+        std::strncmp(simple, "SIMPLE", sizeof(simple)) != 0) {
+        ::close(fd);
+        return Ptr();
+    }
+
+    long long const pageSize = ::sysconf(_SC_PAGESIZE);
+    long long const mapBegin = begin - begin%pageSize;
+    std::size_t const len = end - mapBegin;
+    void *addr = ::mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, mapBegin);
+    ::close(fd);                        // the mapping keeps its own reference to the file
+    if (addr == MAP_FAILED) {
+        return Ptr();
+    }
+    (void)::posix_madvise(addr, len, POSIX_MADV_WILLNEED);
+
+    return Ptr(new fits_mapping(addr, len, static_cast<char *>(addr) + (begin - mapBegin)));
+}
+
+fits_mapping::~fits_mapping() {
+    (void)::munmap(_addr, _len);
+}
+
+/************************************************************************************************************/
+
+namespace {
+    int const DefaultTileSize = 128;    // tiles are square, so reading a cutout decompresses little else
+
+    char const *compressionKeys[] = {   // metadata keys that control compression; not written to headers
+        "ZCMPTYPE", "ZQUANTIZ", "ZQLEVEL", "ZTILE1", "ZTILE2"
+    };
+}
+
+/**
+ * Does metadata request that images be tile compressed (see fits_set_compression)?
+ */
+bool fits_compression_requested(lsst::daf::base::PropertySet const *metadata) {
+    return metadata && metadata->exists("ZCMPTYPE") && metadata->getAsString("ZCMPTYPE") != "NONE";
+}
+
+/**
+ * Set up cfitsio to tile compress the next image HDU created in fd, if metadata requests it.  The
+ * metadata keys used (which are never written to the header) are:
+ *
+ *  - ZCMPTYPE  The algorithm: NONE (the default), RICE_1, GZIP_1, GZIP_2, PLIO_1 or HCOMPRESS_1
+ *  - ZTILE1, ZTILE2  The dimensions of the tiles; 0 means the whole width (height) of the image
+ *                    (default: 128x128)
+ *  - ZQUANTIZ  Floating point images only: how pixels are quantized to integers before compression;
+ *              SUBTRACTIVE_DITHER_1 (the default), SUBTRACTIVE_DITHER_2 (which leaves zeros exact),
+ *              NO_DITHER, or NONE to compress the pixels losslessly (with GZIP_1 or GZIP_2 only)
+ *  - ZQLEVEL   Floating point images only: the quantization step is the tile's noise divided by
+ *              ZQLEVEL, or -ZQLEVEL if it's negative (default: cfitsio's, 4)
+ *
+ * The keywords are those of the FITS tiled image convention, which cfitsio writes to the compressed
+ * HDU's header.  Integer images (and so Masks) are compressed losslessly, typically using RICE_1,
+ * GZIP_1 or (for Masks) PLIO_1; RICE_1 with the default dithered quantization is the usual choice for
+ * images and variances.  Compressed HDUs are written as extensions, so if the file is empty an empty
+ * primary HDU is written first; they may be read back as usual, and reading part of one only
+ * decompresses the tiles that overlap it.
+ *
+ * Return true if the HDU will be compressed, in which case call fits_unset_compression once its pixels
+ * have been written (or use a fits_compression_guard, which does so even if writing them fails).  If we
+ * throw, compression is left turned off.
+ *
+ * @throw lsst::pex::exceptions::InvalidParameterException if ZCMPTYPE or ZQUANTIZ has an unknown value
+ */
+bool fits_set_compression(cfitsio::fitsfile *fd,                     ///< file being written
+                          lsst::daf::base::PropertySet const *metadata, ///< metadata, or NULL
+                          int bitpix,                                ///< BITPIX of the image
+                          long const nAxes[2]                        ///< dimensions of the image
+                         ) {
+    if (!fits_compression_requested(metadata) || nAxes[0] == 0 || nAxes[1] == 0) {
+        return false;
+    }
+
+    std::string const algorithm = metadata->getAsString("ZCMPTYPE");
+    int type = 0;                       // cfitsio's compression type
+    if (algorithm == "RICE_1") {
+        type = RICE_1;
+    } else if (algorithm == "GZIP_1") {
+        type = GZIP_1;
+    } else if (algorithm == "GZIP_2") {
+        type = GZIP_2;
+    } else if (algorithm == "PLIO_1") {
+        type = PLIO_1;
+    } else if (algorithm == "HCOMPRESS_1") {
+        type = HCOMPRESS_1;
+    } else {
+        throw LSST_EXCEPT(lsst::pex::exceptions::InvalidParameterException,
+                          "Unknown compression algorithm ZCMPTYPE = " + algorithm +
+                          "; expected NONE, RICE_1, GZIP_1, GZIP_2, PLIO_1 or HCOMPRESS_1");
+    }
+
+    long tileDims[2] = {DefaultTileSize, DefaultTileSize};
+    char const *tileKeys[2] = {"ZTILE1", "ZTILE2"};
+    for (int i = 0; i != 2; ++i) {
+        if (metadata->exists(tileKeys[i])) {
+            tileDims[i] = metadata->getAsInt(tileKeys[i]);
+        }
+        if (tileDims[i] <= 0 || tileDims[i] > nAxes[i]) {
+            tileDims[i] = nAxes[i];
+        }
+    }
+
+    int status = 0;
+    int nHdu = 0;
+    if (fits_get_num_hdus(fd, &nHdu, &status) != 0) {
+        throw LSST_EXCEPT(FitsException, cfitsio::err_msg(fd, status));
+    }
+    if (nHdu == 0) {                    // compressed images can't be written to the primary HDU
+        long naxes[2] = {0, 0};
+        if (fits_create_img(fd, BYTE_IMG, 0, naxes, &status) != 0) {
+            throw LSST_EXCEPT(FitsException, cfitsio::err_msg(fd, status));
+        }
+    }
+
+    try {
+        if (fits_set_compression_type(fd, type, &status) != 0 ||
+            fits_set_tile_dim(fd, 2, tileDims, &status) != 0) {
+            throw LSST_EXCEPT(FitsException, cfitsio::err_msg(fd, status));
+        }
+
+        if (bitpix < 0) {
+            std::string const quantize =
+                metadata->exists("ZQUANTIZ") ? metadata->getAsString("ZQUANTIZ") : "SUBTRACTIVE_DITHER_1";
+            int method = SUBTRACTIVE_DITHER_1;
+            if (quantize == "NONE") {
+                method = 0;
+            } else if (quantize == "SUBTRACTIVE_DITHER_1") {
+                method = SUBTRACTIVE_DITHER_1;
+            } else if (quantize == "SUBTRACTIVE_DITHER_2") {
+                method = SUBTRACTIVE_DITHER_2;
+            } else if (quantize == "NO_DITHER") {
+                method = NO_DITHER;
+            } else {
+                throw LSST_EXCEPT(lsst::pex::exceptions::InvalidParameterException,
+                                  "Unknown quantization method ZQUANTIZ = " + quantize + "; expected "
+                                  "SUBTRACTIVE_DITHER_1, SUBTRACTIVE_DITHER_2, NO_DITHER or NONE");
+            }
+
+            if (method == 0) {              // a quantize level of 0 means "don't quantize"
+                if (fits_set_quantize_level(fd, 0.0, &status) != 0) {
+                    throw LSST_EXCEPT(FitsException, cfitsio::err_msg(fd, status));
+                }
+            } else {
+                if (fits_set_quantize_method(fd, method, &status) != 0) {
+                    throw LSST_EXCEPT(FitsException, cfitsio::err_msg(fd, status));
+                }
+                if (metadata->exists("ZQLEVEL") &&
+                    fits_set_quantize_level(fd, metadata->getAsDouble("ZQLEVEL"), &status) != 0) {
+                    throw LSST_EXCEPT(FitsException, cfitsio::err_msg(fd, status));
+                }
+            }
+        }
+    } catch (...) {
+        int status = 0;
+        (void)fits_set_compression_type(fd, NOCOMPRESS, &status);
+        throw;
+    }
+
+    return true;
+}
+
+/**
+ * Stop compressing image HDUs created in fd, and restore cfitsio's default quantization
+ */
+void fits_unset_compression(cfitsio::fitsfile *fd) {
+    int status = 0;
+    if (fits_set_compression_type(fd, NOCOMPRESS, &status) != 0 ||
+        fits_set_quantize_method(fd, SUBTRACTIVE_DITHER_1, &status) != 0 ||
+        fits_set_quantize_level(fd, 4.0, &status) != 0) {
+        throw LSST_EXCEPT(FitsException, cfitsio::err_msg(fd, status));
+    }
+}
+
+/**
+ * Is name one of the metadata keys that control compression (see fits_set_compression)?
+ */
+bool fits_is_compression_key(std::string const& name) {
+    for (std::size_t i = 0; i != sizeof(compressionKeys)/sizeof(compressionKeys[0]); ++i) {
+        if (name == compressionKeys[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Copy the keys that control compression (see fits_set_compression) from one PropertySet to another,
+ * e.g. from a MaskedImage's metadata to that of its Mask and Variance HDUs
+ */
+void fits_copy_compression_keys(boost::shared_ptr<lsst::daf::base::PropertySet const> from,
+                                lsst::daf::base::PropertySet::Ptr to) {
+    if (!from || !to) {
+        return;
+    }
+    for (std::size_t i = 0; i != sizeof(compressionKeys)/sizeof(compressionKeys[0]); ++i) {
+        if (from->exists(compressionKeys[i])) {
+            to->copy(compressionKeys[i], from, compressionKeys[i]);
+        }
+    }
+}
+
+/************************************************************************************************************/
+
+namespace {
+    std::size_t const PixelWriterBufferSize = 1 << 20; // bytes converted per write
+
+    /*
+     * Copy n values of type T, flipping the bits in xorMask and then byte swapping them if needed
+     */
+    template <typename T>
+    void copyToFits(void *out, void const *in, std::size_t n, unsigned long long xorMask, bool swap) {
+        T *outPtr = reinterpret_cast<T *>(out);
+        T const *inPtr = reinterpret_cast<T const *>(in);
+        T const mask = static_cast<T>(xorMask);
+        if (swap) {
+            for (std::size_t i = 0; i < n; ++i) {
+                outPtr[i] = swapBytes(static_cast<T>(inPtr[i] ^ mask));
+            }
+        } else {
+            for (std::size_t i = 0; i < n; ++i) {
+                outPtr[i] = inPtr[i] ^ mask;
+            }
+        }
+    }
+}
+
+/**
+ * Prepare to write the pixels of an image HDU whose data starts at offset in an existing file
+ *
+ * @throw lsst::pex::exceptions::IoErrorException if the file can't be opened
+ * @throw lsst::pex::exceptions::InvalidParameterException if bitpix isn't a supported BITPIX
+ */
+fits_pixel_writer::fits_pixel_writer(std::string const& filename, ///< file to write
+                                     long long offset, ///< offset of the HDU's data
+                                     int bitpix        ///< cfitsio's BITPIX for the pixels, e.g. USHORT_IMG
+                                    ) :
+    _fd(-1), _offset(offset), _pixelSize(0), _xorMask(0), _buffer(PixelWriterBufferSize), _nBuffered(0) {
+    switch (bitpix) {
+      case BYTE_IMG:
+        _pixelSize = 1;
+        break;
+      case SHORT_IMG:
+        _pixelSize = 2;
+        break;
+      case USHORT_IMG:                  // stored as signed, with BZERO = 2^15
+        _pixelSize = 2;
+        _xorMask = 0x8000;
+        break;
+      case LONG_IMG:
+      case FLOAT_IMG:
+        _pixelSize = 4;
+        break;
+      case ULONG_IMG:                   // stored as signed, with BZERO = 2^31
+        _pixelSize = 4;
+        _xorMask = 0x80000000;
+        break;
+      case DOUBLE_IMG:
+        _pixelSize = 8;
+        break;
+      default:
+        throw LSST_EXCEPT(lsst::pex::exceptions::InvalidParameterException,
+                          (boost::format("Unsupported value BITPIX==%d") % bitpix).str());
+    }
+
+    _fd = ::open(filename.c_str(), O_WRONLY);
+    if (_fd < 0) {
+        throw LSST_EXCEPT(lsst::pex::exceptions::IoErrorException,
+                          (boost::format("Failed to open %s: %s") % filename % std::strerror(errno)).str());
+    }
+}
+
+fits_pixel_writer::~fits_pixel_writer() {
+    (void)::close(_fd);
+}
+
+/**
+ * Write the next n pixels of the image
+ *
+ * @throw lsst::pex::exceptions::IoErrorException if the pixels can't be written
+ */
+void fits_pixel_writer::write(void const *data, ///< the pixels, in native byte order
+                              long long n       ///< number of pixels
+                             ) {
+    bool const swap = fits_mapping::isNeeded();
+    char const *in = static_cast<char const *>(data);
+    std::size_t nBytes = static_cast<std::size_t>(n)*_pixelSize;
+    while (nBytes > 0) {
+        std::size_t const nCopy = std::min(nBytes, _buffer.size() - _nBuffered);
+        void *out = &_buffer[_nBuffered];
+        switch (_pixelSize) {
+          case 1:
+            copyToFits<boost::uint8_t>(out, in, nCopy, _xorMask, false);
+            break;
+          case 2:
+            copyToFits<boost::uint16_t>(out, in, nCopy/2, _xorMask, swap);
+            break;
+          case 4:
+            copyToFits<boost::uint32_t>(out, in, nCopy/4, _xorMask, swap);
+            break;
+          case 8:
+            copyToFits<boost::uint64_t>(out, in, nCopy/8, _xorMask, swap);
+            break;
+        }
+        in += nCopy;
+        nBytes -= nCopy;
+        _nBuffered += nCopy;
+        if (_nBuffered == _buffer.size()) {
+            flush();
+        }
+    }
+}
+
+/**
+ * Write any buffered pixels to the file
+ *
+ * @throw lsst::pex::exceptions::IoErrorException if the pixels can't be written
+ */
+void fits_pixel_writer::flush() {
+    std::size_t nWritten = 0;
+    while (nWritten < _nBuffered) {
+        ssize_t const n = ::pwrite(_fd, &_buffer[nWritten], _nBuffered - nWritten, _offset + nWritten);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw LSST_EXCEPT(lsst::pex::exceptions::IoErrorException,
+                              (boost::format("Failed to write pixels: %s") % std::strerror(errno)).str());
+        }
+        nWritten += n;
+    }
+    _offset += _nBuffered;
+    _nBuffered = 0;
+}
+
+} // namespace detail
+
+/************************************************************************************************************/
+
 /**
  * \brief Return the metadata from a fits file
  */
@@ -463,5 +908,331 @@ lsst::daf::base::PropertySet::Ptr readMetadata(char **ramFile,				///< RAM buffe
 
     return metadata;
 }
-    
+
+/************************************************************************************************************/
+/*
+ * Scan FITS headers for the values of a few keywords, reading the 2880-byte header blocks ourselves
+ * rather than through cfitsio.  This is much cheaper than readMetadata (which converts every card to a
+ * PropertySet value) and, as each file has its own descriptor and no global state is touched, safe to
+ * do on many threads at once.
+ */
+namespace {
+    int const FITS_BLOCK_SIZE = 2880;   // size of a FITS header or data block
+    int const FITS_CARD_SIZE = 80;      // size of a header card
+    int const FITS_KEY_SIZE = 8;        // maximum length of a (non-HIERARCH) keyword
+
+    typedef std::set<std::string> KeySet;
+
+    /// Strip leading and trailing blanks from [begin, end)
+    std::string trim(char const *begin, char const *end) {
+        while (begin != end && *begin == ' ') {
+            ++begin;
+        }
+        while (end != begin && end[-1] == ' ') {
+            --end;
+        }
+        return std::string(begin, end);
+    }
+
+    /*
+     * Return the value in a card's value field [begin, end): a string with its quotes removed, its
+     * doubled quotes undoubled, and its trailing blanks stripped; or anything else up to the comment
+     */
+    std::string parseValue(char const *begin, char const *end) {
+        while (begin != end && *begin == ' ') {
+            ++begin;
+        }
+        if (begin == end || *begin != '\'') {
+            return trim(begin, std::find(begin, end, '/'));
+        }
+
+        std::string value;
+        for (char const *ptr = begin + 1; ptr != end; ++ptr) {
+            if (*ptr == '\'') {
+                if (ptr + 1 == end || ptr[1] != '\'') {
+                    break;
+                }
+                ++ptr;
+            }
+            value += *ptr;
+        }
+        return value.erase(value.find_last_not_of(' ') + 1);
+    }
+
+    /// Return an integer-valued card's value
+    boost::int64_t parseInt(char const *card) {
+        return std::strtol(parseValue(card + FITS_KEY_SIZE + 2, card + FITS_CARD_SIZE).c_str(), NULL, 10);
+    }
+
+    /*
+     * A FITS file opened for scanning its headers
+     */
+    class HeaderScanner : private boost::noncopyable {
+    public:
+        explicit HeaderScanner(std::string const& fileName) : _fileName(fileName), _fd(-1), _size(0) {
+            _fd = ::open(fileName.c_str(), O_RDONLY);
+            struct stat st;
+            if (_fd < 0 || ::fstat(_fd, &st) != 0) {
+                std::string const error = std::strerror(errno);
+                if (_fd >= 0) {
+                    ::close(_fd);
+                }
+                throw LSST_EXCEPT(lsst::afw::image::FitsException,
+                                  (boost::format("Opening %s: %s") % fileName % error).str());
+            }
+            _size = st.st_size;
+        }
+        ~HeaderScanner() { ::close(_fd); }
+
+        /// Does the file extend beyond offset?
+        bool hasData(off_t offset) const { return offset < _size; }
+
+        off_t scanHdu(off_t offset, KeySet const& keys, lsst::afw::image::HeaderValues *values,
+                      int *nAxis);
+
+    private:
+        std::string _fileName;
+        int _fd;
+        off_t _size;
+    };
+
+    /*
+     * Scan the header of the HDU starting at offset, setting the values of those of keys that are present
+     * (if values is non-NULL), and nAxis to the value of NAXIS
+     *
+     * Returns the offset of the next HDU.  A string continued onto CONTINUE cards is returned in full;
+     * if a key appears more than once the last value wins.
+     */
+    off_t HeaderScanner::scanHdu(off_t offset, KeySet const& keys, lsst::afw::image::HeaderValues *values,
+                                 int *nAxis) {
+        boost::int64_t bitpix = 0, pcount = 0, gcount = 1, nPixel = 1;
+        *nAxis = 0;
+        std::string continuing;         // the key whose value is a string continued onto the next card
+
+        char block[FITS_BLOCK_SIZE];
+        for (bool first = true, done = false; !done; first = false) {
+            ssize_t nRead = 0;
+            while (nRead < FITS_BLOCK_SIZE) {
+                ssize_t const n = ::pread(_fd, block + nRead, FITS_BLOCK_SIZE - nRead, offset + nRead);
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (n < 0) {
+                    throw LSST_EXCEPT(lsst::afw::image::FitsException,
+                                      (boost::format("Reading header of %s: %s") % _fileName %
+                                       std::strerror(errno)).str());
+                } else if (n == 0) {
+                    throw LSST_EXCEPT(lsst::afw::image::FitsException,
+                                      (boost::format("%s is truncated, or is not a FITS file") %
+                                       _fileName).str());
+                }
+                nRead += n;
+            }
+            offset += FITS_BLOCK_SIZE;
+
+            if (first && std::strncmp(block, (offset == FITS_BLOCK_SIZE ? "SIMPLE  " : "XTENSION"),
+                                      FITS_KEY_SIZE) != 0) {
+                throw LSST_EXCEPT(lsst::afw::image::FitsException,
+                                  (boost::format("%s is not a FITS file, or is corrupt at byte %d") %
+                                   _fileName % (offset - FITS_BLOCK_SIZE)).str());
+            }
+
+            for (char const *card = block; card != block + FITS_BLOCK_SIZE; card += FITS_CARD_SIZE) {
+                std::string const key = trim(card, card + FITS_KEY_SIZE);
+                if (key == "END") {
+                    done = true;
+                    break;
+                }
+                bool const hasValue = (card[FITS_KEY_SIZE] == '=' && card[FITS_KEY_SIZE + 1] == ' ');
+
+                if (key == "CONTINUE" && !continuing.empty()) {
+                    std::string &value = (*values)[continuing];
+                    value.erase(value.size() - 1); // the '&'
+                    value += parseValue(card + FITS_KEY_SIZE, card + FITS_CARD_SIZE);
+                    if (value.empty() || value[value.size() - 1] != '&') {
+                        continuing.clear();
+                    }
+                    continue;
+                }
+                continuing.clear();
+
+                if (!hasValue) {
+                    continue;
+                } else if (key == "BITPIX") {
+                    bitpix = parseInt(card);
+                } else if (key == "NAXIS") {
+                    *nAxis = parseInt(card);
+                } else if (key.compare(0, 5, "NAXIS") == 0) {
+                    nPixel *= parseInt(card);
+                } else if (key == "PCOUNT") {
+                    pcount = parseInt(card);
+                } else if (key == "GCOUNT") {
+                    gcount = parseInt(card);
+                }
+
+                if (values && keys.find(key) != keys.end()) {
+                    char const *valueField = card + FITS_KEY_SIZE + 2;
+                    char const *cardEnd = card + FITS_CARD_SIZE;
+                    std::string &value = (*values)[key] = parseValue(valueField, cardEnd);
+                    char const *firstChar = std::find_if(valueField, cardEnd,
+                                                         std::bind2nd(std::not_equal_to<char>(), ' '));
+                    bool const isString = (firstChar != cardEnd && *firstChar == '\'');
+                    if (isString && !value.empty() && value[value.size() - 1] == '&') {
+                        continuing = key;
+                    }
+                }
+            }
+        }
+        /*
+         * Skip the data
+         */
+        boost::int64_t const nData = (*nAxis == 0) ? 0 :
+            ((bitpix < 0 ? -bitpix : bitpix)/8)*gcount*(pcount + nPixel);
+        return offset + FITS_BLOCK_SIZE*((nData + FITS_BLOCK_SIZE - 1)/FITS_BLOCK_SIZE);
+    }
+
+    /// Scan one file
+    lsst::afw::image::HeaderValues scanFile(std::string const& fileName, KeySet const& keys, int hdu) {
+        HeaderScanner scanner(fileName);
+        lsst::afw::image::HeaderValues values;
+        int nAxis = 0;
+        off_t offset = 0;
+        /*
+         * Choose the HDU as readMetadata does:  hdu 0 is the first HDU, unless that's empty and there's
+         * another after it
+         */
+        if (hdu == 0) {
+            off_t const next = scanner.scanHdu(offset, keys, NULL, &nAxis);
+            if (nAxis == 0 && scanner.hasData(next)) {
+                offset = next;
+            }
+        } else {
+            for (int i = 1; i < hdu; ++i) {
+                offset = scanner.scanHdu(offset, keys, NULL, &nAxis);
+                if (!scanner.hasData(offset)) {
+                    throw LSST_EXCEPT(lsst::afw::image::FitsException,
+                                      (boost::format("%s has only %d HDUs; can't read HDU %d") %
+                                       fileName % i % hdu).str());
+                }
+            }
+        }
+        scanner.scanHdu(offset, keys, &values, &nAxis);
+
+        return values;
+    }
+
+    /*
+     * Scan files [begin, end) of a list; the unit of work for each thread
+     */
+    class ScanFiles {
+    public:
+        ScanFiles(std::vector<std::string> const& fileNames, KeySet const& keys, int hdu,
+                  std::vector<lsst::afw::image::HeaderValues> &values, int begin, int end) :
+            _fileNames(&fileNames), _keys(&keys), _hdu(hdu), _values(&values), _begin(begin), _end(end) {}
+
+        void operator()() {
+            for (int i = _begin; i != _end; ++i) {
+                (*_values)[i] = scanFile((*_fileNames)[i], *_keys, _hdu);
+            }
+        }
+    private:
+        std::vector<std::string> const *_fileNames;
+        KeySet const *_keys;
+        int _hdu;
+        std::vector<lsst::afw::image::HeaderValues> *_values;
+        int _begin, _end;
+    };
+}
+
+/**
+ * \brief Return the values of a few keywords in a FITS file's header
+ *
+ * This is much faster than readMetadata when only some of the keywords are wanted (e.g. when indexing
+ * many files by EXPTIME and FILTER):  the header blocks are read and parsed directly, only the requested
+ * keywords' values are saved, and no pixels are read.  Values are returned as strings, with a string's
+ * quotes and trailing blanks removed (and continued long strings reassembled); convert them as required.
+ * Keywords that aren't present are missing from the returned map.
+ *
+ * The HDU is chosen as readMetadata does; the header returned is that in the file, so e.g. for a
+ * tile-compressed image it's the binary table's.  HIERARCH keywords and compressed (.gz) files are not
+ * supported.
+ *
+ * \throw lsst::afw::image::FitsException if the file can't be read, isn't a FITS file, or lacks the HDU
+ */
+HeaderValues scanMetadata(std::string const& fileName,      ///< File to read
+                          std::vector<std::string> const& keys, ///< Keywords whose values are wanted
+                          int hdu                           ///< HDU to read
+                         ) {
+    return scanFile(fileName, KeySet(keys.begin(), keys.end()), hdu);
+}
+
+/**
+ * \brief Return the values of a few keywords in each of a list of FITS files' headers
+ *
+ * The files are scanned as by scanMetadata(fileName, keys, hdu), nThreads at a time.
+ *
+ * \throw lsst::pex::exceptions::Exception if any of the files can't be scanned
+ */
+std::vector<HeaderValues> scanMetadata(
+        std::vector<std::string> const& fileNames, ///< Files to read
+        std::vector<std::string> const& keys,      ///< Keywords whose values are wanted
+        int hdu,                                   ///< HDU to read
+        int nThreads                               ///< Number of threads to use; 0 for one per core
+                                      ) {
+    KeySet const keySet(keys.begin(), keys.end());
+    std::vector<HeaderValues> values(fileNames.size());
+
+    std::vector<int> const edges =
+        lsst::afw::math::detail::computeBandEdges(0, static_cast<int>(fileNames.size()),
+                                                  lsst::afw::math::detail::computeNThreads(nThreads));
+    std::vector<ScanFiles> scanners;
+    for (std::size_t i = 0; i + 1 < edges.size(); ++i) {
+        scanners.push_back(ScanFiles(fileNames, keySet, hdu, values, edges[i], edges[i + 1]));
+    }
+    lsst::afw::math::detail::runInParallel(scanners);
+
+    return values;
+}
+
+/**
+ * \brief Return the values of a few keywords in the headers of each FITS file in a directory
+ *
+ * Each file in dirName (but not its subdirectories) whose name matches the regular expression pattern
+ * is scanned as by scanMetadata(fileName, keys, hdu), nThreads at a time; the returned map is indexed by
+ * the files' paths.
+ *
+ * \throw lsst::pex::exceptions::Exception if the directory can't be read, or any of its matching files
+ * can't be scanned
+ */
+std::map<std::string, HeaderValues> scanMetadataDirectory(
+        std::string const& dirName,                ///< Directory to scan
+        std::vector<std::string> const& keys,      ///< Keywords whose values are wanted
+        int hdu,                                   ///< HDU to read
+        std::string const& pattern,                ///< Regular expression that file names must match
+        int nThreads                               ///< Number of threads to use; 0 for one per core
+                                                         ) {
+    boost::regex const re(pattern);
+    std::vector<std::string> fileNames;
+    try {
+        for (boost::filesystem::directory_iterator ptr(dirName), end; ptr != end; ++ptr) {
+            std::string const fileName = ptr->path().string();
+            if (!boost::filesystem::is_directory(ptr->status()) && boost::regex_search(fileName, re)) {
+                fileNames.push_back(fileName);
+            }
+        }
+    } catch (boost::filesystem::filesystem_error &e) {
+        throw LSST_EXCEPT(lsst::pex::exceptions::IoErrorException,
+                          (boost::format("Listing %s: %s") % dirName % e.what()).str());
+    }
+    std::sort(fileNames.begin(), fileNames.end());
+
+    std::vector<HeaderValues> const values = scanMetadata(fileNames, keys, hdu, nThreads);
+
+    std::map<std::string, HeaderValues> valuesByName;
+    for (std::size_t i = 0; i != fileNames.size(); ++i) {
+        valuesByName.insert(std::make_pair(fileNames[i], values[i]));
+    }
+    return valuesByName;
+}
+
 }}} // namespace lsst::afw::image
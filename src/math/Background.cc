@@ -29,30 +29,73 @@
  * @author Steve Bickerton
  * @date Jan 26, 2009
  */
+#include <algorithm>
 #include <iostream>
 #include <limits>
 #include <vector>
 #include <cmath>
+#include "boost/bind.hpp"
+#include "boost/format.hpp"
+#include "boost/function.hpp"
 #include "lsst/afw/image/MaskedImage.h"
 #include "lsst/afw/math/Interpolate.h"
 #include "lsst/afw/math/Background.h"
 #include "lsst/afw/math/Statistics.h"
+#include "lsst/afw/math/detail/Parallel.h"
 
 using namespace std;
 namespace geom = lsst::afw::geom;
 namespace image = lsst::afw::image;
 namespace math = lsst::afw::math;
+namespace mathDetail = lsst::afw::math::detail;
 namespace ex = lsst::pex::exceptions;
 
+namespace {
+    int const NCOEFF = 4;               // number of polynomial coefficients per interval
+
+    /*
+     * Call func(begin, end) for each of nThreads bands of [begin, end), in parallel
+     */
+    void runInBands(boost::function<void (int, int)> const &func, int const begin, int const end,
+                    int const nThreads) {
+        std::vector<int> const bandEdges = mathDetail::computeBandEdges(begin, end, nThreads);
+        std::vector<boost::function<void ()> > functorList;
+        for (std::size_t i = 0; i + 1 < bandEdges.size(); ++i) {
+            functorList.push_back(boost::bind(func, bandEdges[i], bandEdges[i + 1]));
+        }
+        mathDetail::runInParallel(functorList);
+    }
+
+    /*
+     * Find the coefficients of the cubic through f[0..3], sampled at 0, h/3, 2h/3 and h, such that
+     * p(dx) = coeffs[0] + dx*(coeffs[1] + dx*(coeffs[2] + dx*coeffs[3]))
+     *
+     * All the interpolants we use are piecewise cubic (or linear), so this reproduces them exactly
+     * (up to rounding); a constant or linear f gives vanishing higher-order coefficients.
+     */
+    void fitCubic(double const *f, double const h, double *coeffs) {
+        double const s = h/3;
+        double const d10 = (f[1] - f[0])/s;
+        double const d11 = (f[2] - f[1])/s;
+        double const d12 = (f[3] - f[2])/s;
+        double const d20 = (d11 - d10)/(2*s);
+        double const d21 = (d12 - d11)/(2*s);
+        double const d3 = (d21 - d20)/(3*s);
+        // expand the Newton form f0 + d10*t + d20*t*(t - s) + d3*t*(t - s)*(t - 2s)
+        coeffs[0] = f[0];
+        coeffs[1] = d10 - s*d20 + 2*s*s*d3;
+        coeffs[2] = d20 - 3*s*d3;
+        coeffs[3] = d3;
+    }
+}
 
 /**
  * @brief Constructor for Background
  *
- * Various things are pre-computed by the constructor to make the interpolation faster.
- *
- * @note This is hard-coded to use bicubic spline for interpolation, attempt to use linear interpolate
- *       will cause an assertion failure.
- * @todo Implement user-settable intepolation style
+ * Various things are pre-computed by the constructor to make the interpolation faster:
+ * the statistics of each grid cell, each column's interpolant evaluated at every row,
+ * and the polynomial coefficients of each row's interpolant between the grid points.
+ * All three are computed in parallel on BackgroundControl::getNThreads() threads.
  */
 template<typename ImageT>
 math::Background::Background(ImageT const& img, ///< ImageT (or MaskedImage) whose properties we want
@@ -61,8 +104,6 @@ math::Background::Background(ImageT const& img, ///< ImageT (or MaskedImage) who
     _imgWidth(img.getWidth()), _imgHeight(img.getHeight()),
     _bctrl(bgCtrl) { 
 
-    //assert(_bctrl.ictrl.getInterpStyle() == math::NATURAL_SPLINE); // hard-coded for the time-being
-
     _n = _imgWidth*_imgHeight;
     
     if (_n == 0) {
@@ -77,8 +118,8 @@ math::Background::Background(ImageT const& img, ///< ImageT (or MaskedImage) who
     _ycen.resize(_nySample);
     _xorig.resize(_nxSample);
     _yorig.resize(_nySample);
-    _grid.resize(_nxSample);
-    _gridcolumns.resize(_nxSample);
+    _grid.resize(_nxSample, std::vector<double>(_nySample));
+    _gridcolumns.resize(_nxSample, std::vector<double>(_imgHeight));
 
 
     // Check that an int's large enough to hold the number of pixels
@@ -101,53 +142,131 @@ math::Background::Background(ImageT const& img, ///< ImageT (or MaskedImage) who
         _yorig[iY] = iY * _subimgHeight;
     }
 
-    // make a vector containing the y pixel coords for the column
-    vector<int> ypix(_imgHeight);
-    for (int iY = 0; iY < _imgHeight; ++iY) { ypix[iY] = iY; }
-
+    int const nThreads = mathDetail::computeNThreads(_bctrl.getNThreads());
 
-    // go to each sub-image and get it's stats.
-    // -- do columns in the inner-loop and spline them as they complete
-    for (int iX = 0; iX < _nxSample; ++iX) {
-        
-        _grid[iX].resize(_nySample);
-        for (int iY = 0; iY < _nySample; ++iY) {
-            
-            ImageT subimg = ImageT(img, geom::Box2I(
-                    geom::Point2I(_xorig[iX], _yorig[iY]),
-                    geom::Extent2I(_subimgWidth, _subimgHeight)
-                ),
-                image::LOCAL
-            );
-            
-            math::Statistics stats =
-                math::makeStatistics(subimg, _bctrl.getStatisticsProperty(),
-                                     *(_bctrl.getStatisticsControl()));
-            
-            _grid[iX][iY] = stats.getValue(_bctrl.getStatisticsProperty());
+    // make each cell's sub-image here, as making a sub-image updates img's (non-atomic) reference count
+    std::vector<typename ImageT::Ptr> subimgs(_nxSample*_nySample);
+    for (int iY = 0; iY < _nySample; ++iY) {
+        for (int iX = 0; iX < _nxSample; ++iX) {
+            subimgs[iY*_nxSample + iX].reset(new ImageT(img, geom::Box2I(
+                        geom::Point2I(_xorig[iX], _yorig[iY]),
+                        geom::Extent2I(_subimgWidth, _subimgHeight)
+                    ),
+                    image::LOCAL
+                ));
         }
+    }
+
+    // go to each sub-image and get its stats, then spline the columns
+    runInBands(boost::bind(&Background::_computeGridStatistics<ImageT>, this, boost::cref(subimgs), _1, _2),
+               0, _nxSample*_nySample, nThreads);
+    runInBands(boost::bind(&Background::_computeGridColumns, this, _1, _2), 0, _nxSample, nThreads);
+
+    // find the interval and offset of each column, then the coefficients of each row's interpolant
+    _nInterval = (_bctrl.getInterpStyle() == Interpolate::CONSTANT) ? _nxSample : _nxSample - 1;
+    _xInterval.resize(_imgWidth);
+    _xOffset.resize(_imgWidth);
+    for (int x = 0; x < _imgWidth; ++x) {
+        _xInterval[x] = _findInterval(x, &_xOffset[x]);
+    }
+    _rowCoeffs.resize(static_cast<std::size_t>(_imgHeight)*_nInterval*NCOEFF);
+    runInBands(boost::bind(&Background::_computeRowCoefficients, this, _1, _2), 0, _imgHeight, nThreads);
+}
+
+/**
+ * @brief Compute the statistics of grid cells [cellBegin, cellEnd), numbered iY*_nxSample + iX
+ *
+ * The cells' sub-images are made by the caller; we only read their pixels, so may run on any thread.
+ */
+template<typename ImageT>
+void math::Background::_computeGridStatistics(std::vector<typename ImageT::Ptr> const& subimgs,
+                                              int const cellBegin, int const cellEnd) {
+    for (int cell = cellBegin; cell < cellEnd; ++cell) {
+        int const iX = cell % _nxSample;
+        int const iY = cell / _nxSample;
 
-        _gridcolumns[iX].resize(_imgHeight);
+        math::Statistics stats =
+            math::makeStatistics(*subimgs[cell], _bctrl.getStatisticsProperty(),
+                                 *(_bctrl.getStatisticsControl()));
 
+        _grid[iX][iY] = stats.getValue(_bctrl.getStatisticsProperty());
+    }
+}
+
+/**
+ * @brief Interpolate grid columns [iXBegin, iXEnd) to every row of the image
+ */
+void math::Background::_computeGridColumns(int const iXBegin, int const iXEnd) {
+    for (int iX = iXBegin; iX < iXEnd; ++iX) {
         // there isn't actually any way to interpolate as a constant ... do that manually here
         if (_bctrl.getInterpStyle() != Interpolate::CONSTANT) {
             // this is the real interpolation
-            typename math::Interpolate intobj(_ycen, _grid[iX], _bctrl.getInterpStyle());
+            math::Interpolate intobj(_ycen, _grid[iX], _bctrl.getInterpStyle());
             for (int iY = 0; iY < _imgHeight; ++iY) {
-                _gridcolumns[iX][iY] = intobj.interpolate(ypix[iY]);
+                _gridcolumns[iX][iY] = intobj.interpolate(iY);
             }
         } else {
             // this is the constant interpolation
             // it should only be used sanely when nx,nySample are both 1,
             //  but this should still work for other grid sizes.
             for (int iY = 0; iY < _imgHeight; ++iY) {
-                int const iGridY = (iY/_subimgHeight < _nySample) ? iY/_subimgHeight : _nySample;
+                int const iGridY = (iY/_subimgHeight < _nySample) ? iY/_subimgHeight : _nySample - 1;
                 _gridcolumns[iX][iY] = _grid[iX][iGridY];
             }
         }
+    }
+}
 
+/**
+ * @brief Compute the coefficients of the interpolant along rows [yBegin, yEnd)
+ *
+ * Each interval of a row's interpolant is sampled at four points and the cubic through
+ * them is stored as NCOEFF coefficients in powers of the offset from the interval's start.
+ */
+void math::Background::_computeRowCoefficients(int const yBegin, int const yEnd) {
+    vector<double> bg_x(_nxSample);
+    for (int y = yBegin; y < yEnd; ++y) {
+        for (int iX = 0; iX < _nxSample; ++iX) {
+            bg_x[iX] = _gridcolumns[iX][y];
+        }
+
+        double *coeffs = &_rowCoeffs[static_cast<std::size_t>(y)*_nInterval*NCOEFF];
+        if (_bctrl.getInterpStyle() != Interpolate::CONSTANT) {
+            math::Interpolate intobj(_xcen, bg_x, _bctrl.getInterpStyle());
+            for (int i = 0; i < _nInterval; ++i, coeffs += NCOEFF) {
+                double const h = _xcen[i + 1] - _xcen[i];
+                double f[NCOEFF];
+                f[0] = bg_x[i];
+                f[1] = intobj.interpolate(_xcen[i] + h/3);
+                f[2] = intobj.interpolate(_xcen[i] + 2*h/3);
+                f[3] = bg_x[i + 1];
+                fitCubic(f, h, coeffs);
+            }
+        } else {
+            for (int i = 0; i < _nInterval; ++i, coeffs += NCOEFF) {
+                coeffs[0] = bg_x[i];
+                coeffs[1] = coeffs[2] = coeffs[3] = 0;
+            }
+        }
     }
+}
 
+/**
+ * @brief Return the interval of each row's interpolant used to evaluate column x
+ *
+ * Columns beyond the outermost grid points use (i.e. extrapolate) the outermost interval.
+ */
+int math::Background::_findInterval(int const x, ///< column
+                                    double *offset ///< set to the offset of x from the interval's start
+                                   ) const {
+    if (_bctrl.getInterpStyle() == Interpolate::CONSTANT) {
+        *offset = 0;
+        return (x/_subimgWidth < _nxSample) ? x/_subimgWidth : _nxSample - 1;
+    }
+    int const i = std::upper_bound(_xcen.begin(), _xcen.end() - 1, static_cast<double>(x)) - _xcen.begin();
+    int const interval = std::max(i - 1, 0);
+    *offset = x - _xcen[interval];
+    return interval;
 }
 
 
@@ -157,27 +276,15 @@ math::Background::Background(ImageT const& img, ///< ImageT (or MaskedImage) who
  * @param x x-pixel coordinate (column)
  * @param y y-pixel coordinate (row)
  *
- * @warning This can be a very costly function to get a single pixel
- *          If you want an image, use the getImage() method.
+ * @note This evaluates the precomputed interpolant, but if you want an image use the getImage() method.
  *
  * @return an estimated background at x,y (double)
  */
 double math::Background::getPixel(int const x, int const y) const {
-
-    // build an interpobj along the row y and get the x'th value
-    vector<double> bg_x(_nxSample);
-    for (int iX = 0; iX < _nxSample; iX++) {
-        bg_x[iX] = _gridcolumns[iX][y];
-    }
-
-    if (_bctrl.getInterpStyle() != Interpolate::CONSTANT) {
-        math::Interpolate intobj(_xcen, bg_x, _bctrl.getInterpStyle());
-        return static_cast<double>(intobj.interpolate(x));
-    } else {
-        int const iGridX = (x/_subimgWidth < _nxSample) ? x/_subimgHeight : _nxSample;
-        return static_cast<double>(_gridcolumns[iGridX][y]);
-    }
-    
+    double dx;
+    int const interval = _findInterval(x, &dx);
+    double const *coeffs = &_rowCoeffs[(static_cast<std::size_t>(y)*_nInterval + interval)*NCOEFF];
+    return coeffs[0] + dx*(coeffs[1] + dx*(coeffs[2] + dx*coeffs[3]));
 }
 
 
@@ -195,43 +302,54 @@ typename image::Image<PixelT>::Ptr math::Background::getImage() const {
             geom::Extent2I(_imgWidth, _imgHeight)
         )
     );
+    getImage(*bg);
 
-    // need a vector of all x pixel coords to spline over
-    vector<int> xpix(bg->getWidth());
-    for (int iX = 0; iX < bg->getWidth(); ++iX) { xpix[iX] = iX; }
-    
-    // go through row by row
-    // - spline on the gridcolumns that were pre-computed by the constructor
-    // - copy the values to an ImageT to return to the caller.
-    for (int iY = 0; iY < bg->getHeight(); ++iY) {
-
-        // build an interp object for this row
-        vector<double> bg_x(_nxSample);
-        for (int iX = 0; iX < _nxSample; iX++) {
-            bg_x[iX] = static_cast<double>(_gridcolumns[iX][iY]);
-        }
-        
-        if (_bctrl.getInterpStyle() != Interpolate::CONSTANT) {
-            math::Interpolate intobj(_xcen, bg_x, _bctrl.getInterpStyle());
-            // fill the image with interpolated objects.
-            int iX = 0;
-            for (typename image::Image<PixelT>::x_iterator ptr = bg->row_begin(iY),
-                     end = ptr + bg->getWidth(); ptr != end; ++ptr, ++iX) {
-                *ptr = static_cast<PixelT>(intobj.interpolate(xpix[iX]));
-            }
-        } else {
-            // fill the image with interpolated objects.
-            int iX = 0;
-            for (typename image::Image<PixelT>::x_iterator ptr = bg->row_begin(iY),
-                     end = ptr + bg->getWidth(); ptr != end; ++ptr, ++iX) {
-                int const iGridX = (iX/_subimgWidth < _nxSample) ? iX/_subimgWidth : _nxSample - 1;
-                *ptr = static_cast<PixelT>(_gridcolumns[iGridX][iY]);
+    return bg;
+}
+
+/**
+ * @brief Method to compute the background for entire image into a caller-supplied image
+ *
+ * If subtract is true the background is subtracted from img, with the same result as subtracting
+ * the image returned by getImage<PixelT>() but with no temporary image.
+ *
+ * @throw lsst::pex::exceptions::LengthErrorException if img is not the size of the original image
+ */
+template<typename PixelT>
+void math::Background::getImage(image::Image<PixelT> &img, ///< image to set to (or subtract) background
+                                bool const subtract        ///< subtract the background from img?
+                               ) const {
+    if (img.getWidth() != _imgWidth || img.getHeight() != _imgHeight) {
+        throw LSST_EXCEPT(ex::LengthErrorException,
+                          str(boost::format("Image is %dx%d; the background was computed for %dx%d")
+                              % img.getWidth() % img.getHeight() % _imgWidth % _imgHeight));
+    }
+    runInBands(boost::bind(&Background::_fillRows<PixelT>, this, boost::ref(img), subtract, _1, _2),
+               0, _imgHeight, mathDetail::computeNThreads(_bctrl.getNThreads()));
+}
+
+/**
+ * @brief Set (or subtract) the background for rows [yBegin, yEnd) of img
+ */
+template<typename PixelT>
+void math::Background::_fillRows(image::Image<PixelT> &img, bool const subtract,
+                                 int const yBegin, int const yEnd) const {
+    for (int y = yBegin; y < yEnd; ++y) {
+        double const *rowCoeffs = &_rowCoeffs[static_cast<std::size_t>(y)*_nInterval*NCOEFF];
+        int x = 0;
+        for (typename image::Image<PixelT>::x_iterator ptr = img.row_begin(y), end = img.row_end(y);
+             ptr != end; ++ptr, ++x) {
+            double const *coeffs = rowCoeffs + _xInterval[x]*NCOEFF;
+            double const dx = _xOffset[x];
+            PixelT const value =
+                static_cast<PixelT>(coeffs[0] + dx*(coeffs[1] + dx*(coeffs[2] + dx*coeffs[3])));
+            if (subtract) {
+                *ptr -= value;
+            } else {
+                *ptr = value;
             }
         }
-
     }
-    
-    return bg;
 }
 
 /************************************************************************************************************/
@@ -307,7 +425,8 @@ void math::Background::_checkSampling() {
                                           math::BackgroundControl const& bgCtrl); \
     template math::Background::Background(image::MaskedImage<TYPE> const& img, \
                                           math::BackgroundControl const& bgCtrl); \
-    template image::Image<TYPE>::Ptr math::Background::getImage<TYPE>() const;
+    template image::Image<TYPE>::Ptr math::Background::getImage<TYPE>() const; \
+    template void math::Background::getImage<TYPE>(image::Image<TYPE> &img, bool const subtract) const;
 
 INSTANTIATE_BACKGROUND(double)
 INSTANTIATE_BACKGROUND(float)
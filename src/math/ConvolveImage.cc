@@ -294,6 +294,9 @@ void afwMath::scaledPlus(
  * - Convolution with spatially invariant versions of the other kernels is performed by computing
  *   the kernel %image once and convolving with that. The code has been optimized for cache performance
  *   and so should be fairly efficient.
+ * - Convolution with large spatially invariant kernels (see ConvolutionControl::setFftMinKernelSize)
+ *   of floating point images is performed using FFTs (see detail::convolveWithFft). FFTW plans are cached,
+ *   so the first convolution with a given image and kernel size is slower than subsequent ones.
  * - Convolution with a spatially varying LinearCombinationKernel is performed by convolving the %image
  *   by each basis kernel and combining the result by solving the spatial model. This will be efficient
  *   provided the kernel does not contain too many or very large basis kernels.
@@ -302,13 +305,22 @@ void afwMath::scaledPlus(
  *   the input %image. This is not favorable for cache performance (especially for large kernels)
  *   but avoids recomputing the AnalyticKernel. It is probably possible to do better.
  *
+ * Brute force and SeparableKernel convolution can split the output rows into bands that are computed
+ * on separate threads; see ConvolutionControl::setNThreads. The result does not depend on the number
+ * of threads.
+ *
+ * The inner loops over rows of float and double Image and MaskedImage pixels use SSE2 or AVX2
+ * instructions, as supported by the CPU (see detail/DotProduct.h). Sums are accumulated in double
+ * precision, so results may differ from the generic code by roundoff.
+ *
  * Additional convolution functions include:
  *  - convolveAtAPoint(): convolve a Kernel to an Image or MaskedImage at a point.
  *  - basicConvolve(): convolve a Kernel with an Image or MaskedImage, but do not set the edge pixels
  *    of the output. Optimization of convolution for different types of Kernel are handled by different
  *    specializations of basicConvolve().
  * 
- * afw/examples offers programs that time convolution including timeConvolve and timeSpatiallyVaryingConvolve.
+ * afw/examples offers programs that time convolution including timeConvolve, timeSpatiallyVaryingConvolve
+ * and timeKernelDotProduct.
  *
  * @throw lsst::pex::exceptions::InvalidParameterException if convolvedImage is not the same size as inImage
  * @throw lsst::pex::exceptions::InvalidParameterException if inImage is smaller than kernel
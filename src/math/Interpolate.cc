@@ -28,6 +28,7 @@
  * @ingroup afw
  * @author Steve Bickerton
  */
+#include <algorithm>
 #include <limits>
 #include <map>
 #include "boost/format.hpp"
@@ -38,25 +39,54 @@
 
 #include "lsst/pex/exceptions.h"
 #include "lsst/afw/math/Interpolate.h"
+#include "lsst/afw/math/detail/Spline.h"
 
 namespace math = lsst::afw::math;
 namespace ex = lsst::pex::exceptions;
 
 math::Interpolate::Interpolate(std::vector<double> const &x, std::vector<double> const &y,
-                               ::gsl_interp_type const *gslInterpType) : _x(x), _y(y) {
+                               ::gsl_interp_type const *gslInterpType) :
+    _x(x), _y(y), _acc(NULL), _interp(NULL), _spline() {
     initialize(_x, _y, gslInterpType);
 }
 
-math::Interpolate::Interpolate(std::vector<double> const &x, std::vector<double> const &y,
-                               Interpolate::Style const style) :  _x(x), _y(y) {
+/**
+ * @brief Construct an interpolator of the given style
+ *
+ * @throw lsst::pex::exceptions::InvalidParameterException if style is CONSTANT, or if isNative is true
+ *  and style is not NATURAL_SPLINE, CUBIC_SPLINE or AKIMA_SPLINE
+ */
+math::Interpolate::Interpolate(std::vector<double> const &x, ///< positions of the points; increasing
+                               std::vector<double> const &y, ///< values at x
+                               Interpolate::Style const style, ///< style of interpolation
+                               bool const isNative           ///< use our own spline, not GSL's?
+                              ) :
+    _x(x), _y(y), _acc(NULL), _interp(NULL), _spline() {
     if (style == Interpolate::CONSTANT) {
         throw LSST_EXCEPT(ex::InvalidParameterException, "CONSTANT interpolation not supported.");
     }
-    initialize(_x, _y, math::styleToGslInterpType(style));
+    if (!isNative) {
+        initialize(_x, _y, math::styleToGslInterpType(style));
+        return;
+    }
+
+    switch (style) {
+      case Interpolate::NATURAL_SPLINE:
+      case Interpolate::CUBIC_SPLINE:   // gsl_interp_cspline is also a natural spline
+        _spline.reset(new detail::NaturalSpline(x, y));
+        break;
+      case Interpolate::AKIMA_SPLINE:
+        _spline.reset(new detail::AkimaSpline(x, y));
+        break;
+      default:
+        throw LSST_EXCEPT(ex::InvalidParameterException,
+                          str(boost::format("Native interpolation is not supported for style %d") % style));
+    }
 }
 
 math::Interpolate::Interpolate(std::vector<double> const &x, std::vector<double> const &y,
-                               std::string style) :  _x(x), _y(y) {
+                               std::string style) :
+    _x(x), _y(y), _acc(NULL), _interp(NULL), _spline() {
     if (style == "CONSTANT") {
         throw LSST_EXCEPT(ex::InvalidParameterException, "CONSTANT interpolation not supported.");
     }
@@ -87,14 +117,61 @@ void math::Interpolate::initialize(std::vector<double> const &x, std::vector<dou
 }
 
 math::Interpolate::~Interpolate() {
-    ::gsl_interp_free(_interp);
-    ::gsl_interp_accel_free(_acc);
+    if (_interp) {
+        ::gsl_interp_free(_interp);
+    }
+    if (_acc) {
+        ::gsl_interp_accel_free(_acc);
+    }
 }
 
 double math::Interpolate::interpolate(double const x) {
+    if (_spline) {
+        return _spline->interpolate(x);
+    }
     return ::gsl_interp_eval(_interp, &_x[0], &_y[0], x, _acc);
 }
 
+/**
+ * @brief Interpolate at each of a vector of points
+ *
+ * The values are the same as calling interpolate(x[i]) for each point, but much faster when
+ * x is sorted (or mostly sorted) into increasing order, as for a row of pixels: the interval
+ * containing each point is found by walking forward from the previous point's interval.
+ * Unsorted x are allowed, at the cost of a binary search wherever x decreases.
+ */
+void math::Interpolate::interpolate(std::vector<double> const &x, ///< points to interpolate at
+                                    std::vector<double> &y        ///< values at x (resized as needed)
+                                   ) {
+    if (_spline) {
+        _spline->interpolate(x, y);
+        return;
+    }
+
+    y.resize(x.size());
+    /*
+     * gsl_interp_eval looks in the interval cached by the accelerator before searching for x,
+     * so we walk the cache forward ourselves; it uses the interval i (0 <= i <= nknot - 2)
+     * with _x[i] <= x < _x[i + 1], or the nearest one if x is out of range
+     */
+    int const nknot = _x.size();
+    double const *const knots = &_x[0];
+    int interval = 0;
+    for (std::size_t i = 0; i != x.size(); ++i) {
+        double const xi = x[i];
+        if (i == 0 || xi < x[i - 1]) {
+            interval = std::upper_bound(knots, knots + nknot - 1, xi) - knots - 1;
+            interval = std::max(interval, 0);
+        } else {
+            while (interval < nknot - 2 && xi >= knots[interval + 1]) {
+                ++interval;
+            }
+        }
+        _acc->cache = interval;
+        y[i] = ::gsl_interp_eval(_interp, knots, &_y[0], xi, _acc);
+    }
+}
+
 /**
  * @brief Conversion function to switch an Interpolate::Style to a gsl_interp_type.
  *
@@ -37,10 +37,12 @@
 
 #include "lsst/pex/exceptions.h"
 #include "lsst/afw/math/Kernel.h"
+#include "lsst/afw/math/detail/KernelFunctionTable.h"
 
 namespace pexExcept = lsst::pex::exceptions;
 namespace afwImage = lsst::afw::image;
 namespace afwMath = lsst::afw::math;
+namespace mathDetail = lsst::afw::math::detail;
 
 /**
  * @brief Construct an empty spatially invariant SeparableKernel of size 0x0
@@ -52,7 +54,8 @@ afwMath::SeparableKernel::SeparableKernel()
     _kernelRowFunctionPtr(),
     _localColList(0), _localRowList(0),
     _kernelX(0), _kernelY(0),
-    _kernelRowCache(0), _kernelColCache(0)
+    _kernelRowCache(0), _kernelColCache(0),
+    _kernelFunctionTablePtr()
 {
     _setKernelXY();
 }
@@ -76,7 +79,8 @@ afwMath::SeparableKernel::SeparableKernel(
     _kernelRowFunctionPtr(kernelRowFunction.clone()),
     _localColList(width), _localRowList(height),
     _kernelX(width), _kernelY(height),
-    _kernelRowCache(0), _kernelColCache(0)
+    _kernelRowCache(0), _kernelColCache(0),
+    _kernelFunctionTablePtr()
 {
     _setKernelXY();
 }
@@ -100,7 +104,8 @@ afwMath::SeparableKernel::SeparableKernel(
     _kernelRowFunctionPtr(kernelRowFunction.clone()),
     _localColList(width), _localRowList(height),
     _kernelX(width), _kernelY(height),
-    _kernelRowCache(0), _kernelColCache(0)    
+    _kernelRowCache(0), _kernelColCache(0),
+    _kernelFunctionTablePtr()
 {
     if (kernelColFunction.getNParameters() + kernelRowFunction.getNParameters()
         != spatialFunctionList.size()) {
@@ -258,7 +263,10 @@ double afwMath::SeparableKernel::basicComputeVectors(
     bool doNormalize                    ///< normalize the arrays (so sum of each is 1)?
 ) const {
     double colSum = 0.0;
-    if (_kernelColCache.empty()) {
+    if (_kernelColCache.empty() && _kernelFunctionTablePtr) {
+        colSum = _kernelFunctionTablePtr->computeValues(colList, _kernelX,
+            _kernelColFunctionPtr->getParameter(0));
+    } else if (_kernelColCache.empty()) {
         for (unsigned int i = 0; i != colList.size(); ++i) {
             double colFuncValue = (*_kernelColFunctionPtr)(_kernelX[i]);
             colList[i] = colFuncValue;
@@ -278,7 +286,10 @@ double afwMath::SeparableKernel::basicComputeVectors(
     }
 
     double rowSum = 0.0;
-    if (_kernelRowCache.empty()) {
+    if (_kernelRowCache.empty() && _kernelFunctionTablePtr) {
+        rowSum = _kernelFunctionTablePtr->computeValues(rowList, _kernelY,
+            _kernelRowFunctionPtr->getParameter(0));
+    } else if (_kernelRowCache.empty()) {
         for (unsigned int i = 0; i != rowList.size(); ++i) {
             double rowFuncValue = (*_kernelRowFunctionPtr)(_kernelY[i]);
             rowList[i] = rowFuncValue;
@@ -388,3 +399,30 @@ void afwMath::SeparableKernel::computeCache(
     func = getKernelRowFunction();
     _computeCache(cacheSize, _kernelX, func, &_kernelRowCache);
 }
+
+/**
+ * @brief Return the current cache size (0 if none)
+ *
+ * Note that clone() does not copy the cache; call computeCache(getCacheSize()) on the clone
+ * if it should produce identical results.
+ */
+int afwMath::SeparableKernel::getCacheSize() const {
+    return _kernelColCache.size();
+}
+
+/**
+ * @brief Set (or, if tablePtr is null, clear) an interpolated table of the kernel functions
+ *
+ * When set, the table is used instead of evaluating the column and row kernel functions,
+ * unless a cache has been computed with computeCache (which takes precedence).
+ * The table must describe both the column and the row function, and both functions must be
+ * shift-parameterized (see detail::KernelFunctionTable); this is the case for LanczosWarpingKernel,
+ * the intended user.
+ *
+ * Note that clone() does not copy the table; subclasses that set one should set it on their clones.
+ */
+void afwMath::SeparableKernel::setKernelFunctionTable(
+        boost::shared_ptr<mathDetail::KernelFunctionTable const> tablePtr) ///< table, or null to clear
+{
+    _kernelFunctionTablePtr = tablePtr;
+}
@@ -33,6 +33,10 @@ Spline::_allocateSpline(int const nknot)
                 
 /**
  * Interpolate a Spline.
+ *
+ * Runs of consecutive points that lie in the same interval (as they do when x is sorted and denser
+ * than the knots, e.g. a row of pixels) are evaluated together by a branch-free loop that the
+ * compiler can vectorise; the search for each new interval starts from the previous one.
  */
 void
 Spline::interpolate(std::vector<double> const& x, ///< points to interpolate at
@@ -50,8 +54,9 @@ Spline::interpolate(std::vector<double> const& x, ///< points to interpolate at
      * with
      *    dx = x - knots[i]
      */
+    double const inf = std::numeric_limits<double>::infinity();
     int ind = -1;                        // no idea initially
-    for (int i = 0; i != n; ++i) {
+    for (int i = 0; i != n; ) {
         ind = search_array(x[i], &_knots[0], nknot, ind);
 
         if(ind < 0) {			// off bottom
@@ -59,10 +64,46 @@ Spline::interpolate(std::vector<double> const& x, ///< points to interpolate at
         } else if(ind >= nknot) {		// off top
             ind = nknot - 1;
         }
+        /*
+         * Find the following points that search_array would also put in this interval
+         */
+        double const xlo = (ind == 0) ? -inf : _knots[ind];
+        double const xhi = (ind == nknot - 1) ? inf : _knots[ind + 1];
+        int end = i + 1;
+        while (end != n && x[end] > xlo && x[end] < xhi) {
+            ++end;
+        }
 
-        double const dx = x[i] - _knots[ind];
-        y[i] = _coeffs[0][ind] + dx*(_coeffs[1][ind] + dx*(_coeffs[2][ind]/2 + dx*_coeffs[3][ind]/6));
+        double const x0 = _knots[ind];
+        double const c0 = _coeffs[0][ind];
+        double const c1 = _coeffs[1][ind];
+        double const c2 = _coeffs[2][ind]/2;
+        double const c3 = _coeffs[3][ind]/6;
+        for (; i != end; ++i) {
+            double const dx = x[i] - x0;
+            y[i] = c0 + dx*(c1 + dx*(c2 + dx*c3));
+        }
+    }
+}
+
+/**
+ * Interpolate a Spline at a single point
+ */
+double
+Spline::interpolate(double const x      ///< point to interpolate at
+                   ) const
+{
+    int const nknot = _knots.size();
+    int ind = search_array(x, &_knots[0], nknot, -1);
+
+    if(ind < 0) {			// off bottom
+        ind = 0;
+    } else if(ind >= nknot) {		// off top
+        ind = nknot - 1;
     }
+
+    double const dx = x - _knots[ind];
+    return _coeffs[0][ind] + dx*(_coeffs[1][ind] + dx*(_coeffs[2][ind]/2 + dx*_coeffs[3][ind]/6));
 }
 
 /*****************************************************************************/
@@ -102,6 +143,162 @@ Spline::derivative(std::vector<double> const& x, ///< points to evaluate derivat
     }
 }
                 
+/*****************************************************************************/
+/*
+ * Check the inputs to a spline through the points (x, y), and set its knots to x
+ * and the size of its coefficient vectors
+ */
+static void
+setupInterpolatingSpline(std::vector<double> const& x,
+                         std::vector<double> const& y,
+                         int const nmin,
+                         char const *name,
+                         std::vector<double> &knots,
+                         std::vector<std::vector<double> > &coeffs)
+{
+    if(x.size() != y.size()) {
+        throw LSST_EXCEPT(lsst::pex::exceptions::InvalidParameterException,
+                          (boost::format("%s: x and y must have the same size; saw %d %d\n")
+                           % name % x.size() % y.size()).str());
+    }
+    int const n = x.size();
+    if(n < nmin) {
+        throw LSST_EXCEPT(lsst::pex::exceptions::InvalidParameterException,
+                          (boost::format("%s: n = %d, should be >= %d\n") % name % n % nmin).str());
+    }
+    for (int i = 1; i < n; ++i) {
+        if(x[i - 1] >= x[i]) {
+            throw LSST_EXCEPT(lsst::pex::exceptions::InvalidParameterException,
+                              (boost::format("point %d and the next, %f %f, are out of order")
+                               % (i - 1)  % x[i - 1] % x[i]).str());
+        }
+    }
+
+    knots = x;
+    for (unsigned int i = 0; i != coeffs.size(); ++i) {
+        coeffs[i].resize(n);
+    }
+}
+
+/*
+ * Set the coefficients at the last knot to continue the polynomial of the last interval,
+ * so that points beyond the last knot are extrapolated as gsl_interp does
+ */
+static void
+extendLastInterval(std::vector<double> const& knots,
+                   std::vector<std::vector<double> > &coeffs)
+{
+    int const n = knots.size();
+    double const h = knots[n - 1] - knots[n - 2];
+    coeffs[1][n - 1] = coeffs[1][n - 2] + h*(coeffs[2][n - 2] + h*coeffs[3][n - 2]/2);
+    coeffs[2][n - 1] = coeffs[2][n - 2] + h*coeffs[3][n - 2];
+    coeffs[3][n - 1] = coeffs[3][n - 2];
+}
+
+/**
+ * Construct a natural cubic spline (zero second derivative at the ends) through the points (x, y)
+ *
+ * The second derivatives at the knots satisfy a tridiagonal system, which we solve directly
+ */
+NaturalSpline::NaturalSpline(std::vector<double> const& x, ///< points where function's specified
+                             std::vector<double> const& y  ///< values of function at x
+                            )
+{
+    _allocateSpline(x.size());
+    setupInterpolatingSpline(x, y, 3, "NaturalSpline", _knots, _coeffs);
+    int const n = x.size();
+
+    std::vector<double> h(n - 1), slope(n - 1);
+    for (int i = 0; i < n - 1; ++i) {
+        h[i] = x[i + 1] - x[i];
+        slope[i] = (y[i + 1] - y[i])/h[i];
+    }
+    /*
+     * Solve for the second derivatives, d2[1..n-2], by Gaussian elimination; d2[0] = d2[n-1] = 0
+     */
+    std::vector<double> &d2 = _coeffs[2];
+    std::vector<double> diag(n), rhs(n);
+    d2[0] = d2[n - 1] = 0;
+    for (int i = 1; i < n - 1; ++i) {
+        diag[i] = 2*(h[i - 1] + h[i]);
+        rhs[i] = 6*(slope[i] - slope[i - 1]);
+        if (i > 1) {
+            double const ratio = h[i - 1]/diag[i - 1];
+            diag[i] -= ratio*h[i - 1];
+            rhs[i] -= ratio*rhs[i - 1];
+        }
+    }
+    for (int i = n - 2; i > 0; --i) {
+        d2[i] = (rhs[i] - h[i]*d2[i + 1])/diag[i];
+    }
+
+    for (int i = 0; i < n - 1; ++i) {
+        _coeffs[0][i] = y[i];
+        _coeffs[1][i] = slope[i] - h[i]*(2*d2[i] + d2[i + 1])/6;
+        _coeffs[3][i] = (d2[i + 1] - d2[i])/h[i];
+    }
+    _coeffs[0][n - 1] = y[n - 1];
+    extendLastInterval(_knots, _coeffs);
+}
+
+/**
+ * Construct an Akima spline through the points (x, y)
+ *
+ * The derivative at each knot is a weighted mean of the slopes of the adjacent intervals, with
+ * the weights chosen to suppress the wiggles of a cubic spline; see H. Akima, J. ACM 17, 589 (1970).
+ * The end conditions are the same as gsl_interp_akima's.
+ */
+AkimaSpline::AkimaSpline(std::vector<double> const& x, ///< points where function's specified
+                         std::vector<double> const& y  ///< values of function at x
+                        )
+{
+    _allocateSpline(x.size());
+    setupInterpolatingSpline(x, y, 5, "AkimaSpline", _knots, _coeffs);
+    int const n = x.size();
+    /*
+     * Slopes of the intervals, extrapolated by two intervals at each end; m[i] is the slope of
+     * the interval [x[i], x[i+1]]
+     */
+    std::vector<double> mStore(n + 3);
+    double *m = &mStore[0] + 2;          // we want indices -2..n
+    for (int i = 0; i < n - 1; ++i) {
+        m[i] = (y[i + 1] - y[i])/(x[i + 1] - x[i]);
+    }
+    m[-2] = 3*m[0] - 2*m[1];
+    m[-1] = 2*m[0] - m[1];
+    m[n - 1] = 2*m[n - 2] - m[n - 3];
+    m[n] = 3*m[n - 2] - 2*m[n - 3];
+
+    for (int i = 0; i < n - 1; ++i) {
+        _coeffs[0][i] = y[i];
+
+        double const ne = std::fabs(m[i + 1] - m[i]) + std::fabs(m[i - 1] - m[i - 2]);
+        if (ne == 0) {
+            _coeffs[1][i] = m[i];
+            _coeffs[2][i] = _coeffs[3][i] = 0;
+            continue;
+        }
+
+        double const h = x[i + 1] - x[i];
+        double const neNext = std::fabs(m[i + 2] - m[i + 1]) + std::fabs(m[i] - m[i - 1]);
+        double const alpha = std::fabs(m[i - 1] - m[i - 2])/ne;
+        double tNext;                   // derivative at x[i + 1]
+        if (neNext == 0) {
+            tNext = m[i];
+        } else {
+            double const alphaNext = std::fabs(m[i] - m[i - 1])/neNext;
+            tNext = (1 - alphaNext)*m[i] + alphaNext*m[i + 1];
+        }
+        double const t = (1 - alpha)*m[i - 1] + alpha*m[i]; // derivative at x[i]
+
+        _coeffs[1][i] = t;
+        _coeffs[2][i] = 2*(3*m[i] - 2*t - tNext)/h;
+        _coeffs[3][i] = 6*(t + tNext - 2*m[i])/(h*h);
+    }
+    _coeffs[0][n - 1] = y[n - 1];
+    extendLastInterval(_knots, _coeffs);
+}
+
 /*****************************************************************************/
 /**
  * Adapted from
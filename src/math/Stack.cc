@@ -29,18 +29,30 @@
  * @author Steve Bickerton
  *
  */
-#include <vector>
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <vector>
+#include "boost/bind.hpp"
+#include "boost/format.hpp"
+#include "boost/function.hpp"
 #include "boost/shared_ptr.hpp"
 
 #include "lsst/utils/ieee.h"
 #include "lsst/pex/exceptions.h"
+#include "lsst/daf/base/PropertyList.h"
+#include "lsst/afw/geom/Angle.h"
+#include "lsst/afw/image/fits/fits_io.h"
 #include "lsst/afw/math/Stack.h"
 #include "lsst/afw/math/MaskedVector.h"
+#include "lsst/afw/math/detail/Parallel.h"
 
 namespace afwGeom = lsst::afw::geom;
 namespace afwImage = lsst::afw::image;
 namespace afwMath  = lsst::afw::math;
+namespace mathDetail = lsst::afw::math::detail;
 namespace ex    = lsst::pex::exceptions;
 
 
@@ -49,10 +61,10 @@ namespace {
 /*
  * A function to load values from the weight vector into the variance plane of the pixelSet.
  */
-template <typename PixelT>    
-void loadVariance(std::vector<PixelT> const &wvector, afwMath::MaskedVector<PixelT> &pixelSet) {
+template <typename WeightT, typename PixelT>
+void loadVariance(std::vector<WeightT> const &wvector, afwMath::MaskedVector<PixelT> &pixelSet) {
     unsigned int j = 0;
-    for (typename std::vector<PixelT>::const_iterator pVec = wvector.begin();
+    for (typename std::vector<WeightT>::const_iterator pVec = wvector.begin();
          pVec != wvector.end(); ++pVec) {
         (*pixelSet.getVariance())(j, 0) = static_cast<afwImage::VariancePixel>(*pVec);
         ++j;
@@ -92,6 +104,501 @@ void checkOnlyOneFlag(unsigned int flags) {
 
 
 
+/****************************************************************************
+ *
+ * Tiled stacking engine for Images and MaskedImages
+ *
+ * The output is processed in bands of rows (one band per thread). Each band is processed in tiles of
+ * consecutive pixels of a row: the values of a tile from all the input images are gathered into
+ * contiguous buffers, arranged [pixel][image], and the statistic is then computed pixel by pixel.
+ * MEAN, MEDIAN and MEANCLIP are computed by PixelStackStatistics, which allocates nothing per pixel;
+ * other statistics are computed by a Statistics object made from a MaskedVector (one per band).
+ *
+ ****************************************************************************/
+
+namespace {
+
+double const NaN = std::numeric_limits<double>::quiet_NaN();
+double const IQ_TO_STDEV = 0.741301109252802;   // 1 sigma in units of iqrange (as in Statistics.cc)
+int const TILE_BUFFER_SIZE = 16384;             // desired number of values in a tile buffer
+int const MAX_INSERTION_SORT = 32;              // use an insertion sort for at most this many values
+
+/*
+ * Return true if PixelStackStatistics can compute the requested statistic
+ */
+bool isFastStatistic(afwMath::Property flags) {
+    int const prop = flags & ~afwMath::ERRORS;
+    return (prop == afwMath::MEAN) || (prop == afwMath::MEDIAN) || (prop == afwMath::MEANCLIP);
+}
+
+/*
+ * Compute MEAN, MEDIAN or MEANCLIP (and its error, the number of points used and the OR of their masks)
+ * of the values of one output pixel.
+ *
+ * This follows Statistics step by step (a crude mean for numerical stability, then the mean and variance
+ * about it; median and quartiles interpolated between order statistics; clipping first about the median
+ * using the IQR, then about the clipped mean), so the results are identical to those of a Statistics
+ * object made from a MaskedVector holding the same values. The only memory used is a scratch buffer
+ * that is allocated once.
+ */
+template <typename PixelT>
+class PixelStackStatistics {
+public:
+    PixelStackStatistics(afwMath::StatisticsControl const &sctrl, int nImages) :
+        _sctrl(sctrl), _nImages(nImages), _goodValues(nImages) {}
+
+    void compute(afwMath::Property flags,
+                 PixelT const *values,
+                 afwImage::MaskPixel const *masks,
+                 afwImage::VariancePixel const *weights,
+                 double &value,
+                 double &error,
+                 int &npoint,
+                 afwImage::MaskPixel &orMask);
+
+private:
+    void _sum(PixelT const *values, afwImage::MaskPixel const *masks, afwImage::VariancePixel const *weights,
+              double center, bool doClip, double clipLimit,
+              int &n, double &sum, double &sumx2, double &wsum, afwImage::MaskPixel &orMask) const;
+    void _meanVariance(int n, double sum, double sumx2, double wsum, double center,
+                       double &mean, double &variance) const;
+    int _copyGoodValues(PixelT const *values, afwImage::MaskPixel const *masks);
+    double _median(int n);
+    void _sort(int n);
+    double _interpolate(double idx) const;
+
+    afwMath::StatisticsControl const &_sctrl;
+    int _nImages;
+    std::vector<PixelT> _goodValues;    // scratch buffer for the values used by median and quartiles
+};
+
+/*
+ * Sum the values (about center) of the good pixels, as Statistics::_sumImage
+ */
+template <typename PixelT>
+void PixelStackStatistics<PixelT>::_sum(
+        PixelT const *values,
+        afwImage::MaskPixel const *masks,
+        afwImage::VariancePixel const *weights,
+        double center,
+        bool doClip,
+        double clipLimit,
+        int &n,
+        double &sum,
+        double &sumx2,
+        double &wsum,
+        afwImage::MaskPixel &orMask
+) const {
+    bool const isNanSafe = _sctrl.getNanSafe();
+    bool const isWeighted = _sctrl.getWeighted();
+    bool const isMultiplyingWeights = _sctrl.getMultiplyWeights();
+    afwImage::MaskPixel const andMask = _sctrl.getAndMask();
+
+    n = 0;
+    sum = sumx2 = wsum = 0.0;
+    orMask = 0x0;
+    for (int i = 0; i < _nImages; ++i) {
+        PixelT const val = values[i];
+        if ((isNanSafe && lsst::utils::isnan(static_cast<float>(val))) || (masks[i] & andMask)) {
+            continue;
+        }
+        if (doClip && !(std::fabs(val - center) <= clipLimit)) {
+            continue;
+        }
+
+        double const delta = (val - center);
+        if (isWeighted) {
+            afwImage::VariancePixel const weight = weights[i];
+            if (isMultiplyingWeights) {
+                sum   += weight*delta;
+                sumx2 += weight*delta*delta;
+                wsum  += weight;
+            } else if (weight > 0) {
+                sum   += delta/weight;
+                sumx2 += delta*delta/weight;
+                wsum  += 1.0/weight;
+            }
+        } else {
+            sum += delta;
+            sumx2 += delta*delta;
+        }
+        orMask |= masks[i];
+        ++n;
+    }
+}
+
+/*
+ * Compute the mean and population variance from the sums, as Statistics::_getStandard
+ */
+template <typename PixelT>
+void PixelStackStatistics<PixelT>::_meanVariance(
+        int n, double sum, double sumx2, double wsum, double center,
+        double &mean, double &variance
+) const {
+    if (_sctrl.getWeighted()) {
+        mean = (wsum > 0) ? center + sum/wsum : NaN;
+        variance = (n > 1) ? sumx2/(wsum - wsum/n) - sum*sum/(static_cast<double>(wsum - wsum/n)*wsum) : NaN;
+    } else {
+        mean = (n) ? center + sum/n : NaN;
+        variance = (n > 1) ? sumx2/(n - 1) - sum*sum/(static_cast<double>(n - 1)*n) : NaN;
+    }
+}
+
+/*
+ * Copy the values used for the median and quartiles into _goodValues; return the number copied
+ */
+template <typename PixelT>
+int PixelStackStatistics<PixelT>::_copyGoodValues(PixelT const *values, afwImage::MaskPixel const *masks) {
+    bool const isNanSafe = _sctrl.getNanSafe();
+    afwImage::MaskPixel const andMask = _sctrl.getAndMask();
+
+    int n = 0;
+    for (int i = 0; i < _nImages; ++i) {
+        if (!(isNanSafe && lsst::utils::isnan(static_cast<float>(values[i]))) && !(masks[i] & andMask)) {
+            _goodValues[n++] = values[i];
+        }
+    }
+    return n;
+}
+
+/*
+ * Sort the first n values of _goodValues
+ */
+template <typename PixelT>
+void PixelStackStatistics<PixelT>::_sort(int n) {
+    typename std::vector<PixelT>::iterator const begin = _goodValues.begin();
+    if (n > MAX_INSERTION_SORT) {
+        std::sort(begin, begin + n);
+        return;
+    }
+    for (int i = 1; i < n; ++i) {
+        PixelT const val = _goodValues[i];
+        int j = i;
+        for (; j > 0 && val < _goodValues[j - 1]; --j) {
+            _goodValues[j] = _goodValues[j - 1];
+        }
+        _goodValues[j] = val;
+    }
+}
+
+/*
+ * Interpolate linearly between the sorted values adjacent to (fractional) index idx
+ */
+template <typename PixelT>
+double PixelStackStatistics<PixelT>::_interpolate(double idx) const {
+    int const qa = static_cast<int>(idx);
+    int const qb = qa + 1;
+    double const wa = (static_cast<double>(qb) - idx);
+    double const wb = (idx - static_cast<double>(qa));
+    return wa*static_cast<double>(_goodValues[qa]) + wb*static_cast<double>(_goodValues[qb]);
+}
+
+/*
+ * Return the median of the first n values of _goodValues (which are reordered)
+ */
+template <typename PixelT>
+double PixelStackStatistics<PixelT>::_median(int n) {
+    if (n > MAX_INSERTION_SORT) {
+        double const idx = 0.5*(n - 1);
+        typename std::vector<PixelT>::iterator const mid1 = _goodValues.begin() + static_cast<int>(idx);
+        typename std::vector<PixelT>::iterator const mid2 = mid1 + 1;
+        std::nth_element(_goodValues.begin(), mid2, _goodValues.begin() + n);
+        std::nth_element(_goodValues.begin(), mid1, mid2);
+        return _interpolate(idx);
+    } else if (n > 1) {
+        _sort(n);
+        return _interpolate(0.5*(n - 1));
+    } else if (n == 1) {
+        return _goodValues[0];
+    } else {
+        return NaN;
+    }
+}
+
+template <typename PixelT>
+void PixelStackStatistics<PixelT>::compute(
+        afwMath::Property flags,                    ///< statistic to compute (ERRORS is ignored)
+        PixelT const *values,                       ///< value of the pixel in each image
+        afwImage::MaskPixel const *masks,           ///< mask of the pixel in each image
+        afwImage::VariancePixel const *weights,     ///< weight of each value (if weighted)
+        double &value,                              ///< value of the statistic
+        double &error,                              ///< error in the statistic
+        int &npoint,                                ///< number of points used (NPOINT)
+        afwImage::MaskPixel &orMask                 ///< OR of the masks of the good pixels
+) {
+    int const prop = flags & ~afwMath::ERRORS;
+
+    int n;
+    double sum, sumx2, wsum;
+    _sum(values, masks, weights, 0.0, false, 0.0, n, sum, sumx2, wsum, orMask);
+    double const meanCrude = (n > 0) ? sum/n : 0.0;
+    _sum(values, masks, weights, meanCrude, false, 0.0, n, sum, sumx2, wsum, orMask);
+    double mean, variance;
+    _meanVariance(n, sum, sumx2, wsum, meanCrude, mean, variance);
+    npoint = n;
+
+    if (prop == afwMath::MEAN) {
+        value = mean;
+        error = std::sqrt(variance/npoint);
+        return;
+    }
+
+    int const nGood = _copyGoodValues(values, masks);
+    if (prop == afwMath::MEDIAN) {
+        value = _median(nGood);
+        error = std::sqrt(afwGeom::HALFPI*variance/npoint);
+        return;
+    }
+
+    assert(prop == afwMath::MEANCLIP);
+    double median = NaN;
+    double iqrange = NaN;
+    if (nGood > 1) {
+        _sort(nGood);
+        median = _interpolate(0.50*(nGood - 1));
+        iqrange = _interpolate(0.75*(nGood - 1)) - _interpolate(0.25*(nGood - 1));
+    } else if (nGood == 1) {
+        median = _goodValues[0];
+        iqrange = 0.0;
+    }
+
+    double meanClip = NaN;
+    double varianceClip = NaN;
+    for (int iter = 0; iter < _sctrl.getNumIter(); ++iter) {
+        double const center = (iter > 0) ? meanClip : median;
+        double const hwidth = (iter > 0 && npoint > 1) ?
+            _sctrl.getNumSigmaClip()*std::sqrt(varianceClip) :
+            _sctrl.getNumSigmaClip()*IQ_TO_STDEV*iqrange;
+        if (lsst::utils::isnan(center) || lsst::utils::isnan(hwidth)) {
+            meanClip = varianceClip = NaN;
+            continue;
+        }
+
+        afwImage::MaskPixel clipOrMask;
+        _sum(values, masks, weights, center, true, hwidth, n, sum, sumx2, wsum, clipOrMask);
+        _meanVariance(n, sum, sumx2, wsum, center, meanClip, varianceClip);
+        npoint = n;
+    }
+    value = meanClip;
+    error = std::sqrt(varianceClip/npoint);
+}
+
+/*
+ * Buffers for one tile of a stack; the value for image i of pixel x of the tile is at [x*nImages + i]
+ */
+template <typename PixelT>
+struct StackTile {
+    StackTile(int nImages, int width) :
+        nImages(nImages),
+        width(std::max(1, std::min(width, TILE_BUFFER_SIZE/nImages))),
+        values(this->width*nImages),
+        masks(this->width*nImages, 0x0),
+        variances(this->width*nImages, 0.0)
+    {}
+
+    int nImages;
+    int width;                                      ///< maximum number of pixels in the tile
+    std::vector<PixelT> values;
+    std::vector<afwImage::MaskPixel> masks;         ///< all 0 for Images
+    std::vector<afwImage::VariancePixel> variances; ///< all 0 for Images
+};
+
+/*
+ * Compute the statistic of one pixel of a tile, either directly or using a Statistics object
+ */
+template <typename PixelT, bool UseVariance>
+void computeStackPixel(
+        StackTile<PixelT> const &tile,
+        int x,                                      ///< index of pixel in tile
+        afwMath::Property flags,
+        afwMath::StatisticsControl const &sctrl,
+        std::vector<afwImage::VariancePixel> const &weights, ///< per-image weights if UseVariance
+        PixelStackStatistics<PixelT> &pixelStats,
+        afwMath::MaskedVector<PixelT> &pixelSet,    ///< for other statistics; weights already loaded
+        double &value,
+        double &error,
+        int &npoint,
+        afwImage::MaskPixel &orMask
+) {
+    int const offset = x*tile.nImages;
+    if (isFastStatistic(flags)) {
+        pixelStats.compute(flags, &tile.values[offset], &tile.masks[offset],
+                           UseVariance ? &weights[0] : &tile.variances[offset],
+                           value, error, npoint, orMask);
+        return;
+    }
+
+    typename afwMath::MaskedVector<PixelT>::iterator psPtr = pixelSet.begin();
+    for (int i = 0; i < tile.nImages; ++i, ++psPtr) {
+        psPtr.value() = tile.values[offset + i];
+        psPtr.mask() = tile.masks[offset + i];
+        if (!UseVariance) {
+            psPtr.variance() = tile.variances[offset + i];
+        }
+    }
+    afwMath::Statistics stat =
+        afwMath::makeStatistics(pixelSet, flags | afwMath::NPOINT | afwMath::ERRORS, sctrl);
+    value = stat.getValue(flags);
+    error = stat.getError(flags);
+    npoint = stat.getValue(afwMath::NPOINT);
+    orMask = stat.getOrMask();
+}
+
+/*
+ * Stack rows [rowBegin, rowEnd) of a list of MaskedImages
+ */
+template<typename PixelT, bool UseVariance>
+void stackMaskedImageRows(
+        std::vector<typename afwImage::MaskedImage<PixelT>::Ptr > const &images,
+        afwMath::Property flags,
+        afwMath::StatisticsControl const &sctrl,    ///< weighting has been set if UseVariance
+        std::vector<afwImage::VariancePixel> const &weights,
+        afwImage::MaskedImage<PixelT> &imgStack,
+        int rowBegin,
+        int rowEnd
+) {
+    typedef typename afwImage::MaskedImage<PixelT>::x_iterator x_iterator;
+
+    int const nImages = images.size();
+    int const width = imgStack.getWidth();
+    StackTile<PixelT> tile(nImages, width);
+    PixelStackStatistics<PixelT> pixelStats(sctrl, nImages);
+    afwMath::MaskedVector<PixelT> pixelSet(nImages);
+    if (UseVariance) {
+        loadVariance(weights, pixelSet);
+    }
+
+    for (int y = rowBegin; y != rowEnd; ++y) {
+        x_iterator ptr = imgStack.row_begin(y);
+        for (int tileX0 = 0; tileX0 < width; tileX0 += tile.width) {
+            int const tileWidth = std::min(tile.width, width - tileX0);
+
+            for (int i = 0; i < nImages; ++i) {
+                x_iterator inPtr = images[i]->x_at(tileX0, y);
+                for (int x = 0, j = i; x < tileWidth; ++x, ++inPtr, j += nImages) {
+                    tile.values[j] = inPtr.image();
+                    tile.masks[j] = inPtr.mask();
+                    tile.variances[j] = inPtr.variance();
+                }
+            }
+
+            for (int x = 0; x < tileWidth; ++x, ++ptr) {
+                double value, error;
+                int npoint;
+                afwImage::MaskPixel msk;
+                computeStackPixel<PixelT, UseVariance>(tile, x, flags, sctrl, weights, pixelStats, pixelSet,
+                                                       value, error, npoint, msk);
+
+                PixelT variance = ::pow(error, 2);
+                if (npoint == 0) {
+                    msk = sctrl.getNoGoodPixelsMask();
+                } else if (npoint == 1) {   // the population variance is NaN (we divided by N - 1)
+                    assert(lsst::utils::isnan(variance));
+                    int ngood = 0;          // good (based on mask checks)
+                    for (int i = 0, j = x*nImages; i < nImages; ++i, ++j) {
+                        if (!(tile.masks[j] & sctrl.getAndMask())) {
+                            ++ngood;
+                            variance = tile.variances[j];
+                        }
+                    }
+#if 0
+                    assert(ngood == 1); // we don't handle the case that images were clipped so ngood > npoint
+#else
+                    if (ngood != 1) {
+                        assert(ngood > 1);
+                        std::cerr << "ngood = " << ngood << " complain to RHL" << std::endl;
+                    }
+#endif
+                }
+
+                *ptr = typename afwImage::MaskedImage<PixelT>::Pixel(value, msk, variance);
+            }
+        }
+    }
+}
+
+/*
+ * Stack rows [rowBegin, rowEnd) of a list of Images
+ */
+template<typename PixelT, bool UseVariance>
+void stackImageRows(
+        std::vector<typename afwImage::Image<PixelT>::Ptr > const &images,
+        afwMath::Property flags,
+        afwMath::StatisticsControl const &sctrl,    ///< weighting has been set if UseVariance
+        std::vector<afwImage::VariancePixel> const &weights,
+        afwImage::Image<PixelT> &imgStack,
+        int rowBegin,
+        int rowEnd
+) {
+    typedef typename afwImage::Image<PixelT>::x_iterator x_iterator;
+
+    int const nImages = images.size();
+    int const width = imgStack.getWidth();
+    StackTile<PixelT> tile(nImages, width);
+    PixelStackStatistics<PixelT> pixelStats(sctrl, nImages);
+    afwMath::MaskedVector<PixelT> pixelSet(nImages);
+    if (UseVariance) {
+        loadVariance(weights, pixelSet);
+    }
+
+    for (int y = rowBegin; y != rowEnd; ++y) {
+        x_iterator ptr = imgStack.row_begin(y);
+        for (int tileX0 = 0; tileX0 < width; tileX0 += tile.width) {
+            int const tileWidth = std::min(tile.width, width - tileX0);
+
+            for (int i = 0; i < nImages; ++i) {
+                x_iterator inPtr = images[i]->x_at(tileX0, y);
+                for (int x = 0, j = i; x < tileWidth; ++x, ++inPtr, j += nImages) {
+                    tile.values[j] = *inPtr;
+                }
+            }
+
+            for (int x = 0; x < tileWidth; ++x, ++ptr) {
+                double value, error;
+                int npoint;
+                afwImage::MaskPixel msk;
+                computeStackPixel<PixelT, UseVariance>(tile, x, flags, sctrl, weights, pixelStats, pixelSet,
+                                                       value, error, npoint, msk);
+                *ptr = value;
+            }
+        }
+    }
+}
+
+/*
+ * Convert a vector of weights to the type stored in a variance plane
+ */
+template<typename PixelT>
+std::vector<afwImage::VariancePixel> makeWeights(std::vector<PixelT> const &wvector) {
+    return std::vector<afwImage::VariancePixel>(wvector.begin(), wvector.end());
+}
+
+/*
+ * Split the output rows into one band per thread and stack each band
+ */
+template<typename ImageT, typename StackRowsFunctionT>
+void stackInParallel(
+        StackRowsFunctionT stackRows,   ///< function to stack a band of rows
+        std::vector<typename ImageT::Ptr> const &images,
+        afwMath::Property flags,
+        afwMath::StatisticsControl const &sctrl,
+        std::vector<afwImage::VariancePixel> const &weights,
+        ImageT &imgStack
+) {
+    int const nThreads = mathDetail::computeNThreads(sctrl.getNThreads());
+    std::vector<int> const bandEdges = mathDetail::computeBandEdges(0, imgStack.getHeight(), nThreads);
+    std::vector<boost::function<void ()> > functorList;
+    for (std::size_t band = 0; band + 1 < bandEdges.size(); ++band) {
+        functorList.push_back(boost::bind(stackRows, boost::cref(images), flags, boost::cref(sctrl),
+                                          boost::cref(weights), boost::ref(imgStack),
+                                          bandEdges[band], bandEdges[band + 1]));
+    }
+    mathDetail::runInParallel(functorList);
+}
+
+} // end anonymous namespace
+
+
 /****************************************************************************
  *
  * stack MaskedImages
@@ -116,81 +623,15 @@ typename afwImage::MaskedImage<PixelT>::Ptr computeMaskedImageStack(
     typedef afwImage::MaskedImage<PixelT> Image;
     typename Image::Ptr imgStack(new Image(images[0]->getDimensions()));
 
-    // get a list of row_begin iterators
-    typedef typename afwImage::MaskedImage<PixelT>::x_iterator x_iterator;
-    std::vector<x_iterator> rows;
-    rows.reserve(images.size());
-
-    // get a list to contain a pixel from x,y for each image
-    afwMath::MaskedVector<PixelT> pixelSet(images.size());
-    afwMath::StatisticsControl sctrlTmp(sctrl);
-
     // if we're forcing the user variances ...
+    afwMath::StatisticsControl sctrlTmp(sctrl);
     if (UseVariance) {
         sctrlTmp.setWeighted(true);
         sctrlTmp.setMultiplyWeights(true);
-        loadVariance(wvector, pixelSet); // put them in the variance vector
     }
 
-    // loop over x,y ... the loop over the stack to fill pixelSet
-    // - get the stats on pixelSet and put the value in the output image at x,y
-    for (int y = 0; y != imgStack->getHeight(); ++y) {
-
-        for (unsigned int i = 0; i < images.size(); ++i) {
-            x_iterator ptr = images[i]->row_begin(y);
-            if (y == 0) {
-                rows.push_back(ptr);
-            } else {
-                rows[i] = ptr;
-            }
-        }
-
-        for (x_iterator ptr = imgStack->row_begin(y), end = imgStack->row_end(y); ptr != end; ++ptr) {
-            typename afwMath::MaskedVector<PixelT>::iterator psPtr = pixelSet.begin();
-            afwImage::MaskPixel msk(0x0);
-            for (unsigned int i = 0; i < images.size(); ++i, ++psPtr) {
-                afwImage::MaskPixel mskTmp = rows[i].mask();
-                psPtr.value() = rows[i].image();
-                psPtr.mask()  = mskTmp;
-
-                // if we're not using the wvector weights, use the variance plane.
-                if (! UseVariance) {
-                    psPtr.variance() = rows[i].variance();
-                }
-
-                ++rows[i];
-            }
-            afwMath::Statistics stat =
-                afwMath::makeStatistics(pixelSet, flags | afwMath::NPOINT | afwMath::ERRORS, sctrlTmp);
-            
-            PixelT variance = ::pow(stat.getError(flags), 2);
-            msk = stat.getOrMask();
-            int const npoint = stat.getValue(afwMath::NPOINT);
-            if (npoint == 0) {
-                msk = sctrlTmp.getNoGoodPixelsMask();
-            } else if (npoint == 1) {   // the population variance is NaN (we divided by N - 1)
-                assert(lsst::utils::isnan(variance));
-                int ngood = 0;          // good (based on mask checks)
-                for (unsigned int i = 0; i < images.size(); ++i) {
-                    x_iterator ptr = rows[i]; ptr += -1;
-                    if (!(ptr.mask() & sctrl.getAndMask())) {
-                        ++ngood;
-                        variance = ptr.variance();
-                    }
-                }
-#if 0
-                assert(ngood == 1);     // we don't handle the case that images were clipped so ngood > npoint
-#else
-                if (ngood != 1) {
-                    assert(ngood > 1);
-                    std::cerr << "ngood = " << ngood << " complain to RHL" << std::endl;
-                }
-#endif
-            }
-
-            *ptr = typename afwImage::MaskedImage<PixelT>::Pixel(stat.getValue(flags), msk, variance);
-        }
-    }
+    stackInParallel(&stackMaskedImageRows<PixelT, UseVariance>, images, flags, sctrlTmp,
+                    makeWeights(wvector), *imgStack);
 
     return imgStack;
 
@@ -242,6 +683,120 @@ typename afwImage::MaskedImage<PixelT>::Ptr afwMath::statisticsStack(
 
 
 
+/****************************************************************************
+ *
+ * stack MaskedImages in FITS files
+ *
+ ****************************************************************************/
+
+/**
+ * @brief A function to compute some statistics of a stack of MaskedImages stored in FITS files
+ * @relates Statistics
+ *
+ * The stack is computed a band of bandHeight rows at a time: the band is read from each input
+ * (with fits_read_subset), stacked as by statisticsStack, and written to the output. Only one band of
+ * each input is in memory at any time, so the memory needed is about
+ * (fileNames.size() + 1)*bandHeight*width*(sizeof(PixelT) + 6) bytes, independent of the image height.
+ *
+ * The inputs must all be MEF files of MaskedImages of the same dimensions; the output is an MEF file
+ * (as written by MaskedImage::writeFits) with the same dimensions and xy0 = (0, 0).
+ *
+ * @throw lsst::pex::exceptions::LengthErrorException if there are no inputs, or they have different
+ *  dimensions
+ * @throw lsst::pex::exceptions::InvalidParameterException if bandHeight < 1, more than one statistic is
+ *  requested, or wvector is neither empty nor the same length as fileNames
+ */
+template<typename PixelT>
+void afwMath::statisticsStackFits(
+        std::string const& outFileName,             ///< MEF file to write the stacked MaskedImage to
+        std::vector<std::string> const& fileNames,  ///< MEF files of the MaskedImages to process
+        afwMath::Property flags,                    ///< Desired statistic (only one!)
+        afwMath::StatisticsControl const& sctrl,    ///< Fine control over processing
+        std::vector<PixelT> const &wvector,         ///< optional weights vector
+        int bandHeight                              ///< number of rows to read from each file at a time
+                                 ) {
+    typedef afwImage::MaskedImage<PixelT> MaskedImageT;
+
+    if (fileNames.size() == 0) {
+        throw LSST_EXCEPT(ex::LengthErrorException, "Please specify at least one file");
+    }
+    if (bandHeight < 1) {
+        throw LSST_EXCEPT(ex::InvalidParameterException,
+                          (boost::format("bandHeight = %d must be >= 1") % bandHeight).str());
+    }
+    checkOnlyOneFlag(flags);
+    if (wvector.size() != 0 && wvector.size() != fileNames.size()) {
+        throw LSST_EXCEPT(ex::InvalidParameterException,
+                          "Weight vector must have same length as number of MaskedImages to be stacked.");
+    }
+    //
+    // Check the dimensions of the inputs (the image is in the first HDU that has data)
+    //
+    afwGeom::Extent2I dimensions;
+    for (std::vector<std::string>::const_iterator fileName = fileNames.begin();
+         fileName != fileNames.end(); ++fileName) {
+        lsst::daf::base::PropertySet::Ptr metadata(new lsst::daf::base::PropertyList);
+        afwImage::detail::fits_reader reader(*fileName, metadata, 0, true);
+        if (fileName == fileNames.begin()) {
+            dimensions = reader.getDimensions();
+        } else if (reader.getDimensions() != dimensions) {
+            throw LSST_EXCEPT(ex::LengthErrorException,
+                              (boost::format("%s is %dx%d, but %s is %dx%d") %
+                               *fileName % reader.getDimensions().getX() % reader.getDimensions().getY() %
+                               fileNames[0] % dimensions.getX() % dimensions.getY()).str());
+        }
+    }
+    //
+    // Create the output file: a PDU, then the image, mask and variance HDUs (which we fill in band by band).
+    // If anything goes wrong we remove it rather than leave a partly-written stack behind
+    //
+    try {
+        int const imageHdu = 2, maskHdu = 3, varianceHdu = 4;
+        afwImage::detail::fits_writer writer(outFileName, "w");
+        writer.create_image<PixelT>(afwGeom::Extent2I(0, 0), lsst::daf::base::PropertySet::Ptr());
+
+        lsst::daf::base::PropertySet::Ptr metadata(new lsst::daf::base::PropertyList);
+        metadata->set("EXTTYPE", "IMAGE");
+        writer.create_image<PixelT>(dimensions, metadata);
+
+        metadata.reset(new lsst::daf::base::PropertyList);
+        afwImage::Mask<afwImage::MaskPixel>::addMaskPlanesToMetadata(metadata);
+        metadata->set("EXTTYPE", "MASK");
+        writer.create_image<afwImage::MaskPixel>(dimensions, metadata);
+
+        metadata.reset(new lsst::daf::base::PropertyList);
+        metadata->set("EXTTYPE", "VARIANCE");
+        writer.create_image<afwImage::VariancePixel>(dimensions, metadata);
+
+        for (int y0 = 0; y0 < dimensions.getY(); y0 += bandHeight) {
+            afwGeom::Box2I const bbox(afwGeom::Point2I(0, y0),
+                                      afwGeom::Extent2I(dimensions.getX(),
+                                                        std::min(bandHeight, dimensions.getY() - y0)));
+            std::vector<typename MaskedImageT::Ptr> images;
+            images.reserve(fileNames.size());
+            for (std::vector<std::string>::const_iterator fileName = fileNames.begin();
+                 fileName != fileNames.end(); ++fileName) {
+                images.push_back(typename MaskedImageT::Ptr(
+                                     new MaskedImageT(*fileName, 0, lsst::daf::base::PropertySet::Ptr(),
+                                                      bbox, afwImage::LOCAL)));
+            }
+
+            typename MaskedImageT::Ptr band = afwMath::statisticsStack<PixelT>(images, flags, sctrl, wvector);
+            images.clear();                 // release the input bands before writing
+
+            writer.write_rows<PixelT>(imageHdu, y0, band->getImage()->getArray());
+            writer.write_rows<afwImage::MaskPixel>(maskHdu, y0, band->getMask()->getArray());
+            writer.write_rows<afwImage::VariancePixel>(varianceHdu, y0, band->getVariance()->getArray());
+        }
+    } catch (...) {
+        (void)std::remove(outFileName.c_str()); // the writer's already closed the file
+        throw;
+    }
+}
+
+
+
+
 /****************************************************************************
  *
  * stack Images
@@ -270,38 +825,16 @@ typename afwImage::Image<PixelT>::Ptr computeImageStack(
     typedef afwImage::Image<PixelT> Image;
     typename Image::Ptr imgStack(new Image(images[0]->getDimensions(), 0.0));
 
-    afwMath::StatisticsControl sctrlTmp(sctrl);
-    afwMath::MaskedVector<typename Image::Pixel> pixelSet(images.size());
-
-    // set the mask to be an infinite iterator
-    afwMath::MaskImposter<afwImage::MaskPixel> msk;
-
     // if we're going to use contant weights
+    afwMath::StatisticsControl sctrlTmp(sctrl);
     if ( UseVariance ) {
         sctrlTmp.setWeighted(true);
         sctrlTmp.setMultiplyWeights(true);
-        // copy the weights in to the variance vector
-        loadVariance(wvector, pixelSet);
-    }
-        
-    // get the desired statistic
-    for (int y = 0; y != imgStack->getHeight(); ++y) {
-        for (int x = 0; x != imgStack->getWidth(); ++x) {
-            for (unsigned int i = 0; i != images.size(); ++i) {
-                (*pixelSet.getImage())(i, 0) = (*images[i])(x, y);
-            }
-            if (UseVariance) {
-                afwMath::Statistics stat =
-                    afwMath::makeStatistics(*pixelSet.getImage(), msk, *pixelSet.getVariance(),
-                                         flags, sctrlTmp);
-                (*imgStack)(x, y) = stat.getValue();
-            } else {
-                afwMath::Statistics stat = afwMath::makeStatistics(pixelSet, flags, sctrlTmp);
-                (*imgStack)(x, y) = stat.getValue();
-            }
-        }
     }
 
+    stackInParallel(&stackImageRows<PixelT, UseVariance>, images, flags, sctrlTmp,
+                    makeWeights(wvector), *imgStack);
+
     return imgStack;
 }
 
@@ -319,6 +852,9 @@ typename afwImage::Image<PixelT>::Ptr afwMath::statisticsStack(
         afwMath::StatisticsControl const& sctrl,
         std::vector<PixelT> const &wvector
                                                         ) {
+    if (images.size() == 0) {
+        throw LSST_EXCEPT(lsst::pex::exceptions::LengthErrorException, "Please specify at least one image");
+    }
 
     checkOnlyOneFlag(flags);
 
@@ -579,6 +1115,13 @@ typename afwImage::MaskedImage<PixelT>::Ptr afwMath::statisticsStack(
             afwMath::Property flags, \
             afwMath::StatisticsControl const& sctrl,    \
             std::vector<TYPE> const &wvector);                          \
+    template void afwMath::statisticsStackFits<TYPE>( \
+            std::string const& outFileName, \
+            std::vector<std::string> const& fileNames, \
+            afwMath::Property flags, \
+            afwMath::StatisticsControl const& sctrl,    \
+            std::vector<TYPE> const &wvector, \
+            int bandHeight); \
     template boost::shared_ptr<std::vector<TYPE> > afwMath::statisticsStack<TYPE>( \
             std::vector<boost::shared_ptr<std::vector<TYPE> > > &vectors, \
             afwMath::Property flags, \
@@ -30,9 +30,13 @@
  * @author Steve Bickerton
  * @ingroup afw
  */
+#include <algorithm>
+#include <cassert>
+#include <cstring>
 #include <iostream>
 #include <limits>
 #include <cmath>
+#include "boost/cstdint.hpp"
 #include "boost/shared_ptr.hpp"
 #include "lsst/pex/exceptions.h"
 #include "lsst/afw/image/Image.h"
@@ -144,6 +148,235 @@ typedef CheckValueGtMax ChkMax;
 typedef CheckClipRange  ChkClip;    
 typedef AlwaysTrue      AlwaysT;
 typedef AlwaysFalse     AlwaysF;
+
+/*
+ * Order-preserving maps between pixel values and unsigned integer keys, used to select quantiles
+ * by radix selection (for any two non-NaN values, a < b implies toKey(a) < toKey(b))
+ */
+template<typename T>
+struct RadixTraits {};
+
+template<>
+struct RadixTraits<boost::uint16_t> {
+    typedef boost::uint16_t Key;
+    static Key toKey(boost::uint16_t val) { return val; }
+    static boost::uint16_t fromKey(Key key) { return key; }
+};
+
+template<>
+struct RadixTraits<int> {
+    typedef boost::uint32_t Key;
+    static Key toKey(int val) { return static_cast<Key>(val) ^ 0x80000000u; }
+    static int fromKey(Key key) { return static_cast<int>(key ^ 0x80000000u); }
+};
+
+template<>
+struct RadixTraits<float> {
+    typedef boost::uint32_t Key;
+    static Key toKey(float val) {
+        Key bits;
+        std::memcpy(&bits, &val, sizeof(bits));
+        return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+    }
+    static float fromKey(Key key) {
+        Key const bits = (key & 0x80000000u) ? (key & ~0x80000000u) : ~key;
+        float val;
+        std::memcpy(&val, &bits, sizeof(val));
+        return val;
+    }
+};
+
+template<>
+struct RadixTraits<double> {
+    typedef boost::uint64_t Key;
+    static Key const SIGN_BIT = static_cast<Key>(1) << 63;
+    static Key toKey(double val) {
+        Key bits;
+        std::memcpy(&bits, &val, sizeof(bits));
+        return (bits & SIGN_BIT) ? ~bits : (bits | SIGN_BIT);
+    }
+    static double fromKey(Key key) {
+        Key const bits = (key & SIGN_BIT) ? (key & ~SIGN_BIT) : ~key;
+        double val;
+        std::memcpy(&val, &bits, sizeof(val));
+        return val;
+    }
+};
+
+int const RADIX_BITS = 16;                      // number of bits in a digit of a key
+int const RADIX_SIZE = 1 << RADIX_BITS;         // number of values of a digit
+
+/*
+ * A functor to histogram one digit of the keys of the values whose higher digits
+ * match one of a set of prefixes (there's a histogram for each prefix)
+ */
+template<typename T>
+class DigitHistogram {
+public:
+    typedef typename RadixTraits<T>::Key Key;
+
+    DigitHistogram(int shift,                           // shift to move the digit to the low bits
+                   std::vector<Key> const &prefixes     // the desired higher digits; ignored for top digit
+                  ) :
+        _shift(shift), _isTopDigit(shift + RADIX_BITS >= static_cast<int>(8*sizeof(Key))),
+        _prefixes(prefixes), _counts(std::max<std::size_t>(prefixes.size(), 1)*RADIX_SIZE, 0) {}
+
+    void operator()(T val) {
+        Key const key = RadixTraits<T>::toKey(val);
+        int const digit = static_cast<int>((key >> _shift) & (RADIX_SIZE - 1));
+        if (_isTopDigit) {
+            ++_counts[digit];
+            return;
+        }
+        Key const prefix = key >> (_shift + RADIX_BITS);
+        for (std::size_t i = 0; i != _prefixes.size(); ++i) {
+            if (prefix == _prefixes[i]) {
+                ++_counts[i*RADIX_SIZE + digit];
+                return;
+            }
+        }
+    }
+
+    /// Return the histogram for the i'th prefix
+    int const *getCounts(int i) const { return &_counts[i*RADIX_SIZE]; }
+private:
+    int _shift;
+    bool _isTopDigit;
+    std::vector<Key> _prefixes;
+    std::vector<int> _counts;
+};
+
+/*
+ * Return the digit containing the value of the given rank in a histogram, and
+ * set rank to the rank of the value among those with that digit
+ */
+int findDigit(int const *counts, int &rank) {
+    int cumulative = 0;
+    for (int digit = 0; digit != RADIX_SIZE; ++digit) {
+        if (rank < cumulative + counts[digit]) {
+            rank -= cumulative;
+            return digit;
+        }
+        cumulative += counts[digit];
+    }
+    assert(false);
+    return RADIX_SIZE - 1;
+}
+
+/*
+ * Compute percentiles (interpolated between order statistics, as Statistics::_percentile does)
+ * of the values visited by source.apply(), without copying or reordering them.
+ *
+ * The order statistics are found by radix selection on the values' keys, one 16-bit digit
+ * (so one pass through the values) at a time, starting with the most significant: one pass for
+ * 16-bit integers, two for 32-bit ints and floats, and four for doubles.  All the order statistics
+ * needed are found in the same passes.  The values must not include NaNs.
+ */
+template<typename T, typename SourceT>
+std::vector<double> computePercentiles(SourceT const &source, std::vector<double> const &percentiles) {
+    typedef typename RadixTraits<T>::Key Key;
+    int const nDigit = sizeof(Key)*8/RADIX_BITS;
+
+    // Histogram the top digit; this tells us how many values there are
+    DigitHistogram<T> topHist((nDigit - 1)*RADIX_BITS, std::vector<Key>());
+    source.apply(topHist);
+    int n = 0;
+    for (int digit = 0; digit != RADIX_SIZE; ++digit) {
+        n += topHist.getCounts(0)[digit];
+    }
+    if (n == 0) {
+        return std::vector<double>(percentiles.size(), NaN);
+    }
+
+    // The ranks of the order statistics that we need (two for each percentile)
+    std::vector<int> ranks;
+    for (std::vector<double>::const_iterator ptr = percentiles.begin(); ptr != percentiles.end(); ++ptr) {
+        int const qa = static_cast<int>(*ptr*(n - 1));
+        ranks.push_back(qa);
+        ranks.push_back(std::min(qa + 1, n - 1));
+    }
+    int const nRank = ranks.size();
+    std::vector<Key> prefixes(nRank);     // the digits found so far for each rank
+    for (int i = 0; i != nRank; ++i) {
+        prefixes[i] = findDigit(topHist.getCounts(0), ranks[i]);
+    }
+    // Now the lower digits, only histogramming values that have one of the desired prefixes
+    for (int iDigit = nDigit - 2; iDigit >= 0; --iDigit) {
+        std::vector<Key> uniquePrefixes;
+        std::vector<int> slots(nRank);
+        for (int i = 0; i != nRank; ++i) {
+            slots[i] = std::find(uniquePrefixes.begin(), uniquePrefixes.end(), prefixes[i]) -
+                uniquePrefixes.begin();
+            if (slots[i] == static_cast<int>(uniquePrefixes.size())) {
+                uniquePrefixes.push_back(prefixes[i]);
+            }
+        }
+        DigitHistogram<T> hist(iDigit*RADIX_BITS, uniquePrefixes);
+        source.apply(hist);
+        for (int i = 0; i != nRank; ++i) {
+            prefixes[i] = (prefixes[i] << RADIX_BITS) | findDigit(hist.getCounts(slots[i]), ranks[i]);
+        }
+    }
+
+    std::vector<double> results;
+    for (std::size_t i = 0; i != percentiles.size(); ++i) {
+        double const val1 = static_cast<double>(RadixTraits<T>::fromKey(prefixes[2*i]));
+        if (n == 1) {
+            results.push_back(val1);
+            continue;
+        }
+        double const val2 = static_cast<double>(RadixTraits<T>::fromKey(prefixes[2*i + 1]));
+        double const idx = percentiles[i]*(n - 1);
+        int const q1 = static_cast<int>(idx);
+        int const q2 = q1 + 1;
+        double const w1 = (static_cast<double>(q2) - idx);
+        double const w2 = (idx - static_cast<double>(q1));
+        results.push_back(w1*val1 + w2*val2);
+    }
+    return results;
+}
+
+/*
+ * Sources of values for computePercentiles: the unmasked finite pixels of an image, or a vector of values
+ */
+template<typename ImageT, typename MaskT>
+class GoodImageValues {
+public:
+    GoodImageValues(ImageT const &img, MaskT const &msk, int andMask) :
+        _img(img), _msk(msk), _andMask(andMask) {}
+
+    template<typename VisitorT>
+    void apply(VisitorT &visitor) const {
+        for (int iY = 0; iY < _img.getHeight(); ++iY) {
+            typename MaskT::x_iterator mptr = _msk.row_begin(iY);
+            for (typename ImageT::x_iterator ptr = _img.row_begin(iY), end = ptr + _img.getWidth();
+                 ptr != end; ++ptr, ++mptr) {
+                if (CheckFinite()(*ptr) && !(*mptr & _andMask)) {
+                    visitor(*ptr);
+                }
+            }
+        }
+    }
+private:
+    ImageT const &_img;
+    MaskT const &_msk;
+    int _andMask;
+};
+
+template<typename T>
+class VectorValues {
+public:
+    explicit VectorValues(std::vector<T> const &values) : _values(values) {}
+
+    template<typename VisitorT>
+    void apply(VisitorT &visitor) const {
+        for (typename std::vector<T>::const_iterator ptr = _values.begin(); ptr != _values.end(); ++ptr) {
+            visitor(*ptr);
+        }
+    }
+private:
+    std::vector<T> const &_values;
+};
     
 }
 
@@ -174,38 +407,6 @@ afwMath::Property afwMath::stringToStatisticsProperty(std::string const property
     return statisticsProperty[property];
 }
 
-/**
- * @brief A private function to copy an image into a vector
- *
- * This is used for percentile and iq_range as these must reorder the values.
- * Because it loops over the pixels, it's been templated over the NaN test to avoid
- * code repetition of the loops.
- */
-template<typename IsFinite, typename ImageT, typename MaskT, typename VarianceT>
-boost::shared_ptr<std::vector<typename ImageT::Pixel> > afwMath::Statistics::_makeVectorCopy(
-        ImageT const &img,
-        MaskT const &msk,
-        VarianceT const &,
-        int const
-                                                                                         )
-{
-
-    // Note to self: I'm not going to keep track of allPixelOrMask here ... sumImage() does that
-    // and it always gets called
-    boost::shared_ptr<std::vector<typename ImageT::Pixel> > imgcp(new std::vector<typename ImageT::Pixel>(0));
-    for (int i_y = 0; i_y < img.getHeight(); ++i_y) {
-        typename MaskT::x_iterator mptr = msk.row_begin(i_y);
-        for (typename ImageT::x_iterator ptr = img.row_begin(i_y), end = img.row_end(i_y); ptr != end; ++ptr) {
-            if ( IsFinite()(*ptr) && !(*mptr & _sctrl.getAndMask()) ) {
-                imgcp->push_back(*ptr);
-            }
-            ++mptr;
-        }
-    }
-    return imgcp;
-}
-
-
 /**
  * @brief Constructor for Statistics object
  *
@@ -234,8 +435,16 @@ afwMath::Statistics::Statistics(
     // Check that an int's large enough to hold the number of pixels
     assert(img.getWidth()*static_cast<double>(img.getHeight()) < std::numeric_limits<int>::max());
 
-    // get the standard statistics
-    StandardReturn standard = _getStandard(img, msk, var, flags);
+    // get the standard statistics; if we need to clip (or to find the median or quartiles by reordering
+    // the values) copy the good values as we go
+    bool const isClipping = flags & (MEANCLIP | STDEVCLIP | VARIANCECLIP);
+    bool const needQuantiles = flags & (MEDIAN | IQRANGE | MEANCLIP | STDEVCLIP | VARIANCECLIP);
+    bool const useHistogram = _sctrl.getHistogramQuantiles() && _sctrl.getNanSafe();
+    bool const needValues = isClipping || (needQuantiles && !useHistogram);
+    std::vector<typename ImageT::Pixel> values;             // the values of the good pixels, in order
+    std::vector<afwImage::VariancePixel> weights;           // their weights (if weighted)
+    StandardReturn standard = needValues ?
+        _getStandard(img, msk, var, flags, values, weights) : _getStandard(img, msk, var, flags);
 
     _mean = standard.get<0>();
     _variance = standard.get<1>();
@@ -247,28 +456,51 @@ afwMath::Statistics::Statistics(
     // ==========================================================
     // now only calculate it if it's specifically requested - these all cost more!
 
-    // copy the image for any routines that will use median or quantiles
-    if (flags & (MEDIAN | IQRANGE | MEANCLIP | STDEVCLIP | VARIANCECLIP)) {
-
-        // make a vector copy of the image to get the median and quartiles (will move values)
-        boost::shared_ptr<std::vector<typename ImageT::Pixel> > imgcp;
-        if (_sctrl.getNanSafe()) {
-            imgcp = _makeVectorCopy<ChkFin>(img, msk, var, flags);
+    if (needQuantiles) {
+        bool const medianOnly =
+            (flags & MEDIAN) && !(flags & (IQRANGE | MEANCLIP | STDEVCLIP | VARIANCECLIP));
+
+        std::vector<typename ImageT::Pixel> valuesCopy;
+        if (useHistogram) {
+            // select the quantiles with histograms, without copying (or reordering) the values
+            std::vector<double> percentiles(1, 0.5);
+            if (!medianOnly) {
+                percentiles.push_back(0.25);
+                percentiles.push_back(0.75);
+            }
+            std::vector<double> quantiles;
+            if (needValues) {
+                VectorValues<typename ImageT::Pixel> const source(values);
+                quantiles = computePercentiles<typename ImageT::Pixel>(source, percentiles);
+            } else {
+                GoodImageValues<ImageT, MaskT> const source(img, msk, _sctrl.getAndMask());
+                quantiles = computePercentiles<typename ImageT::Pixel>(source, percentiles);
+            }
+            _median = quantiles[0];
+            if (!medianOnly) {
+                _iqrange = quantiles[2] - quantiles[1];
+            }
         } else {
-            imgcp = _makeVectorCopy<AlwaysT>(img, msk, var, flags);
-        }
+            // the median and quartiles reorder the values, but clipping needs them in their original order
+            if (isClipping) {
+                valuesCopy = values;
+            }
+            std::vector<typename ImageT::Pixel> &imgcp = isClipping ? valuesCopy : values;
 
-        // if we *only* want the median, just use _percentile(), otherwise use _medianAndQuartiles()
-        if ( (flags & (MEDIAN)) && !(flags & (IQRANGE | MEANCLIP | STDEVCLIP | VARIANCECLIP)) ) {
-            _median = _percentile(*imgcp, 0.5);
-        } else {
-            MedianQuartileReturn mq = _medianAndQuartiles(*imgcp);
-            _median = mq.get<0>();
-            _iqrange = mq.get<2>() - mq.get<1>();
+            // if we *only* want the median, just use _percentile(), otherwise use _medianAndQuartiles()
+            if (medianOnly) {
+                _median = _percentile(imgcp, 0.5);
+            } else {
+                MedianQuartileReturn mq = _medianAndQuartiles(imgcp);
+                _median = mq.get<0>();
+                _iqrange = mq.get<2>() - mq.get<1>();
+            }
         }
         
         
-        if (flags & (MEANCLIP | STDEVCLIP | VARIANCECLIP)) {            
+        if (isClipping) {
+            std::vector<typename ImageT::Pixel>().swap(valuesCopy);
+
             for (int i_i = 0; i_i < _sctrl.getNumIter(); ++i_i) {
                 
                 double const center = (i_i > 0) ? _meanclip : _median;
@@ -278,7 +510,8 @@ afwMath::Statistics::Statistics(
                 std::pair<double, double> const clipinfo(center, hwidth);
                 
                 // returns a tuple but we'll ignore clipped min, max, and sum;
-                StandardReturn clipped = _getStandard(img, msk, var, flags, clipinfo);
+                // only the good pixels can survive clipping, so we needn't look at the image again
+                StandardReturn clipped = _getStandard(values, weights, flags, clipinfo);
                 
                 _meanclip = clipped.get<0>();
                 _varianceclip = clipped.get<1>();
@@ -369,27 +602,162 @@ afwMath::Statistics::SumReturn afwMath::Statistics::_sumImage(ImageT const &img,
     return afwMath::Statistics::SumReturn(n, sum, sumx2, min, max, wsum, allPixelOrMask);
 }
 
-/* =========================================================================
- * _getStandard(img, flags)
- * @brief Compute the standard stats: mean, variance, min, max
+/**
+ * @brief The inner summation loop of _sumImage, also copying the good pixels' values (and weights)
  *
- * @param img    an afw::Image to compute the stats over
- * @param flags  an integer (bit field indicating which statistics are to be computed
+ * Pixels that pass IsFinite and the mask test are copied into values (and, if IsWeighted, their
+ * weights into weights), in the order that they're found; the sums are accumulated for those
+ * that also pass IsFiniteSum.  This allows us to get the standard statistics and the values needed
+ * for the median, quartiles, and clipping, in a single pass through the image.
+ */
+template<typename IsFinite,
+         typename IsFiniteSum,
+         typename HasValueLtMin,
+         typename HasValueGtMax,
+         bool IsWeighted,
+         typename ImageT, typename MaskT, typename VarianceT>
+afwMath::Statistics::SumReturn afwMath::Statistics::_sumImageAndCopy(
+        ImageT const &img,
+        MaskT const &msk,
+        VarianceT const &var,
+        int const nCrude,
+        double const meanCrude,
+        std::vector<typename ImageT::Pixel> &values,
+        std::vector<afwImage::VariancePixel> &weights
+                                                                     ) {
+    int n = 0;
+    double wsum = 0.0;
+    double sum = 0, sumx2 = 0;
+    double min = (nCrude) ? meanCrude : MAX_DOUBLE;
+    double max = (nCrude) ? meanCrude : -MAX_DOUBLE;
+
+    afwImage::MaskPixel allPixelOrMask = 0x0;
+
+    std::size_t const nPix = static_cast<std::size_t>(img.getWidth())*img.getHeight();
+    values.clear();
+    values.reserve(nPix);
+    weights.clear();
+    if (IsWeighted) {
+        weights.reserve(nPix);
+    }
+    
+    for (int iY = 0; iY < img.getHeight(); ++iY) {
+        
+        typename MaskT::x_iterator mptr = msk.row_begin(iY);
+        typename VarianceT::x_iterator vptr = var.row_begin(iY);
+        
+        for (typename ImageT::x_iterator ptr = img.row_begin(iY), end = ptr + img.getWidth();
+             ptr != end; ++ptr, ++mptr, ++vptr) {
+            
+            if (!IsFinite()(*ptr) || (*mptr & _sctrl.getAndMask())) {
+                continue;
+            }
+            values.push_back(*ptr);
+            if (IsWeighted) {
+                weights.push_back(*vptr);
+            }
+
+            if (IsFiniteSum()(*ptr)) {
+                double const delta = (*ptr - meanCrude);
+
+                if (IsWeighted) {
+                    if ( _sctrl.getMultiplyWeights()) {
+                        sum   += (*vptr)*delta;
+                        sumx2 += (*vptr)*delta*delta;
+                        wsum  += (*vptr);
+                    } else {
+                        if (*vptr > 0) {
+                            sum   += delta/(*vptr);
+                            sumx2 += delta*delta/(*vptr);
+                            wsum  += 1.0/(*vptr);
+                        }
+                    }
+                    
+                } else {
+                    sum += delta;
+                    sumx2 += delta*delta;
+                }
+
+                allPixelOrMask |= *mptr;
+                
+                if ( HasValueLtMin()(*ptr, min) ) { min = *ptr; }
+                if ( HasValueGtMax()(*ptr, max) ) { max = *ptr; }
+                n++;
+            }
+        }
+    }
+    if (n == 0) {
+        min = NaN;
+        max = NaN;
+    }
+
+    return afwMath::Statistics::SumReturn(n, sum, sumx2, min, max, wsum, allPixelOrMask);
+}
+
+/**
+ * @brief The clipped summation loop of _sumImage, run over values (and weights) copied by _sumImageAndCopy
  *
- * @note An overloaded version below is used to get clipped versions
+ * The values are in the same order as in the image, so the sums are identical to those from the image
  */
-template<typename ImageT, typename MaskT, typename VarianceT>
-afwMath::Statistics::StandardReturn afwMath::Statistics::_getStandard(ImageT const &img,
-                                                                      MaskT const &msk,
-                                                                      VarianceT const &var,
-                                                                      int const flags) {
+template<typename IsFinite, bool IsWeighted, typename Pixel>
+afwMath::Statistics::SumReturn afwMath::Statistics::_sumValues(
+        std::vector<Pixel> const &values,
+        std::vector<afwImage::VariancePixel> const &weights,
+        double const center,
+        double const cliplimit
+                                                              ) {
+    int n = 0;
+    double wsum = 0.0;
+    double sum = 0, sumx2 = 0;
 
+    typename std::vector<afwImage::VariancePixel>::const_iterator vptr = weights.begin();
+    for (typename std::vector<Pixel>::const_iterator ptr = values.begin(), end = values.end();
+         ptr != end; ++ptr) {
+        afwImage::VariancePixel const weight = IsWeighted ? *vptr++ : 0;
 
-    // =====================================================
-    // a crude estimate of the mean, used for numerical stability of variance
+        if (IsFinite()(*ptr) && ChkClip()(*ptr, center, cliplimit)) {
+            double const delta = (*ptr - center);
+
+            if (IsWeighted) {
+                if ( _sctrl.getMultiplyWeights()) {
+                    sum   += weight*delta;
+                    sumx2 += weight*delta*delta;
+                    wsum  += weight;
+                } else {
+                    if (weight > 0) {
+                        sum   += delta/weight;
+                        sumx2 += delta*delta/weight;
+                        wsum  += 1.0/weight;
+                    }
+                }
+            } else {
+                sum += delta;
+                sumx2 += delta*delta;
+            }
+            n++;
+        }
+    }
+
+    return afwMath::Statistics::SumReturn(n, sum, sumx2, NaN, NaN, wsum, 0x0);
+}
+
+/* =========================================================================
+ * _getMeanCrude(img, flags, nCrude)
+ * @brief Compute a crude estimate of the mean (used for numerical stability of variance)
+ *
+ * @param img    an afw::Image to compute the crude mean of
+ * @param flags  an integer (bit field indicating which statistics are to be computed
+ * @param nCrude set to the number of pixels used
+ */
+template<typename ImageT, typename MaskT, typename VarianceT>
+double afwMath::Statistics::_getMeanCrude(ImageT const &img,
+                                          MaskT const &msk,
+                                          VarianceT const &var,
+                                          int const flags,
+                                          int &nCrude) {
     SumReturn loopValues;
     
-    int nCrude       = 0;
+    nCrude = 0;
     double meanCrude = 0.0;
 
     // for small numbers of values, use a small stride
@@ -420,14 +788,68 @@ afwMath::Statistics::StandardReturn afwMath::Statistics::_getStandard(ImageT con
     nCrude = loopValues.get<0>();
 
     double sumCrude = loopValues.get<1>();
-    meanCrude = 0.0;
     if ( nCrude > 0 ) {
         meanCrude = sumCrude/nCrude;
     }
 
+    return meanCrude;
+}
+
+/* =========================================================================
+ * _makeStandardReturn(loopValues, center)
+ * @brief Convert the sums (about center) from a summation loop to the standard stats, and set _n
+ */
+afwMath::Statistics::StandardReturn afwMath::Statistics::_makeStandardReturn(SumReturn const &loopValues,
+                                                                             double const center) {
+    int n        = loopValues.get<0>();
+    double sum   = loopValues.get<1>();
+    double sumx2 = loopValues.get<2>();
+    double min   = loopValues.get<3>();
+    double max   = loopValues.get<4>();
+    double wsum  = loopValues.get<5>();
+    afwImage::MaskPixel allPixelOrMask = loopValues.get<6>();
+    
+    // estimate of population mean and variance
+    double mean, variance;
+    if (_sctrl.getWeighted()) {
+        mean = (wsum > 0) ? center + sum/wsum : NaN;
+        variance = (n > 1) ? sumx2/(wsum - wsum/n) - sum*sum/(static_cast<double>(wsum - wsum/n)*wsum) : NaN;
+        sum += center*wsum;
+    } else {
+        mean = (n) ? center + sum/n : NaN;
+        variance = (n > 1) ? sumx2/(n - 1) - sum*sum/(static_cast<double>(n - 1)*n) : NaN;
+        sum += n*center;
+    }
+    _n = n;
+    
+    return afwMath::Statistics::StandardReturn(mean, variance, min, max, sum, allPixelOrMask);
+}
+
+/* =========================================================================
+ * _getStandard(img, flags)
+ * @brief Compute the standard stats: mean, variance, min, max
+ *
+ * @param img    an afw::Image to compute the stats over
+ * @param flags  an integer (bit field indicating which statistics are to be computed
+ *
+ * @note An overloaded version below is used to get clipped versions
+ */
+template<typename ImageT, typename MaskT, typename VarianceT>
+afwMath::Statistics::StandardReturn afwMath::Statistics::_getStandard(ImageT const &img,
+                                                                      MaskT const &msk,
+                                                                      VarianceT const &var,
+                                                                      int const flags) {
+
+
+    // =====================================================
+    // a crude estimate of the mean, used for numerical stability of variance
+    int nCrude;
+    double const meanCrude = _getMeanCrude(img, msk, var, flags, nCrude);
+
     // =======================================================
     // Estimate the full precision variance using that crude mean
     // - get the min and max as well
+    SumReturn loopValues;
     
     // If we want max or min (you get both)
     if (flags & (MIN | MAX)){
@@ -461,28 +883,79 @@ afwMath::Statistics::StandardReturn afwMath::Statistics::_getStandard(ImageT con
         }
     }
 
-    int n        = loopValues.get<0>();
-    double sum   = loopValues.get<1>();
-    double sumx2 = loopValues.get<2>();
-    double min   = loopValues.get<3>();
-    double max   = loopValues.get<4>();
-    double wsum  = loopValues.get<5>();
-    afwImage::MaskPixel allPixelOrMask = loopValues.get<6>();
-    
-    // estimate of population mean and variance
-    double mean, variance;
-    if (_sctrl.getWeighted()) {
-        mean = (wsum > 0) ? meanCrude + sum/wsum : NaN;
-        variance = (n > 1) ? sumx2/(wsum - wsum/n) - sum*sum/(static_cast<double>(wsum - wsum/n)*wsum) : NaN;
-        sum += meanCrude*wsum;
+    return _makeStandardReturn(loopValues, meanCrude);
+}
+
+
+/* ==========================================================
+ * *overload _getStandard(img, flags, values, weights)
+ *
+ * @param img      an afw::Image to compute stats for
+ * @param flags    an int (bit field indicating which stats to compute
+ * @param values   set to the values of the pixels to be used for the median, quartiles, and clipping
+ * @param weights  set to the weights of those pixels (if weighted)
+ *
+ * @brief A routine to get standard stats: mean, variance, min, max, while copying the values
+ *   of the good pixels (in a single pass through the image)
+ *
+ * The pixels copied are those that the old copy (for the median and quartiles) used, i.e. those
+ * not excluded by the andMask and (if nanSafe) not NaN.  The statistics are identical to those
+ * computed by the version of _getStandard that doesn't copy.
+ */
+template<typename ImageT, typename MaskT, typename VarianceT>
+afwMath::Statistics::StandardReturn afwMath::Statistics::_getStandard(
+    ImageT const &img,
+    MaskT const &msk,
+    VarianceT const &var,
+    int const flags,
+    std::vector<typename ImageT::Pixel> &values,
+    std::vector<afwImage::VariancePixel> &weights
+                                                                     ) {
+    int nCrude;
+    double const meanCrude = _getMeanCrude(img, msk, var, flags, nCrude);
+
+    SumReturn loopValues;
+
+    // If we want max or min (you get both); NaNs are never included in the sums if we do
+    if (flags & (MIN | MAX)){
+        if (_sctrl.getNanSafe()) {
+            if (_sctrl.getWeighted()) {
+                loopValues = _sumImageAndCopy<ChkFin, ChkFin, ChkMin, ChkMax, true>(
+                    img, msk, var, nCrude, meanCrude, values, weights);
+            } else {
+                loopValues = _sumImageAndCopy<ChkFin, ChkFin, ChkMin, ChkMax, false>(
+                    img, msk, var, nCrude, meanCrude, values, weights);
+            }
+        } else {
+            if (_sctrl.getWeighted()) {
+                loopValues = _sumImageAndCopy<AlwaysT, ChkFin, ChkMin, ChkMax, true>(
+                    img, msk, var, nCrude, meanCrude, values, weights);
+            } else {
+                loopValues = _sumImageAndCopy<AlwaysT, ChkFin, ChkMin, ChkMax, false>(
+                    img, msk, var, nCrude, meanCrude, values, weights);
+            }
+        }
     } else {
-        mean = (n) ? meanCrude + sum/n : NaN;
-        variance = (n > 1) ? sumx2/(n - 1) - sum*sum/(static_cast<double>(n - 1)*n) : NaN;
-        sum += n*meanCrude;
+        if (_sctrl.getNanSafe()) {
+            if (_sctrl.getWeighted()) {
+                loopValues = _sumImageAndCopy<ChkFin, ChkFin, AlwaysF, AlwaysF, true>(
+                    img, msk, var, nCrude, meanCrude, values, weights);
+            } else {
+                loopValues = _sumImageAndCopy<ChkFin, ChkFin, AlwaysF, AlwaysF, false>(
+                    img, msk, var, nCrude, meanCrude, values, weights);
+            }
+        } else {
+            if (_sctrl.getWeighted()) {
+                loopValues = _sumImageAndCopy<AlwaysT, AlwaysT, AlwaysF, AlwaysF, true>(
+                    img, msk, var, nCrude, meanCrude, values, weights);
+            } else {
+                loopValues = _sumImageAndCopy<AlwaysT, AlwaysT, AlwaysF, AlwaysF, false>(
+                    img, msk, var, nCrude, meanCrude, values, weights);
+            }
+        }
     }
-    _n = n;
-    
-    return afwMath::Statistics::StandardReturn(mean, variance, min, max, sum, allPixelOrMask);
+
+    return _makeStandardReturn(loopValues, meanCrude);
 }
 
 
@@ -558,28 +1031,52 @@ afwMath::Statistics::StandardReturn afwMath::Statistics::_getStandard(
         }
     }
     
-    int n        = loopValues.get<0>();
-    double sum   = loopValues.get<1>();
-    double sumx2 = loopValues.get<2>();
-    double min   = loopValues.get<3>();
-    double max   = loopValues.get<4>();
-    double wsum  = loopValues.get<5>();
-    afwImage::MaskPixel allPixelOrMask = loopValues.get<6>();
+    return _makeStandardReturn(loopValues, center);
+}
+
+
+/* ==========================================================
+ * *overload _getStandard(values, weights, flags, clipinfo)
+ *
+ * @param values   the values of the good pixels, as set by _getStandard(img, flags, values, weights)
+ * @param weights  their weights (if weighted)
+ * @param flags    an int (bit field indicating which stats to compute
+ * @param clipinfo the center and cliplimit for the clip iteration
+ *
+ * @brief Get the clipped mean and variance from the good pixels' values, as
+ *   _getStandard(img, flags, clipinfo) does from the image (the min, max, sum, and OrMask are not set)
+ */
+template<typename Pixel>
+afwMath::Statistics::StandardReturn afwMath::Statistics::_getStandard(
+    std::vector<Pixel> const &values,
+    std::vector<afwImage::VariancePixel> const &weights,
+    int const flags,
+    std::pair<double, double> const clipinfo
+                                                                     ) {
     
-    // estimate of population variance
-    double mean, variance;
-    if (_sctrl.getWeighted()) {
-        mean = (wsum > 0) ? center + sum/wsum : NaN;
-        variance = (n > 1) ? sumx2/(wsum - wsum/n) - sum*sum/(static_cast<double>(wsum - wsum/n)*wsum) : NaN;
-        sum += center*wsum;
+    double const center = clipinfo.first;
+    double const cliplimit = clipinfo.second;
+
+    if (lsst::utils::isnan(center) || lsst::utils::isnan(cliplimit)) {
+        return afwMath::Statistics::StandardReturn(NaN, NaN, NaN, NaN, NaN, ~0x0);
+    }
+
+    SumReturn loopValues;
+    if ((flags & (MIN | MAX)) || _sctrl.getNanSafe()) {
+        if (_sctrl.getWeighted()) {
+            loopValues = _sumValues<ChkFin, true>(values, weights, center, cliplimit);
+        } else {
+            loopValues = _sumValues<ChkFin, false>(values, weights, center, cliplimit);
+        }
     } else {
-        mean = (n) ? center + sum/n : NaN;
-        variance = (n > 1) ? sumx2/(n - 1) - sum*sum/(static_cast<double>(n - 1)*n) : NaN;
-        sum += n*center;
+        if (_sctrl.getWeighted()) {
+            loopValues = _sumValues<AlwaysT, true>(values, weights, center, cliplimit);
+        } else {
+            loopValues = _sumValues<AlwaysT, false>(values, weights, center, cliplimit);
+        }
     }
-    _n = n;
-    
-    return afwMath::Statistics::StandardReturn(mean, variance, min, max, sum, allPixelOrMask);
+
+    return _makeStandardReturn(loopValues, center);
 }
 
 
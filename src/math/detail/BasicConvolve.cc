@@ -33,10 +33,13 @@
  */
 #include <algorithm>
 #include <cmath>
+#include <limits>
 #include <sstream>
 #include <vector>
 
+#include "boost/bind.hpp"
 #include "boost/cstdint.hpp" 
+#include "boost/function.hpp"
 
 #include "lsst/pex/exceptions.h"
 #include "lsst/pex/logging/Trace.h"
@@ -44,6 +47,8 @@
 #include "lsst/afw/math.h"
 #include "lsst/afw/geom.h"
 #include "lsst/afw/math/detail/Convolve.h"
+#include "lsst/afw/math/detail/DotProduct.h"
+#include "lsst/afw/math/detail/Parallel.h"
 
 namespace pexExcept = lsst::pex::exceptions;
 namespace pexLog = lsst::pex::logging;
@@ -54,6 +59,18 @@ namespace mathDetail = lsst::afw::math::detail;
 
 namespace {
 
+    /*
+     * Return a pointer to a kernel pixel, given a reference to it as a double or as a kernel %image pixel
+     */
+    inline double const *getKernelPointer(double const &kVal) {
+        return &kVal;
+    }
+
+    template <typename KernelPixelT>
+    inline double const *getKernelPointer(KernelPixelT const &kPixel) {
+        return &kPixel[0];
+    }
+
     /*
      * @brief Compute the dot product of a kernel row or column and the overlapping portion of an %image
      *
@@ -61,6 +78,9 @@ namespace {
      *
      * The pixel computed belongs at position imageIter + kernel center.
      *
+     * Rows of float and double pixels are handled by vectorized code (see lsst/afw/math/detail/DotProduct.h)
+     * unless SIMD has been disabled.
+     *
      * @todo get rid of KernelPixelT parameter if possible by not computing local variable kVal,
      * or by using iterator traits:
      *     typedef typename std::iterator_traits<KernelIterT>::value_type KernelPixel;
@@ -84,6 +104,9 @@ include/lsst/afw/image/Pixel.h:212: error: no type named ‘VariancePixelT’ in
             int kWidth)                 ///< width of kernel
     {
         OutPixelT outPixel(0);
+        if (mathDetail::addDotProduct(outPixel, imageIter, getKernelPointer(*kernelIter), kWidth)) {
+            return outPixel;
+        }
         for (int x = 0; x < kWidth; ++x, ++imageIter, ++kernelIter) {
             KernelPixelT kVal = *kernelIter;
             if (kVal != 0) {
@@ -130,6 +153,266 @@ include/lsst/afw/image/Pixel.h:212: error: no type named ‘VariancePixelT’ in
         }
     }
     
+
+    /*
+     * Return true if the image's (image plane) pixels are floating point
+     */
+    template <typename ImageT>
+    bool hasFloatingPointPixels(afwImage::detail::Image_tag) {
+        return !std::numeric_limits<typename ImageT::SinglePixel>::is_integer;
+    }
+
+    template <typename ImageT>
+    bool hasFloatingPointPixels(afwImage::detail::MaskedImage_tag) {
+        return !std::numeric_limits<typename ImageT::Image::SinglePixel>::is_integer;
+    }
+
+    /*
+     * Return true if convolution should use FFTs rather than brute force
+     *
+     * FFTs are used for spatially invariant kernels that are large enough (as specified by convolutionControl)
+     * when the output is floating point (brute force convolution truncates each term for integer output).
+     */
+    template <typename OutImageT>
+    bool shouldUseFft(
+        afwMath::Kernel const &kernel,
+        afwMath::ConvolutionControl const &convolutionControl
+    ) {
+        int const minSize = convolutionControl.getFftMinKernelSize();
+        return (minSize > 0) && !kernel.isSpatiallyVarying()
+            && (kernel.getWidth() >= minSize) && (kernel.getHeight() >= minSize)
+            && hasFloatingPointPixels<OutImageT>(
+                typename afwImage::detail::image_traits<OutImageT>::image_category());
+    }
+    
+    /*
+     * Convolve a band of rows with a spatially invariant kernel image (see convolveWithBruteForce)
+     *
+     * Sets output rows [cnvStartY + inStartYBegin, cnvStartY + inStartYEnd).
+     */
+    template <typename OutImageT, typename InImageT>
+    void convolveRowsWithKernelImage(
+        OutImageT &convolvedImage,      ///< convolved %image
+        InImageT const &inImage,        ///< %image to convolve
+        afwImage::Image<afwMath::Kernel::Pixel> const &kernelImage, ///< kernel image
+        int cnvStartX,                  ///< x index of first good output pixel
+        int cnvStartY,                  ///< y index of first good output pixel
+        int inStartYBegin,              ///< first input row of band (lower left corner of kernel)
+        int inStartYEnd                 ///< last input row of band + 1
+    ) {
+        typedef typename afwMath::Kernel::Pixel KernelPixel;
+        typedef afwImage::Image<KernelPixel> KernelImage;
+        typedef typename KernelImage::const_x_iterator KernelXIterator;
+        typedef typename InImageT::const_x_iterator InXIterator;
+        typedef typename OutImageT::x_iterator OutXIterator;
+        typedef typename OutImageT::SinglePixel OutPixel;
+
+        int const kWidth = kernelImage.getWidth();
+        int const kHeight = kernelImage.getHeight();
+        int const cnvWidth = inImage.getWidth() + 1 - kWidth;
+
+        for (int inStartY = inStartYBegin, cnvY = cnvStartY + inStartYBegin; inStartY < inStartYEnd;
+            ++inStartY, ++cnvY) {
+            KernelXIterator kernelXIter = kernelImage.x_at(0, 0);
+            InXIterator inXIter = inImage.x_at(0, inStartY);
+            OutXIterator cnvXIter = convolvedImage.x_at(cnvStartX, cnvY);
+            for (int x = 0; x < cnvWidth; ++x, ++cnvXIter, ++inXIter) {
+                *cnvXIter = kernelDotProduct<OutPixel, InXIterator, KernelXIterator, KernelPixel>(
+                    inXIter, kernelXIter, kWidth);
+            }
+            for (int kernelY = 1, inY = inStartY + 1; kernelY < kHeight; ++inY, ++kernelY) {
+                KernelXIterator kernelXIter = kernelImage.x_at(0, kernelY);
+                InXIterator inXIter = inImage.x_at(0, inY);
+                OutXIterator cnvXIter = convolvedImage.x_at(cnvStartX, cnvY);
+                for (int x = 0; x < cnvWidth; ++x, ++cnvXIter, ++inXIter) {
+                    *cnvXIter += kernelDotProduct<OutPixel, InXIterator, KernelXIterator, KernelPixel>(
+                        inXIter, kernelXIter, kWidth);
+                }
+            }
+        }
+    }
+
+    /*
+     * Convolve a band of rows with a spatially varying kernel, computing the kernel image at every pixel
+     *
+     * The kernel is modified (its parameters are set from the spatial model), so each band
+     * must be given its own copy.
+     */
+    template <typename OutImageT, typename InImageT>
+    void convolveRowsWithVaryingKernel(
+        OutImageT &convolvedImage,      ///< convolved %image
+        InImageT const &inImage,        ///< %image to convolve
+        afwMath::Kernel::ConstPtr kernelPtr,    ///< convolution kernel; not shared with any other band
+        bool doNormalize,               ///< if true, normalize the kernel, else use "as is"
+        int cnvYBegin,                  ///< first output row of band
+        int cnvYEnd                     ///< last output row of band + 1
+    ) {
+        typedef typename afwMath::Kernel::Pixel KernelPixel;
+        typedef afwImage::Image<KernelPixel> KernelImage;
+        typedef typename KernelImage::const_xy_locator KernelXYLocator;
+        typedef typename InImageT::const_xy_locator InXYLocator;
+        typedef typename OutImageT::x_iterator OutXIterator;
+
+        int const kWidth = kernelPtr->getWidth();
+        int const kHeight = kernelPtr->getHeight();
+        int const cnvStartX = kernelPtr->getCtrX();
+        int const cnvStartY = kernelPtr->getCtrY();
+        int const cnvEndX = cnvStartX + inImage.getWidth() + 1 - kWidth;  // end index + 1
+
+        KernelImage kernelImage(kernelPtr->getDimensions());
+        KernelXYLocator const kernelLoc = kernelImage.xy_at(0,0);
+
+        for (int cnvY = cnvYBegin; cnvY != cnvYEnd; ++cnvY) {
+            double const rowPos = inImage.indexToPosition(cnvY, afwImage::Y);
+            
+            InXYLocator  inImLoc =  inImage.xy_at(0, cnvY - cnvStartY);
+            OutXIterator cnvXIter = convolvedImage.x_at(cnvStartX, cnvY);
+            for (int cnvX = cnvStartX; cnvX != cnvEndX; ++cnvX, ++inImLoc.x(), ++cnvXIter) {
+                double const colPos = inImage.indexToPosition(cnvX, afwImage::X);
+
+                KernelPixel kSum = kernelPtr->computeImage(kernelImage, false, colPos, rowPos);
+                *cnvXIter = afwMath::convolveAtAPoint<OutImageT, InImageT>(
+                    inImLoc, kernelLoc, kWidth, kHeight);
+                if (doNormalize) {
+                    *cnvXIter = *cnvXIter/kSum;
+                }
+            }
+        }
+    }
+
+    /*
+     * Convolve a band of rows with a spatially varying separable kernel
+     *
+     * The kernel is modified (its parameters are set from the spatial model), so each band
+     * must be given its own copy.
+     */
+    template <typename OutImageT, typename InImageT>
+    void convolveRowsWithVaryingSeparableKernel(
+        OutImageT &convolvedImage,      ///< convolved %image
+        InImageT const &inImage,        ///< %image to convolve
+        afwMath::SeparableKernel::ConstPtr kernelPtr,   ///< convolution kernel; not shared with any other band
+        bool doNormalize,               ///< if true, normalize the kernel, else use "as is"
+        afwGeom::Box2I const &goodBBox, ///< bounding box of good pixels of convolved image
+        int cnvYBegin,                  ///< first output row of band
+        int cnvYEnd                     ///< last output row of band + 1
+    ) {
+        typedef typename afwMath::Kernel::Pixel KernelPixel;
+        typedef typename std::vector<KernelPixel> KernelVector;
+        typedef typename InImageT::const_xy_locator InXYLocator;
+        typedef typename OutImageT::x_iterator OutXIterator;
+
+        KernelVector kernelXVec(kernelPtr->getWidth());
+        KernelVector kernelYVec(kernelPtr->getHeight());
+
+        for (int cnvY = cnvYBegin; cnvY < cnvYEnd; ++cnvY) {
+            double const rowPos = inImage.indexToPosition(cnvY, afwImage::Y);
+            
+            InXYLocator inImLoc = inImage.xy_at(0, cnvY - goodBBox.getMinY());
+            OutXIterator cnvXIter = convolvedImage.row_begin(cnvY) + goodBBox.getMinX();
+            for (int cnvX = goodBBox.getMinX(); cnvX <= goodBBox.getMaxX();
+                ++cnvX, ++inImLoc.x(), ++cnvXIter) {
+                double const colPos = inImage.indexToPosition(cnvX, afwImage::X);
+
+                KernelPixel kSum = kernelPtr->computeVectors(kernelXVec, kernelYVec,
+                    doNormalize, colPos, rowPos);
+
+                // why does this trigger warnings? It did not in the past.
+                *cnvXIter = afwMath::convolveAtAPoint<OutImageT, InImageT>(inImLoc, kernelXVec, kernelYVec);
+                if (doNormalize) {
+                    *cnvXIter = *cnvXIter/kSum;
+                }
+            }
+        }
+    }
+
+    /*
+     * Convolve a band of rows with a spatially invariant separable kernel
+     *
+     * The basic sequence:
+     * - For each output row:
+     * - Compute x-convolved data: a kernel height's strip of input image convolved with kernel x vector
+     * - Compute one row of output by dotting each column of x-convolved data with the kernel y vector
+     * The x-convolved data is stored in a kernel-height by good-width buffer.
+     * This is circular buffer along y (to avoid shifting pixels before setting each new row);
+     * so for each new row the kernel y vector is rotated to match the order of the x-convolved data.
+     *
+     * Input row inY is always stored in buffer row inY % kernel height, whichever row the band starts at;
+     * thus the order of summation, and hence the result, does not depend on how the image is split into bands.
+     */
+    template <typename OutImageT, typename InImageT>
+    void convolveRowsWithSeparableKernelVectors(
+        OutImageT &convolvedImage,      ///< convolved %image
+        InImageT const &inImage,        ///< %image to convolve
+        std::vector<afwMath::Kernel::Pixel> const &kernelXVec,  ///< kernel x vector
+        std::vector<afwMath::Kernel::Pixel> kernelYVec, ///< kernel y vector (a copy, since it is rotated)
+        afwGeom::Box2I const &goodBBox, ///< bounding box of good pixels of convolved image
+        int cnvYBegin,                  ///< first output row of band
+        int cnvYEnd                     ///< last output row of band + 1
+    ) {
+        typedef typename afwMath::Kernel::Pixel KernelPixel;
+        typedef typename std::vector<KernelPixel>::const_iterator KernelIterator;
+        typedef typename InImageT::const_x_iterator InXIterator;
+        typedef typename OutImageT::x_iterator OutXIterator;
+        typedef typename OutImageT::y_iterator OutYIterator;
+        typedef typename OutImageT::SinglePixel OutPixel;
+
+        int const kWidth = kernelXVec.size();
+        int const kHeight = kernelYVec.size();
+        KernelIterator const kernelXVecBegin = kernelXVec.begin();
+
+        // buffer for x-convolved data
+        OutImageT buffer(afwGeom::Extent2I(goodBBox.getWidth(), kHeight));
+
+        // rotate the kernel y vector to match the buffer rows for the first output row of this band
+        int const inYBegin = cnvYBegin - goodBBox.getMinY();
+        std::rotate(kernelYVec.begin(), kernelYVec.end() - (inYBegin % kHeight), kernelYVec.end());
+        KernelIterator const kernelYVecBegin = kernelYVec.begin();
+        
+        // pre-fill x-convolved data buffer with all but one row of data
+        int inY = inYBegin;
+        int const inYPrefillEnd = inYBegin + kHeight - 1;
+        for (; inY < inYPrefillEnd; ++inY) {
+            int const bufY = inY % kHeight;
+            OutXIterator bufXIter = buffer.x_at(0, bufY);
+            OutXIterator const bufXEnd = buffer.x_at(goodBBox.getWidth(), bufY);
+            InXIterator inXIter = inImage.x_at(0, inY);
+            for ( ; bufXIter != bufXEnd; ++bufXIter, ++inXIter) {
+                *bufXIter = kernelDotProduct<OutPixel, InXIterator, KernelIterator, KernelPixel>(
+                    inXIter, kernelXVecBegin, kWidth);
+            }
+        }
+
+        // compute output pixels using the sequence described above
+        int bufY = inY % kHeight;
+        int cnvY = cnvYBegin;
+        while (true) {
+            // fill next buffer row and compute output row
+            InXIterator inXIter = inImage.x_at(0, inY);
+            OutXIterator bufXIter = buffer.x_at(0, bufY);
+            OutXIterator cnvXIter = convolvedImage.x_at(goodBBox.getMinX(), cnvY);
+            for (int bufX = 0; bufX < goodBBox.getWidth(); ++bufX, ++cnvXIter, ++bufXIter, ++inXIter) {
+                // note: bufXIter points to the row of the buffer that is being updated,
+                // whereas bufYIter points to row 0 of the buffer
+                *bufXIter = kernelDotProduct<OutPixel, InXIterator, KernelIterator, KernelPixel>(
+                    inXIter, kernelXVecBegin, kWidth);
+
+                OutYIterator bufYIter = buffer.y_at(bufX, 0);
+                *cnvXIter = kernelDotProduct<OutPixel, OutYIterator, KernelIterator, KernelPixel>(
+                    bufYIter, kernelYVecBegin, kHeight);
+            }
+            
+            // test for done now, instead of the start of the loop,
+            // to avoid an unnecessary extra rotation of the kernel Y vector
+            if (cnvY + 1 >= cnvYEnd) break;
+            
+            // update y indices, including bufY, and rotate the kernel y vector to match
+            ++inY;
+            bufY = (bufY + 1) % kHeight;
+            ++cnvY;
+            std::rotate(kernelYVec.begin(), kernelYVec.end()-1, kernelYVec.end());
+        }
+    }
+    
 }   // anonymous namespace
 
 /**
@@ -186,11 +469,13 @@ void mathDetail::basicConvolve(
         pexLog::TTrace<3>("lsst.afw.math.convolve", "generic basicConvolve: using linear interpolation");
         mathDetail::convolveWithInterpolation(convolvedImage, inImage, kernel, convolutionControl);
 
+    } else if (shouldUseFft<OutImageT>(kernel, convolutionControl)) {
+        pexLog::TTrace<3>("lsst.afw.math.convolve", "generic basicConvolve: using FFT");
+        mathDetail::convolveWithFft(convolvedImage, inImage, kernel, convolutionControl);
     } else {
         // use brute force
         pexLog::TTrace<3>("lsst.afw.math.convolve", "generic basicConvolve: using brute force");
-        mathDetail::convolveWithBruteForce(convolvedImage, inImage, kernel,
-            convolutionControl.getDoNormalize());
+        mathDetail::convolveWithBruteForce(convolvedImage, inImage, kernel, convolutionControl);
     }
 }
 
@@ -251,12 +536,15 @@ void mathDetail::basicConvolve(
     afwMath::LinearCombinationKernel const& kernel,         ///< convolution kernel
     afwMath::ConvolutionControl const & convolutionControl) ///< convolution control parameters
 {
-    if (!kernel.isSpatiallyVarying()) {
+    if (shouldUseFft<OutImageT>(kernel, convolutionControl)) {
+        pexLog::TTrace<3>("lsst.afw.math.convolve",
+            "basicConvolve for LinearCombinationKernel: spatially invariant; using FFT");
+        return mathDetail::convolveWithFft(convolvedImage, inImage, kernel, convolutionControl);
+    } else if (!kernel.isSpatiallyVarying()) {
         // use the standard algorithm for the spatially invariant case
         pexLog::TTrace<3>("lsst.afw.math.convolve",
             "basicConvolve for LinearCombinationKernel: spatially invariant; using brute force");
-        return mathDetail::convolveWithBruteForce(convolvedImage, inImage, kernel,
-            convolutionControl.getDoNormalize());
+        return mathDetail::convolveWithBruteForce(convolvedImage, inImage, kernel, convolutionControl);
     } else {
         // refactor the kernel if this is reasonable and possible;
         // then use the standard algorithm for the spatially varying case
@@ -279,7 +567,7 @@ void mathDetail::basicConvolve(
             pexLog::TTrace<3>("lsst.afw.math.convolve",
                 "basicConvolve for LinearCombinationKernel: maxInterpolationError < 0; using brute force");
             return mathDetail::convolveWithBruteForce(convolvedImage, inImage, *refKernelPtr,
-                convolutionControl.getDoNormalize());
+                convolutionControl);
         }
     }
 }
@@ -287,6 +575,9 @@ void mathDetail::basicConvolve(
 /**
  * @brief A version of basicConvolve that should be used when convolving separable kernels
  *
+ * The output rows are split into convolutionControl.getNThreads() bands which are processed in parallel;
+ * the result is identical for any number of threads.
+ *
  * @ingroup afw
  */
 template <typename OutImageT, typename InImageT>
@@ -298,107 +589,46 @@ void mathDetail::basicConvolve(
 {
     typedef typename afwMath::Kernel::Pixel KernelPixel;
     typedef typename std::vector<KernelPixel> KernelVector;
-    typedef KernelVector::const_iterator KernelIterator;
-    typedef typename InImageT::const_x_iterator InXIterator;
-    typedef typename InImageT::const_xy_locator InXYLocator;
-    typedef typename OutImageT::x_iterator OutXIterator;
-    typedef typename OutImageT::y_iterator OutYIterator;
-    typedef typename OutImageT::SinglePixel OutPixel;
 
     assertDimensionsOK(convolvedImage, inImage, kernel);
     
     afwGeom::Box2I const fullBBox = inImage.getBBox(image::LOCAL);
     afwGeom::Box2I const goodBBox = kernel.shrinkBBox(fullBBox);
 
-    KernelVector kernelXVec(kernel.getWidth());
-    KernelVector kernelYVec(kernel.getHeight());
-    
+    int const nThreads = mathDetail::computeNThreads(convolutionControl.getNThreads());
+    std::vector<int> const bandEdges = mathDetail::computeBandEdges(
+        goodBBox.getMinY(), goodBBox.getMaxY() + 1, nThreads);
+    std::vector<boost::function<void ()> > bandList;
+    bandList.reserve(bandEdges.size() - 1);
+
     if (kernel.isSpatiallyVarying()) {
         pexLog::TTrace<3>("lsst.afw.math.convolve",
-            "SeparableKernel basicConvolve: kernel is spatially varying");
-
-        for (int cnvY = goodBBox.getMinY(); cnvY <= goodBBox.getMaxY(); ++cnvY) {
-            double const rowPos = inImage.indexToPosition(cnvY, afwImage::Y);
-            
-            InXYLocator inImLoc = inImage.xy_at(0, cnvY - goodBBox.getMinY());
-            OutXIterator cnvXIter = convolvedImage.row_begin(cnvY) + goodBBox.getMinX();
-            for (int cnvX = goodBBox.getMinX(); cnvX <= goodBBox.getMaxX();
-                ++cnvX, ++inImLoc.x(), ++cnvXIter) {
-                double const colPos = inImage.indexToPosition(cnvX, afwImage::X);
-
-                KernelPixel kSum = kernel.computeVectors(kernelXVec, kernelYVec,
-                    convolutionControl.getDoNormalize(), colPos, rowPos);
-
-                // why does this trigger warnings? It did not in the past.
-                *cnvXIter = afwMath::convolveAtAPoint<OutImageT, InImageT>(inImLoc, kernelXVec, kernelYVec);
-                if (convolutionControl.getDoNormalize()) {
-                    *cnvXIter = *cnvXIter/kSum;
-                }
-            }
+            "SeparableKernel basicConvolve: kernel is spatially varying; %d band(s)",
+            static_cast<int>(bandEdges.size()) - 1);
+
+        for (std::size_t i = 0; i + 1 < bandEdges.size(); ++i) {
+            afwMath::SeparableKernel::ConstPtr kernelPtr =
+                boost::dynamic_pointer_cast<afwMath::SeparableKernel const>(kernel.clone());
+            bandList.push_back(boost::bind(&convolveRowsWithVaryingSeparableKernel<OutImageT, InImageT>,
+                boost::ref(convolvedImage), boost::cref(inImage), kernelPtr,
+                convolutionControl.getDoNormalize(), goodBBox, bandEdges[i], bandEdges[i + 1]));
         }
+        mathDetail::runInParallel(bandList);
     } else {
-        // kernel is spatially invariant
-        // The basic sequence:
-        // - For each output row:
-        // - Compute x-convolved data: a kernel height's strip of input image convolved with kernel x vector
-        // - Compute one row of output by dotting each column of x-convolved data with the kernel y vector
-        // The x-convolved data is stored in a kernel-height by good-width buffer.
-        // This is circular buffer along y (to avoid shifting pixels before setting each new row);
-        // so for each new row the kernel y vector is rotated to match the order of the x-convolved data.
-
         pexLog::TTrace<3>("lsst.afw.math.convolve",
-            "SeparableKernel basicConvolve: kernel is spatially invariant");
+            "SeparableKernel basicConvolve: kernel is spatially invariant; %d band(s)",
+            static_cast<int>(bandEdges.size()) - 1);
 
+        KernelVector kernelXVec(kernel.getWidth());
+        KernelVector kernelYVec(kernel.getHeight());
         kernel.computeVectors(kernelXVec, kernelYVec, convolutionControl.getDoNormalize());
-        KernelIterator const kernelXVecBegin = kernelXVec.begin();
-        KernelIterator const kernelYVecBegin = kernelYVec.begin();
 
-        // buffer for x-convolved data
-        OutImageT buffer(afwGeom::Extent2I(goodBBox.getWidth(), kernel.getHeight()));
-        
-        // pre-fill x-convolved data buffer with all but one row of data
-        int yInd = 0; // during initial fill bufY = inImageY
-        int const yPrefillEnd = buffer.getHeight() - 1;
-        for (; yInd < yPrefillEnd; ++yInd) {
-            OutXIterator bufXIter = buffer.x_at(0, yInd);
-            OutXIterator const bufXEnd = buffer.x_at(goodBBox.getWidth(), yInd);
-            InXIterator inXIter = inImage.x_at(0, yInd);
-            for ( ; bufXIter != bufXEnd; ++bufXIter, ++inXIter) {
-                *bufXIter = kernelDotProduct<OutPixel, InXIterator, KernelIterator, KernelPixel>(
-                    inXIter, kernelXVecBegin, kernel.getWidth());
-            }
-        }
-
-        // compute output pixels using the sequence described above
-        int inY = yPrefillEnd;
-        int bufY = yPrefillEnd;
-        int cnvY = goodBBox.getMinY();
-        while (true) {
-            // fill next buffer row and compute output row
-            InXIterator inXIter = inImage.x_at(0, inY);
-            OutXIterator bufXIter = buffer.x_at(0, bufY);
-            OutXIterator cnvXIter = convolvedImage.x_at(goodBBox.getMinX(), cnvY);
-            for (int bufX = 0; bufX < goodBBox.getWidth(); ++bufX, ++cnvXIter, ++bufXIter, ++inXIter) {
-                // note: bufXIter points to the row of the buffer that is being updated,
-                // whereas bufYIter points to row 0 of the buffer
-                *bufXIter = kernelDotProduct<OutPixel, InXIterator, KernelIterator, KernelPixel>(
-                    inXIter, kernelXVecBegin, kernel.getWidth());
-
-                OutYIterator bufYIter = buffer.y_at(bufX, 0);
-                *cnvXIter = kernelDotProduct<OutPixel, OutYIterator, KernelIterator, KernelPixel>(
-                    bufYIter, kernelYVecBegin, kernel.getHeight());
-            }
-            
-            // test for done now, instead of the start of the loop,
-            // to avoid an unnecessary extra rotation of the kernel Y vector
-            if (cnvY >= goodBBox.getMaxY()) break;
-            
-            // update y indices, including bufY, and rotate the kernel y vector to match
-            ++inY;
-            bufY = (bufY + 1) % kernel.getHeight();
-            ++cnvY;
-            std::rotate(kernelYVec.begin(), kernelYVec.end()-1, kernelYVec.end());
+        for (std::size_t i = 0; i + 1 < bandEdges.size(); ++i) {
+            bandList.push_back(boost::bind(&convolveRowsWithSeparableKernelVectors<OutImageT, InImageT>,
+                boost::ref(convolvedImage), boost::cref(inImage), boost::cref(kernelXVec), kernelYVec,
+                goodBBox, bandEdges[i], bandEdges[i + 1]));
         }
+        mathDetail::runInParallel(bandList);
     }
 }
 
@@ -415,6 +645,10 @@ void mathDetail::basicConvolve(
  * - kernel.getWidth()  - 1 - kernel.getCtrX() along the right edge
  * - kernel.getHeight() - 1 - kernel.getCtrY() along the top edge
  *
+ * The output rows are split into convolutionControl.getNThreads() bands which are processed in parallel;
+ * each band uses its own copy of a spatially varying kernel. The result is identical for any number
+ * of threads.
+ *
  * @throw lsst::pex::exceptions::InvalidParameterException if convolvedImage dimensions != inImage dimensions
  * @throw lsst::pex::exceptions::InvalidParameterException if inImage smaller than kernel in width or height
  * @throw lsst::pex::exceptions::InvalidParameterException if kernel width or height < 1
@@ -426,80 +660,70 @@ void mathDetail::convolveWithBruteForce(
         OutImageT &convolvedImage,      ///< convolved %image
         InImageT const& inImage,        ///< %image to convolve
         afwMath::Kernel const& kernel,  ///< convolution kernel
-        bool doNormalize)               ///< if true, normalize the kernel, else use "as is"
+        afwMath::ConvolutionControl const& convolutionControl)  ///< convolution control parameters
 {
     typedef typename afwMath::Kernel::Pixel KernelPixel;
     typedef afwImage::Image<KernelPixel> KernelImage;
 
-    typedef typename KernelImage::const_x_iterator KernelXIterator;
-    typedef typename KernelImage::const_xy_locator KernelXYLocator;
-    typedef typename InImageT::const_x_iterator InXIterator;
-    typedef typename InImageT::const_xy_locator InXYLocator;
-    typedef typename OutImageT::x_iterator OutXIterator;
-    typedef typename OutImageT::SinglePixel OutPixel;
-
     assertDimensionsOK(convolvedImage, inImage, kernel);
     
-    int const inImageWidth = inImage.getWidth();
-    int const inImageHeight = inImage.getHeight();
-    int const kWidth = kernel.getWidth();
-    int const kHeight = kernel.getHeight();
-    int const cnvWidth = inImageWidth + 1 - kernel.getWidth();
-    int const cnvHeight = inImageHeight + 1 - kernel.getHeight();
+    int const cnvHeight = inImage.getHeight() + 1 - kernel.getHeight();
     int const cnvStartX = kernel.getCtrX();
     int const cnvStartY = kernel.getCtrY();
-    int const cnvEndX = cnvStartX + cnvWidth;  // end index + 1
     int const cnvEndY = cnvStartY + cnvHeight; // end index + 1
+    bool const doNormalize = convolutionControl.getDoNormalize();
 
-    KernelImage kernelImage(kernel.getDimensions());
-    KernelXYLocator const kernelLoc = kernelImage.xy_at(0,0);
+    int const nThreads = mathDetail::computeNThreads(convolutionControl.getNThreads());
+    std::vector<boost::function<void ()> > bandList;
 
     if (kernel.isSpatiallyVarying()) {
         pexLog::TTrace<5>("lsst.afw.math.convolve",
             "convolveWithBruteForce: kernel is spatially varying");
 
-        for (int cnvY = cnvStartY; cnvY != cnvEndY; ++cnvY) {
-            double const rowPos = inImage.indexToPosition(cnvY, afwImage::Y);
-            
-            InXYLocator  inImLoc =  inImage.xy_at(0, cnvY - cnvStartY);
-            OutXIterator cnvXIter = convolvedImage.x_at(cnvStartX, cnvY);
-            for (int cnvX = cnvStartX; cnvX != cnvEndX; ++cnvX, ++inImLoc.x(), ++cnvXIter) {
-                double const colPos = inImage.indexToPosition(cnvX, afwImage::X);
-
-                KernelPixel kSum = kernel.computeImage(kernelImage, false, colPos, rowPos);
-                *cnvXIter = afwMath::convolveAtAPoint<OutImageT, InImageT>(
-                    inImLoc, kernelLoc, kWidth, kHeight);
-                if (doNormalize) {
-                    *cnvXIter = *cnvXIter/kSum;
-                }
-            }
+        std::vector<int> const bandEdges = mathDetail::computeBandEdges(cnvStartY, cnvEndY, nThreads);
+        for (std::size_t i = 0; i + 1 < bandEdges.size(); ++i) {
+            afwMath::Kernel::ConstPtr kernelPtr = kernel.clone();
+            bandList.push_back(boost::bind(&convolveRowsWithVaryingKernel<OutImageT, InImageT>,
+                boost::ref(convolvedImage), boost::cref(inImage), kernelPtr, doNormalize,
+                bandEdges[i], bandEdges[i + 1]));
         }
+        mathDetail::runInParallel(bandList);
     } else {
         pexLog::TTrace<5>("lsst.afw.math.convolve",
             "convolveWithBruteForce: kernel is spatially invariant");
+        KernelImage kernelImage(kernel.getDimensions());
         (void)kernel.computeImage(kernelImage, doNormalize);
         
-        for (int inStartY = 0, cnvY = cnvStartY; inStartY < cnvHeight; ++inStartY, ++cnvY) {
-            KernelXIterator kernelXIter = kernelImage.x_at(0, 0);
-            InXIterator inXIter = inImage.x_at(0, inStartY);
-            OutXIterator cnvXIter = convolvedImage.x_at(cnvStartX, cnvY);
-            for (int x = 0; x < cnvWidth; ++x, ++cnvXIter, ++inXIter) {
-                *cnvXIter = kernelDotProduct<OutPixel, InXIterator, KernelXIterator, KernelPixel>(
-                    inXIter, kernelXIter, kWidth);
-            }
-            for (int kernelY = 1, inY = inStartY + 1; kernelY < kHeight; ++inY, ++kernelY) {
-                KernelXIterator kernelXIter = kernelImage.x_at(0, kernelY);
-                InXIterator inXIter = inImage.x_at(0, inY);
-                OutXIterator cnvXIter = convolvedImage.x_at(cnvStartX, cnvY);
-                for (int x = 0; x < cnvWidth; ++x, ++cnvXIter, ++inXIter) {
-                    *cnvXIter += kernelDotProduct<OutPixel, InXIterator, KernelXIterator, KernelPixel>(
-                        inXIter, kernelXIter, kWidth);
-                }
-            }
+        std::vector<int> const bandEdges = mathDetail::computeBandEdges(0, cnvHeight, nThreads);
+        for (std::size_t i = 0; i + 1 < bandEdges.size(); ++i) {
+            bandList.push_back(boost::bind(&convolveRowsWithKernelImage<OutImageT, InImageT>,
+                boost::ref(convolvedImage), boost::cref(inImage), boost::cref(kernelImage),
+                cnvStartX, cnvStartY, bandEdges[i], bandEdges[i + 1]));
         }
+        mathDetail::runInParallel(bandList);
     }
 }
 
+/**
+ * @brief Convolve an Image or MaskedImage with a Kernel by computing the kernel image
+ * at every point, using a single thread.
+ *
+ * @deprecated Use the version that takes a ConvolutionControl.
+ *
+ * @ingroup afw
+ */
+template <typename OutImageT, typename InImageT>
+void mathDetail::convolveWithBruteForce(
+        OutImageT &convolvedImage,      ///< convolved %image
+        InImageT const& inImage,        ///< %image to convolve
+        afwMath::Kernel const& kernel,  ///< convolution kernel
+        bool doNormalize)               ///< if true, normalize the kernel, else use "as is"
+{
+    afwMath::ConvolutionControl convolutionControl;
+    convolutionControl.setDoNormalize(doNormalize);
+    mathDetail::convolveWithBruteForce(convolvedImage, inImage, kernel, convolutionControl);
+}
+
 /*
  * Explicit instantiation
  */
@@ -521,6 +745,9 @@ void mathDetail::convolveWithBruteForce(
     template void mathDetail::basicConvolve( \
         IMGMACRO(OUTPIXTYPE)&, IMGMACRO(INPIXTYPE) const&, afwMath::SeparableKernel const&, \
             afwMath::ConvolutionControl const&); NL \
+    template void mathDetail::convolveWithBruteForce( \
+        IMGMACRO(OUTPIXTYPE)&, IMGMACRO(INPIXTYPE) const&, afwMath::Kernel const&, \
+            afwMath::ConvolutionControl const&); NL \
     template void mathDetail::convolveWithBruteForce( \
         IMGMACRO(OUTPIXTYPE)&, IMGMACRO(INPIXTYPE) const&, afwMath::Kernel const&, bool);
 // Instantiate both Image and MaskedImage versions
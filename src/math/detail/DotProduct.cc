@@ -0,0 +1,435 @@
+// -*- LSST-C++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file
+ *
+ * @brief Definition of vectorized dot products of %image and kernel rows
+ *
+ * SSE2 code is used if the compiler targets it (as it always does on x86_64). AVX2 code is compiled
+ * using gcc's per-function target attribute (so the rest of afw need not be built for AVX2)
+ * and is only used if the CPU supports it.
+ *
+ * Each vector lane computes image*kernel and keeps it only where the kernel pixel != 0,
+ * matching the generic code's handling of NaN %image pixels under zero kernel pixels.
+ *
+ * @ingroup afw
+ */
+#include "lsst/afw/math/detail/DotProduct.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#   define LSST_AFW_MATH_HAVE_SSE2 1
+#   include <emmintrin.h>
+#   if (__GNUC__ > 4) || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)
+#       define LSST_AFW_MATH_HAVE_AVX2 1
+#       include <immintrin.h>
+#   endif
+#endif
+
+namespace afwImage = lsst::afw::image;
+namespace mathDetail = lsst::afw::math::detail;
+
+namespace {
+
+    /*
+     * Scalar code, used for the last few pixels of a row that do not fill a vector
+     */
+    template <typename ImagePixelT>
+    inline double scalarDotProduct(ImagePixelT const *image, double const *kernel, int begin, int end) {
+        double sum = 0;
+        for (int i = begin; i < end; ++i) {
+            if (kernel[i] != 0) {
+                sum += image[i] * kernel[i];
+            }
+        }
+        return sum;
+    }
+
+    template <typename ImagePixelT>
+    inline void scalarMaskedDotProduct(
+        ImagePixelT const *image,
+        afwImage::MaskPixel const *mask,
+        afwImage::VariancePixel const *variance,
+        double const *kernel,
+        int begin,
+        int end,
+        double &imageSum,
+        afwImage::MaskPixel &maskSum,
+        double &varianceSum
+    ) {
+        for (int i = begin; i < end; ++i) {
+            double const kVal = kernel[i];
+            if (kVal != 0) {
+                imageSum += image[i] * kVal;
+                maskSum |= mask[i];
+                varianceSum += variance[i] * kVal * kVal;
+            }
+        }
+    }
+
+    /*
+     * OR of the mask pixels under nonzero kernel pixels; there is little to be gained by vectorizing this
+     */
+    inline afwImage::MaskPixel maskOr(afwImage::MaskPixel const *mask, double const *kernel, int n) {
+        afwImage::MaskPixel maskSum = 0;
+        for (int i = 0; i < n; ++i) {
+            if (kernel[i] != 0) {
+                maskSum |= mask[i];
+            }
+        }
+        return maskSum;
+    }
+
+#if defined(LSST_AFW_MATH_HAVE_SSE2)
+
+    inline double sumSse2(__m128d sum) {
+        double result[2];
+        _mm_storeu_pd(result, sum);
+        return result[0] + result[1];
+    }
+
+    /*
+     * Product of image and kernel, with lanes where the kernel is zero set to zero
+     */
+    inline __m128d maskedProductSse2(__m128d image, __m128d kernel) {
+        return _mm_and_pd(_mm_mul_pd(image, kernel), _mm_cmpneq_pd(kernel, _mm_setzero_pd()));
+    }
+
+    double dotProductSse2(float const *image, double const *kernel, int n) {
+        __m128d sum0 = _mm_setzero_pd();
+        __m128d sum1 = _mm_setzero_pd();
+        int i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m128 const im = _mm_loadu_ps(image + i);
+            sum0 = _mm_add_pd(sum0, maskedProductSse2(_mm_cvtps_pd(im), _mm_loadu_pd(kernel + i)));
+            sum1 = _mm_add_pd(sum1, maskedProductSse2(_mm_cvtps_pd(_mm_movehl_ps(im, im)),
+                                                      _mm_loadu_pd(kernel + i + 2)));
+        }
+        return sumSse2(_mm_add_pd(sum0, sum1)) + scalarDotProduct(image, kernel, i, n);
+    }
+
+    double dotProductSse2(double const *image, double const *kernel, int n) {
+        __m128d sum0 = _mm_setzero_pd();
+        __m128d sum1 = _mm_setzero_pd();
+        int i = 0;
+        for (; i + 4 <= n; i += 4) {
+            sum0 = _mm_add_pd(sum0, maskedProductSse2(_mm_loadu_pd(image + i), _mm_loadu_pd(kernel + i)));
+            sum1 = _mm_add_pd(sum1, maskedProductSse2(_mm_loadu_pd(image + i + 2),
+                                                      _mm_loadu_pd(kernel + i + 2)));
+        }
+        return sumSse2(_mm_add_pd(sum0, sum1)) + scalarDotProduct(image, kernel, i, n);
+    }
+
+    template <typename ImagePixelT>
+    void maskedDotProductSse2(
+        ImagePixelT const *image,
+        afwImage::MaskPixel const *mask,
+        afwImage::VariancePixel const *variance,
+        double const *kernel,
+        int n,
+        double &imageSum,
+        afwImage::MaskPixel &maskSum,
+        double &varianceSum
+    ) {
+        __m128d imSum = _mm_setzero_pd();
+        __m128d varSum = _mm_setzero_pd();
+        int i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m128 const var = _mm_loadu_ps(variance + i);
+            __m128d const k0 = _mm_loadu_pd(kernel + i);
+            __m128d const k1 = _mm_loadu_pd(kernel + i + 2);
+            imSum = _mm_add_pd(imSum, maskedProductSse2(_mm_set_pd(image[i + 1], image[i]), k0));
+            imSum = _mm_add_pd(imSum, maskedProductSse2(_mm_set_pd(image[i + 3], image[i + 2]), k1));
+            varSum = _mm_add_pd(varSum, maskedProductSse2(_mm_mul_pd(_mm_cvtps_pd(var), k0), k0));
+            varSum = _mm_add_pd(varSum,
+                maskedProductSse2(_mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(var, var)), k1), k1));
+        }
+        imageSum = sumSse2(imSum);
+        varianceSum = sumSse2(varSum);
+        maskSum = maskOr(mask, kernel, i);
+        scalarMaskedDotProduct(image, mask, variance, kernel, i, n, imageSum, maskSum, varianceSum);
+    }
+
+#endif // LSST_AFW_MATH_HAVE_SSE2
+
+#if defined(LSST_AFW_MATH_HAVE_AVX2)
+
+    __attribute__((target("avx2")))
+    inline double sumAvx2(__m256d sum) {
+        double result[4];
+        _mm256_storeu_pd(result, sum);
+        return (result[0] + result[1]) + (result[2] + result[3]);
+    }
+
+    __attribute__((target("avx2")))
+    inline __m256d maskedProductAvx2(__m256d image, __m256d kernel) {
+        return _mm256_and_pd(_mm256_mul_pd(image, kernel),
+                             _mm256_cmp_pd(kernel, _mm256_setzero_pd(), _CMP_NEQ_UQ));
+    }
+
+    __attribute__((target("avx2")))
+    double dotProductAvx2(float const *image, double const *kernel, int n) {
+        __m256d sum0 = _mm256_setzero_pd();
+        __m256d sum1 = _mm256_setzero_pd();
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            sum0 = _mm256_add_pd(sum0, maskedProductAvx2(_mm256_cvtps_pd(_mm_loadu_ps(image + i)),
+                                                         _mm256_loadu_pd(kernel + i)));
+            sum1 = _mm256_add_pd(sum1, maskedProductAvx2(_mm256_cvtps_pd(_mm_loadu_ps(image + i + 4)),
+                                                         _mm256_loadu_pd(kernel + i + 4)));
+        }
+        if (i + 4 <= n) {
+            sum0 = _mm256_add_pd(sum0, maskedProductAvx2(_mm256_cvtps_pd(_mm_loadu_ps(image + i)),
+                                                         _mm256_loadu_pd(kernel + i)));
+            i += 4;
+        }
+        return sumAvx2(_mm256_add_pd(sum0, sum1)) + scalarDotProduct(image, kernel, i, n);
+    }
+
+    __attribute__((target("avx2")))
+    double dotProductAvx2(double const *image, double const *kernel, int n) {
+        __m256d sum0 = _mm256_setzero_pd();
+        __m256d sum1 = _mm256_setzero_pd();
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            sum0 = _mm256_add_pd(sum0, maskedProductAvx2(_mm256_loadu_pd(image + i),
+                                                         _mm256_loadu_pd(kernel + i)));
+            sum1 = _mm256_add_pd(sum1, maskedProductAvx2(_mm256_loadu_pd(image + i + 4),
+                                                         _mm256_loadu_pd(kernel + i + 4)));
+        }
+        if (i + 4 <= n) {
+            sum0 = _mm256_add_pd(sum0, maskedProductAvx2(_mm256_loadu_pd(image + i),
+                                                         _mm256_loadu_pd(kernel + i)));
+            i += 4;
+        }
+        return sumAvx2(_mm256_add_pd(sum0, sum1)) + scalarDotProduct(image, kernel, i, n);
+    }
+
+    __attribute__((target("avx2")))
+    inline __m256d loadAvx2(float const *image) {
+        return _mm256_cvtps_pd(_mm_loadu_ps(image));
+    }
+
+    __attribute__((target("avx2")))
+    inline __m256d loadAvx2(double const *image) {
+        return _mm256_loadu_pd(image);
+    }
+
+    template <typename ImagePixelT>
+    __attribute__((target("avx2")))
+    void maskedDotProductAvx2(
+        ImagePixelT const *image,
+        afwImage::MaskPixel const *mask,
+        afwImage::VariancePixel const *variance,
+        double const *kernel,
+        int n,
+        double &imageSum,
+        afwImage::MaskPixel &maskSum,
+        double &varianceSum
+    ) {
+        __m256d imSum = _mm256_setzero_pd();
+        __m256d varSum = _mm256_setzero_pd();
+        int i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m256d const k = _mm256_loadu_pd(kernel + i);
+            imSum = _mm256_add_pd(imSum, maskedProductAvx2(loadAvx2(image + i), k));
+            varSum = _mm256_add_pd(varSum, maskedProductAvx2(_mm256_mul_pd(loadAvx2(variance + i), k), k));
+        }
+        imageSum = sumAvx2(imSum);
+        varianceSum = sumAvx2(varSum);
+        maskSum = maskOr(mask, kernel, i);
+        scalarMaskedDotProduct(image, mask, variance, kernel, i, n, imageSum, maskSum, varianceSum);
+    }
+
+#endif // LSST_AFW_MATH_HAVE_AVX2
+
+    /*
+     * Return the best instruction set supported by both this build and the CPU
+     */
+    mathDetail::SimdLevel computeMaxSimdLevel() {
+#if defined(LSST_AFW_MATH_HAVE_AVX2)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return mathDetail::SIMD_AVX2;
+        }
+#endif
+#if defined(LSST_AFW_MATH_HAVE_SSE2)
+        return mathDetail::SIMD_SSE2;
+#else
+        return mathDetail::SIMD_NONE;
+#endif
+    }
+
+    mathDetail::SimdLevel const maxSimdLevel = computeMaxSimdLevel();
+    mathDetail::SimdLevel simdLevel = maxSimdLevel;
+
+}   // anonymous namespace
+
+/**
+ * @brief Return the instruction set currently used to vectorize dot products
+ */
+mathDetail::SimdLevel mathDetail::getSimdLevel() {
+    return simdLevel;
+}
+
+/**
+ * @brief Return the best instruction set supported by this build of afw and by the CPU
+ *
+ * This is the default for getSimdLevel.
+ */
+mathDetail::SimdLevel mathDetail::getMaxSimdLevel() {
+    return maxSimdLevel;
+}
+
+/**
+ * @brief Set the instruction set used to vectorize dot products
+ *
+ * Intended for testing and benchmarking. Levels above getMaxSimdLevel() are silently reduced to it.
+ *
+ * @warning Not thread safe: do not call while another thread is convolving.
+ */
+void mathDetail::setSimdLevel(
+        SimdLevel level)    ///< desired instruction set; SIMD_NONE to use the generic (template) code
+{
+    simdLevel = (level > maxSimdLevel) ? maxSimdLevel : level;
+}
+
+/**
+ * @brief Compute the dot product of a row of float %image pixels and a row of kernel pixels
+ *
+ * Terms for which the kernel pixel is 0 are skipped.
+ * Callers should check getSimdLevel() != SIMD_NONE before calling this function; otherwise it is
+ * computed using scalar code.
+ */
+double mathDetail::dotProduct(
+        float const *image,     ///< first %image pixel
+        double const *kernel,   ///< first kernel pixel
+        int n)                  ///< number of pixels
+{
+    switch (simdLevel) {
+#if defined(LSST_AFW_MATH_HAVE_AVX2)
+      case SIMD_AVX2:
+        return dotProductAvx2(image, kernel, n);
+#endif
+#if defined(LSST_AFW_MATH_HAVE_SSE2)
+      case SIMD_SSE2:
+        return dotProductSse2(image, kernel, n);
+#endif
+      default:
+        return scalarDotProduct(image, kernel, 0, n);
+    }
+}
+
+/**
+ * @brief Compute the dot product of a row of double %image pixels and a row of kernel pixels
+ *
+ * @copydetails dotProduct(float const *, double const *, int)
+ */
+double mathDetail::dotProduct(
+        double const *image,    ///< first %image pixel
+        double const *kernel,   ///< first kernel pixel
+        int n)                  ///< number of pixels
+{
+    switch (simdLevel) {
+#if defined(LSST_AFW_MATH_HAVE_AVX2)
+      case SIMD_AVX2:
+        return dotProductAvx2(image, kernel, n);
+#endif
+#if defined(LSST_AFW_MATH_HAVE_SSE2)
+      case SIMD_SSE2:
+        return dotProductSse2(image, kernel, n);
+#endif
+      default:
+        return scalarDotProduct(image, kernel, 0, n);
+    }
+}
+
+/**
+ * @brief Compute the dot product of a row of MaskedImage pixels and a row of kernel pixels
+ *
+ * Computes sum(image * kernel), the OR of the mask pixels and sum(variance * kernel^2),
+ * in each case skipping terms for which the kernel pixel is 0.
+ */
+void mathDetail::maskedDotProduct(
+        float const *image,                     ///< first %image pixel
+        afwImage::MaskPixel const *mask,        ///< first mask pixel
+        afwImage::VariancePixel const *variance,    ///< first variance pixel
+        double const *kernel,                   ///< first kernel pixel
+        int n,                                  ///< number of pixels
+        double &imageSum,                       ///< computed dot product of %image
+        afwImage::MaskPixel &maskSum,           ///< computed OR of mask
+        double &varianceSum)                    ///< computed dot product of variance and kernel^2
+{
+    switch (simdLevel) {
+#if defined(LSST_AFW_MATH_HAVE_AVX2)
+      case SIMD_AVX2:
+        maskedDotProductAvx2(image, mask, variance, kernel, n, imageSum, maskSum, varianceSum);
+        return;
+#endif
+#if defined(LSST_AFW_MATH_HAVE_SSE2)
+      case SIMD_SSE2:
+        maskedDotProductSse2(image, mask, variance, kernel, n, imageSum, maskSum, varianceSum);
+        return;
+#endif
+      default:
+        imageSum = 0;
+        maskSum = 0;
+        varianceSum = 0;
+        scalarMaskedDotProduct(image, mask, variance, kernel, 0, n, imageSum, maskSum, varianceSum);
+    }
+}
+
+/**
+ * @brief Compute the dot product of a row of MaskedImage pixels and a row of kernel pixels
+ *
+ * @copydetails maskedDotProduct(float const *, afwImage::MaskPixel const *, afwImage::VariancePixel const *, double const *, int, double &, afwImage::MaskPixel &, double &)
+ */
+void mathDetail::maskedDotProduct(
+        double const *image,                    ///< first %image pixel
+        afwImage::MaskPixel const *mask,        ///< first mask pixel
+        afwImage::VariancePixel const *variance,    ///< first variance pixel
+        double const *kernel,                   ///< first kernel pixel
+        int n,                                  ///< number of pixels
+        double &imageSum,                       ///< computed dot product of %image
+        afwImage::MaskPixel &maskSum,           ///< computed OR of mask
+        double &varianceSum)                    ///< computed dot product of variance and kernel^2
+{
+    switch (simdLevel) {
+#if defined(LSST_AFW_MATH_HAVE_AVX2)
+      case SIMD_AVX2:
+        maskedDotProductAvx2(image, mask, variance, kernel, n, imageSum, maskSum, varianceSum);
+        return;
+#endif
+#if defined(LSST_AFW_MATH_HAVE_SSE2)
+      case SIMD_SSE2:
+        maskedDotProductSse2(image, mask, variance, kernel, n, imageSum, maskSum, varianceSum);
+        return;
+#endif
+      default:
+        imageSum = 0;
+        maskSum = 0;
+        varianceSum = 0;
+        scalarMaskedDotProduct(image, mask, variance, kernel, 0, n, imageSum, maskSum, varianceSum);
+    }
+}
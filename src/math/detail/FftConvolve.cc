@@ -0,0 +1,589 @@
+// -*- LSST-C++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file
+ *
+ * @brief Definition of convolveWithFft declared in detail/Convolve.h
+ *
+ * The image is convolved using FFTW and the overlap-save method: the good region of the output
+ * is divided into tiles; for each tile the corresponding block of input (the tile grown by the kernel size)
+ * is Fourier transformed, multiplied by the transform of the kernel and transformed back.
+ * The portion of the cyclic convolution that is not contaminated by wrap-around is exactly the tile.
+ *
+ * @ingroup afw
+ */
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include "boost/bind.hpp"
+#include "boost/cstdint.hpp"
+#include "boost/function.hpp"
+#include "boost/noncopyable.hpp"
+#include "boost/shared_ptr.hpp"
+#include "boost/thread/mutex.hpp"
+
+#include "fftw3.h"
+
+#include "lsst/utils/ieee.h"
+#include "lsst/pex/exceptions.h"
+#include "lsst/pex/logging/Trace.h"
+#include "lsst/afw/image.h"
+#include "lsst/afw/math.h"
+#include "lsst/afw/geom.h"
+#include "lsst/afw/math/detail/Convolve.h"
+#include "lsst/afw/math/detail/Parallel.h"
+
+namespace pexExcept = lsst::pex::exceptions;
+namespace pexLog = lsst::pex::logging;
+namespace afwGeom = lsst::afw::geom;
+namespace afwImage = lsst::afw::image;
+namespace afwMath = lsst::afw::math;
+namespace mathDetail = lsst::afw::math::detail;
+
+namespace {
+
+    typedef afwImage::Image<afwMath::Kernel::Pixel> KernelImage;
+
+    int const MinFftBlockSize = 256;    // minimum width or height of a block (unless the image is smaller)
+
+    /*
+     * Return the smallest integer >= n whose only prime factors are 2, 3, 5 and 7 (for which FFTW is fast)
+     */
+    int goodFftSize(int n) {
+        for (int size = std::max(n, 1); ; ++size) {
+            int rem = size;
+            int const factors[] = {2, 3, 5, 7};
+            for (int i = 0; i < 4; ++i) {
+                while (rem % factors[i] == 0) {
+                    rem /= factors[i];
+                }
+            }
+            if (rem == 1) {
+                return size;
+            }
+        }
+    }
+
+    /*
+     * Return the width or height of the FFT block for one axis
+     *
+     * Blocks are large compared to the kernel (so that little of each transform is wasted on the overlap)
+     * but not larger than needed to cover the whole image.
+     */
+    int computeBlockSize(
+        int kernelSize, ///< kernel width or height
+        int imageSize)  ///< image width or height
+    {
+        int const blockSize = goodFftSize(std::max(4 * kernelSize, MinFftBlockSize));
+        return std::min(blockSize, goodFftSize(imageSize));
+    }
+
+    /*
+     * A buffer allocated with fftw_malloc (thus suitably aligned for any FFTW plan)
+     */
+    template <typename T>
+    class FftwBuffer : private boost::noncopyable {
+    public:
+        explicit FftwBuffer(std::size_t size) :
+            _data(static_cast<T *>(fftw_malloc(sizeof(T) * size)))
+        {
+            if (!_data) {
+                throw LSST_EXCEPT(pexExcept::MemoryException, "Could not allocate FFTW buffer");
+            }
+        }
+        ~FftwBuffer() { fftw_free(_data); }
+        T *get() const { return _data; }
+    private:
+        T *_data;
+    };
+
+    /*
+     * Forward (real to complex) and inverse (complex to real) FFTW plans for one block size
+     *
+     * Plans are created once (FFTW's planner is not thread-safe, so this is done under a lock)
+     * and then only used via the new-array execute functions, which are thread-safe.
+     * All arrays must be allocated with fftw_malloc so their alignment matches that used for planning.
+     */
+    class FftPlans : private boost::noncopyable {
+    public:
+        typedef boost::shared_ptr<FftPlans const> ConstPtr;
+
+        int getWidth() const { return _width; }
+        int getHeight() const { return _height; }
+        /// Number of elements in the real array
+        std::size_t getRealSize() const { return static_cast<std::size_t>(_width) * _height; }
+        /// Number of elements in the complex (half-plane) array
+        std::size_t getComplexSize() const { return static_cast<std::size_t>(_width / 2 + 1) * _height; }
+
+        void forward(double *in, fftw_complex *out) const { fftw_execute_dft_r2c(_forward, in, out); }
+        /// Inverse transform; destroys the input
+        void inverse(fftw_complex *in, double *out) const { fftw_execute_dft_c2r(_inverse, in, out); }
+
+        ~FftPlans() {
+            boost::mutex::scoped_lock lock(_plannerMutex);
+            fftw_destroy_plan(_forward);
+            fftw_destroy_plan(_inverse);
+        }
+
+        /*
+         * Return plans for the given block size, creating (and caching) them if necessary
+         */
+        static ConstPtr get(int width, int height) {
+            boost::mutex::scoped_lock lock(_plannerMutex);
+            std::pair<int, int> const key(width, height);
+            PlanCache::const_iterator const cacheIter = _planCache.find(key);
+            if (cacheIter != _planCache.end()) {
+                return cacheIter->second;
+            }
+            ConstPtr plansPtr(new FftPlans(width, height));
+            _planCache[key] = plansPtr;
+            return plansPtr;
+        }
+
+    private:
+        typedef std::map<std::pair<int, int>, ConstPtr> PlanCache;
+
+        // call only while holding _plannerMutex
+        FftPlans(int width, int height) : _width(width), _height(height) {
+            // FFTW_MEASURE overwrites the arrays, so plan using scratch arrays
+            FftwBuffer<double> realBuffer(getRealSize());
+            FftwBuffer<fftw_complex> complexBuffer(getComplexSize());
+            _forward = fftw_plan_dft_r2c_2d(_height, _width, realBuffer.get(), complexBuffer.get(),
+                FFTW_MEASURE);
+            _inverse = fftw_plan_dft_c2r_2d(_height, _width, complexBuffer.get(), realBuffer.get(),
+                FFTW_MEASURE);
+            if (!_forward || !_inverse) {
+                throw LSST_EXCEPT(pexExcept::RuntimeErrorException, "Could not create FFTW plans");
+            }
+        }
+
+        int _width;
+        int _height;
+        fftw_plan _forward;
+        fftw_plan _inverse;
+
+        static boost::mutex _plannerMutex;
+        static PlanCache _planCache;
+    };
+
+    boost::mutex FftPlans::_plannerMutex;
+    FftPlans::PlanCache FftPlans::_planCache;
+
+    /*
+     * The Fourier transform of a (flipped, zero-padded) kernel image, for one block size
+     *
+     * Convolution in afw is a correlation: out(x + ctrX, y + ctrY) = sum over i,j of in(x+i, y+j) k(i,j),
+     * so the kernel is flipped before it is transformed.  The 1/N normalization of the inverse transform
+     * is folded into the kernel transform.
+     */
+    class KernelTransform : private boost::noncopyable {
+    public:
+        KernelTransform(
+            KernelImage const &kernelImage, ///< kernel image
+            bool doSquare,                  ///< square the kernel pixels? (as needed for variance)
+            FftPlans const &plans)          ///< plans for the block size
+        :
+            _data(plans.getComplexSize())
+        {
+            int const kWidth = kernelImage.getWidth();
+            int const kHeight = kernelImage.getHeight();
+            FftwBuffer<double> padded(plans.getRealSize());
+            std::fill(padded.get(), padded.get() + plans.getRealSize(), 0.0);
+            for (int j = 0; j < kHeight; ++j) {
+                double *paddedRow = padded.get() + static_cast<std::size_t>(kHeight - 1 - j) * plans.getWidth();
+                KernelImage::const_x_iterator kIter = kernelImage.row_begin(j);
+                for (int i = 0; i < kWidth; ++i, ++kIter) {
+                    double const kVal = *kIter;
+                    paddedRow[kWidth - 1 - i] = doSquare ? kVal * kVal : kVal;
+                }
+            }
+            plans.forward(padded.get(), _data.get());
+
+            double const scale = 1.0 / static_cast<double>(plans.getRealSize());
+            for (std::size_t i = 0; i < plans.getComplexSize(); ++i) {
+                _data.get()[i][0] *= scale;
+                _data.get()[i][1] *= scale;
+            }
+        }
+
+        fftw_complex const *get() const { return _data.get(); }
+    private:
+        FftwBuffer<fftw_complex> _data;
+    };
+
+    /*
+     * Convolve a band of tile rows of one image plane using FFTs
+     *
+     * Tiles whose input block contains a non-finite pixel are computed directly instead,
+     * since a NaN or infinity would otherwise contaminate the whole tile.
+     * As with brute force convolution, kernel pixels that are exactly zero are ignored.
+     */
+    template <typename OutPixelT, typename InPixelT>
+    void convolveTileRowsWithFft(
+        afwImage::Image<OutPixelT> &outImage,   ///< convolved image plane
+        afwImage::Image<InPixelT> const &inImage,   ///< image plane to convolve
+        KernelImage const &kernelImage,         ///< kernel image (not squared)
+        bool doSquare,                          ///< square the kernel pixels? (as needed for variance)
+        KernelTransform const &kernelTransform, ///< transform of (possibly squared) kernel
+        FftPlans const &plans,                  ///< FFT plans
+        afwGeom::Point2I const &kernelCtr,      ///< kernel center
+        int tileRowBegin,                       ///< first row of tiles to compute
+        int tileRowEnd)                         ///< last row of tiles to compute + 1
+    {
+        typedef typename afwImage::Image<InPixelT>::const_x_iterator InXIterator;
+        typedef typename afwImage::Image<OutPixelT>::x_iterator OutXIterator;
+
+        int const kWidth = kernelImage.getWidth();
+        int const kHeight = kernelImage.getHeight();
+        int const blockWidth = plans.getWidth();
+        int const blockHeight = plans.getHeight();
+        int const tileWidth = blockWidth + 1 - kWidth;
+        int const tileHeight = blockHeight + 1 - kHeight;
+        int const cnvWidth = inImage.getWidth() + 1 - kWidth;
+        int const cnvHeight = inImage.getHeight() + 1 - kHeight;
+
+        FftwBuffer<double> realBuffer(plans.getRealSize());
+        FftwBuffer<fftw_complex> complexBuffer(plans.getComplexSize());
+
+        for (int tileRow = tileRowBegin; tileRow < tileRowEnd; ++tileRow) {
+            int const y0 = tileRow * tileHeight;    // index of input row at bottom of block
+            int const nOutY = std::min(tileHeight, cnvHeight - y0);
+            int const nInY = std::min(blockHeight, inImage.getHeight() - y0);
+
+            for (int x0 = 0; x0 < cnvWidth; x0 += tileWidth) {
+                int const nOutX = std::min(tileWidth, cnvWidth - x0);
+                int const nInX = std::min(blockWidth, inImage.getWidth() - x0);
+
+                // copy the input block, zero-padding past the edge of the image
+                bool isFinite = true;
+                std::fill(realBuffer.get(), realBuffer.get() + plans.getRealSize(), 0.0);
+                for (int j = 0; j < nInY; ++j) {
+                    double *blockPtr = realBuffer.get() + static_cast<std::size_t>(j) * blockWidth;
+                    InXIterator inIter = inImage.x_at(x0, y0 + j);
+                    for (int i = 0; i < nInX; ++i, ++inIter, ++blockPtr) {
+                        *blockPtr = *inIter;
+                    }
+                }
+                for (std::size_t i = 0; i < plans.getRealSize(); ++i) {
+                    if (!lsst::utils::isfinite(realBuffer.get()[i])) {
+                        isFinite = false;
+                        break;
+                    }
+                }
+
+                if (isFinite) {
+                    plans.forward(realBuffer.get(), complexBuffer.get());
+                    fftw_complex *cPtr = complexBuffer.get();
+                    fftw_complex const *kPtr = kernelTransform.get();
+                    for (std::size_t i = 0; i < plans.getComplexSize(); ++i, ++cPtr, ++kPtr) {
+                        double const re = (*cPtr)[0] * (*kPtr)[0] - (*cPtr)[1] * (*kPtr)[1];
+                        double const im = (*cPtr)[0] * (*kPtr)[1] + (*cPtr)[1] * (*kPtr)[0];
+                        (*cPtr)[0] = re;
+                        (*cPtr)[1] = im;
+                    }
+                    plans.inverse(complexBuffer.get(), realBuffer.get());
+
+                    // the uncontaminated part of the cyclic convolution starts at (kWidth-1, kHeight-1)
+                    for (int j = 0; j < nOutY; ++j) {
+                        double const *blockPtr = realBuffer.get()
+                            + static_cast<std::size_t>(j + kHeight - 1) * blockWidth + (kWidth - 1);
+                        OutXIterator outIter = outImage.x_at(x0 + kernelCtr.getX(), y0 + j + kernelCtr.getY());
+                        for (int i = 0; i < nOutX; ++i, ++outIter, ++blockPtr) {
+                            *outIter = static_cast<OutPixelT>(*blockPtr);
+                        }
+                    }
+                } else {
+                    // compute directly from the unmodified block
+                    for (int j = 0; j < nOutY; ++j) {
+                        OutXIterator outIter = outImage.x_at(x0 + kernelCtr.getX(), y0 + j + kernelCtr.getY());
+                        for (int i = 0; i < nOutX; ++i, ++outIter) {
+                            double sum = 0;
+                            for (int kj = 0; kj < kHeight; ++kj) {
+                                KernelImage::const_x_iterator kIter = kernelImage.row_begin(kj);
+                                double const *blockPtr = realBuffer.get()
+                                    + static_cast<std::size_t>(j + kj) * blockWidth + i;
+                                for (int ki = 0; ki < kWidth; ++ki, ++kIter, ++blockPtr) {
+                                    double const kVal = *kIter;
+                                    if (kVal != 0) {
+                                        sum += *blockPtr * (doSquare ? kVal * kVal : kVal);
+                                    }
+                                }
+                            }
+                            *outIter = static_cast<OutPixelT>(sum);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    /*
+     * Convolve one image plane using FFTs, splitting the rows of tiles among threads
+     */
+    template <typename OutPixelT, typename InPixelT>
+    void convolvePlaneWithFft(
+        afwImage::Image<OutPixelT> &outImage,   ///< convolved image plane
+        afwImage::Image<InPixelT> const &inImage,   ///< image plane to convolve
+        KernelImage const &kernelImage,         ///< kernel image
+        bool doSquare,                          ///< square the kernel pixels? (as needed for variance)
+        FftPlans const &plans,                  ///< FFT plans
+        afwGeom::Point2I const &kernelCtr,      ///< kernel center
+        int nThreads)                           ///< number of threads
+    {
+        KernelTransform const kernelTransform(kernelImage, doSquare, plans);
+
+        int const tileHeight = plans.getHeight() + 1 - kernelImage.getHeight();
+        int const cnvHeight = inImage.getHeight() + 1 - kernelImage.getHeight();
+        int const nTileRows = (cnvHeight + tileHeight - 1) / tileHeight;
+
+        std::vector<int> const bandEdges = mathDetail::computeBandEdges(0, nTileRows, nThreads);
+        std::vector<boost::function<void ()> > bandList;
+        for (std::size_t i = 0; i + 1 < bandEdges.size(); ++i) {
+            bandList.push_back(boost::bind(&convolveTileRowsWithFft<OutPixelT, InPixelT>,
+                boost::ref(outImage), boost::cref(inImage), boost::cref(kernelImage), doSquare,
+                boost::cref(kernelTransform), boost::cref(plans), kernelCtr, bandEdges[i], bandEdges[i + 1]));
+        }
+        mathDetail::runInParallel(bandList);
+    }
+
+    /*
+     * Compute a band of rows of the convolved mask: the OR of all input mask pixels that lie under
+     * a nonzero kernel pixel
+     *
+     * Each row of the kernel is decomposed into runs of nonzero pixels; the OR over a run is computed
+     * using the van Herk/Gil-Werman algorithm, which costs ~3 operations per pixel regardless of run length.
+     */
+    template <typename MaskPixelT>
+    void convolveMaskRows(
+        afwImage::Mask<MaskPixelT> &outMask,    ///< convolved mask
+        afwImage::Mask<MaskPixelT> const &inMask,   ///< mask to convolve
+        std::vector<std::vector<std::pair<int, int> > > const &runList,
+            ///< for each kernel row: (start, length) of each run of nonzero kernel pixels
+        afwGeom::Point2I const &kernelCtr,      ///< kernel center
+        int kWidth,                             ///< kernel width
+        int cnvYBegin,                          ///< first output row (relative to the good region)
+        int cnvYEnd)                            ///< last output row + 1
+    {
+        int const cnvWidth = inMask.getWidth() + 1 - kWidth;
+        std::vector<MaskPixelT> accum(cnvWidth);
+        std::vector<MaskPixelT> prefix(inMask.getWidth());
+        std::vector<MaskPixelT> suffix(inMask.getWidth());
+
+        for (int y = cnvYBegin; y < cnvYEnd; ++y) {
+            std::fill(accum.begin(), accum.end(), 0);
+            for (std::size_t kj = 0; kj < runList.size(); ++kj) {
+                typename afwImage::Mask<MaskPixelT>::const_x_iterator const inRow = inMask.row_begin(y + kj);
+                for (std::vector<std::pair<int, int> >::const_iterator runIter = runList[kj].begin();
+                    runIter != runList[kj].end(); ++runIter) {
+                    int const start = runIter->first;
+                    int const length = runIter->second;
+                    int const n = cnvWidth + length - 1;  // number of input pixels touched by this run
+                    for (int i = 0; i < n; ++i) {
+                        MaskPixelT const val = inRow[start + i];
+                        prefix[i] = (i % length == 0) ? val : (prefix[i - 1] | val);
+                    }
+                    for (int i = n - 1; i >= 0; --i) {
+                        MaskPixelT const val = inRow[start + i];
+                        suffix[i] = ((i + 1) % length == 0 || i == n - 1) ? val : (suffix[i + 1] | val);
+                    }
+                    for (int x = 0; x < cnvWidth; ++x) {
+                        accum[x] |= suffix[x] | prefix[x + length - 1];
+                    }
+                }
+            }
+            std::copy(accum.begin(), accum.end(), outMask.x_at(kernelCtr.getX(), y + kernelCtr.getY()));
+        }
+    }
+
+    template <typename MaskPixelT>
+    void convolveMask(
+        afwImage::Mask<MaskPixelT> &outMask,    ///< convolved mask
+        afwImage::Mask<MaskPixelT> const &inMask,   ///< mask to convolve
+        KernelImage const &kernelImage,         ///< kernel image
+        afwGeom::Point2I const &kernelCtr,      ///< kernel center
+        int nThreads)                           ///< number of threads
+    {
+        std::vector<std::vector<std::pair<int, int> > > runList(kernelImage.getHeight());
+        for (int kj = 0; kj < kernelImage.getHeight(); ++kj) {
+            KernelImage::const_x_iterator kIter = kernelImage.row_begin(kj);
+            for (int ki = 0; ki < kernelImage.getWidth(); ) {
+                if (kIter[ki] == 0) {
+                    ++ki;
+                    continue;
+                }
+                int const start = ki;
+                while (ki < kernelImage.getWidth() && kIter[ki] != 0) {
+                    ++ki;
+                }
+                runList[kj].push_back(std::make_pair(start, ki - start));
+            }
+        }
+
+        int const cnvHeight = inMask.getHeight() + 1 - kernelImage.getHeight();
+        std::vector<int> const bandEdges = mathDetail::computeBandEdges(0, cnvHeight, nThreads);
+        std::vector<boost::function<void ()> > bandList;
+        for (std::size_t i = 0; i + 1 < bandEdges.size(); ++i) {
+            bandList.push_back(boost::bind(&convolveMaskRows<MaskPixelT>,
+                boost::ref(outMask), boost::cref(inMask), boost::cref(runList), kernelCtr,
+                kernelImage.getWidth(), bandEdges[i], bandEdges[i + 1]));
+        }
+        mathDetail::runInParallel(bandList);
+    }
+
+    /*
+     * Convolve an Image using FFTs
+     */
+    template <typename OutImageT, typename InImageT>
+    void convolveWithFftImpl(
+        OutImageT &convolvedImage,
+        InImageT const &inImage,
+        KernelImage const &kernelImage,
+        afwGeom::Point2I const &kernelCtr,
+        FftPlans const &plans,
+        int nThreads,
+        afwImage::detail::Image_tag)
+    {
+        convolvePlaneWithFft(convolvedImage, inImage, kernelImage, false, plans, kernelCtr, nThreads);
+    }
+
+    /*
+     * Convolve a MaskedImage using FFTs: the image plane is convolved with the kernel,
+     * the variance plane with the square of the kernel and the mask plane is ORed over the kernel footprint
+     */
+    template <typename OutImageT, typename InImageT>
+    void convolveWithFftImpl(
+        OutImageT &convolvedImage,
+        InImageT const &inImage,
+        KernelImage const &kernelImage,
+        afwGeom::Point2I const &kernelCtr,
+        FftPlans const &plans,
+        int nThreads,
+        afwImage::detail::MaskedImage_tag)
+    {
+        convolvePlaneWithFft(*convolvedImage.getImage(), *inImage.getImage(), kernelImage, false,
+            plans, kernelCtr, nThreads);
+        convolvePlaneWithFft(*convolvedImage.getVariance(), *inImage.getVariance(), kernelImage, true,
+            plans, kernelCtr, nThreads);
+        convolveMask(*convolvedImage.getMask(), *inImage.getMask(), kernelImage, kernelCtr, nThreads);
+    }
+
+}   // anonymous namespace
+
+/**
+ * @brief Convolve an Image or MaskedImage with a spatially invariant Kernel using FFTs.
+ *
+ * @warning Low-level convolution function that does not set edge pixels.
+ *
+ * The output is the same as convolveWithBruteForce to within roundoff error, with these notes:
+ * - for a MaskedImage the variance plane is convolved with the square of the kernel and the mask plane
+ *   is the OR of all mask pixels under nonzero kernel pixels, exactly as for brute force convolution;
+ * - tiles of input containing NaN or infinite pixels are convolved directly, so non-finite values
+ *   spread only as far as they would with brute force convolution;
+ * - the sum is computed in double precision and cast to the output pixel type, so integer output
+ *   is not truncated term-by-term as it is by brute force convolution.
+ *
+ * FFTW plans are cached for each block size, so repeated convolutions of similar images are fast.
+ * The tiles are divided among convolutionControl.getNThreads() threads.
+ *
+ * @throw lsst::pex::exceptions::InvalidParameterException if convolvedImage dimensions != inImage dimensions
+ * @throw lsst::pex::exceptions::InvalidParameterException if inImage smaller than kernel in width or height
+ * @throw lsst::pex::exceptions::InvalidParameterException if kernel is spatially varying
+ *
+ * @ingroup afw
+ */
+template <typename OutImageT, typename InImageT>
+void mathDetail::convolveWithFft(
+        OutImageT &convolvedImage,      ///< convolved %image
+        InImageT const& inImage,        ///< %image to convolve
+        afwMath::Kernel const& kernel,  ///< convolution kernel
+        afwMath::ConvolutionControl const& convolutionControl)  ///< convolution control parameters
+{
+    if (convolvedImage.getDimensions() != inImage.getDimensions()) {
+        std::ostringstream os;
+        os << "convolvedImage dimensions = ( "
+            << convolvedImage.getWidth() << ", " << convolvedImage.getHeight()
+            << ") != (" << inImage.getWidth() << ", " << inImage.getHeight() << ") = inImage dimensions";
+        throw LSST_EXCEPT(pexExcept::InvalidParameterException, os.str());
+    }
+    if (afwGeom::any(inImage.getDimensions().lt(kernel.getDimensions()))
+        || (kernel.getWidth() < 1) || (kernel.getHeight() < 1)) {
+        std::ostringstream os;
+        os << "inImage dimensions = ( "
+            << inImage.getWidth() << ", " << inImage.getHeight()
+            << ") smaller than (" << kernel.getWidth() << ", " << kernel.getHeight()
+            << ") = kernel dimensions in width and/or height, or kernel is empty";
+        throw LSST_EXCEPT(pexExcept::InvalidParameterException, os.str());
+    }
+    if (kernel.isSpatiallyVarying()) {
+        throw LSST_EXCEPT(pexExcept::InvalidParameterException,
+            "convolveWithFft requires a spatially invariant kernel");
+    }
+
+    KernelImage kernelImage(kernel.getDimensions());
+    (void)kernel.computeImage(kernelImage, convolutionControl.getDoNormalize());
+
+    int const blockWidth = computeBlockSize(kernel.getWidth(), inImage.getWidth());
+    int const blockHeight = computeBlockSize(kernel.getHeight(), inImage.getHeight());
+    FftPlans::ConstPtr plansPtr = FftPlans::get(blockWidth, blockHeight);
+
+    pexLog::TTrace<4>("lsst.afw.math.convolve", "convolveWithFft: block size %d x %d",
+        blockWidth, blockHeight);
+
+    convolveWithFftImpl(convolvedImage, inImage, kernelImage, kernel.getCtr(), *plansPtr,
+        mathDetail::computeNThreads(convolutionControl.getNThreads()),
+        typename afwImage::detail::image_traits<OutImageT>::image_category());
+}
+
+/*
+ * Explicit instantiation
+ */
+/// \cond
+#define IMAGE(PIXTYPE) afwImage::Image<PIXTYPE>
+#define MASKEDIMAGE(PIXTYPE) afwImage::MaskedImage<PIXTYPE, afwImage::MaskPixel, afwImage::VariancePixel>
+#define NL /* */
+// Instantiate Image or MaskedImage versions
+#define INSTANTIATE_IM_OR_MI(IMGMACRO, OUTPIXTYPE, INPIXTYPE) \
+    template void mathDetail::convolveWithFft( \
+        IMGMACRO(OUTPIXTYPE)&, IMGMACRO(INPIXTYPE) const&, afwMath::Kernel const&, \
+            afwMath::ConvolutionControl const&);
+// Instantiate both Image and MaskedImage versions
+#define INSTANTIATE(OUTPIXTYPE, INPIXTYPE) \
+    INSTANTIATE_IM_OR_MI(IMAGE,       OUTPIXTYPE, INPIXTYPE) \
+    INSTANTIATE_IM_OR_MI(MASKEDIMAGE, OUTPIXTYPE, INPIXTYPE)
+
+INSTANTIATE(double, double)
+INSTANTIATE(double, float)
+INSTANTIATE(double, int)
+INSTANTIATE(double, boost::uint16_t)
+INSTANTIATE(float, float)
+INSTANTIATE(float, int)
+INSTANTIATE(float, boost::uint16_t)
+INSTANTIATE(int, int)
+INSTANTIATE(boost::uint16_t, boost::uint16_t)
+/// \endcond
@@ -0,0 +1,145 @@
+// -*- LSST-C++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file
+ *
+ * @brief Definition of KernelFunctionTable
+ *
+ * @ingroup afw
+ */
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <sstream>
+
+#include "boost/thread/mutex.hpp"
+
+#include "lsst/pex/exceptions.h"
+#include "lsst/afw/math/FunctionLibrary.h"
+#include "lsst/afw/math/detail/KernelFunctionTable.h"
+
+namespace pexExcept = lsst::pex::exceptions;
+namespace afwMath = lsst::afw::math;
+namespace mathDetail = lsst::afw::math::detail;
+
+/**
+ * @brief Construct a table for a function
+ *
+ * @throw lsst::pex::exceptions::InvalidParameterException if function does not have exactly 1 parameter,
+ *  halfWidth <= 0 or samplesPerUnit < 1.
+ */
+mathDetail::KernelFunctionTable::KernelFunctionTable(
+        Function1<double> const &function,  ///< function to tabulate; its one parameter must be an offset
+        double halfWidth,       ///< the table covers x in [-halfWidth, halfWidth]
+        int samplesPerUnit)     ///< number of table entries per unit of x
+:
+    _functionPtr(function.clone()),
+    _halfWidth(halfWidth),
+    _samplesPerUnit(samplesPerUnit),
+    _maxPos(0),
+    _table(),
+    _maxError(0)
+{
+    if (function.getNParameters() != 1) {
+        throw LSST_EXCEPT(pexExcept::InvalidParameterException, "function must have exactly one parameter");
+    }
+    if ((halfWidth <= 0) || (samplesPerUnit < 1)) {
+        std::ostringstream os;
+        os << "halfWidth = " << halfWidth << " must be > 0 and samplesPerUnit = " << samplesPerUnit
+            << " must be >= 1";
+        throw LSST_EXCEPT(pexExcept::InvalidParameterException, os.str());
+    }
+    _functionPtr->setParameter(0, 0.0);
+
+    int const nSamples = 1 + static_cast<int>(std::ceil(2.0 * halfWidth * samplesPerUnit));
+    _table.reserve(nSamples);
+    for (int i = 0; i < nSamples; ++i) {
+        _table.push_back((*_functionPtr)(static_cast<double>(i) / samplesPerUnit - halfWidth));
+    }
+    _maxPos = nSamples - 1;
+
+    // Linear interpolation errors are largest near the midpoints between samples
+    for (int i = 0; i < nSamples - 1; ++i) {
+        double const x = (i + 0.5) / samplesPerUnit - halfWidth;
+        _maxError = std::max(_maxError, std::fabs((*this)(x) - (*_functionPtr)(x)));
+    }
+}
+
+/**
+ * @brief Compute valueList[i] = f(xList[i] - offset) for each element of valueList
+ *
+ * @return the sum of the values
+ *
+ * @warning the length of xList is not checked; it must be at least as long as valueList
+ */
+double mathDetail::KernelFunctionTable::computeValues(
+        std::vector<double> &valueList,     ///< computed values
+        std::vector<double> const &xList,   ///< x at which to evaluate the function
+        double offset                       ///< offset (the function parameter)
+) const {
+    double sum = 0;
+    std::vector<double>::const_iterator xIter = xList.begin();
+    for (std::vector<double>::iterator valIter = valueList.begin(); valIter != valueList.end();
+        ++valIter, ++xIter) {
+        *valIter = (*this)(*xIter - offset);
+        sum += *valIter;
+    }
+    return sum;
+}
+
+/**
+ * @brief Return a shared table for a LanczosFunction1 of the given order
+ *
+ * The table covers x in [-(order + 2), order + 2], which covers all positions used by a warping kernel
+ * (even one whose center has been moved by one pixel, as offsetImage does). Tables are built
+ * on first use and then retained for the life of the process.
+ *
+ * With DEFAULT_SAMPLES_PER_UNIT = 4096 the maximum error, max|f''| / (8 * 4096^2), is 3.1e-8 for order 2
+ * and decreases towards 2.5e-8 for higher orders (relative to the peak value of 1).
+ *
+ * @throw lsst::pex::exceptions::InvalidParameterException if order < 1
+ */
+mathDetail::KernelFunctionTable::ConstPtr mathDetail::KernelFunctionTable::getLanczosTable(
+        int order)  ///< order of Lanczos function
+{
+    if (order < 1) {
+        std::ostringstream os;
+        os << "order = " << order << " must be >= 1";
+        throw LSST_EXCEPT(pexExcept::InvalidParameterException, os.str());
+    }
+
+    typedef std::map<int, ConstPtr> TableMap;
+    static TableMap tableMap;
+    static boost::mutex tableMutex;
+
+    boost::mutex::scoped_lock lock(tableMutex);
+    TableMap::const_iterator tableIter = tableMap.find(order);
+    if (tableIter != tableMap.end()) {
+        return tableIter->second;
+    }
+    ConstPtr tablePtr(new KernelFunctionTable(afwMath::LanczosFunction1<double>(order), order + 2));
+    tableMap.insert(std::make_pair(order, tablePtr));
+    return tablePtr;
+}
@@ -30,6 +30,7 @@
  * \brief Support for warping an %image to a new Wcs.
  */
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <limits>
@@ -38,15 +39,21 @@
 #include <vector>
 #include <utility>
 
+#include "boost/bind.hpp"
 #include "boost/cstdint.hpp" 
+#include "boost/function.hpp"
 #include "boost/regex.hpp"
+#include "boost/shared_ptr.hpp"
 
 #include "lsst/pex/logging/Trace.h" 
 #include "lsst/pex/exceptions.h"
+#include "lsst/ndarray.h"
 #include "lsst/afw/image.h"
 #include "lsst/afw/geom.h"
 #include "lsst/afw/math.h"
 #include "lsst/afw/coord/Coord.h"
+#include "lsst/afw/math/detail/KernelFunctionTable.h"
+#include "lsst/afw/math/detail/Parallel.h"
 
 namespace pexExcept = lsst::pex::exceptions;
 namespace pexLog = lsst::pex::logging;
@@ -54,9 +61,11 @@ namespace afwImage = lsst::afw::image;
 namespace afwGeom = lsst::afw::geom;
 namespace afwCoord = lsst::afw::coord;
 namespace afwMath = lsst::afw::math;
+namespace mathDetail = lsst::afw::math::detail;
 
 afwMath::Kernel::Ptr afwMath::LanczosWarpingKernel::clone() const {
-    return afwMath::Kernel::Ptr(new afwMath::LanczosWarpingKernel(this->getOrder()));
+    return afwMath::Kernel::Ptr(
+        new afwMath::LanczosWarpingKernel(this->getOrder(), this->getUseLookupTable()));
 }
 
 /**
@@ -66,6 +75,28 @@ int afwMath::LanczosWarpingKernel::getOrder() const {
     return this->getWidth() / 2;
 }
 
+/**
+* @brief Set whether to compute the kernel from a lookup table of the Lanczos function
+*
+* The table is shared by all kernels of the same order; it is built the first time it is needed.
+*/
+void afwMath::LanczosWarpingKernel::setUseLookupTable(
+    bool useLookupTable ///< use a lookup table (true) or evaluate the Lanczos function exactly (false)?
+) {
+    if (useLookupTable) {
+        this->setKernelFunctionTable(mathDetail::KernelFunctionTable::getLanczosTable(this->getOrder()));
+    } else {
+        this->setKernelFunctionTable(mathDetail::KernelFunctionTable::ConstPtr());
+    }
+}
+
+/**
+* @brief Return true if the kernel is computed from a lookup table of the Lanczos function
+*/
+bool afwMath::LanczosWarpingKernel::getUseLookupTable() const {
+    return this->getKernelFunctionTable().get() != 0;
+}
+
 afwMath::Kernel::Ptr afwMath::BilinearWarpingKernel::clone() const {
     return afwMath::Kernel::Ptr(new afwMath::BilinearWarpingKernel());
 }
@@ -181,7 +212,8 @@ int afwMath::warpExposure(
                                         ///< All other attributes are left alone (including Detector and Psf)
     SrcExposureT const &srcExposure,    ///< Source exposure
     SeparableKernel &warpingKernel,     ///< Warping kernel; determines warping algorithm
-    int const interpLength              ///< Distance over which WCS can be linearily interpolated    
+    int const interpLength,             ///< Distance over which WCS can be linearily interpolated    
+    int const nThreads                  ///< number of threads to use; 0 for one per core
     )
 {
     if (!destExposure.hasWcs()) {
@@ -195,25 +227,60 @@ int afwMath::warpExposure(
     destExposure.setCalib(calibCopy);
     destExposure.setFilter(srcExposure.getFilter());
     return warpImage(mi, *destExposure.getWcs(),
-                     srcExposure.getMaskedImage(), *srcExposure.getWcs(), warpingKernel, interpLength);
+                     srcExposure.getMaskedImage(), *srcExposure.getWcs(), warpingKernel, interpLength,
+                     nThreads);
 }
 
 
 /************************************************************************************************************/
 namespace {
-    inline afwGeom::Point2D computeSrcPos(
-            int destCol,  ///< destination column index
-            int destRow,  ///< destination row index
-            afwGeom::Point2D const &destXY0,    ///< xy0 of destination image
-            afwImage::Wcs const &destWcs,       ///< WCS of remapped %image
-            afwImage::Wcs const &srcWcs)        ///< WCS of source %image
-    {
-        double const col = afwImage::indexToPosition(destCol + destXY0[0]);
-        double const row = afwImage::indexToPosition(destRow + destXY0[1]);
-        afwGeom::Angle sky1, sky2;
-        destWcs.pixelToSky(col, row, sky1, sky2);
-        return srcWcs.skyToPixel(sky1, sky2);
-    }
+    /*
+     * Compute source positions for a fixed list of destination columns in any row,
+     * passing the whole row through each WCS at once
+     */
+    class SrcPosRowComputer {
+    public:
+        SrcPosRowComputer(
+            std::vector<int> const &destColList,    ///< destination column indices
+            afwGeom::Point2D const &destXY0,        ///< xy0 of destination image
+            afwImage::Wcs const &destWcs,           ///< WCS of remapped %image
+            afwImage::Wcs const &srcWcs             ///< WCS of source %image
+        ) :
+            _destColList(destColList),
+            _nCols(destColList.size()),
+            _destXY0(destXY0),
+            _destWcs(destWcs),
+            _srcWcs(srcWcs),
+            _posArr(lsst::ndarray::allocate(lsst::ndarray::makeVector(_nCols, 2))),
+            _skyArr(lsst::ndarray::allocate(lsst::ndarray::makeVector(_nCols, 2)))
+        {}
+
+        /*
+         * Set srcPosIter[i] to the source position of destination pixel (destColList[i], destRow)
+         */
+        template <typename IterT>
+        void operator()(int destRow, IterT srcPosIter) {
+            double const row = afwImage::indexToPosition(destRow + _destXY0[1]);
+            for (int i = 0; i < _nCols; ++i) {
+                _posArr[i][0] = afwImage::indexToPosition(_destColList[i] + _destXY0[0]);
+                _posArr[i][1] = row;
+            }
+            _destWcs.pixelToSky(_posArr, _skyArr);
+            _srcWcs.skyToPixel(_skyArr, _posArr);
+            for (int i = 0; i < _nCols; ++i, ++srcPosIter) {
+                *srcPosIter = afwGeom::Point2D(_posArr[i][0], _posArr[i][1]);
+            }
+        }
+
+    private:
+        std::vector<int> _destColList;
+        int _nCols;
+        afwGeom::Point2D _destXY0;
+        afwImage::Wcs const &_destWcs;
+        afwImage::Wcs const &_srcWcs;
+        lsst::ndarray::Array<double, 2, 2> _posArr;   ///< destination, then source, pixel positions
+        lsst::ndarray::Array<double, 2, 2> _skyArr;   ///< sky positions
+    };
     
 
     inline double computeRelativeArea(
@@ -226,6 +293,294 @@ namespace {
         
         return std::abs(dSrcA.getX()*dSrcB.getY() - dSrcA.getY()*dSrcB.getX());
     }
+
+    /*
+     * Can a source position be converted to a pixel index?  A WCS may return NaN for positions off the
+     * sky, and converting NaN (or anything outside an int's range) to int is undefined
+     */
+    inline bool isIndexable(afwGeom::Point2D const &srcPos) {
+        double const maxPos = std::numeric_limits<int>::max()/2;
+        return std::fabs(srcPos[0]) < maxPos && std::fabs(srcPos[1]) < maxPos; // false if either is NaN
+    }
+
+    /*
+     * Warp a band of rows [rowBegin, rowEnd) of destImage
+     *
+     * If interpolating, rowBegin must be a multiple of interpLength and rowEnd must be a multiple
+     * of interpLength or destImage.getHeight(), so that the interpolation bands are the same as if
+     * the whole image was warped at once. Each interpolation band is anchored on positions computed
+     * directly from the WCS, so the result does not depend on how the image is split into bands.
+     *
+     * The warping kernel is modified and the WCS may not be safe to share, so each band that is
+     * processed in parallel must be given its own copies.
+     */
+    template<typename DestImageT, typename SrcImageT>
+    void warpRows(
+        DestImageT &destImage,              ///< remapped %image
+        afwImage::Wcs const &destWcs,       ///< WCS of remapped %image
+        SrcImageT const &srcImage,          ///< source %image
+        afwImage::Wcs const &srcWcs,        ///< WCS of source %image
+        afwMath::SeparableKernel &warpingKernel,    ///< warping kernel; not shared with any other band
+        int const interpLength,             ///< distance over which WCS can be linearily interpolated
+        int const rowBegin,                 ///< first row of band
+        int const rowEnd,                   ///< last row of band + 1
+        int &numGoodPixels                  ///< number of good pixels in the band (output)
+    ) {
+        numGoodPixels = 0;
+
+        // Compute borders; use to prevent applying kernel outside of srcImage
+        int const kernelWidth = warpingKernel.getWidth();
+        int const kernelHeight = warpingKernel.getHeight();
+        int const kernelCtrX = warpingKernel.getCtrX();
+        int const kernelCtrY = warpingKernel.getCtrY();
+
+        int const destWidth = destImage.getWidth();
+        afwGeom::Point2D const destXY0(destImage.getXY0());
+
+        typename DestImageT::SinglePixel const edgePixel = afwMath::edgePixel<DestImageT>(
+            typename afwImage::detail::image_traits<DestImageT>::image_category()
+        );
+        
+        std::vector<double> kernelXList(kernelWidth);
+        std::vector<double> kernelYList(kernelHeight);
+        
+        afwGeom::Box2I srcGoodBBox = warpingKernel.shrinkBBox(srcImage.getBBox(afwImage::LOCAL));
+
+        // A cache of pixel positions on the source corresponding to the previous or current row
+        // of the destination image.
+        // The first value is for column -1 because the previous source position is used to compute
+        // relative area.
+        // To simplify the indexing, use an iterator that starts at begin+1, thus:
+        // srcPosView = _srcPosList.begin() + 1
+        // srcPosView[col-1] and lower indices are for this row
+        // srcPosView[col] and higher indices are for the previous row
+        std::vector<afwGeom::Point2D> _srcPosList(1 + destWidth);
+        std::vector<afwGeom::Point2D>::iterator const srcPosView = _srcPosList.begin() + 1;
+        
+        int const maxCol = destWidth - 1;
+        int const maxRow = rowEnd - 1;
+
+        if (interpLength > 0) {
+            // Use interpolation. Note that 1 produces the same result as no interpolation
+            // but uses this code branch, thus providing an easy way to compare the two branches.
+            
+            // Estimate for number of horizontal interpolation band edges, to reserve memory in vectors
+            int const numColEdges = 2 + ((destWidth - 1) / interpLength);
+            
+            // A list of edge column indices for interpolation bands;
+            // starts at -1, increments by interpLen (except the final interval), and ends at destWidth-1
+            std::vector<int> edgeColList;
+            edgeColList.reserve(numColEdges);
+            
+            // A list of 1/column width for horizontal interpolation bands; the first value is garbage.
+            // The inverse is used for speed because the values is always multiplied.
+            std::vector<double> invWidthList;
+            invWidthList.reserve(numColEdges);
+            
+            // Compute edgeColList and invWidthList
+            edgeColList.push_back(-1);
+            invWidthList.push_back(0.0);
+            for (int prevEndCol = -1; prevEndCol < maxCol; prevEndCol += interpLength) {
+                int endCol = prevEndCol + interpLength;
+                if (endCol > maxCol) {
+                    endCol = maxCol;
+                }
+                edgeColList.push_back(endCol);
+                assert(endCol - prevEndCol > 0);
+                invWidthList.push_back(1.0 / static_cast<double>(endCol - prevEndCol));
+            }
+            assert(edgeColList.back() == maxCol);
+            
+            // A list of delta source positions along the edge columns of the horizontal interpolation bands
+            std::vector<afwGeom::Extent2D> yDeltaSrcPosList(edgeColList.size());
+
+            // A list of source positions computed from the WCS at the edge columns
+            // of the last row of the previous horizontal interpolation band
+            std::vector<afwGeom::Point2D> edgeSrcPosList(edgeColList.size());
+            SrcPosRowComputer computeEdgeSrcPos(edgeColList, destXY0, destWcs, srcWcs);
+            computeEdgeSrcPos(rowBegin - 1, edgeSrcPosList.begin());
+            
+            int endRow = rowBegin - 1;
+            while (endRow < maxRow) {
+                // Next horizontal interpolation band
+                
+                int prevEndRow = endRow;
+                endRow = prevEndRow + interpLength;
+                if (endRow > maxRow) {
+                    endRow = maxRow;
+                }
+                assert(endRow - prevEndRow > 0);
+                double interpInvHeight = 1.0 / static_cast<double>(endRow - prevEndRow);
+
+                // Initialize _srcPosList for row prevEndRow by interpolating between the edge positions
+                srcPosView[-1] = edgeSrcPosList[0];
+                for (int colBand = 1, endBand = edgeColList.size(); colBand < endBand; ++colBand) {
+                    int const prevEndCol = edgeColList[colBand-1];
+                    int const endCol = edgeColList[colBand];
+                    afwGeom::Point2D leftSrcPos = srcPosView[prevEndCol];
+                    afwGeom::Point2D rightSrcPos = edgeSrcPosList[colBand];
+                    afwGeom::Extent2D xDeltaSrcPos = (rightSrcPos - leftSrcPos) * invWidthList[colBand]; 
+
+                    for (int col = prevEndCol + 1; col <= endCol; ++col) {
+                        srcPosView[col] = srcPosView[col-1] + xDeltaSrcPos;
+                    }
+                }
+            
+                // Set yDeltaSrcPosList for this horizontal interpolation band
+                // and save the edge positions for the next band
+                computeEdgeSrcPos(endRow, edgeSrcPosList.begin());
+                for (int colBand = 0, endBand = edgeColList.size(); colBand < endBand; ++colBand) {
+                    int endCol = edgeColList[colBand];
+                    yDeltaSrcPosList[colBand] =
+                        (edgeSrcPosList[colBand] - srcPosView[endCol]) * interpInvHeight;
+                }
+
+                for (int row = prevEndRow + 1; row <= endRow; ++row) {
+                    typename DestImageT::x_iterator destXIter = destImage.row_begin(row);
+                    srcPosView[-1] += yDeltaSrcPosList[0];
+                    for (int colBand = 1, endBand = edgeColList.size(); colBand < endBand; ++colBand) {
+                        /// Next vertical interpolation band
+                        
+                        int const prevEndCol = edgeColList[colBand-1];
+                        int const endCol = edgeColList[colBand];
+        
+                        // Compute xDeltaSrcPos; remember that srcPosView contains
+                        // positions for this row in prevEndCol and smaller indices,
+                        // and positions for the previous row for larger indices (including endCol)
+                        afwGeom::Point2D leftSrcPos = srcPosView[prevEndCol];
+                        afwGeom::Point2D rightSrcPos = srcPosView[endCol] + yDeltaSrcPosList[colBand];
+                        afwGeom::Extent2D xDeltaSrcPos = (rightSrcPos - leftSrcPos) * invWidthList[colBand]; 
+                        
+                        for (int col = prevEndCol + 1; col <= endCol; ++col, ++destXIter) {
+                            afwGeom::Point2D leftSrcPos = srcPosView[col-1];
+                            afwGeom::Point2D srcPos = leftSrcPos + xDeltaSrcPos;
+                            double relativeArea = computeRelativeArea(srcPos, leftSrcPos, srcPosView[col]);
+                            
+                            srcPosView[col] = srcPos;
+
+                            if (!isIndexable(srcPos)) {
+                                *destXIter = edgePixel;
+                                continue;
+                            }
+            
+                            // Compute associated source pixel index as integer and nonnegative
+                            // fractional parts; the latter is used to compute the remapping kernel.
+                            std::pair<int, double> srcIndFracX =
+                                srcImage.positionToIndex(srcPos[0], afwImage::X);
+                            std::pair<int, double> srcIndFracY =
+                                srcImage.positionToIndex(srcPos[1], afwImage::Y);
+                            if (srcIndFracX.second < 0) {
+                                ++srcIndFracX.second;
+                                --srcIndFracX.first;
+                            }
+                            if (srcIndFracY.second < 0) {
+                                ++srcIndFracY.second;
+                                --srcIndFracY.first;
+                            }
+                            
+                            afwGeom::Point2I const srcInd(srcIndFracX.first, srcIndFracY.first);
+                            if (srcGoodBBox.contains(srcInd)) {
+                                 ++numGoodPixels;
+            
+                                // Offset source pixel index from kernel center to kernel corner (0, 0)
+                                // so we can convolveAtAPoint the pixels that overlap
+                                // between source and kernel
+                                srcIndFracX.first -= kernelCtrX;
+                                srcIndFracY.first -= kernelCtrY;
+                                    
+                                // Compute warped pixel
+                                std::pair<double, double> srcFracInd(srcIndFracX.second, srcIndFracY.second);
+                                warpingKernel.setKernelParameters(srcFracInd);
+                                double kSum = warpingKernel.computeVectors(kernelXList, kernelYList, false);
+                
+                                typename SrcImageT::const_xy_locator srcLoc =
+                                    srcImage.xy_at(srcIndFracX.first, srcIndFracY.first);
+                                
+                                *destXIter = afwMath::convolveAtAPoint<DestImageT,SrcImageT>(
+                                    srcLoc, kernelXList, kernelYList);
+                                *destXIter *= relativeArea/kSum;
+                            } else {
+                               // Edge pixel pixel
+                                *destXIter = edgePixel;
+                            }
+                        } // for col
+                    }   // for col band
+                }   // for row
+            }   // while next row band
+
+
+        } else {
+            // No interpolation
+            
+            // Source positions for columns -1 through destWidth-1 are computed a row at a time
+            std::vector<int> colList(1 + destWidth);
+            for (int col = -1; col < destWidth; ++col) {
+                colList[col + 1] = col;
+            }
+            SrcPosRowComputer computeRowSrcPos(colList, destXY0, destWcs, srcWcs);
+            std::vector<afwGeom::Point2D> rowSrcPosList(1 + destWidth);
+            std::vector<afwGeom::Point2D>::const_iterator const rowSrcPosView = rowSrcPosList.begin() + 1;
+
+            // initialize _srcPosList for row rowBegin-1;
+            // the first value is not needed, but it's safer to compute it
+            computeRowSrcPos(rowBegin - 1, _srcPosList.begin());
+            
+            for (int row = rowBegin; row < rowEnd; ++row) {
+                typename DestImageT::x_iterator destXIter = destImage.row_begin(row);
+                
+                computeRowSrcPos(row, rowSrcPosList.begin());
+                srcPosView[-1] = rowSrcPosView[-1];
+                
+                for (int col = 0; col < destWidth; ++col, ++destXIter) {
+                    afwGeom::Point2D srcPos = rowSrcPosView[col];
+                    double relativeArea = computeRelativeArea(srcPos, srcPosView[col-1], srcPosView[col]);
+                    srcPosView[col] = srcPos;
+
+                    if (!isIndexable(srcPos)) {
+                        *destXIter = edgePixel;
+                        continue;
+                    }
+
+                    // Compute associated source pixel index as integer and nonnegative fractional parts;
+                    // the latter is used to compute the remapping kernel.
+                    std::pair<int, double> srcIndFracX = srcImage.positionToIndex(srcPos[0], afwImage::X);
+                    std::pair<int, double> srcIndFracY = srcImage.positionToIndex(srcPos[1], afwImage::Y);
+                    if (srcIndFracX.second < 0) {
+                        ++srcIndFracX.second;
+                        --srcIndFracX.first;
+                    }
+                    if (srcIndFracY.second < 0) {
+                        ++srcIndFracY.second;
+                        --srcIndFracY.first;
+                    }
+                    
+                    if (srcGoodBBox.contains(afwGeom::Point2I(srcIndFracX.first, srcIndFracY.first))) {
+                         ++numGoodPixels;
+
+                        // Offset source pixel index from kernel center to kernel corner (0, 0)
+                        // so we can convolveAtAPoint the pixels that overlap between source and kernel
+                        srcIndFracX.first -= kernelCtrX;
+                        srcIndFracY.first -= kernelCtrY;
+                            
+                        // Compute warped pixel
+                        std::pair<double, double> srcFracInd(srcIndFracX.second, srcIndFracY.second);
+                        warpingKernel.setKernelParameters(srcFracInd);
+                        double kSum = warpingKernel.computeVectors(kernelXList, kernelYList, false);
+        
+                        typename SrcImageT::const_xy_locator srcLoc =
+                            srcImage.xy_at(srcIndFracX.first, srcIndFracY.first);
+                        
+                        *destXIter = afwMath::convolveAtAPoint<DestImageT,SrcImageT>(
+                            srcLoc, kernelXList, kernelYList);
+                        *destXIter *= relativeArea/kSum;
+                    } else {
+                       // Edge pixel pixel
+                        *destXIter = edgePixel;
+                    }
+                }   // for col
+            }   // for row
+        } // if interp
+    }
 }
 
 /**
@@ -278,6 +633,15 @@ namespace {
  * pixel position. This computation is only made at a grid of points on the destination image,
  * separated by interpLen pixels along rows and columns. All other source pixel positions are determined
  * by linear interpolation between those grid points. Everything else remains the same.
+ * Each horizontal band of interpLength rows is started afresh from source positions computed
+ * using the WCS at the grid points along its upper edge.
+ *
+ * \b Threading:
+ *
+ * If nThreads != 1 the destination %image is split into bands of rows (aligned with the horizontal
+ * interpolation bands, if interpolating) that are warped on separate threads. Each thread
+ * uses its own clone of the warping kernel (with the same cache size) and of each WCS.
+ * The result, including the number of good pixels, does not depend on the number of threads.
  *
  * \throw lsst::pex::exceptions::InvalidParameterException if destImage is srcImage
  *
@@ -293,252 +657,75 @@ int afwMath::warpImage(
     SrcImageT const &srcImage,          ///< source %image
     afwImage::Wcs const &srcWcs,        ///< WCS of source %image
     SeparableKernel &warpingKernel,     ///< warping kernel; determines warping algorithm
-    int const interpLength              ///< Distance over which WCS can be linearily interpolated
+    int const interpLength,             ///< Distance over which WCS can be linearily interpolated
         ///< 0 means no interpolation and uses an optimized branch of the code
         ///< 1 also performs no interpolation but it runs the interpolation code branch
+    int const nThreads                  ///< number of threads to use; 0 for one per core
     )
 {
     if (afwMath::details::isSameObject(destImage, srcImage)) {
         throw LSST_EXCEPT(pexExcept::InvalidParameterException,
             "destImage is srcImage; cannot warp in place");
     }
-    int numGoodPixels = 0;
 
-    typedef afwImage::Image<afwMath::Kernel::Pixel> KernelImageT;
-    
-    // Compute borders; use to prevent applying kernel outside of srcImage
-    int const kernelWidth = warpingKernel.getWidth();
-    int const kernelHeight = warpingKernel.getHeight();
-    int const kernelCtrX = warpingKernel.getCtrX();
-    int const kernelCtrY = warpingKernel.getCtrY();
-
-    // Get the source MaskedImage and a pixel accessor to it.
-    int const srcWidth = srcImage.getWidth();
-    int const srcHeight = srcImage.getHeight();
-    pexLog::TTrace<3>("lsst.afw.math.warp", "source image width=%d; height=%d", srcWidth, srcHeight);
-
-    int const destWidth = destImage.getWidth();
-    int const destHeight = destImage.getHeight();
-    afwGeom::Point2D const destXY0(destImage.getXY0());
-    pexLog::TTrace<3>("lsst.afw.math.warp", "remap image width=%d; height=%d", destWidth, destHeight);
+    pexLog::TTrace<3>("lsst.afw.math.warp", "source image width=%d; height=%d",
+                      srcImage.getWidth(), srcImage.getHeight());
 
-    typename DestImageT::SinglePixel const edgePixel = afwMath::edgePixel<DestImageT>(
-        typename afwImage::detail::image_traits<DestImageT>::image_category()
-    );
-    
-    std::vector<double> kernelXList(kernelWidth);
-    std::vector<double> kernelYList(kernelHeight);
-    
-    afwGeom::Box2I srcGoodBBox = warpingKernel.shrinkBBox(srcImage.getBBox(afwImage::LOCAL));
+    int const destHeight = destImage.getHeight();
+    pexLog::TTrace<3>("lsst.afw.math.warp", "remap image width=%d; height=%d",
+                      destImage.getWidth(), destHeight);
+
+    // Split the destination image into bands of rows, one per thread. When interpolating,
+    // band edges must fall on the edges of the horizontal interpolation bands.
+    int const rowsPerUnit = (interpLength > 0) ? interpLength : 1;
+    int const nUnits = (destHeight + rowsPerUnit - 1) / rowsPerUnit;
+    std::vector<int> bandEdges = mathDetail::computeBandEdges(0, nUnits,
+                                                              mathDetail::computeNThreads(nThreads));
+    for (std::vector<int>::iterator edgeIter = bandEdges.begin(); edgeIter != bandEdges.end(); ++edgeIter) {
+        *edgeIter = std::min(*edgeIter * rowsPerUnit, destHeight);
+    }
+    int const nBands = static_cast<int>(bandEdges.size()) - 1;
 
     // Set each pixel of destExposure's MaskedImage
-    pexLog::TTrace<4>("lsst.afw.math.warp", "Remapping masked image");
-    
-    // A cache of pixel positions on the source corresponding to the previous or current row
-    // of the destination image.
-    // The first value is for column -1 because the previous source position is used to compute relative area
-    // To simplify the indexing, use an iterator that starts at begin+1, thus:
-    // srcPosView = _srcPosList.begin() + 1
-    // srcPosView[col-1] and lower indices are for this row
-    // srcPosView[col] and higher indices are for the previous row
-    std::vector<afwGeom::Point2D> _srcPosList(1 + destWidth);
-    std::vector<afwGeom::Point2D>::iterator const srcPosView = _srcPosList.begin() + 1;
-    
-    int const maxCol = destWidth - 1;
-    int const maxRow = destHeight - 1;
-
-    if (interpLength > 0) {
-        // Use interpolation. Note that 1 produces the same result as no interpolation
-        // but uses this code branch, thus providing an easy way to compare the two branches.
-        
-        // Estimate for number of horizontal interpolation band edges, to reserve memory in vectors
-        int const numColEdges = 2 + ((destWidth - 1) / interpLength);
-        
-        // A list of edge column indices for interpolation bands;
-        // starts at -1, increments by interpLen (except the final interval), and ends at destWidth-1
-        std::vector<int> edgeColList;
-        edgeColList.reserve(numColEdges);
-        
-        // A list of 1/column width for horizontal interpolation bands; the first value is garbage.
-        // The inverse is used for speed because the values is always multiplied.
-        std::vector<double> invWidthList;
-        invWidthList.reserve(numColEdges);
-        
-        // Compute edgeColList and invWidthList
-        edgeColList.push_back(-1);
-        invWidthList.push_back(0.0);
-        for (int prevEndCol = -1; prevEndCol < maxCol; prevEndCol += interpLength) {
-            int endCol = prevEndCol + interpLength;
-            if (endCol > maxCol) {
-                endCol = maxCol;
-            }
-            edgeColList.push_back(endCol);
-            assert(endCol - prevEndCol > 0);
-            invWidthList.push_back(1.0 / static_cast<double>(endCol - prevEndCol));
-        }
-        assert(edgeColList.back() == maxCol);
-        
-        // A list of delta source positions along the edge columns of the horizontal interpolation bands
-        std::vector<afwGeom::Extent2D> yDeltaSrcPosList(edgeColList.size());
-        
-        // Initialize _srcPosList for row -1
-        srcPosView[-1] = computeSrcPos(-1, -1, destXY0, destWcs, srcWcs);
-        for (int colBand = 1, endBand = edgeColList.size(); colBand < endBand; ++colBand) {
-            int const prevEndCol = edgeColList[colBand-1];
-            int const endCol = edgeColList[colBand];
-            afwGeom::Point2D leftSrcPos = srcPosView[prevEndCol];
-            afwGeom::Point2D rightSrcPos = computeSrcPos(endCol, -1, destXY0, destWcs, srcWcs);
-            afwGeom::Extent2D xDeltaSrcPos = (rightSrcPos - leftSrcPos) * invWidthList[colBand]; 
-
-            for (int col = prevEndCol + 1; col <= endCol; ++col) {
-                srcPosView[col] = srcPosView[col-1] + xDeltaSrcPos;
-            }
-        }
-        
-        int endRow = -1;
-        while (endRow < maxRow) {
-            // Next horizontal interpolation band
-            
-            int prevEndRow = endRow;
-            endRow = prevEndRow + interpLength;
-            if (endRow > maxRow) {
-                endRow = maxRow;
+    pexLog::TTrace<4>("lsst.afw.math.warp", "Remapping masked image using %d bands of rows", nBands);
+
+    // The first band uses the caller's kernel and WCS; the others get their own copies
+    std::vector<boost::shared_ptr<SeparableKernel> > kernelList;
+    std::vector<afwImage::Wcs::Ptr> wcsList;
+    std::vector<int> numGoodPixelsList(nBands);
+    std::vector<boost::function<void ()> > bandList;
+    int const cacheSize = warpingKernel.getCacheSize();
+    for (int band = 0; band < nBands; ++band) {
+        SeparableKernel *kernelPtr = &warpingKernel;
+        afwImage::Wcs const *destWcsPtr = &destWcs;
+        afwImage::Wcs const *srcWcsPtr = &srcWcs;
+        if (band > 0) {
+            kernelList.push_back(boost::dynamic_pointer_cast<SeparableKernel>(warpingKernel.clone()));
+            if (!kernelList.back()) {
+                throw LSST_EXCEPT(pexExcept::LogicErrorException,
+                    "warpingKernel.clone() did not return a SeparableKernel");
             }
-            assert(endRow - prevEndRow > 0);
-            double interpInvHeight = 1.0 / static_cast<double>(endRow - prevEndRow);
-        
-            // Set yDeltaSrcPosList for this horizontal interpolation band
-            for (int colBand = 0, endBand = edgeColList.size(); colBand < endBand; ++colBand) {
-                int endCol = edgeColList[colBand];
-                afwGeom::Point2D bottomSrcPos = computeSrcPos(endCol, endRow, destXY0, destWcs, srcWcs);
-                yDeltaSrcPosList[colBand] = (bottomSrcPos - srcPosView[endCol]) * interpInvHeight;
+            if (cacheSize > 0) {
+                kernelList.back()->computeCache(cacheSize);
             }
-
-            for (int row = prevEndRow + 1; row <= endRow; ++row) {
-                typename DestImageT::x_iterator destXIter = destImage.row_begin(row);
-                srcPosView[-1] += yDeltaSrcPosList[0];
-                for (int colBand = 1, endBand = edgeColList.size(); colBand < endBand; ++colBand) {
-                    /// Next vertical interpolation band
-                    
-                    int const prevEndCol = edgeColList[colBand-1];
-                    int const endCol = edgeColList[colBand];
-    
-                    // Compute xDeltaSrcPos; remember that srcPosView contains
-                    // positions for this row in prevEndCol and smaller indices,
-                    // and positions for the previous row for larger indices (including endCol)
-                    afwGeom::Point2D leftSrcPos = srcPosView[prevEndCol];
-                    afwGeom::Point2D rightSrcPos = srcPosView[endCol] + yDeltaSrcPosList[colBand];
-                    afwGeom::Extent2D xDeltaSrcPos = (rightSrcPos - leftSrcPos) * invWidthList[colBand]; 
-                    
-                    for (int col = prevEndCol + 1; col <= endCol; ++col, ++destXIter) {
-                        afwGeom::Point2D leftSrcPos = srcPosView[col-1];
-                        afwGeom::Point2D srcPos = leftSrcPos + xDeltaSrcPos;
-                        double relativeArea = computeRelativeArea(srcPos, leftSrcPos, srcPosView[col]);
-                        
-                        srcPosView[col] = srcPos;
-        
-                        // Compute associated source pixel index as integer and nonnegative fractional parts;
-                        // the latter is used to compute the remapping kernel.
-                        std::pair<int, double> srcIndFracX = srcImage.positionToIndex(srcPos[0], afwImage::X);
-                        std::pair<int, double> srcIndFracY = srcImage.positionToIndex(srcPos[1], afwImage::Y);
-                        if (srcIndFracX.second < 0) {
-                            ++srcIndFracX.second;
-                            --srcIndFracX.first;
-                        }
-                        if (srcIndFracY.second < 0) {
-                            ++srcIndFracY.second;
-                            --srcIndFracY.first;
-                        }
-                        
-                        if (srcGoodBBox.contains(afwGeom::Point2I(srcIndFracX.first, srcIndFracY.first))) {
-                             ++numGoodPixels;
-        
-                            // Offset source pixel index from kernel center to kernel corner (0, 0)
-                            // so we can convolveAtAPoint the pixels that overlap between source and kernel
-                            srcIndFracX.first -= kernelCtrX;
-                            srcIndFracY.first -= kernelCtrY;
-                                
-                            // Compute warped pixel
-                            std::pair<double, double> srcFracInd(srcIndFracX.second, srcIndFracY.second);
-                            warpingKernel.setKernelParameters(srcFracInd);
-                            double kSum = warpingKernel.computeVectors(kernelXList, kernelYList, false);
-            
-                            typename SrcImageT::const_xy_locator srcLoc =
-                                srcImage.xy_at(srcIndFracX.first, srcIndFracY.first);
-                            
-                            *destXIter = afwMath::convolveAtAPoint<DestImageT,SrcImageT>(
-                                srcLoc, kernelXList, kernelYList);
-                            *destXIter *= relativeArea/kSum;
-                        } else {
-                           // Edge pixel pixel
-                            *destXIter = edgePixel;
-                        }
-                    } // for col
-                }   // for col band
-            }   // for row
-        }   // while next row band
-
-
-    } else {
-        // No interpolation
-        
-        // initialize _srcPosList for row -1;
-        // the first value is not needed, but it's safer to compute it
-        std::vector<afwGeom::Point2D>::iterator srcPosView = _srcPosList.begin() + 1;
-        for (int col = -1; col < destWidth; ++col) {
-            srcPosView[col] = computeSrcPos(col, -1, destXY0, destWcs, srcWcs);
+            kernelPtr = kernelList.back().get();
+            wcsList.push_back(destWcs.clone());
+            destWcsPtr = wcsList.back().get();
+            wcsList.push_back(srcWcs.clone());
+            srcWcsPtr = wcsList.back().get();
         }
-        
-        for (int row = 0; row < destHeight; ++row) {
-            typename DestImageT::x_iterator destXIter = destImage.row_begin(row);
-            
-            srcPosView[-1] = computeSrcPos(-1, row, destXY0, destWcs, srcWcs);
-            
-            for (int col = 0; col < destWidth; ++col, ++destXIter) {
-                afwGeom::Point2D srcPos = computeSrcPos(col, row, destXY0, destWcs, srcWcs);
-                double relativeArea = computeRelativeArea(srcPos, srcPosView[col-1], srcPosView[col]);
-                srcPosView[col] = srcPos;
-
-                // Compute associated source pixel index as integer and nonnegative fractional parts;
-                // the latter is used to compute the remapping kernel.
-                std::pair<int, double> srcIndFracX = srcImage.positionToIndex(srcPos[0], afwImage::X);
-                std::pair<int, double> srcIndFracY = srcImage.positionToIndex(srcPos[1], afwImage::Y);
-                if (srcIndFracX.second < 0) {
-                    ++srcIndFracX.second;
-                    --srcIndFracX.first;
-                }
-                if (srcIndFracY.second < 0) {
-                    ++srcIndFracY.second;
-                    --srcIndFracY.first;
-                }
-                
-                if (srcGoodBBox.contains(afwGeom::Point2I(srcIndFracX.first, srcIndFracY.first))) {
-                     ++numGoodPixels;
-
-                    // Offset source pixel index from kernel center to kernel corner (0, 0)
-                    // so we can convolveAtAPoint the pixels that overlap between source and kernel
-                    srcIndFracX.first -= kernelCtrX;
-                    srcIndFracY.first -= kernelCtrY;
-                        
-                    // Compute warped pixel
-                    std::pair<double, double> srcFracInd(srcIndFracX.second, srcIndFracY.second);
-                    warpingKernel.setKernelParameters(srcFracInd);
-                    double kSum = warpingKernel.computeVectors(kernelXList, kernelYList, false);
-    
-                    typename SrcImageT::const_xy_locator srcLoc =
-                        srcImage.xy_at(srcIndFracX.first, srcIndFracY.first);
-                    
-                    *destXIter = afwMath::convolveAtAPoint<DestImageT,SrcImageT>(
-                        srcLoc, kernelXList, kernelYList);
-                    *destXIter *= relativeArea/kSum;
-                } else {
-                   // Edge pixel pixel
-                    *destXIter = edgePixel;
-                }
-            }   // for col
-        }   // for row
-    } // if interp
+        bandList.push_back(boost::bind(&warpRows<DestImageT, SrcImageT>,
+            boost::ref(destImage), boost::cref(*destWcsPtr), boost::cref(srcImage), boost::cref(*srcWcsPtr),
+            boost::ref(*kernelPtr), interpLength, bandEdges[band], bandEdges[band + 1],
+            boost::ref(numGoodPixelsList[band])));
+    }
+    mathDetail::runInParallel(bandList);
 
+    int numGoodPixels = 0;
+    for (std::vector<int>::const_iterator numIter = numGoodPixelsList.begin();
+        numIter != numGoodPixelsList.end(); ++numIter) {
+        numGoodPixels += *numIter;
+    }
     return numGoodPixels;
 }
 
@@ -558,17 +745,17 @@ int afwMath::warpImage(
         afwImage::Wcs const &destWcs, \
         IMAGE(SRCIMAGEPIXELT) const &srcImage, \
         afwImage::Wcs const &srcWcs, \
-        SeparableKernel &warpingKernel, int const interpLength); NL    \
+        SeparableKernel &warpingKernel, int const interpLength, int const nThreads); NL    \
     template int afwMath::warpImage( \
         MASKEDIMAGE(DESTIMAGEPIXELT) &destImage, \
         afwImage::Wcs const &destWcs, \
         MASKEDIMAGE(SRCIMAGEPIXELT) const &srcImage, \
         afwImage::Wcs const &srcWcs, \
-        SeparableKernel &warpingKernel, int const interpLength); NL    \
+        SeparableKernel &warpingKernel, int const interpLength, int const nThreads); NL    \
     template int afwMath::warpExposure( \
         EXPOSURE(DESTIMAGEPIXELT) &destExposure, \
         EXPOSURE(SRCIMAGEPIXELT) const &srcExposure, \
-        SeparableKernel &warpingKernel, int const interpLength);
+        SeparableKernel &warpingKernel, int const interpLength, int const nThreads);
 
 INSTANTIATE(double, double)
 INSTANTIATE(double, float)
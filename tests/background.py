@@ -55,6 +55,7 @@ except NameError:
 # BackgroundTestImages: tests Laher's afwdata/Statistics/*.fits images (doubles)
 # testRamp: make sure a constant slope is *exactly* reproduced by the spline model
 # testParabola: make sure a quadratic map is *well* reproduced by the spline model
+# testGetImageInPlace: getImage into (or subtracting from) an image, and on several threads
 
 #-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 
@@ -212,6 +213,44 @@ class BackgroundTestCase(unittest.TestCase):
                 #  is a fair (if arbitrary) test.
                 self.assertTrue( abs(testval - realval) < 0.5 )
 
+    def testGetImageInPlace(self):
+        """Test getImage into a supplied image, subtracting in place, and using several threads"""
+        nx, ny = 200, 150
+        img = afwImage.ImageF(afwGeom.Extent2I(nx, ny))
+        for x in range(nx):
+            for y in range(ny):
+                img.set(x, y, 1.0e-4*(x - 80)**2 - 2.0e-4*(y - 60)**2 + 0.01*((x*37 + y*11) % 7) + 1000.0)
+
+        for style in [afwMath.Interpolate.AKIMA_SPLINE, afwMath.Interpolate.LINEAR,
+                      afwMath.Interpolate.NATURAL_SPLINE]:
+            bctrl = afwMath.BackgroundControl(style, 6, 5)
+            backobj = afwMath.makeBackground(img, bctrl)
+            bimg = backobj.getImageF()
+
+            for x, y in [(0, 0), (nx//2, ny//2), (nx - 1, ny - 1), (17, ny - 3)]:
+                self.assertAlmostEqual(bimg.get(x, y), backobj.getPixel(x, y), 2)
+
+            bimg2 = afwImage.ImageF(afwGeom.Extent2I(nx, ny))
+            backobj.getImageF(bimg2)
+
+            subimg = img.Factory(img, True)
+            backobj.getImageF(subimg, True)
+            expected = img.Factory(img, True)
+            expected -= bimg
+
+            bctrl.setNThreads(4)
+            backobj4 = afwMath.makeBackground(img, bctrl)
+            bimg4 = backobj4.getImageF()
+
+            for x in range(0, nx, 7):
+                for y in range(0, ny, 5):
+                    self.assertEqual(bimg2.get(x, y), bimg.get(x, y))
+                    self.assertEqual(subimg.get(x, y), expected.get(x, y))
+                    self.assertEqual(bimg4.get(x, y), bimg.get(x, y))
+
+        utilsTests.assertRaisesLsstCpp(self, lsst.pex.exceptions.LengthErrorException,
+                                       backobj.getImageF, afwImage.ImageF(afwGeom.Extent2I(nx, ny + 1)))
+
     def testCFHT(self):
         """Test background subtraction on some real CFHT data"""
 
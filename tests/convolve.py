@@ -366,6 +366,16 @@ class ConvolveTestCase(unittest.TestCase):
             convControl.setMaxInterpolationDistance(maxInterpDist)
             self.assertEqual(convControl.getMaxInterpolationDistance(), maxInterpDist)
         
+        self.assertEqual(convControl.getNThreads(), 1)
+        for nThreads in (0, 1, 4):
+            convControl.setNThreads(nThreads)
+            self.assertEqual(convControl.getNThreads(), nThreads)
+
+        self.assertEqual(convControl.getFftMinKernelSize(), 15)
+        for fftMinKernelSize in (0, 1, 21):
+            convControl.setFftMinKernelSize(fftMinKernelSize)
+            self.assertEqual(convControl.getFftMinKernelSize(), fftMinKernelSize)
+        
     def testUnityConvolution(self):
         """Verify that convolution with a centered delta function reproduces the original.
         """
@@ -504,6 +514,83 @@ class ConvolveTestCase(unittest.TestCase):
         self.runStdTest(separableKernel, refKernel=analyticKernel,
             kernelDescr="Spatially Varying Gaussian Separable Kernel")
     
+    def testFftConvolve(self):
+        """Test convolution of large spatially invariant kernels using FFTs
+        """
+        kWidth = 21
+        kHeight = 17
+
+        kFunc =  afwMath.GaussianFunction2D(4.5, 3.0, 0.5)
+        kernel = afwMath.AnalyticKernel(kWidth, kHeight, kFunc)
+        kernelImage = afwImage.ImageD(afwGeom.Extent2I(kWidth, kHeight))
+        kernel.computeImage(kernelImage, False)
+        # zero some kernel pixels to test that the mask is ORed only over nonzero kernel pixels
+        for x in range(0, kWidth, 3):
+            kernelImage.set(x, 0, 0.0)
+        fixedKernel = afwMath.FixedKernel(kernelImage)
+
+        self.runStdTest(kernel, kernelDescr="Large Gaussian Analytic Kernel (FFT)")
+        self.runStdTest(fixedKernel, kernelDescr="Large Gaussian Fixed Kernel (FFT)")
+
+        # compare to brute force convolution
+        for nThreads in (1, 3):
+            fftControl = afwMath.ConvolutionControl()
+            fftControl.setNThreads(nThreads)
+            self.assert_(kWidth >= fftControl.getFftMinKernelSize())
+            afwMath.convolve(self.cnvMaskedImage, self.maskedImage, fixedKernel, fftControl)
+
+            bruteControl = afwMath.ConvolutionControl()
+            bruteControl.setFftMinKernelSize(0)
+            bruteMaskedImage = afwImage.MaskedImageF(FullMaskedImage, ShiftedBBox, afwImage.LOCAL, True)
+            afwMath.convolve(bruteMaskedImage, self.maskedImage, fixedKernel, bruteControl)
+
+            errStr = imTestUtils.maskedImagesDiffer(self.cnvMaskedImage.getArrays(),
+                bruteMaskedImage.getArrays(), doVariance = True, rtol=1.0e-6, atol=1.0e-6)
+            if errStr:
+                self.fail("FFT convolution (nThreads=%d) differs from brute force:\n%s" % (nThreads, errStr))
+
+    def testMultithreadedConvolve(self):
+        """Test that convolution with several threads gives exactly the same result as with one
+        """
+        kWidth = 7
+        kHeight = 6
+
+        sFunc = afwMath.PolynomialFunction2D(1)
+        sParams = (
+            (1.0, 1.0 / self.width, 0.0),
+            (1.0, 0.0, 1.0 / self.height),
+            (0.0, 0.0, 0.0),
+        )
+        gaussFunc1 = afwMath.GaussianFunction1D(1.0)
+        gaussFunc2 = afwMath.GaussianFunction2D(1.5, 2.5, 0.5)
+
+        varyingAnalyticKernel = afwMath.AnalyticKernel(kWidth, kHeight, gaussFunc2, sFunc)
+        varyingAnalyticKernel.setSpatialParameters(sParams)
+        varyingSeparableKernel = afwMath.SeparableKernel(kWidth, kHeight, gaussFunc1, gaussFunc1, sFunc)
+        varyingSeparableKernel.setSpatialParameters(sParams[0:2])
+
+        for kernel, kernelDescr in (
+            (afwMath.AnalyticKernel(kWidth, kHeight, gaussFunc2), "Gaussian Analytic Kernel"),
+            (afwMath.SeparableKernel(kWidth, kHeight, gaussFunc1, gaussFunc1), "Gaussian Separable Kernel"),
+            (varyingAnalyticKernel, "Spatially Varying Gaussian Analytic Kernel"),
+            (varyingSeparableKernel, "Spatially Varying Gaussian Separable Kernel"),
+        ):
+            convControl = afwMath.ConvolutionControl()
+            convControl.setMaxInterpolationDistance(0)
+            afwMath.convolve(self.cnvMaskedImage, self.maskedImage, kernel, convControl)
+            desImMaskVarArr = self.cnvMaskedImage.getArrays()
+
+            # include more threads than there are rows of good pixels
+            for nThreads in (2, 3, 7, self.height + 5):
+                convControl.setNThreads(nThreads)
+                cnvMaskedImage = afwImage.MaskedImageF(FullMaskedImage, ShiftedBBox, afwImage.LOCAL, True)
+                afwMath.convolve(cnvMaskedImage, self.maskedImage, kernel, convControl)
+                errStr = imTestUtils.maskedImagesDiffer(cnvMaskedImage.getArrays(), desImMaskVarArr,
+                    doVariance = True, rtol=0, atol=0)
+                if errStr:
+                    self.fail("convolve(MaskedImage, kernel=%s, nThreads=%d) differs from nThreads=1:\n%s" % \
+                        (kernelDescr, nThreads, errStr))
+
     def testDeltaConvolve(self):
         """Test convolution with various delta function kernels using optimized code
         """
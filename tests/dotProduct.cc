@@ -0,0 +1,166 @@
+// -*- LSST-C++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file dotProduct.cc
+ *
+ * Test the vectorized kernel dot products against simple scalar code, at every SIMD level
+ * supported by this CPU, and check that convolution gives the same answer with and without SIMD.
+ */
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE DotProduct
+
+#include "boost/test/unit_test.hpp"
+#include "boost/test/floating_point_comparison.hpp"
+
+#include "lsst/utils/ieee.h"
+#include "lsst/afw/geom.h"
+#include "lsst/afw/image/Image.h"
+#include "lsst/afw/image/MaskedImage.h"
+#include "lsst/afw/math/FunctionLibrary.h"
+#include "lsst/afw/math/Kernel.h"
+#include "lsst/afw/math/ConvolveImage.h"
+#include "lsst/afw/math/detail/DotProduct.h"
+
+namespace afwGeom = lsst::afw::geom;
+namespace afwImage = lsst::afw::image;
+namespace afwMath = lsst::afw::math;
+namespace mathDetail = lsst::afw::math::detail;
+
+namespace {
+    /*
+     * Fill the test vectors; every 4th kernel pixel is zero, and one image pixel under a zero kernel
+     * pixel is NaN (which must not affect the result)
+     */
+    void makeData(int n, std::vector<float> &image, std::vector<afwImage::MaskPixel> &mask,
+                  std::vector<afwImage::VariancePixel> &variance, std::vector<double> &kernel) {
+        image.resize(n);
+        mask.resize(n);
+        variance.resize(n);
+        kernel.resize(n);
+        for (int i = 0; i < n; ++i) {
+            image[i] = (i * 37) % 101 - 40.5;
+            mask[i] = 1 << (i % 16);
+            variance[i] = (i * 13) % 29 + 0.5;
+            kernel[i] = (i % 4 == 1) ? 0.0 : 0.1 * ((i * 7) % 11) - 0.3;
+        }
+        if (n > 1) {
+            image[1] = std::numeric_limits<float>::quiet_NaN();
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(dotProduct) {
+    for (int level = mathDetail::SIMD_NONE; level <= mathDetail::getMaxSimdLevel(); ++level) {
+        mathDetail::setSimdLevel(static_cast<mathDetail::SimdLevel>(level));
+        BOOST_CHECK_EQUAL(mathDetail::getSimdLevel(), level);
+
+        for (int n = 1; n < 40; ++n) {
+            std::vector<float> image;
+            std::vector<afwImage::MaskPixel> mask;
+            std::vector<afwImage::VariancePixel> variance;
+            std::vector<double> kernel;
+            makeData(n, image, mask, variance, kernel);
+            std::vector<double> dImage(image.begin(), image.end());
+
+            double imageSum = 0;
+            afwImage::MaskPixel maskSum = 0;
+            double varianceSum = 0;
+            for (int i = 0; i < n; ++i) {
+                if (kernel[i] != 0) {
+                    imageSum += image[i] * kernel[i];
+                    maskSum |= mask[i];
+                    varianceSum += variance[i] * kernel[i] * kernel[i];
+                }
+            }
+
+            BOOST_CHECK_CLOSE(mathDetail::dotProduct(&image[0], &kernel[0], n), imageSum, 1.0e-10);
+            BOOST_CHECK_CLOSE(mathDetail::dotProduct(&dImage[0], &kernel[0], n), imageSum, 1.0e-10);
+
+            double simdImageSum, simdVarianceSum;
+            afwImage::MaskPixel simdMaskSum;
+            mathDetail::maskedDotProduct(&image[0], &mask[0], &variance[0], &kernel[0], n,
+                                         simdImageSum, simdMaskSum, simdVarianceSum);
+            BOOST_CHECK_CLOSE(simdImageSum, imageSum, 1.0e-10);
+            BOOST_CHECK_EQUAL(simdMaskSum, maskSum);
+            BOOST_CHECK_CLOSE(simdVarianceSum, varianceSum, 1.0e-10);
+
+            mathDetail::maskedDotProduct(&dImage[0], &mask[0], &variance[0], &kernel[0], n,
+                                         simdImageSum, simdMaskSum, simdVarianceSum);
+            BOOST_CHECK_CLOSE(simdImageSum, imageSum, 1.0e-10);
+            BOOST_CHECK_EQUAL(simdMaskSum, maskSum);
+            BOOST_CHECK_CLOSE(simdVarianceSum, varianceSum, 1.0e-10);
+        }
+    }
+    mathDetail::setSimdLevel(mathDetail::getMaxSimdLevel());
+}
+
+BOOST_AUTO_TEST_CASE(convolve) {
+    typedef afwImage::MaskedImage<float> MaskedImageT;
+
+    int const size = 50;
+    MaskedImageT inImage(afwGeom::Extent2I(size, size));
+    for (int y = 0; y != size; ++y) {
+        int x = 0;
+        for (MaskedImageT::x_iterator ptr = inImage.row_begin(y), end = inImage.row_end(y);
+             ptr != end; ++ptr, ++x) {
+            *ptr = MaskedImageT::SinglePixel((x * 31 + y * 17) % 100, 1 << ((x + y) % 8), 1 + (x % 5));
+        }
+    }
+
+    afwMath::GaussianFunction2<afwMath::Kernel::Pixel> gaussFunc(2.0, 1.5, 0.3);
+    afwMath::GaussianFunction1<afwMath::Kernel::Pixel> gaussFunc1(2.0);
+    afwMath::AnalyticKernel analyticKernel(11, 9, gaussFunc);
+    afwMath::SeparableKernel separableKernel(7, 9, gaussFunc1, gaussFunc1);
+    afwMath::Kernel const *kernelList[] = {&analyticKernel, &separableKernel};
+
+    afwMath::ConvolutionControl convControl;
+    convControl.setFftMinKernelSize(0);
+    for (int k = 0; k < 2; ++k) {
+        MaskedImageT genericImage(inImage.getDimensions());
+        MaskedImageT simdImage(inImage.getDimensions());
+        mathDetail::setSimdLevel(mathDetail::SIMD_NONE);
+        afwMath::convolve(genericImage, inImage, *kernelList[k], convControl);
+        mathDetail::setSimdLevel(mathDetail::getMaxSimdLevel());
+        afwMath::convolve(simdImage, inImage, *kernelList[k], convControl);
+
+        for (int y = 0; y != size; ++y) {
+            MaskedImageT::x_iterator genericPtr = genericImage.row_begin(y);
+            for (MaskedImageT::x_iterator simdPtr = simdImage.row_begin(y), end = simdImage.row_end(y);
+                 simdPtr != end; ++simdPtr, ++genericPtr) {
+                if (lsst::utils::isnan(genericPtr.image())) {
+                    BOOST_CHECK(lsst::utils::isnan(simdPtr.image()));
+                } else {
+                    BOOST_CHECK_CLOSE(simdPtr.image(), genericPtr.image(), 1.0e-3);
+                    BOOST_CHECK_CLOSE(simdPtr.variance(), genericPtr.variance(), 1.0e-3);
+                }
+                BOOST_CHECK_EQUAL(simdPtr.mask(), genericPtr.mask());
+            }
+        }
+    }
+}
@@ -194,6 +194,33 @@ class FootprintTestCase(unittest.TestCase):
         
         self.assertEqual(sp[-1].toString(), toString(y, x0, x1))
 
+    def testSpanVector(self):
+        """Check the Spans stored by value against the compatibility list of Span pointers"""
+        foot = afwDetect.Footprint()
+        for y, x0, x1 in [(11, 99, 104), (10, 100, 105), (10, 106, 108), (11, 101, 102), (10, 90, 95)]:
+            foot.addSpan(y, x0, x1)
+        self.assertEqual(len(foot.getSpans()), 5)
+        self.assertEqual(foot.getArea(), 6 + 6 + 3 + 2 + 6)
+
+        foot.normalize()
+        expected = [(10, 90, 95), (10, 100, 108), (11, 99, 104)]
+        self.assertEqual([(s.getY(), s.getX0(), s.getX1()) for s in foot.getSpanVector()], expected)
+        self.assertEqual([(s.getY(), s.getX0(), s.getX1()) for s in foot.getSpans()], expected)
+        self.assertEqual(foot.getArea(), 6 + 9 + 6)
+        self.assertEqual(foot.getBBox(), afwGeom.Box2I(afwGeom.Point2I(90, 10), afwGeom.Point2I(108, 11)))
+
+        for x, y, inFoot in [(95, 10, True), (96, 10, False), (100, 10, True), (108, 10, True),
+                             (99, 11, True), (98, 11, False), (105, 11, False)]:
+            self.assertEqual(foot.contains(afwGeom.Point2I(x, y)), inFoot)
+
+        foot.shift(1, 2)                # the list of pointers must see the change
+        self.assertEqual([(s.getY(), s.getX0(), s.getX1()) for s in foot.getSpans()],
+                         [(y + 2, x0 + 1, x1 + 1) for y, x0, x1 in expected])
+
+        copy = afwDetect.Footprint(foot.getSpanVector())
+        self.assertEqual([s.toString() for s in copy.getSpanVector()],
+                         [s.toString() for s in foot.getSpanVector()])
+
     def testBbox(self):
         """Add Spans and check bounding box"""
         foot = afwDetect.Footprint()
@@ -366,6 +393,38 @@ class FootprintTestCase(unittest.TestCase):
             # Check that region was preserved
             self.assertEqual(foot1.getRegion(), foot2.getRegion())
 
+    def testGrowIsotropic(self):
+        """Check an isotropic grow against an explicit dilation by a disk"""
+        foot = afwDetect.Footprint()
+        for y, x0, x1 in [(10, 10, 20), (11, 10, 10), (11, 20, 20), (12, 10, 12), (12, 18, 20),
+                          (13, 15, 15), (25, 30, 31)]:
+            foot.addSpan(y, x0, x1)
+        foot.normalize()
+
+        pixels = set()
+        for s in foot.getSpanVector():
+            for x in range(s.getX0(), s.getX1() + 1):
+                pixels.add((x, s.getY()))
+
+        for ngrow in (0, 1, 3, 7, 12):
+            expected = set()
+            for x, y in pixels:
+                for dy in range(-ngrow, ngrow + 1):
+                    for dx in range(-ngrow, ngrow + 1):
+                        if dx*dx + dy*dy <= ngrow*ngrow:
+                            expected.add((x + dx, y + dy))
+
+            gfoot = afwDetect.growFootprint(foot, ngrow, True)
+            grown = set()
+            for s in gfoot.getSpanVector():
+                for x in range(s.getX0(), s.getX1() + 1):
+                    self.assertFalse((x, s.getY()) in grown) # Spans mustn't overlap
+                    grown.add((x, s.getY()))
+
+            self.assertEqual(grown, expected)
+            self.assertEqual(gfoot.getNpix(), len(expected))
+            self.assertTrue(gfoot.isNormalized())
+
     def testFootprintToBBoxList(self):
         """Test footprintToBBoxList"""
         region = afwGeom.Box2I(afwGeom.Point2I(0,0), afwGeom.Extent2I(12,10))
@@ -588,6 +647,28 @@ class FootprintSetTestCase(unittest.TestCase):
         for i in range(len(objects)):
             self.assertEqual(objects[i], self.objects[i])
             
+    def testFootprintsNThreads(self):
+        """Check that detecting objects in parallel bands of rows gives the same Footprints"""
+        im = afwImage.ImageF(afwGeom.Extent2I(61, 53))
+        for y in range(im.getHeight()):
+            for x in range(im.getWidth()):
+                im.set(x, y, (x*37 + y*101 + x*y*13) % 29)
+
+        threshold = afwDetect.Threshold(15)
+        objects = afwDetect.makeFootprintSet(im, threshold).getFootprints()
+        self.assertTrue(len(objects) > 10)
+
+        for nThreads in [2, 3, 7, 0]:
+            threshold.setNThreads(nThreads)
+            pobjects = afwDetect.makeFootprintSet(im, threshold).getFootprints()
+
+            self.assertEqual(len(pobjects), len(objects))
+            for foot, pfoot in zip(objects, pobjects):
+                self.assertEqual([(s.getY(), s.getX0(), s.getX1()) for s in pfoot.getSpans()],
+                                 [(s.getY(), s.getX0(), s.getX1()) for s in foot.getSpans()])
+                self.assertEqual([(p.getIx(), p.getIy()) for p in pfoot.getPeaks()],
+                                 [(p.getIx(), p.getIy()) for p in foot.getPeaks()])
+
     def testFootprintsMasks(self):
         """Check that detectionSets have the proper mask bits set"""
         ds = afwDetect.makeFootprintSet(self.ms, afwDetect.Threshold(10), "OBJECT")
@@ -474,6 +474,70 @@ class PeaksInFootprintsTestCase(unittest.TestCase):
 
         self.checkPeaks(frame=3)
 
+    def testMergeMatchesDetection(self):
+        """Check that merging gives the Footprints found by detecting the union of the grown Footprints"""
+        x0, y0 = 5, 6
+        dwidth, dheight = 6, 7
+        def callback():
+            self.im.getImage().set(x0 + 10, y0 + 4, -20)
+            self.im.getImage().set(0, 0, -30) # in the corner, so grown Footprints must be clipped
+
+        for grow1, grow2 in [(0, 0), (1, 2), (3, 1), (2, 6)]:
+            self.doTestPeaks(threshold=10, callback=callback, grow=0,
+                             x0=x0, y0=y0, dwidth=dwidth, dheight=dheight)
+
+            fs1 = self.fs
+            threshold = afwDetect.Threshold(10, afwDetect.Threshold.VALUE, False)
+            fs2 = afwDetect.makeFootprintSet(self.im, threshold)
+            peaks = [p.getPeakValue() for fs in (fs1, fs2) for foot in fs.getFootprints()
+                     for p in foot.getPeaks()]
+
+            msk = afwImage.MaskU(self.im.getDimensions())
+            msk.set(0)
+            for fs, grow in [(fs1, grow1), (fs2, grow2)]:
+                for foot in fs.getFootprints():
+                    if grow > 0:
+                        foot = afwDetect.growFootprint(foot, grow)
+                    afwDetect.setMaskFromFootprint(msk, foot, 0x1)
+            expected = afwDetect.makeFootprintSet(msk, afwDetect.Threshold(0x1, afwDetect.Threshold.BITMASK))
+
+            fs1.merge(fs2, grow1, grow2)
+            merged = fs1.getFootprints()
+
+            self.assertEqual(len(merged), len(expected.getFootprints()))
+            for foot, efoot in zip(merged, expected.getFootprints()):
+                self.assertEqual([s.toString() for s in foot.getSpanVector()],
+                                 [s.toString() for s in efoot.getSpanVector()])
+                values = [p.getPeakValue() for p in foot.getPeaks()]
+                self.assertEqual(values, sorted(values, reverse=True))
+            self.assertEqual(sorted([p.getPeakValue() for foot in merged for p in foot.getPeaks()]),
+                             sorted(peaks))
+
+    def testMergeUnsortedPeaks(self):
+        """Check that merging sorts Peak lists that the user has left out of order"""
+        def callback():
+            self.im.getImage().set(15, 10, -20)
+
+        self.doTestPeaks(threshold=10, callback=callback, grow=0, x0=5, y0=6, dwidth=6, dheight=7)
+
+        fs1 = self.fs
+        fs2 = afwDetect.makeFootprintSet(self.im, afwDetect.Threshold(10, afwDetect.Threshold.VALUE, False))
+        for i, fs in enumerate([fs1, fs2]):
+            for foot in fs.getFootprints():
+                bbox = foot.getBBox()
+                foot.getPeaks().append(afwDetect.Peak(bbox.getMinX(), bbox.getMinY(), 1000 + i))
+        peaks = [p.getPeakValue() for fs in (fs1, fs2) for foot in fs.getFootprints() for p in foot.getPeaks()]
+
+        for grow1, grow2 in [(0, 0), (6, 6)]:
+            fs = afwDetect.FootprintSetF(fs1)
+            fs.merge(fs2, grow1, grow2)
+
+            for foot in fs.getFootprints():
+                values = [p.getPeakValue() for p in foot.getPeaks()]
+                self.assertEqual(values, sorted(values, reverse=True))
+            self.assertEqual(sorted([p.getPeakValue() for foot in fs.getFootprints() for p in foot.getPeaks()]),
+                             sorted(peaks))
+
 #-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 
 def suite():
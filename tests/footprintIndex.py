@@ -0,0 +1,149 @@
+#!/usr/bin/env python
+
+# 
+# LSST Data Management System
+# Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+# 
+# This product includes software developed by the
+# LSST Project (http://www.lsst.org/).
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+# 
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+# 
+# You should have received a copy of the LSST License Statement and 
+# the GNU General Public License along with this program.  If not, 
+# see <http://www.lsstcorp.org/LegalNotices/>.
+#
+
+"""
+Tests for FootprintIndex
+
+Run with:
+   footprintIndex.py
+or
+   python
+   >>> import footprintIndex; footprintIndex.run()
+"""
+
+import unittest
+import lsst.utils.tests as utilsTests
+import lsst.pex.exceptions as pexExcept
+import lsst.afw.geom as afwGeom
+import lsst.afw.detection as afwDetect
+
+#-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+class FootprintIndexTestCase(unittest.TestCase):
+    """A test case for FootprintIndex"""
+
+    def setUp(self):
+        self.footprints = afwDetect.FootprintContainerT()
+        for i in range(60):
+            x, y = (i*37) % 200, (i*53) % 150
+            if i % 3 == 0:
+                foot = afwDetect.Footprint(afwGeom.Point2I(x, y), 2 + i % 5)
+            elif i % 3 == 1:
+                foot = afwDetect.Footprint(afwGeom.Box2I(afwGeom.Point2I(x, y),
+                                                         afwGeom.Extent2I(1 + i % 7, 1 + i % 4)))
+            else:                       # an L-shape with its Spans out of order, so not normalized
+                foot = afwDetect.Footprint()
+                foot.addSpan(y + 3, x, x + 8)
+                for dy in range(3):
+                    foot.addSpan(y + dy, x, x + 1)
+            self.footprints.push_back(foot)
+        self.footprints.push_back(afwDetect.Footprint()) # an empty Footprint is never found
+
+        self.index = afwDetect.FootprintIndex(self.footprints, 4)
+
+    def tearDown(self):
+        del self.index
+        del self.footprints
+
+    def distanceSquared(self, foot, x, y):
+        """Return the squared distance from (x, y) to the nearest pixel centre in foot"""
+        best = None
+        for s in foot.getSpans():
+            dx = max(s.getX0() - x, x - s.getX1(), 0)
+            d2 = dx**2 + (y - s.getY())**2
+            if best is None or d2 < best:
+                best = d2
+        return best
+
+    def testSize(self):
+        self.assertEqual(self.index.getSize(), len(self.footprints))
+
+    def testContaining(self):
+        """Check findContaining against looking at every Footprint"""
+        for y in range(-5, 160, 3):
+            for x in range(-5, 215, 2):
+                pix = afwGeom.Point2I(x, y)
+                expected = [f for f in self.footprints if f.contains(pix)]
+                found = self.index.findContaining(pix)
+                if expected:
+                    self.assertEqual(found.getId(), expected[0].getId())
+                else:
+                    self.assertEqual(found, None)
+
+    def testOverlapping(self):
+        """Check findOverlapping against looking at every Footprint"""
+        for i in range(40):
+            box = afwGeom.Box2I(afwGeom.Point2I((i*23) % 210 - 5, (i*41) % 160 - 5),
+                                afwGeom.Extent2I(1 + (i*7) % 30, 1 + (i*11) % 20))
+            expected = []
+            for f in self.footprints:
+                for s in f.getSpans():
+                    if box.getMinY() <= s.getY() <= box.getMaxY() and \
+                            s.getX0() <= box.getMaxX() and s.getX1() >= box.getMinX():
+                        expected.append(f.getId())
+                        break
+            self.assertEqual([f.getId() for f in self.index.findOverlapping(box)], expected)
+
+    def testNearest(self):
+        """Check findNearest against looking at every Footprint"""
+        for i in range(100):
+            x, y = (i*13.7) % 230 - 15, (i*29.3) % 180 - 15
+            best, bestD2 = None, None
+            for f in self.footprints:
+                d2 = self.distanceSquared(f, x, y)
+                if d2 is not None and (bestD2 is None or d2 < bestD2):
+                    best, bestD2 = f, d2
+            found = self.index.findNearest(afwGeom.Point2D(x, y))
+            self.assertAlmostEqual(self.distanceSquared(found, x, y), bestD2)
+            self.assertEqual(found.getId(), best.getId())
+
+    def testEmpty(self):
+        index = afwDetect.FootprintIndex(afwDetect.FootprintContainerT())
+        self.assertEqual(index.getSize(), 0)
+        self.assertEqual(index.findContaining(afwGeom.Point2I(0, 0)), None)
+        self.assertEqual(len(index.findOverlapping(afwGeom.Box2I(afwGeom.Point2I(0, 0),
+                                                                 afwGeom.Extent2I(10, 10)))), 0)
+        self.assertEqual(index.findNearest(afwGeom.Point2D(0, 0)), None)
+
+    def testBadNodeCapacity(self):
+        utilsTests.assertRaisesLsstCpp(self, pexExcept.InvalidParameterException,
+                                       afwDetect.FootprintIndex, self.footprints, 1)
+
+#-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+def suite():
+    """Returns a suite containing all the test cases in this module."""
+    utilsTests.init()
+
+    suites = []
+    suites += unittest.makeSuite(FootprintIndexTestCase)
+    suites += unittest.makeSuite(utilsTests.MemoryTestCase)
+    return unittest.TestSuite(suites)
+
+def run(shouldExit=False):
+    """Run the tests"""
+    utilsTests.run(suite(), shouldExit)
+
+if __name__ == "__main__":
+    run(True)
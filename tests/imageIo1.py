@@ -32,6 +32,7 @@ import unittest
 import eups
 import lsst.afw.geom as afwGeom
 import lsst.afw.image as afwImage
+import lsst.pex.exceptions as pexExcept
 import lsst.utils.tests as utilsTests
 import lsst.afw.display.ds9 as ds9
 
@@ -117,6 +118,51 @@ class ReadFitsTestCase(unittest.TestCase):
         self.assertEqual(im2.getX0(), sim.getX0())
         self.assertEqual(im2.getY0(), sim.getY0())
 
+    def testMappedRoundTrip(self):
+        """Test that images read by mapping the file (those of the file's type) match those written,
+        whole or in part, and that modifying them doesn't modify the file"""
+
+        imPath = "data"
+        if os.path.exists("tests"):
+            imPath = os.path.join("tests", imPath)
+        imPath = os.path.join(imPath, "mapped.fits")
+
+        bbox = afwGeom.Box2I(afwGeom.Point2I(11, 7), afwGeom.Extent2I(33, 21))
+        for Image in (afwImage.ImageU, afwImage.ImageI, afwImage.ImageF, afwImage.ImageD):
+            im = Image(afwGeom.Extent2I(120, 50))
+            im.setXY0(afwGeom.Point2I(5, 6))
+            for y in range(im.getHeight()):
+                for x in range(im.getWidth()):
+                    im.set(x, y, 60000 - 100*y - x if Image == afwImage.ImageU else 100*y - x + 0.5)
+            im.writeFits(imPath)
+
+            im2 = Image(imPath)
+            self.assertEqual(im2.getXY0(), im.getXY0())
+            self.assertEqual(im2.getDimensions(), im.getDimensions())
+            for x, y in [(0, 0), (119, 0), (0, 49), (119, 49), (57, 23)]:
+                self.assertEqual(im2.get(x, y), im.get(x, y))
+
+            for origin, offset in [(afwImage.LOCAL, afwGeom.Extent2I(0, 0)),
+                                   (afwImage.PARENT, afwGeom.Extent2I(im.getXY0()))]:
+                readBox = afwGeom.Box2I(bbox.getMin() + offset, bbox.getDimensions())
+                sim = im.Factory(im, bbox, afwImage.LOCAL)
+                im3 = Image(imPath, 0, None, readBox, origin)
+                self.assertEqual(im3.getXY0(), sim.getXY0())
+                self.assertEqual(im3.getDimensions(), sim.getDimensions())
+                for x, y in [(0, 0), (32, 0), (0, 20), (32, 20), (17, 9)]:
+                    self.assertEqual(im3.get(x, y), sim.get(x, y))
+
+            im2.set(0)
+            self.assertEqual(Image(imPath).get(57, 23), im.get(57, 23))
+
+            # boxes that overlap the image's far edges
+            for readBox in [afwGeom.Box2I(afwGeom.Point2I(100, 0), afwGeom.Extent2I(21, 10)),
+                            afwGeom.Box2I(afwGeom.Point2I(0, 45), afwGeom.Extent2I(10, 6))]:
+                utilsTests.assertRaisesLsstCpp(self, pexExcept.LengthErrorException,
+                                               Image, imPath, 0, None, readBox, afwImage.LOCAL)
+
+        os.remove(imPath)
+
     def testMEF(self):
         """Test writing a set of images to an MEF fits file, and then reading them back"""
         
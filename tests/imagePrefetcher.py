@@ -0,0 +1,175 @@
+#!/usr/bin/env python
+
+#
+# LSST Data Management System
+# Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+#
+# This product includes software developed by the
+# LSST Project (http://www.lsst.org/).
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the LSST License Statement and
+# the GNU General Public License along with this program.  If not,
+# see <http://www.lsstcorp.org/LegalNotices/>.
+#
+
+"""
+Tests for ImagePrefetcher
+
+Run with:
+   python imagePrefetcher.py
+or
+   python
+   >>> import imagePrefetcher; imagePrefetcher.run()
+"""
+
+import os
+import unittest
+
+import lsst.utils.tests as utilsTests
+import lsst.daf.base as dafBase
+import lsst.afw.image as afwImage
+import lsst.afw.geom as afwGeom
+import lsst.pex.exceptions as pexEx
+
+#-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+class ImagePrefetcherTestCase(unittest.TestCase):
+    """A test case for ImagePrefetcher"""
+    def setUp(self):
+        self.fileNames = []
+        for i in range(5):
+            mi = afwImage.MaskedImageF(afwGeom.Extent2I(20, 10))
+            mi.setXY0(afwGeom.Point2I(i, 2*i))
+            mi.set(100 + i, 0x1, 10 + i)
+            fileName = "prefetch%d.fits" % i
+            afwImage.ExposureF(mi).writeFits(fileName)
+            self.fileNames.append(fileName)
+
+    def tearDown(self):
+        for fileName in self.fileNames:
+            os.remove(fileName)
+
+    def testOrder(self):
+        """Check that images are returned in the order requested, however many are read at once"""
+        for nAhead, nThreads in [(1, 1), (2, 1), (3, 2), (10, 4)]:
+            prefetcher = afwImage.ExposurePrefetcherF(self.fileNames, nAhead, nThreads)
+            self.assertEqual(prefetcher.size(), len(self.fileNames))
+            i = 0
+            while prefetcher.hasNext():
+                exposure = prefetcher.next()
+                self.assertEqual(exposure.getMaskedImage().getXY0(), afwGeom.Point2I(i, 2*i))
+                self.assertEqual(exposure.getMaskedImage().get(0, 0), (100 + i, 0x1, 10 + i))
+                i += 1
+            self.assertEqual(i, len(self.fileNames))
+
+            utilsTests.assertRaisesLsstCpp(self, pexEx.OutOfRangeException, prefetcher.next)
+
+    def testRequests(self):
+        """Check that bounding boxes are honoured, and requests made from a Formatter's additionalData"""
+        bbox = afwGeom.Box2I(afwGeom.Point2I(3, 4), afwGeom.Extent2I(5, 6))
+        additionalData = dafBase.PropertySet()
+        additionalData.set("llcX", 3)
+        additionalData.set("llcY", 4)
+        additionalData.set("width", 5)
+        additionalData.set("height", 6)
+
+        requests = afwImage.VectorPrefetchRequest()
+        requests.push_back(afwImage.PrefetchRequest(self.fileNames[1], 0, bbox, afwImage.LOCAL))
+        requests.push_back(afwImage.PrefetchRequest.fromAdditionalData(self.fileNames[2], additionalData))
+
+        prefetcher = afwImage.MaskedImagePrefetcherF(requests)
+        for i in (1, 2):
+            mi = prefetcher.next()
+            self.assertEqual(mi.getDimensions(), bbox.getDimensions())
+            self.assertEqual(mi.getXY0(), afwGeom.Point2I(i + 3, 2*i + 4))
+        self.assertFalse(prefetcher.hasNext())
+
+    def testWcs(self):
+        """Check that Exposures with a WCS may be read on several threads at once"""
+        fileNames = []
+        for i in range(8):
+            md = dafBase.PropertySet()
+            md.set("CTYPE1", "RA---TAN")
+            md.set("CTYPE2", "DEC--TAN")
+            md.setDouble("CRVAL1", 215.0 + i)
+            md.setDouble("CRVAL2", 53.0)
+            md.setDouble("CRPIX1", 10.0)
+            md.setDouble("CRPIX2", 5.0)
+            md.setDouble("CD1_1", 5.0e-05)
+            md.setDouble("CD1_2", 0.0)
+            md.setDouble("CD2_1", 0.0)
+            md.setDouble("CD2_2", 5.0e-05)
+            exposure = afwImage.ExposureF(afwImage.MaskedImageF(afwGeom.Extent2I(20, 10)),
+                                          afwImage.makeWcs(md))
+            fileName = "prefetchWcs%d.fits" % i
+            exposure.writeFits(fileName)
+            fileNames.append(fileName)
+
+        try:
+            prefetcher = afwImage.ExposurePrefetcherF(fileNames, 8, 4)
+            for i in range(len(fileNames)):
+                wcs = prefetcher.next().getWcs()
+                self.assertTrue(wcs)
+                self.assertAlmostEqual(wcs.getSkyOrigin().getPosition(afwGeom.degrees)[0], 215.0 + i)
+        finally:
+            for fileName in fileNames:
+                os.remove(fileName)
+
+    def testMaskPlanes(self):
+        """Check that masks whose planes differ from the process's dictionary are conformed to it"""
+        fileNames = []
+        for i in range(6):
+            mi = afwImage.MaskedImageF(afwGeom.Extent2I(20, 10))
+            mask = mi.getMask()
+            mask.addMaskPlane("PREFETCH%d" % i)
+            mask.set(mask.getPlaneBitMask("PREFETCH%d" % i))
+            fileName = "prefetchMask%d.fits" % i
+            afwImage.ExposureF(mi).writeFits(fileName)
+            fileNames.append(fileName)
+            mask.removeMaskPlane("PREFETCH%d" % i)
+
+        try:
+            prefetcher = afwImage.ExposurePrefetcherF(fileNames, 6, 3)
+            for i in range(len(fileNames)):
+                mask = prefetcher.next().getMaskedImage().getMask()
+                self.assertEqual(mask.get(0, 0), mask.getPlaneBitMask("PREFETCH%d" % i))
+        finally:
+            for fileName in fileNames:
+                os.remove(fileName)
+            for i in range(len(fileNames)):
+                afwImage.MaskU().removeMaskPlane("PREFETCH%d" % i)
+
+    def testMissingFile(self):
+        """Check that failing to read an image is reported when it's wanted, and not before"""
+        prefetcher = afwImage.ExposurePrefetcherF(["noSuchFile.fits"] + self.fileNames[0:1], 2)
+        utilsTests.assertRaisesLsstCpp(self, pexEx.RuntimeErrorException, prefetcher.next)
+        self.assertEqual(prefetcher.next().getMaskedImage().get(0, 0), (100, 0x1, 10))
+
+#-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+def suite():
+    """Returns a suite containing all the test cases in this module."""
+
+    utilsTests.init()
+
+    suites = []
+    suites += unittest.makeSuite(ImagePrefetcherTestCase)
+    suites += unittest.makeSuite(utilsTests.MemoryTestCase)
+    return unittest.TestSuite(suites)
+
+def run(shouldExit=False):
+    """Run the tests"""
+    utilsTests.run(suite(), shouldExit)
+
+if __name__ == "__main__":
+    run(True)
@@ -33,6 +33,7 @@ or
 """
 
 
+import math
 import unittest
 
 import lsst.utils.tests as utilsTests
@@ -95,6 +96,42 @@ class InterpolateTestCase(unittest.TestCase):
 
         self.assertEqual(youtS, self.y2test)
 
+    def testVectorInterpolate(self):
+        """Test interpolating a vector of points, sorted and unsorted, with GSL and native splines"""
+        n = 12
+        x = afwMath.vectorD(n)
+        y = afwMath.vectorD(n)
+        for i in range(n):
+            x[i] = 1.5*i + 0.1*i*i
+            y[i] = 100.0 + 10.0*math.sin(0.8*i) + i
+
+        xs = [0.25*i - 1.0 for i in range(100)]      # sorted, including extrapolated points
+        xs += [7.3, 0.5, 21.0, 2.0, 2.0, -0.5]      # unsorted
+        xtest = afwMath.vectorD(len(xs))
+        for i, xx in enumerate(xs):
+            xtest[i] = xx
+
+        for style in [afwMath.Interpolate.LINEAR, afwMath.Interpolate.NATURAL_SPLINE,
+                      afwMath.Interpolate.AKIMA_SPLINE]:
+            interp = afwMath.Interpolate(x, y, style)
+            ytest = afwMath.vectorD()
+            interp.interpolate(xtest, ytest)
+            self.assertEqual(len(ytest), len(xtest))
+            for i in range(len(xtest)):
+                self.assertEqual(ytest[i], interp.interpolate(xtest[i]))
+
+            if style == afwMath.Interpolate.LINEAR:
+                utilsTests.assertRaisesLsstCpp(self, pexExcept.InvalidParameterException,
+                                               lambda : afwMath.Interpolate(x, y, style, True))
+                continue
+
+            native = afwMath.Interpolate(x, y, style, True)
+            ynative = afwMath.vectorD()
+            native.interpolate(xtest, ynative)
+            for i in range(len(xtest)):
+                self.assertAlmostEqual(ynative[i], ytest[i], 9)
+                self.assertEqual(ynative[i], native.interpolate(xtest[i]))
+
     def testInvalidInputs(self):
         """Test that invalid inputs cause an abort"""
 
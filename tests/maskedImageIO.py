@@ -169,6 +169,30 @@ class MaskedImageTestCase(unittest.TestCase):
 
         utilsTests.assertRaisesLsstCpp(self, pexEx.IoErrorException, tst)
 
+    def testReadWriteMEFPixels(self):
+        """Test that the planes of an MEF round trip, whole or in part, and when they're converted"""
+        mi = afwImage.MaskedImageF(afwGeom.Extent2I(30, 20))
+        mi.setXY0(afwGeom.Point2I(5, 6))
+        for y in range(mi.getHeight()):
+            for x in range(mi.getWidth()):
+                mi.set(x, y, (100*y + x + 0.5, (x*y) & 0xff, y - x))
+
+        tmpFile = "foo.fits"
+        mi.writeFits(tmpFile)
+
+        bbox = afwGeom.Box2I(afwGeom.Point2I(12, 10), afwGeom.Extent2I(9, 7))
+        for mi2, sub in [(afwImage.MaskedImageF(tmpFile), mi),
+                         (afwImage.MaskedImageF(tmpFile, 0, None, bbox, afwImage.PARENT),
+                          afwImage.MaskedImageF(mi, bbox, afwImage.PARENT)),
+                         (afwImage.MaskedImageD(tmpFile), mi)]:
+            self.assertEqual(mi2.getXY0(), sub.getXY0())
+            self.assertEqual(mi2.getDimensions(), sub.getDimensions())
+            for y in range(sub.getHeight()):
+                for x in range(sub.getWidth()):
+                    self.assertEqual(mi2.get(x, y), sub.get(x, y))
+
+        os.remove(tmpFile)
+
     def testReadWriteXY0(self):
         """Test that we read and write (X0, Y0) correctly"""
         im = afwImage.MaskedImageF(afwGeom.Extent2I(10, 20))
@@ -195,6 +219,48 @@ class MaskedImageTestCase(unittest.TestCase):
         os.remove(afwImage.MaskedImageF.maskFileName(tmpFile))
         os.remove(afwImage.MaskedImageF.varianceFileName(tmpFile))
 
+    def testTileCompression(self):
+        """Test that a tile-compressed MaskedImage round trips (the image and variance to within their
+        quantization), whole or in part, and that the compression keys aren't written to the header"""
+        import random
+        import lsst.daf.base as dafBase
+
+        mi = afwImage.MaskedImageF(afwGeom.Extent2I(300, 200))
+        mi.setXY0(afwGeom.Point2I(10, 20))
+        rand = random.Random(666)
+        for y in range(mi.getHeight()):
+            for x in range(mi.getWidth()):
+                mi.getImage().set(x, y, 1000 + rand.gauss(0, 10))
+                mi.getMask().set(x, y, 0x4 if (x - 150)**2 + (y - 100)**2 < 400 else 0x0)
+                mi.getVariance().set(x, y, 100 + rand.gauss(0, 1))
+
+        tmpFile, compressedFile = "foo.fits", "fooCompressed.fits"
+        mi.writeFits(tmpFile)
+        md = dafBase.PropertyList()
+        md.set("ZCMPTYPE", "RICE_1")
+        mi.writeFits(compressedFile, md)
+        self.assertTrue(os.path.getsize(compressedFile) < os.path.getsize(tmpFile)/2)
+
+        hdr = afwImage.readMetadata(compressedFile, 2, True)
+        self.assertEqual(hdr.get("EXTTYPE"), "IMAGE")
+        for k in ("ZCMPTYPE", "ZIMAGE", "ZBITPIX", "TTYPE1", "TFIELDS"):
+            self.assertFalse(hdr.exists(k))
+
+        bbox = afwGeom.Box2I(afwGeom.Point2I(140, 90), afwGeom.Extent2I(40, 30))
+        for mi2, sub in [(afwImage.MaskedImageF(compressedFile), mi),
+                         (afwImage.MaskedImageF(compressedFile, 0, None, bbox, afwImage.LOCAL),
+                          afwImage.MaskedImageF(mi, bbox, afwImage.LOCAL))]:
+            self.assertEqual(mi2.getXY0(), sub.getXY0())
+            self.assertEqual(mi2.getDimensions(), sub.getDimensions())
+            for y in range(0, sub.getHeight(), 7):
+                for x in range(0, sub.getWidth(), 5):
+                    self.assertEqual(mi2.getMask().get(x, y), sub.getMask().get(x, y))
+                    self.assertTrue(abs(mi2.getImage().get(x, y) - sub.getImage().get(x, y)) < 3.0)
+                    self.assertTrue(abs(mi2.getVariance().get(x, y) - sub.getVariance().get(x, y)) < 0.3)
+
+        os.remove(tmpFile)
+        os.remove(compressedFile)
+
     def testWcs(self):
         """Test round-tripping an empty Wcs"""
         mi = afwImage.MaskedImageF(afwGeom.Extent2I(10, 20))
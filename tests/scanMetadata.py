@@ -0,0 +1,139 @@
+#!/usr/bin/env python
+
+#
+# LSST Data Management System
+# Copyright 2008, 2009, 2010, 2011 LSST Corporation.
+#
+# This product includes software developed by the
+# LSST Project (http://www.lsst.org/).
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the LSST License Statement and
+# the GNU General Public License along with this program.  If not,
+# see <http://www.lsstcorp.org/LegalNotices/>.
+#
+
+"""
+Tests for scanMetadata, which reads selected keywords from FITS headers
+
+Run with:
+   python scanMetadata.py
+or
+   python
+   >>> import scanMetadata; scanMetadata.run()
+"""
+
+import os
+import shutil
+import tempfile
+import unittest
+
+import lsst.utils.tests as utilsTests
+import lsst.daf.base as dafBase
+import lsst.afw.image as afwImage
+import lsst.afw.geom as afwGeom
+import lsst.pex.exceptions as pexEx
+
+#-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+class ScanMetadataTestCase(unittest.TestCase):
+    """A test case for scanMetadata"""
+    def setUp(self):
+        self.dirName = tempfile.mkdtemp()
+        self.longString = "A string that is too long to fit on one header card, so cfitsio continues it " \
+            "onto the next"
+        self.fileNames = []
+        for i in range(4):
+            md = dafBase.PropertyList()
+            md.set("EXPTIME", 10.0*(i + 1))
+            md.set("FILTER", "ugriz"[i])
+            md.set("OBJECT", self.longString)
+            md.set("NFRAME", i)
+            fileName = os.path.join(self.dirName, "scan%d.fits" % i)
+            afwImage.MaskedImageF(afwGeom.Extent2I(30 + i, 20)).writeFits(fileName, md)
+            self.fileNames.append(fileName)
+        open(os.path.join(self.dirName, "notFits.txt"), "w").write("Not a FITS file\n")
+
+        self.keys = ["EXPTIME", "FILTER", "OBJECT", "NFRAME", "EXTTYPE", "NAXIS1", "NOSUCHKEY"]
+
+    def tearDown(self):
+        shutil.rmtree(self.dirName)
+
+    def checkValues(self, values, fileName, hdu):
+        """Check that the values scanned from a file agree with those read by readMetadata"""
+        md = afwImage.readMetadata(fileName, hdu)
+        for k in self.keys:
+            if md.exists(k):
+                value = md.get(k)
+                self.assertEqual(type(value)(values[k]), value)
+            else:
+                self.assertFalse(k in values)
+
+    def testScanFile(self):
+        """Check that we find the right HDU, and parse the values in it"""
+        for hdu, extType in [(0, "IMAGE"), (1, None), (2, "IMAGE"), (3, "MASK"), (4, "VARIANCE")]:
+            values = afwImage.scanMetadata(self.fileNames[1], self.keys, hdu)
+            if extType:
+                self.assertEqual(values["EXTTYPE"], extType)
+            self.checkValues(values, self.fileNames[1], hdu)
+
+        values = afwImage.scanMetadata(self.fileNames[3], self.keys)
+        self.assertEqual(values["OBJECT"], self.longString)
+        self.assertEqual(values["FILTER"], "z")
+        self.assertEqual(int(values["NAXIS1"]), 33)
+        self.assertFalse("NOSUCHKEY" in values)
+
+    def testScanFiles(self):
+        """Check that scanning a list of files, on any number of threads, returns each file's values"""
+        for nThreads in (0, 1, 3):
+            valuesList = afwImage.scanMetadata(self.fileNames, self.keys, 0, nThreads)
+            self.assertEqual(len(valuesList), len(self.fileNames))
+            for i, values in enumerate(valuesList):
+                self.assertEqual(values["FILTER"], "ugriz"[i])
+                self.checkValues(values, self.fileNames[i], 0)
+
+    def testScanDirectory(self):
+        """Check that we scan only the FITS files in a directory"""
+        valuesByName = afwImage.scanMetadataDirectory(self.dirName, ["NFRAME"])
+        self.assertEqual(sorted(valuesByName.keys()), sorted(self.fileNames))
+        for i, fileName in enumerate(self.fileNames):
+            self.assertEqual(int(valuesByName[fileName]["NFRAME"]), i)
+
+        utilsTests.assertRaisesLsstCpp(self, pexEx.LsstCppException,
+                                       afwImage.scanMetadataDirectory, self.dirName, ["NFRAME"], 0, ".*", 2)
+
+    def testErrors(self):
+        """Check that we complain about missing files, non-FITS files, and missing HDUs"""
+        for fileName, hdu in [(os.path.join(self.dirName, "noSuchFile.fits"), 0),
+                              (os.path.join(self.dirName, "notFits.txt"), 0),
+                              (self.fileNames[0], 5)]:
+            utilsTests.assertRaisesLsstCpp(self, pexEx.LsstCppException,
+                                           afwImage.scanMetadata, fileName, self.keys, hdu)
+
+#-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+def suite():
+    """Returns a suite containing all the test cases in this module."""
+
+    utilsTests.init()
+
+    suites = []
+    suites += unittest.makeSuite(ScanMetadataTestCase)
+    suites += unittest.makeSuite(utilsTests.MemoryTestCase)
+    return unittest.TestSuite(suites)
+
+def run(shouldExit=False):
+    """Run the tests"""
+    utilsTests.run(suite(), shouldExit)
+
+if __name__ == "__main__":
+    run(True)
@@ -80,6 +80,68 @@ class SourceMatchTestCase(unittest.TestCase):
             s1 = mat[0][1]
             print s0.getRa(), s1.getRa(), s0.getId(), s1.getId()
 
+    def testSkyIndex(self):
+        """Check that a SourceSkyIndex reproduces matchRaDec, and supports point queries"""
+        nobj = 1000
+        for i in range(nobj):
+            for ss in (self.ss1, self.ss2):
+                s = afwDetect.Source()
+                s.setId(i + (0 if ss is self.ss1 else nobj))
+                s.setRa((10 + 0.001*i) * afwGeom.degrees)
+                s.setDec((80 + 0.01*i + (0 if ss is self.ss1 else 1e-4)) * afwGeom.degrees)
+                ss.append(s)
+
+        radius = 1.0 * afwGeom.arcseconds
+        index = afwDetect.SourceSkyIndex(self.ss2)
+        self.assertEqual(index.getSize(), nobj)
+        for closest in (True, False):
+            mat = afwDetect.matchRaDec(self.ss1, self.ss2, radius, closest)
+            self.assertEqual(len(mat), nobj)
+            for nThreads in (1, 3):
+                indexMat = index.match(self.ss1, radius, closest, nThreads)
+                self.assertEqual([(m.first.getId(), m.second.getId(), m.distance) for m in indexMat],
+                                 [(m.first.getId(), m.second.getId(), m.distance) for m in mat])
+
+        s = self.ss1[17]
+        self.assertEqual(index.findClosest(s.getRa(), s.getDec(), radius).getId(), nobj + 17)
+        # neighbouring sources are 36 arcsec apart
+        self.assertEqual(len(index.findWithin(s.getRa(), s.getDec(), 10*radius)), 1)
+        self.assertEqual(len(index.findWithin(s.getRa(), s.getDec(), 1000*radius)), 2*27 + 1)
+
+    def testSourceCatalog(self):
+        """Check that a SourceCatalog holds the fields of its sources, and matches like a SourceSet"""
+        nobj = 100
+        for i in range(nobj):
+            for ss in (self.ss1, self.ss2):
+                s = afwDetect.Source()
+                s.setId(i + (0 if ss is self.ss1 else nobj))
+                s.setRa((10 + 0.001*i) * afwGeom.degrees)
+                s.setDec((10 + 0.001*i) * afwGeom.degrees)
+                s.setXAstrom(10.0*i)
+                s.setYAstrom(5.0*i)
+                s.setPsfFlux(1000.0 + i)
+                ss.append(s)
+
+        cat1 = afwDetect.SourceCatalog(self.ss1)
+        cat2 = afwDetect.SourceCatalog(self.ss2)
+        self.assertEqual(len(cat1), nobj)
+        self.assertEqual(cat1[-1].getId(), nobj - 1)
+        self.assertEqual(cat1[17].getPsfFlux(), 1017.0)
+        self.assertEqual(cat1[17].getSource().getId(), 17)
+        self.assertEqual(list(cat1.getPsfFluxColumn()), [s.getPsfFlux() for s in self.ss1])
+        self.assertEqual([row.getXAstrom() for row in cat1], [s.getXAstrom() for s in self.ss1])
+        self.assertRaises(IndexError, lambda: cat1[nobj])
+        self.assertEqual(len(cat1.getSources()), nobj)
+
+        radius = 1.0 * afwGeom.arcseconds
+        for closest in (True, False):
+            mat = afwDetect.matchRaDec(cat1, cat2, radius, closest)
+            self.assertEqual(len(mat), nobj)
+            self.assertEqual([(m.first.getId(), m.second.getId()) for m in mat],
+                             [(m.first.getId(), m.second.getId())
+                              for m in afwDetect.matchRaDec(self.ss1, self.ss2, radius, closest)])
+            self.assertEqual(len(afwDetect.matchXy(cat1, cat2, 1.0, closest)), nobj)
+
     def testNaNPositions(self):
         ss1 = afwDetect.SourceSet()
         ss2 = afwDetect.SourceSet()
@@ -25,13 +25,16 @@
 #define BOOST_TEST_DYN_LINK
 #define BOOST_TEST_MODULE SourceMatch
 
+#include <algorithm>
 #include <cmath>
 
 #include "boost/test/unit_test.hpp"
 #include "boost/test/floating_point_comparison.hpp"
 
 #include "lsst/afw/detection/Source.h"
+#include "lsst/afw/detection/SourceCatalog.h"
 #include "lsst/afw/detection/SourceMatch.h"
+#include "lsst/afw/detection/SourceSkyIndex.h"
 #include "lsst/afw/math/Random.h"
 #include "lsst/afw/coord/Utils.h"
 #include "lsst/afw/geom/Angle.h"
@@ -176,6 +179,76 @@ void compareMatches(std::vector<det::SourceMatch> &matches,
     }
 }
 
+// The declination-band algorithm that matchRaDec used before SourceSkyIndex;
+// the index is required to reproduce its results exactly
+struct BandPos {
+    double dec, x, y, z;
+    det::Source::Ptr src;
+    bool operator<(BandPos const &rhs) const { return dec < rhs.dec; }
+};
+
+std::vector<BandPos> makeBandPositions(det::SourceSet const &set) {
+    std::vector<BandPos> pos;
+    for (det::SourceSet::const_iterator i = set.begin(); i != set.end(); ++i) {
+        afwGeom::Angle ra = (*i)->getRa();
+        afwGeom::Angle dec = (*i)->getDec();
+        double cosDec = std::cos(dec);
+        BandPos p = {dec.asRadians(), std::cos(ra)*cosDec, std::sin(ra)*cosDec, std::sin(dec), *i};
+        pos.push_back(p);
+    }
+    std::sort(pos.begin(), pos.end());
+    return pos;
+}
+
+std::vector<det::SourceMatch> bandMatchRaDec(det::SourceSet const &set1, det::SourceSet const &set2,
+                                             afwGeom::Angle radius, bool closest) {
+    double const d2Limit = radius.toUnitSphereDistanceSquared();
+    std::vector<BandPos> pos1 = makeBandPositions(set1);
+    std::vector<BandPos> pos2 = makeBandPositions(set2);
+
+    std::vector<det::SourceMatch> matches;
+    for (size_t i = 0, start = 0; i < pos1.size(); ++i) {
+        double minDec = pos1[i].dec - radius.asRadians();
+        while (start < pos2.size() && pos2[start].dec < minDec) { ++start; }
+        double maxDec = pos1[i].dec + radius.asRadians();
+        size_t closestIndex = 0;
+        double d2Include = d2Limit;
+        bool found = false;
+        for (size_t j = start; j < pos2.size() && pos2[j].dec <= maxDec; ++j) {
+            double dx = pos1[i].x - pos2[j].x;
+            double dy = pos1[i].y - pos2[j].y;
+            double dz = pos1[i].z - pos2[j].z;
+            double d2 = dx*dx + dy*dy + dz*dz;
+            if (d2 < d2Include) {
+                if (closest) {
+                    d2Include = d2;
+                    closestIndex = j;
+                    found = true;
+                } else {
+                    matches.push_back(det::SourceMatch(pos1[i].src, pos2[j].src,
+                        afwGeom::Angle::fromUnitSphereDistanceSquared(d2).asRadians()));
+                }
+            }
+        }
+        if (closest && found) {
+            matches.push_back(det::SourceMatch(pos1[i].src, pos2[closestIndex].src,
+                afwGeom::Angle::fromUnitSphereDistanceSquared(d2Include).asRadians()));
+        }
+    }
+    return matches;
+}
+
+// Check that two lists of matches are identical, element by element
+void checkIdentical(std::vector<det::SourceMatch> const &matches,
+                    std::vector<det::SourceMatch> const &refMatches) {
+    BOOST_REQUIRE_EQUAL(matches.size(), refMatches.size());
+    for (size_t i = 0; i < matches.size(); ++i) {
+        BOOST_CHECK(matches[i].first == refMatches[i].first);
+        BOOST_CHECK(matches[i].second == refMatches[i].second);
+        BOOST_CHECK_EQUAL(matches[i].distance, refMatches[i].distance);
+    }
+}
+
 } // namespace <anonymous>
 
 
@@ -354,3 +427,135 @@ BOOST_AUTO_TEST_CASE(matchNearPole) {
 }
 
 
+
+BOOST_AUTO_TEST_CASE(skyIndexMatchesBand) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+    int const N = 2000;   // # of points to generate
+    double const M = 8.0; // avg. # of matches
+    afwGeom::Angle radius = std::acos(1.0 - 2.0*M/N) * afwGeom::radians;
+
+    det::SourceSet set1, set2;
+    makeSources(set1, N);
+    makeSources(set2, N);
+
+    det::SourceSkyIndex index(set2, 4);
+    BOOST_CHECK_EQUAL(index.getSize(), N);
+    for (int closest = 0; closest != 2; ++closest) {
+        std::vector<det::SourceMatch> refMatches = bandMatchRaDec(set1, set2, radius, closest);
+        checkIdentical(index.match(set1, radius, closest), refMatches);
+        checkIdentical(index.match(set1, radius, closest, 3), refMatches);
+        checkIdentical(det::matchRaDec(set1, set2, radius, closest), refMatches);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(skyIndexMatchSelf) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+    int const N = 2000;   // # of points to generate
+    double const M = 8.0; // avg. # of matches
+    afwGeom::Angle radius = std::acos(1.0 - 2.0*M/N) * afwGeom::radians;
+
+    det::SourceSet set;
+    makeSources(set, N);
+    det::SourceSkyIndex index(set);
+    for (int symmetric = 0; symmetric != 2; ++symmetric) {
+        std::vector<det::SourceMatch> matches = index.matchSelf(radius, symmetric);
+        checkIdentical(index.matchSelf(radius, symmetric, 4), matches);
+        if (symmetric) {
+            std::vector<det::SourceMatch> refMatches = bruteMatch(set, radius.asRadians(), DistRaDec());
+            compareMatches(matches, refMatches, radius);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(skyIndexPointQueries) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+    int const N = 1000;   // # of points to generate
+    double const M = 8.0; // avg. # of matches
+    afwGeom::Angle radius = std::acos(1.0 - 2.0*M/N) * afwGeom::radians;
+
+    det::SourceSet set, probes;
+    makeSources(set, N);
+    makeSources(probes, 100);
+    det::SourceSkyIndex index(set);
+
+    std::vector<det::SourceMatch> closest = bandMatchRaDec(probes, set, radius, true);
+    std::vector<det::SourceMatch> all = bandMatchRaDec(probes, set, radius, false);
+    for (det::SourceSet::const_iterator i = probes.begin(); i != probes.end(); ++i) {
+        det::Source::Ptr refClosest;
+        for (size_t j = 0; j < closest.size(); ++j) {
+            if (closest[j].first == *i) {
+                refClosest = closest[j].second;
+            }
+        }
+        BOOST_CHECK(index.findClosest((*i)->getRa(), (*i)->getDec(), radius) == refClosest);
+
+        size_t nWithin = 0;
+        for (size_t j = 0; j < all.size(); ++j) {
+            nWithin += (all[j].first == *i);
+        }
+        BOOST_CHECK_EQUAL(index.findWithin((*i)->getRa(), (*i)->getDec(), radius).size(), nWithin);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(matchThreads) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+    int const N = 2000;   // # of points to generate
+    double const M = 8.0; // avg. # of matches
+    afwGeom::Angle radiusRaDec = std::acos(1.0 - 2.0*M/N) * afwGeom::radians;
+    double const radiusXy = std::sqrt(M/(afwGeom::PI*static_cast<double>(N)));
+
+    det::SourceSet set1, set2;
+    makeSources(set1, N);
+    makeSources(set2, N);
+    for (int closest = 0; closest != 2; ++closest) {
+        std::vector<det::SourceMatch> refMatches = det::matchXy(set1, set2, radiusXy, closest);
+        std::vector<det::SourceMatch> refSelfMatches = det::matchXy(set1, radiusXy, closest);
+        std::vector<det::SourceMatch> refRaDecMatches = det::matchRaDec(set1, set2, radiusRaDec, closest);
+        std::vector<det::SourceMatch> refSelfRaDecMatches = det::matchRaDec(set1, radiusRaDec, closest);
+        for (int nThreads = 2; nThreads <= 7; nThreads += 5) {
+            checkIdentical(det::matchXy(set1, set2, radiusXy, closest, nThreads), refMatches);
+            checkIdentical(det::matchXy(set1, radiusXy, closest, nThreads), refSelfMatches);
+            checkIdentical(det::matchRaDec(set1, set2, radiusRaDec, closest, nThreads), refRaDecMatches);
+            checkIdentical(det::matchRaDec(set1, radiusRaDec, closest, nThreads), refSelfRaDecMatches);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(matchCatalogs) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+    int const N = 2000;   // # of points to generate
+    double const M = 8.0; // avg. # of matches
+    afwGeom::Angle radiusRaDec = std::acos(1.0 - 2.0*M/N) * afwGeom::radians;
+    double const radiusXy = std::sqrt(M/(afwGeom::PI*static_cast<double>(N)));
+
+    det::SourceSet set1, set2;
+    makeSources(set1, N);
+    makeSources(set2, N);
+    set1[0]->setPsfFlux(100.0);
+    set1[0]->setFlagForDetection(0x5);
+    det::SourceCatalog cat1(set1), cat2(set2);
+
+    BOOST_CHECK_EQUAL(cat1.size(), N);
+    BOOST_CHECK(cat1.getSources() == set1);
+    BOOST_CHECK(det::PersistableSourceVector(cat1).getSources() == set1);
+    for (int i = 0; i < N; ++i) {
+        det::SourceCatalog::Row const row = cat1[i];
+        BOOST_CHECK(row.getSource() == set1[i]);
+        BOOST_CHECK_EQUAL(row.getId(), set1[i]->getId());
+        BOOST_CHECK_EQUAL(row.getRa().asRadians(), set1[i]->getRa().asRadians());
+        BOOST_CHECK_EQUAL(row.getDec().asRadians(), set1[i]->getDec().asRadians());
+        BOOST_CHECK_EQUAL(row.getXAstrom(), set1[i]->getXAstrom());
+        BOOST_CHECK_EQUAL(row.getYAstrom(), set1[i]->getYAstrom());
+    }
+    BOOST_CHECK_EQUAL(cat1[0].getPsfFlux(), 100.0);
+    BOOST_CHECK_EQUAL(cat1.getPsfFluxColumn()[0], 100.0);
+    BOOST_CHECK_EQUAL(cat1.getFlagForDetectionColumn()[0], 0x5);
+
+    for (int closest = 0; closest != 2; ++closest) {
+        checkIdentical(det::matchXy(cat1, cat2, radiusXy, closest),
+                       det::matchXy(set1, set2, radiusXy, closest));
+        checkIdentical(det::matchXy(cat1, radiusXy, closest, 3),
+                       det::matchXy(set1, radiusXy, closest));
+        checkIdentical(det::matchRaDec(cat1, cat2, radiusRaDec, closest, 3),
+                       det::matchRaDec(set1, set2, radiusRaDec, closest));
+        checkIdentical(det::matchRaDec(cat1, radiusRaDec, closest),
+                       det::matchRaDec(set1, radiusRaDec, closest));
+        checkIdentical(det::SourceSkyIndex(cat2).match(cat1, radiusRaDec, closest),
+                       det::SourceSkyIndex(set2).match(set1, radiusRaDec, closest));
+    }
+}
@@ -28,7 +28,10 @@
  * @brief An example executible which calls the example 'stack' code 
  *
  */
+#include <cstdio>
 #include <iostream>
+#include <sstream>
+#include <unistd.h>
 
 #define BOOST_TEST_DYN_LINK
 #define BOOST_TEST_MODULE Stacker
@@ -36,6 +39,8 @@
 #include "boost/test/unit_test.hpp"
 #include "boost/test/floating_point_comparison.hpp"
 
+#include "lsst/utils/ieee.h"
+#include "lsst/pex/exceptions.h"
 #include "lsst/afw/image/Image.h"
 #include "lsst/afw/math/Stack.h"
 
@@ -126,3 +131,104 @@ BOOST_AUTO_TEST_CASE(MeanStack) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a
     BOOST_CHECK_EQUAL((*wvecStack)[nX*nY/2], knownWeightMean);
 
 }
+
+namespace {
+    bool isSame(float a, float b) {
+        return (a == b) || (lsst::utils::isnan(a) && lsst::utils::isnan(b));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(FitsStack) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+    //
+    // Stack MaskedImages from FITS files a few rows at a time, and check that the result
+    // is the same as stacking them in memory
+    //
+    int const nImg = 5;
+    int const nX = 17;
+    int const nY = 23;
+
+    std::vector<MImageF::Ptr> mimgList;
+    std::vector<std::string> fileNames;
+    for (int iImg = 0; iImg < nImg; ++iImg) {
+        MImageF::Ptr mimg = MImageF::Ptr(new MImageF(geom::Extent2I(nX, nY)));
+        for (int y = 0; y != nY; ++y) {
+            int x = 0;
+            for (MImageF::x_iterator ptr = mimg->row_begin(y), end = mimg->row_end(y); ptr != end;
+                 ++ptr, ++x) {
+                *ptr = MImageF::SinglePixel((x*7 + y*3 + iImg*11) % 13, (x + y + iImg) % 4 == 0 ? 0x2 : 0x1,
+                                            1 + iImg);
+            }
+        }
+        mimgList.push_back(mimg);
+
+        std::ostringstream fileName;
+        fileName << "tests/stackerInput" << iImg << ".fits";
+        fileNames.push_back(fileName.str());
+        mimg->writeFits(fileNames.back());
+    }
+
+    math::StatisticsControl sctrl;
+    sctrl.setAndMask(0x2);
+    math::Property const statList[] = {math::MEAN, math::MEDIAN, math::MEANCLIP};
+    for (int i = 0; i != 3; ++i) {
+        MImageF::Ptr mimgStack = math::statisticsStack<float>(mimgList, statList[i], sctrl);
+
+        std::string const outFileName = "tests/stackerOutput.fits";
+        math::statisticsStackFits<float>(outFileName, fileNames, statList[i], sctrl, VecF(), 4);
+        MImageF fitsStack(outFileName);
+        std::remove(outFileName.c_str());
+
+        BOOST_CHECK_EQUAL(fitsStack.getDimensions(), mimgStack->getDimensions());
+        for (int y = 0; y != nY; ++y) {
+            MImageF::x_iterator ptr = mimgStack->row_begin(y);
+            for (MImageF::x_iterator fitsPtr = fitsStack.row_begin(y), end = fitsStack.row_end(y);
+                 fitsPtr != end; ++fitsPtr, ++ptr) {
+                BOOST_CHECK(isSame(fitsPtr.image(), ptr.image()));
+                BOOST_CHECK_EQUAL(fitsPtr.mask(), ptr.mask());
+                BOOST_CHECK(isSame(fitsPtr.variance(), ptr.variance()));
+            }
+        }
+    }
+
+    for (int iImg = 0; iImg < nImg; ++iImg) {
+        std::remove(fileNames[iImg].c_str());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(FitsStackFailure) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+    //
+    // Check that if the stack can't be computed (here because an input's pixels have been truncated
+    // away, although its headers are intact) we don't leave a partly-written output file behind
+    //
+    int const nImg = 3;
+    int const nX = 17;
+    int const nY = 23;
+
+    std::vector<std::string> fileNames;
+    for (int iImg = 0; iImg < nImg; ++iImg) {
+        MImageF mimg(geom::Extent2I(nX, nY));
+        mimg = MImageF::SinglePixel(iImg, 0x0, 1);
+
+        std::ostringstream fileName;
+        fileName << "tests/stackerFailureInput" << iImg << ".fits";
+        fileNames.push_back(fileName.str());
+        mimg.writeFits(fileNames.back());
+    }
+    BOOST_REQUIRE_EQUAL(truncate(fileNames.back().c_str(), 2*2880), 0); // keep the PDU and the image header
+
+    std::string const outFileName = "tests/stackerFailureOutput.fits";
+    BOOST_CHECK_THROW(math::statisticsStackFits<float>(outFileName, fileNames, math::MEAN,
+                                                       math::StatisticsControl(), VecF(), 4),
+                      lsst::pex::exceptions::Exception);
+
+    std::FILE *fd = std::fopen(outFileName.c_str(), "r");
+    BOOST_CHECK(fd == NULL);
+    if (fd != NULL) {
+        std::fclose(fd);
+        std::remove(outFileName.c_str());
+    }
+
+    for (int iImg = 0; iImg < nImg; ++iImg) {
+        std::remove(fileNames[iImg].c_str());
+    }
+}
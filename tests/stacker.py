@@ -255,7 +255,49 @@ class StackTestCase(unittest.TestCase):
         # now try with sctrl (andmask = 0x0001), should see 0x0100 for all output mask pixels
         imgStack = afwMath.statisticsStack(imgList, afwMath.MEAN, sctrl)
         self.assertEqual(imgStack.get(0, 0)[1], 0x4)
-        
+
+    def testThreadedStack(self):
+        """Check that the (tiled, threaded) stack agrees with makeStatistics for each pixel"""
+
+        nImg, width, height = 9, 11, 7
+        BAD = 0x2
+        mimgList = afwImage.vectorMaskedImageF()
+        imgList = afwImage.vectorImageF()
+        for i in range(nImg):
+            mimg = afwImage.MaskedImageF(afwGeom.Extent2I(width, height))
+            for y in range(height):
+                for x in range(width):
+                    val = ((37*x + 11*y + 17*i) % 23) - 5.0
+                    if (x + y + i) % 7 == 0:
+                        val += 100              # an outlier, to be clipped
+                    msk = BAD if (x*y + i) % 5 == 0 else 0x1
+                    mimg.set(x, y, (val, msk, 1.0 + (x + i) % 3))
+            mimgList.push_back(mimg)
+            imgList.push_back(mimg.getImage())
+
+        sctrl = afwMath.StatisticsControl()
+        sctrl.setAndMask(BAD)
+        for stat in (afwMath.MEAN, afwMath.MEDIAN, afwMath.MEANCLIP, afwMath.VARIANCE):
+            stacks = []
+            for nThreads in (1, 2, 0):
+                sctrl.setNThreads(nThreads)
+                stacks.append(afwMath.statisticsStack(mimgList, stat, sctrl))
+            imgStack = afwMath.statisticsStack(imgList, stat, sctrl)
+
+            for y in range(height):
+                for x in range(width):
+                    pixels = afwImage.MaskedImageF(afwGeom.Extent2I(nImg, 1))
+                    for i in range(nImg):
+                        pixels.set(i, 0, mimgList[i].get(x, y))
+                    stats = afwMath.makeStatistics(pixels, stat | afwMath.ERRORS, sctrl)
+                    for mimgStack in stacks:
+                        self.assertAlmostEqual(mimgStack.getImage().get(x, y), stats.getValue(stat), 5)
+                        self.assertEqual(mimgStack.getMask().get(x, y), 0x1)
+
+                    pixels.getMask().set(0)
+                    stats = afwMath.makeStatistics(pixels, stat, sctrl)
+                    self.assertAlmostEqual(imgStack.get(x, y), stats.getValue(stat), 5)
+
 #################################################################
 # Test suite boiler plate
 #################################################################
@@ -385,7 +385,48 @@ class StatisticsTestCase(unittest.TestCase):
         img.set(0)
         stats = afwMath.makeStatistics(img, afwMath.MEANCLIP)
         self.assertEqual(stats.getValue(), 0)
-        
+
+    def testHistogramQuantiles(self):
+        """Test that finding the quantiles with histograms gives exactly the same answers"""
+        for ImageT, isSigned in [(afwImage.ImageU, False), (afwImage.ImageI, True),
+                                 (afwImage.ImageF, True), (afwImage.ImageD, True)]:
+            for width, height in [(1, 1), (2, 1), (37, 11), (64, 64)]:
+                img = ImageT(afwGeom.Extent2I(width, height))
+                for y in range(height):
+                    for x in range(width):
+                        val = (x*7919 + y*104729) % 65521
+                        if isSigned:
+                            val -= 30000
+                        if ImageT in (afwImage.ImageF, afwImage.ImageD):
+                            val *= 1.0e-3
+                            if (x + y) % 17 == 3:
+                                val = float("NaN")
+                        img.set(x, y, val)
+
+                for flags in [afwMath.MEDIAN, afwMath.MEDIAN | afwMath.IQRANGE,
+                              afwMath.MEANCLIP | afwMath.IQRANGE]:
+                    ctrl = afwMath.StatisticsControl()
+                    stats = afwMath.makeStatistics(img, flags, ctrl)
+                    ctrl.setHistogramQuantiles(True)
+                    hstats = afwMath.makeStatistics(img, flags, ctrl)
+                    for prop in [afwMath.MEDIAN, afwMath.IQRANGE, afwMath.MEANCLIP]:
+                        if prop & flags:
+                            self.assertEqual(hstats.getValue(prop), stats.getValue(prop))
+        #
+        # Check that masked pixels are ignored
+        #
+        mimg = afwImage.MaskedImageF(afwGeom.Extent2I(20, 20))
+        for y in range(mimg.getHeight()):
+            for x in range(mimg.getWidth()):
+                mimg.set(x, y, ((x*31 + y*17) % 101 - 50.5, 0x1 if (x + y) % 3 else 0x2, 1.0))
+        ctrl = afwMath.StatisticsControl()
+        ctrl.setAndMask(0x2)
+        stats = afwMath.makeStatistics(mimg, afwMath.MEDIAN | afwMath.IQRANGE, ctrl)
+        ctrl.setHistogramQuantiles(True)
+        hstats = afwMath.makeStatistics(mimg, afwMath.MEDIAN | afwMath.IQRANGE, ctrl)
+        self.assertEqual(hstats.getValue(afwMath.MEDIAN), stats.getValue(afwMath.MEDIAN))
+        self.assertEqual(hstats.getValue(afwMath.IQRANGE), stats.getValue(afwMath.IQRANGE))
+
             
 #-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 
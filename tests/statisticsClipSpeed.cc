@@ -0,0 +1,116 @@
+// -*- LSST-C++ -*-
+
+/* 
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ * 
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the LSST License Statement and 
+ * the GNU General Public License along with this program.  If not, 
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+ 
+/**
+ * @file statisticsClipSpeed.cc
+ *
+ * Time the statistics (MEDIAN, IQRANGE, and MEANCLIP) that need a copy of the good pixels,
+ * which is made in the same pass through the image as the standard statistics.
+ * The clipping iterations then only look at the copied values.
+ */
+#include <iostream>
+#include <cmath>
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE StatisticsClipSpeed
+
+#include "boost/test/unit_test.hpp"
+#include "boost/test/floating_point_comparison.hpp"
+#include "boost/timer.hpp"
+
+#include "lsst/afw/image/Image.h"
+#include "lsst/afw/image/MaskedImage.h"
+#include "lsst/afw/math/Statistics.h"
+
+namespace image = lsst::afw::image;
+namespace math = lsst::afw::math;
+namespace geom = lsst::afw::geom;
+
+typedef image::Image<float> Image;
+typedef image::MaskedImage<float> MaskedImage;
+
+/**
+ * @brief Time MEAN, MEDIAN, MEDIAN | IQRANGE and MEANCLIP on a 4k x 4k ramp, and check the results
+ *
+ * For a ramp z = z0 + x (with the number of columns a multiple of 4) the median and the mean are
+ * both z0 + (nx - 1)/2, the interquartile range is (nx - 1)/2, and 3-sigma clipping removes nothing.
+ * The MEANCLIP shouldn't take much longer than the MEDIAN, as it doesn't reread the image.
+ */
+BOOST_AUTO_TEST_CASE(StatisticsClipSpeed) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+
+    int const nx = 4096;
+    int const ny = nx;
+    MaskedImage mimg(geom::Extent2I(nx, ny));
+    double const z0 = 10.0;
+    for (int iY = 0; iY < ny; ++iY) {
+        int x = 0;
+        for (MaskedImage::x_iterator ptr = mimg.row_begin(iY), end = mimg.row_end(iY); ptr != end;
+             ++ptr, ++x) {
+            *ptr = MaskedImage::SinglePixel(z0 + x, 0x0, 1.0);
+        }
+    }
+    double const mean = z0 + (nx - 1)/2.0;
+    double const iqrange = (nx - 1)/2.0;
+
+    Image const &img = *mimg.getImage();
+    math::StatisticsControl sctrl;
+    boost::timer timer;
+
+    timer.restart();
+    math::Statistics statsMean = math::makeStatistics(img, math::NPOINT | math::MEAN, sctrl);
+    double const tMean = timer.elapsed();
+    BOOST_CHECK_CLOSE(statsMean.getValue(math::MEAN), mean, 1.0e-6);
+
+    timer.restart();
+    math::Statistics statsMedian = math::makeStatistics(img, math::MEDIAN, sctrl);
+    double const tMedian = timer.elapsed();
+    BOOST_CHECK_EQUAL(statsMedian.getValue(math::MEDIAN), mean);
+
+    timer.restart();
+    math::Statistics statsQuartiles = math::makeStatistics(img, math::MEDIAN | math::IQRANGE, sctrl);
+    double const tQuartiles = timer.elapsed();
+    BOOST_CHECK_EQUAL(statsQuartiles.getValue(math::MEDIAN), mean);
+    BOOST_CHECK_EQUAL(statsQuartiles.getValue(math::IQRANGE), iqrange);
+
+    timer.restart();
+    math::Statistics statsClip = math::makeStatistics(img, math::NPOINT | math::MEANCLIP, sctrl);
+    double const tClip = timer.elapsed();
+    BOOST_CHECK_CLOSE(statsClip.getValue(math::MEANCLIP), mean, 1.0e-6);
+    BOOST_CHECK_EQUAL(statsClip.getValue(math::NPOINT), nx*static_cast<double>(ny));
+
+    // the same, but masked and weighted
+    sctrl.setWeighted(true);
+    timer.restart();
+    math::Statistics statsWeightedClip =
+        math::makeStatistics(mimg, math::NPOINT | math::MEANCLIP | math::MIN | math::MAX, sctrl);
+    double const tWeightedClip = timer.elapsed();
+    BOOST_CHECK_CLOSE(statsWeightedClip.getValue(math::MEANCLIP), mean, 1.0e-6);
+    BOOST_CHECK_EQUAL(statsWeightedClip.getValue(math::MIN), z0);
+    BOOST_CHECK_EQUAL(statsWeightedClip.getValue(math::MAX), z0 + nx - 1);
+
+    std::cout << "Time (sec) for a " << nx << "x" << ny << " image:" << std::endl;
+    std::cout << "MEAN " << tMean << "; MEDIAN " << tMedian << "; MEDIAN|IQRANGE " << tQuartiles
+              << "; MEANCLIP " << tClip << "; weighted MaskedImage MEANCLIP|MIN|MAX " << tWeightedClip
+              << std::endl;
+}
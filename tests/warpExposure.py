@@ -184,6 +184,58 @@ class WarpExposureTestCase(unittest.TestCase):
         except Exception:
             pass
 
+    def testMultithreadedWarp(self):
+        """Test that warping with several threads matches warping with one thread
+        """
+        originalExposure = afwImage.ExposureF(originalExposurePath)
+        swarpedImagePath = os.path.join(dataDir, "medswarp1lanczos2.fits")
+        swarpedDecoratedImage = afwImage.DecoratedImageF(swarpedImagePath)
+        warpedWcs = afwImage.makeWcs(swarpedDecoratedImage.getMetadata())
+        dimensions = swarpedDecoratedImage.getImage().getDimensions()
+
+        for kernelName in ("bilinear", "lanczos3"):
+            warpingKernel = afwMath.makeWarpingKernel(kernelName)
+            warpingKernel.computeCache(10000)
+            for interpLength in (0, 7, 10):
+                serialExposure = afwImage.ExposureF(afwImage.MaskedImageF(dimensions), warpedWcs)
+                serialNumGood = afwMath.warpExposure(serialExposure, originalExposure, warpingKernel,
+                    interpLength, 1)
+                serialArrSet = serialExposure.getMaskedImage().getArrays()
+                for nThreads in (2, 3, 0):
+                    descr = "kernel=%s, interpLength=%s, nThreads=%s" % (kernelName, interpLength, nThreads)
+                    warpedExposure = afwImage.ExposureF(afwImage.MaskedImageF(dimensions), warpedWcs)
+                    numGood = afwMath.warpExposure(warpedExposure, originalExposure, warpingKernel,
+                        interpLength, nThreads)
+                    self.assertEqual(numGood, serialNumGood, descr)
+                    errStr = imageTestUtils.maskedImagesDiffer(
+                        warpedExposure.getMaskedImage().getArrays(), serialArrSet, rtol=0, atol=0)
+                    if errStr:
+                        self.fail("%s: %s" % (descr, errStr))
+
+    def testLanczosLookupTable(self):
+        """Test that a Lanczos kernel computed from its lookup table matches the exact kernel
+        """
+        for order in (2, 3, 4, 5):
+            tableKernel = afwMath.LanczosWarpingKernel(order)
+            self.assertTrue(tableKernel.getUseLookupTable())
+            self.assertTrue(tableKernel.clone().getUseLookupTable())
+            exactKernel = afwMath.LanczosWarpingKernel(order, False)
+            self.assertFalse(exactKernel.getUseLookupTable())
+            self.assertFalse(exactKernel.clone().getUseLookupTable())
+
+            tableImage = afwImage.ImageD(tableKernel.getDimensions())
+            exactImage = afwImage.ImageD(exactKernel.getDimensions())
+            for xFrac in numpy.linspace(0.0, 0.999, 13):
+                for yFrac in (0.0, 0.2531, 0.5, 0.9873):
+                    for doNormalize in (False, True):
+                        tableKernel.setKernelParameters((xFrac, yFrac))
+                        exactKernel.setKernelParameters((xFrac, yFrac))
+                        tableKernel.computeImage(tableImage, doNormalize)
+                        exactKernel.computeImage(exactImage, doNormalize)
+                        self.assertTrue(numpy.allclose(tableImage.getArray(), exactImage.getArray(),
+                            rtol=0, atol=2.0e-7),
+                            "order=%s, xFrac=%s, yFrac=%s, doNormalize=%s" % (order, xFrac, yFrac, doNormalize))
+
     def testMatchSwarpBilinearImage(self):
         """Test that warpExposure matches swarp using a bilinear warping kernel
         """
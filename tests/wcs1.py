@@ -27,6 +27,8 @@ import math
 import pdb                          # we may want to say pdb.set_trace()
 import unittest
 
+import numpy
+
 import eups
 import lsst.afw.image as afwImage
 import lsst.afw.geom as afwGeom
@@ -114,6 +116,35 @@ class WCSTestCaseSDSS(unittest.TestCase):
         self.assertAlmostEqual(raDec[0], raDec2[0])
         self.assertAlmostEqual(raDec[1], raDec2[1])
 
+    def testPositionArrays(self):
+        """Check that converting arrays of positions matches converting one position at a time"""
+        sipA = numpy.zeros((4, 4))
+        sipB = numpy.zeros((4, 4))
+        sipA[2, 0] = 2.1e-6; sipA[1, 1] = -1.3e-6; sipA[0, 3] = 4.0e-9
+        sipB[0, 2] = -1.7e-6; sipB[2, 1] = 3.3e-9
+        sipAp = -sipA
+        sipBp = -sipB
+        sipWcs = afwImage.TanWcs(afwGeom.Point2D(245.167400, 19.1976583), afwGeom.Point2D(100.0, 110.0),
+                                 self.wcs.getCDMatrix(), sipA, sipB, sipAp, sipBp)
+        self.assertTrue(sipWcs.hasDistortion())
+
+        pixels = numpy.array([(x, y) for x in (-50.0, 0.0, 33.3, 110.0, 500.0) for y in (-7.5, 0.0, 123.0)])
+        for wcs in (self.wcs, sipWcs):
+            sky = numpy.zeros(pixels.shape)
+            wcs.pixelToSky(pixels, sky)
+            pixels2 = numpy.zeros(pixels.shape)
+            wcs.skyToPixel(sky, pixels2)
+            for i in range(len(pixels)):
+                raDec = wcs.pixelToSky(pixels[i][0], pixels[i][1])
+                self.assertAlmostEqual(sky[i][0], raDec.getLongitude().asDegrees(), 10)
+                self.assertAlmostEqual(sky[i][1], raDec.getLatitude().asDegrees(), 10)
+                xy = wcs.skyToPixel(sky[i][0] * afwGeom.degrees, sky[i][1] * afwGeom.degrees)
+                self.assertAlmostEqual(pixels2[i][0], xy.getX(), 8)
+                self.assertAlmostEqual(pixels2[i][1], xy.getY(), 8)
+
+        self.assertRaises(exceptions.LsstCppException, self.wcs.pixelToSky, pixels, numpy.zeros((3, 2)))
+        self.assertRaises(exceptions.LsstCppException, self.wcs.skyToPixel, pixels, numpy.zeros((15, 3)))
+
     def test_RaTan_DecTan(self):
         """Check the RA---TAN, DEC--TAN WCS conversion"""
         # values from wcstools xy2sky (v3.8.1). Confirmed by ds9